@@ -1,53 +1,99 @@
-#version 460 core
+#version 450 core
 out vec4 FragColor;
 
-struct Material {
-    sampler2D diffuse;
-    sampler2D specular;
-    float shininess;
-};
+#include "include/blocks.glsl"
 
-struct Light {
-    vec3 position;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-
-    float constant;
-    float linear;
-    float quadratic;
-};
+#ifdef CLUSTERED_LIGHTING
+#include "include/clusters.glsl"
+#endif
 
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
 
-uniform Material material;
-uniform Light light;
+#ifdef MATERIAL_TEXTURE_ARRAY
+// Many materials share these arrays and pick their layer from the block.
+layout (binding = 0) uniform sampler2DArray diffuseMap;
+layout (binding = 1) uniform sampler2DArray specularMap;
+
+vec3 sampleDiffuse()
+{
+    return vec3(texture(diffuseMap, vec3(TexCoords, material.diffuseLayer)));
+}
+
+vec3 sampleSpecular()
+{
+    return vec3(texture(specularMap, vec3(TexCoords, material.specularLayer)));
+}
+#else
+layout (binding = 0) uniform sampler2D diffuseMap;
+layout (binding = 1) uniform sampler2D specularMap;
+
+vec3 sampleDiffuse()
+{
+    return vec3(texture(diffuseMap, TexCoords));
+}
+
+vec3 sampleSpecular()
+{
+    return vec3(texture(specularMap, TexCoords));
+}
+#endif
 
 void main()
 {
+    Light light = frame.light;
+
     // Vector pointing towards the light source.
     vec3 L = normalize(light.position - FragPos);
 
     // Normalized surface normal.
     vec3 N = normalize(Normal);
 
+    // Vector pointing towards the viewer.
+    vec3 V = normalize(view.position - FragPos);
+
+    float atten = attenuate(light, length(light.position - FragPos));
+
+    // Calculate diffuse intensity.
+    float diff = max(dot(L, N), 0.0);
+
+    vec3 albedo = sampleDiffuse();
+    vec3 ambient = atten * light.ambient * albedo;
+    vec3 diffuse = atten * light.diffuse * diff * albedo;
+
+#ifdef MATERIAL_SPECULAR_MAP
+    vec3 specularColor = sampleSpecular();
+
     // Reflect around the normal.
     vec3 R = normalize(reflect(-L, N));
 
-    // Calculate the intensity over distance.
-    float dist = length(light.position - FragPos);
-    float atten = 1.0 / (light.constant + light.linear * dist + light.quadratic * (dist * dist));
+    float spec = pow(max(dot(V, R), 0.0), material.shininess);
+    vec3 specular = atten * light.specular * spec * specularColor;
+#else
+    // Without a specular map the surface is fully matte.
+    vec3 specular = vec3(0.0);
+#endif
 
-    // Calculate diffuse and specular intensity.
-    float diff = max(dot(L, N), 0.0);
-    float spec = pow(max(dot(normalize(-FragPos), R), 0.0), material.shininess);
+#ifdef CLUSTERED_LIGHTING
+    uvec2 cluster = getLightCluster(FragPos);
+
+    for (uint i = 0u; i < cluster.y; ++i) {
+        uint index = lightIndices[cluster.x + i];
+
+        vec3 toLight = lightPositions[index].xyz - FragPos;
+        float dist = length(toLight);
+        vec3 Lp = toLight / max(dist, 1e-4);
+
+        vec3 radiance = lightColors[index].rgb * attenuatePointLight(index, dist);
+        diffuse += radiance * max(dot(Lp, N), 0.0) * albedo;
 
-    vec3 ambient = atten * light.ambient * vec3(texture(material.diffuse, TexCoords));
-    vec3 diffuse = atten * light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = atten * light.specular * spec * vec3(texture(material.specular, TexCoords));
+#ifdef MATERIAL_SPECULAR_MAP
+        vec3 Rp = reflect(-Lp, N);
+        specular += radiance * pow(max(dot(V, Rp), 0.0), material.shininess) * specularColor;
+#endif
+    }
+#endif
 
     FragColor = vec4(ambient + diffuse + specular, 1.0);
 }
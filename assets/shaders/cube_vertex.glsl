@@ -1,23 +1,18 @@
-#version 460 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec2 aTexCoords;
+#version 450 core
+
+#include "include/blocks.glsl"
+#include "include/vertex.glsl"
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
-// Normal matrix to transform the normal vector to view space.
-uniform mat3 normal;
-
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    FragPos = vec3(view * model * vec4(aPos, 1.0));
-    Normal = normal * aNormal;
-    TexCoords = aTexCoords;
+    vec4 worldPos = getModelMatrix() * vec4(decodePosition(), 1.0);
+
+    gl_Position = view.viewProjection * worldPos;
+    FragPos = vec3(worldPos);
+    Normal = getNormalMatrix() * decodeNormal();
+    TexCoords = decodeTexCoords();
 }
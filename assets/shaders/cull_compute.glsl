@@ -0,0 +1,80 @@
+#version 450 core
+
+// Frustum culls every object and appends the visible ones to their mesh's
+// draw command. Built with `CULL_COMPACT` instead, it packs the commands that
+// ended up with instances and counts them, for glMultiDrawElementsIndirectCount.
+
+#include "include/scene.glsl"
+
+layout (local_size_x = 64) in;
+
+layout (std140, binding = 4) uniform CullBlock {
+    vec4 planes[6];
+    uint objectCount;
+    uint commandCount;
+} cull;
+
+// A DrawElementsIndirectCommand.
+struct Command {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 3) buffer CommandBuffer {
+    Command commands[];
+};
+
+#ifdef CULL_COMPACT
+layout (std430, binding = 5) buffer DrawCountBuffer {
+    uint drawCount;
+};
+
+layout (std430, binding = 6) writeonly buffer CompactedCommandBuffer {
+    Command compacted[];
+};
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+
+    if (index >= cull.commandCount || commands[index].instanceCount == 0) {
+        return;
+    }
+
+    compacted[atomicAdd(drawCount, 1)] = commands[index];
+}
+#else
+layout (std430, binding = 4) writeonly buffer VisibleBuffer {
+    uint visible[];
+};
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+
+    if (index >= cull.objectCount) {
+        return;
+    }
+
+    Object object = objects[index];
+    vec4 sphere = meshes[object.mesh].sphere;
+
+    vec3 center = vec3(object.model * vec4(sphere.xyz, 1.0));
+    float scale = max(
+        length(object.model[0].xyz),
+        max(length(object.model[1].xyz), length(object.model[2].xyz)));
+    float radius = sphere.w * scale;
+
+    for (int i = 0; i < 6; ++i) {
+        if (dot(cull.planes[i].xyz, center) + cull.planes[i].w < -radius) {
+            return;
+        }
+    }
+
+    uint slot = atomicAdd(commands[object.mesh].instanceCount, 1);
+    visible[commands[object.mesh].baseInstance + slot] = index;
+}
+#endif
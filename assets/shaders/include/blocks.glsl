@@ -0,0 +1,34 @@
+// Mirrors `src/Renderer/UniformBlocks.hpp`; keep both in sync.
+
+#include "include/lighting.glsl"
+
+layout (std140, binding = 0) uniform FrameBlock {
+    float time;
+    float deltaTime;
+    Light light;
+} frame;
+
+layout (std140, binding = 1) uniform ViewBlock {
+    mat4 projection;
+    mat4 view;
+    mat4 viewProjection;
+    vec3 position;
+} view;
+
+layout (std140, binding = 2) uniform MaterialBlock {
+    float shininess;
+    int diffuseLayer;
+    int specularLayer;
+} material;
+
+layout (std140, binding = 3) uniform ObjectBlock {
+    mat4 model;
+
+    // Normal matrix to transform the normal vector to world space.
+    mat3 normal;
+
+    // Dequantization of the mesh's vertices, see `include/vertex.glsl`.
+    vec4 positionOffset;
+    vec4 positionScale;
+    vec4 texCoordTransform;
+} object;
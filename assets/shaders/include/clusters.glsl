@@ -0,0 +1,57 @@
+// Clustered point lights, see `src/Renderer/ClusteredLighting.hpp`. Needs
+// `include/blocks.glsl` for the view block.
+
+layout (std140, binding = 5) uniform LightGridBlock {
+    // Tiles across, tiles up, slices and the number of lights.
+    uvec4 size;
+
+    // Tiles per pixel along x and y, and the slice scale and bias.
+    vec4 scale;
+} lightGrid;
+
+// Each light's attributes live in their own array.
+layout (std430, binding = 7) readonly buffer LightPositionBuffer {
+    // World space position, and the radius the light was clustered with.
+    vec4 lightPositions[];
+};
+
+layout (std430, binding = 8) readonly buffer LightColorBuffer {
+    vec4 lightColors[];
+};
+
+layout (std430, binding = 9) readonly buffer LightAttenuationBuffer {
+    // Constant, linear and quadratic terms.
+    vec4 lightAttenuations[];
+};
+
+// Offset into lightIndices and count, per cluster.
+layout (std430, binding = 10) readonly buffer LightClusterBuffer {
+    uvec2 lightClusters[];
+};
+
+layout (std430, binding = 11) readonly buffer LightIndexBuffer {
+    uint lightIndices[];
+};
+
+uvec2 getLightCluster(vec3 worldPosition)
+{
+    float depth = -(view.view * vec4(worldPosition, 1.0)).z;
+
+    uvec2 tile = min(uvec2(gl_FragCoord.xy * lightGrid.scale.xy), lightGrid.size.xy - 1u);
+    int slice = int(floor(log(max(depth, 1e-4)) * lightGrid.scale.z + lightGrid.scale.w));
+    uint z = uint(clamp(slice, 0, int(lightGrid.size.z) - 1));
+
+    return lightClusters[(z * lightGrid.size.y + tile.y) * lightGrid.size.x + tile.x];
+}
+
+float attenuatePointLight(uint light, float dist)
+{
+    vec4 terms = lightAttenuations[light];
+    float falloff = 1.0 / (terms.x + terms.y * dist + terms.z * (dist * dist));
+
+    // Fade out towards the clustering radius, so the light doesn't stop at
+    // the cluster boundaries.
+    float window = clamp(1.0 - pow(dist / lightPositions[light].w, 4.0), 0.0, 1.0);
+
+    return falloff * window * window;
+}
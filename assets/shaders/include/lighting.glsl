@@ -0,0 +1,21 @@
+struct Light {
+    vec3 position;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    float constant;
+    float linear;
+    float quadratic;
+};
+
+// Calculate the intensity over distance.
+float attenuate(Light light, float dist)
+{
+#ifdef LIGHT_ATTENUATION
+    return 1.0 / (light.constant + light.linear * dist + light.quadratic * (dist * dist));
+#else
+    return 1.0;
+#endif
+}
@@ -0,0 +1,26 @@
+// Objects and meshes of the GPU-driven path; mirrors the storage structs in
+// `src/Renderer/UniformBlocks.hpp`. Keep both in sync.
+
+struct Object {
+    mat4 model;
+    mat3 normal;
+    uint mesh;
+};
+
+struct MeshInfo {
+    // Bounding sphere in model space: center and radius.
+    vec4 sphere;
+
+    // Dequantization of the mesh's vertices, see `include/vertex.glsl`.
+    vec4 positionOffset;
+    vec4 positionScale;
+    vec4 texCoordTransform;
+};
+
+layout (std430, binding = 1) readonly buffer ObjectBuffer {
+    Object objects[];
+};
+
+layout (std430, binding = 2) readonly buffer MeshBuffer {
+    MeshInfo meshes[];
+};
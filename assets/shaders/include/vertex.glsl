@@ -0,0 +1,91 @@
+// Vertex attributes and their decoding; mirrors the formats in
+// `src/Geometry/VertexLayout.hpp`. Also selects the object's transforms: from
+// the object block, from the instance buffer when `INSTANCED`, or from the
+// culled object list when `GPU_DRIVEN`. Include after `include/blocks.glsl`.
+
+layout (location = 0) in vec3 aPos;
+
+#ifdef VERTEX_OCTAHEDRAL_NORMAL
+layout (location = 1) in vec2 aNormal;
+#else
+layout (location = 1) in vec3 aNormal;
+#endif
+
+layout (location = 2) in vec2 aTexCoords;
+
+#ifdef GPU_DRIVEN
+#include "include/scene.glsl"
+
+// The visible object, fetched per instance from the list the culling pass
+// compacted; the draw's base instance points at the mesh's part of it.
+layout (location = 3) in uint aObject;
+
+#define DEQUANTIZATION meshes[objects[aObject].mesh]
+#else
+#define DEQUANTIZATION object
+#endif
+
+#ifdef INSTANCED
+struct Instance {
+    mat4 model;
+    mat3 normal;
+};
+
+// Transforms of every instance in the current draw, see InstancedRenderer.
+layout (std430, binding = 0) readonly buffer InstanceBuffer {
+    Instance instances[];
+};
+#endif
+
+mat4 getModelMatrix()
+{
+#if defined(GPU_DRIVEN)
+    return objects[aObject].model;
+#elif defined(INSTANCED)
+    return instances[gl_InstanceID].model;
+#else
+    return object.model;
+#endif
+}
+
+mat3 getNormalMatrix()
+{
+#if defined(GPU_DRIVEN)
+    return objects[aObject].normal;
+#elif defined(INSTANCED)
+    return instances[gl_InstanceID].normal;
+#else
+    return object.normal;
+#endif
+}
+
+vec3 decodePosition()
+{
+#ifdef VERTEX_QUANTIZED_POSITION
+    return DEQUANTIZATION.positionOffset.xyz + aPos * DEQUANTIZATION.positionScale.xyz;
+#else
+    return aPos;
+#endif
+}
+
+vec3 decodeNormal()
+{
+#ifdef VERTEX_OCTAHEDRAL_NORMAL
+    // Unfold the lower half of the octahedron, see EncodeOctahedral().
+    vec3 n = vec3(aNormal, 1.0 - abs(aNormal.x) - abs(aNormal.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+#else
+    return aNormal;
+#endif
+}
+
+vec2 decodeTexCoords()
+{
+#ifdef VERTEX_QUANTIZED_TEXCOORD
+    return DEQUANTIZATION.texCoordTransform.xy + aTexCoords * DEQUANTIZATION.texCoordTransform.zw;
+#else
+    return aTexCoords;
+#endif
+}
@@ -1,11 +1,9 @@
-#version 460 core
-layout (location = 0) in vec3 aPos;
+#version 450 core
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "include/blocks.glsl"
+#include "include/vertex.glsl"
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = view.viewProjection * getModelMatrix() * vec4(decodePosition(), 1.0);
 }
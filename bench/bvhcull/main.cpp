@@ -0,0 +1,190 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Geometry/Bvh.hpp"
+#include "Geometry/Frustum.hpp"
+
+// Small boxes scattered over a square that grows with the count, so the
+// density, and with it the fraction a camera sees, stays about the same.
+static std::vector<Myst::BoundingBox> createScene(std::size_t objects, float extent)
+{
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-extent, extent);
+    std::uniform_real_distribution<float> height(0.0f, 8.0f);
+    std::uniform_real_distribution<float> size(0.2f, 1.5f);
+
+    std::vector<Myst::BoundingBox> bounds(objects);
+
+    for (Myst::BoundingBox& box : bounds) {
+        glm::vec3 center(position(random), height(random), position(random));
+        glm::vec3 extents(size(random), size(random), size(random));
+
+        box = {center - extents, center + extents};
+    }
+
+    return bounds;
+}
+
+// Cameras standing in the scene looking around the horizon.
+static std::vector<Myst::Frustum> createViews(int count, float extent)
+{
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> position(-extent * 0.5f, extent * 0.5f);
+    std::vector<Myst::Frustum> views;
+
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 250.0f);
+
+    for (int i = 0; i < count; ++i) {
+        float angle = 6.2831853f * static_cast<float>(i) / static_cast<float>(count);
+        glm::vec3 eye(position(random), 4.0f, position(random));
+        glm::vec3 target = eye + glm::vec3(std::cos(angle), -0.1f, std::sin(angle));
+        glm::mat4 view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+
+        views.push_back(Myst::Frustum::FromMatrix(projection * view));
+    }
+
+    return views;
+}
+
+template<typename Function>
+static double measure(int iterations, Function function)
+{
+    double best{1e30};
+
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+
+    return best;
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::size_t> counts{100000, 250000, 500000, 1000000};
+    int iterations{5};
+    int viewCount{16};
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--objects") == 0 && i + 1 < argc) {
+            counts = {std::max<std::size_t>(1, std::strtoul(argv[++i], nullptr, 10))};
+        } else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--views") == 0 && i + 1 < argc) {
+            viewCount = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cerr << "usage: myst-bench-bvhcull [--objects <n>] [--iterations <n>] "
+                         "[--views <n>]"
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << "myst-bench-bvhcull: " << viewCount << " views, best of " << iterations
+              << std::endl;
+
+    std::cout << std::left << std::setw(10) << "objects" << std::setw(16) << "pass"
+              << std::right << std::setw(12) << "ms" << std::setw(16) << "objects/ms"
+              << std::setw(12) << "visible" << std::endl;
+
+    for (std::size_t objects : counts) {
+        const float extent = 2.0f * std::sqrt(static_cast<float>(objects));
+        std::vector<Myst::BoundingBox> bounds = createScene(objects, extent);
+        const std::vector<Myst::Frustum> views = createViews(viewCount, extent);
+
+        Myst::Bvh bvh;
+        std::vector<std::uint32_t> visible;
+        visible.reserve(objects);
+
+        auto report = [&](const char* pass, double seconds, std::size_t processed, std::size_t shown) {
+            std::cout << std::left << std::setw(10) << objects << std::setw(16) << pass
+                      << std::right << std::fixed << std::setprecision(3) << std::setw(12)
+                      << seconds * 1e3 << std::setprecision(0) << std::setw(16)
+                      << static_cast<double>(processed) / (seconds * 1e3) << std::setw(12)
+                      << shown << std::endl;
+        };
+
+        double build = measure(iterations, [&]() { bvh.Build(bounds); });
+        report("build", build, objects, 0);
+
+        // A tenth of the scene moving a little every frame.
+        std::mt19937 random(3);
+        std::uniform_real_distribution<float> step(-0.25f, 0.25f);
+        std::vector<std::uint32_t> moving;
+
+        for (std::uint32_t object = 0; object < objects; object += 10) {
+            moving.push_back(object);
+        }
+
+        double refit = measure(iterations, [&]() {
+            for (std::uint32_t object : moving) {
+                glm::vec3 offset(step(random), 0.0f, step(random));
+                bounds[object].Min += offset;
+                bounds[object].Max += offset;
+                bvh.Update(object, bounds[object]);
+            }
+
+            bvh.Refit();
+        });
+        report("refit 10%", refit, moving.size(), 0);
+
+        std::size_t bvhVisible{0};
+        double bvhCull = measure(iterations, [&]() {
+            bvhVisible = 0;
+
+            for (const Myst::Frustum& frustum : views) {
+                visible.clear();
+                bvh.Cull(frustum, visible);
+                bvhVisible += visible.size();
+            }
+        });
+        report("bvh cull", bvhCull, objects * views.size(), bvhVisible / views.size());
+
+        std::size_t linearVisible{0};
+        double linearCull = measure(iterations, [&]() {
+            linearVisible = 0;
+
+            for (const Myst::Frustum& frustum : views) {
+                visible.clear();
+
+                for (std::uint32_t object = 0; object < objects; ++object) {
+                    if (frustum.Intersects(bounds[object])) {
+                        visible.push_back(object);
+                    }
+                }
+
+                linearVisible += visible.size();
+            }
+        });
+        report("linear cull", linearCull, objects * views.size(), linearVisible / views.size());
+
+        if (bvhVisible != linearVisible) {
+            std::cerr << "myst: the BVH found " << bvhVisible << " visible objects, the scan "
+                      << linearVisible << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,169 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Core/JobSystem.hpp"
+#include "Geometry/Frustum.hpp"
+#include "Scene/SceneGraph.hpp"
+
+// Platforms carrying groups of crates: every platform moves each frame, so
+// the whole hierarchy below it has to follow.
+struct Scene
+{
+    Myst::SceneGraph Graph;
+    std::vector<Myst::SceneGraph::Node> Platforms;
+    std::vector<Myst::SceneGraph::Node> Crates;
+};
+
+static void createScene(Scene& scene, std::size_t nodes)
+{
+    constexpr std::size_t kGroups{15};
+    constexpr std::size_t kCratesPerGroup{16};
+
+    const std::size_t platforms = std::max<std::size_t>(
+        1, nodes / (1 + kGroups * (1 + kCratesPerGroup)));
+    const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(platforms))));
+    const Myst::BoundingBox crate{glm::vec3(-0.5f), glm::vec3(0.5f)};
+
+    for (std::size_t p = 0; p < platforms; ++p) {
+        const glm::vec3 origin(
+            static_cast<float>(static_cast<int>(p) % side) * 20.0f, 0.0f,
+            static_cast<float>(static_cast<int>(p) / side) * 20.0f);
+        Myst::SceneGraph::Node platform =
+            scene.Graph.Create(Myst::SceneGraph::kNone, glm::translate(glm::mat4(1.0f), origin));
+        scene.Platforms.push_back(platform);
+
+        for (std::size_t g = 0; g < kGroups; ++g) {
+            const float angle = 6.2831853f * static_cast<float>(g) / kGroups;
+            Myst::SceneGraph::Node group = scene.Graph.Create(
+                platform,
+                glm::rotate(
+                    glm::translate(
+                        glm::mat4(1.0f), glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) * 6.0f),
+                    angle, glm::vec3(0.0f, 1.0f, 0.0f)));
+
+            for (std::size_t c = 0; c < kCratesPerGroup; ++c) {
+                const glm::vec3 offset(
+                    static_cast<float>(c % 4) * 1.1f, static_cast<float>(c / 4) * 1.1f, 0.0f);
+                scene.Crates.push_back(scene.Graph.Create(
+                    group, glm::translate(glm::mat4(1.0f), offset), crate));
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t nodes{262144};
+    int frames{20};
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+            nodes = std::max<std::size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cerr << "usage: myst-bench-jobs [--nodes <n>] [--frames <n>]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    Scene scene;
+    createScene(scene, nodes);
+
+    const glm::mat4 viewProjection =
+        glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 500.0f) *
+        glm::lookAt(glm::vec3(-10.0f, 30.0f, -10.0f), glm::vec3(100.0f, 0.0f, 100.0f),
+                    glm::vec3(0.0f, 1.0f, 0.0f));
+    const Myst::Frustum frustum = Myst::Frustum::FromMatrix(viewProjection);
+
+    std::cout << "myst-bench-jobs: " << scene.Graph.GetNodeCount() << " nodes, "
+              << scene.Platforms.size() << " moving platforms, best of " << frames
+              << " frames" << std::endl;
+
+    std::cout << std::left << std::setw(10) << "threads" << std::right << std::setw(12)
+              << "update ms" << std::setw(12) << "cull ms" << std::setw(12) << "frame ms"
+              << std::setw(10) << "speedup" << std::setw(12) << "visible" << std::endl;
+
+    const unsigned int hardware = std::max(1u, std::thread::hardware_concurrency());
+    double serial{0.0};
+
+    for (unsigned int threads = 1;; threads = std::min(threads * 2, hardware)) {
+        Myst::JobSystem jobs(threads);
+
+        double bestUpdate{1e30};
+        double bestCull{1e30};
+        double bestFrame{1e30};
+        std::size_t visible{0};
+
+        for (int frame = 0; frame < frames; ++frame) {
+            auto start = std::chrono::steady_clock::now();
+
+            const float time = static_cast<float>(frame) * 0.016f;
+
+            for (std::size_t p = 0; p < scene.Platforms.size(); ++p) {
+                glm::mat4 local = scene.Graph.GetLocalTransform(scene.Platforms[p]);
+                local[3].y = std::sin(time + static_cast<float>(p)) * 2.0f;
+                scene.Graph.SetLocalTransform(scene.Platforms[p], local);
+            }
+
+            scene.Graph.Update(&jobs);
+
+            auto updated = std::chrono::steady_clock::now();
+
+            std::atomic<std::size_t> count{0};
+
+            jobs.ParallelFor(
+                scene.Crates.size(), 4096, [&](std::size_t begin, std::size_t end) {
+                    std::size_t local{0};
+
+                    for (std::size_t i = begin; i < end; ++i) {
+                        local += frustum.Intersects(scene.Graph.GetWorldBounds(scene.Crates[i]));
+                    }
+
+                    count += local;
+                });
+
+            auto end = std::chrono::steady_clock::now();
+
+            bestUpdate = std::min(bestUpdate, std::chrono::duration<double>(updated - start).count());
+            bestCull = std::min(bestCull, std::chrono::duration<double>(end - updated).count());
+            bestFrame = std::min(bestFrame, std::chrono::duration<double>(end - start).count());
+            visible = count;
+        }
+
+        if (threads == 1) {
+            serial = bestFrame;
+        }
+
+        std::cout << std::left << std::setw(10) << threads << std::right << std::fixed
+                  << std::setprecision(2) << std::setw(12) << bestUpdate * 1e3
+                  << std::setw(12) << bestCull * 1e3 << std::setw(12) << bestFrame * 1e3
+                  << std::setw(9) << serial / bestFrame << "x" << std::setw(12) << visible
+                  << std::endl;
+
+        if (threads == hardware) {
+            break;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
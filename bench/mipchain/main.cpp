@@ -0,0 +1,165 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Core/JobSystem.hpp"
+#include "Image/Image.hpp"
+#include "Image/MipChain.hpp"
+
+struct Config
+{
+    const char* Name;
+    int Channels;
+    Myst::MipFilter Filter;
+    bool SRGB;
+    bool NormalMap;
+};
+
+// Deterministic noise over a gradient, so neither the data nor the timings
+// depend on an asset.
+static Myst::Image createImage(int size, int channels)
+{
+    Myst::Image image(size, size, channels);
+    std::uint32_t state{0x12345678u};
+
+    for (int y = 0; y < size; ++y) {
+        unsigned char* row = image.GetRow(y);
+
+        for (int x = 0; x < size * channels; ++x) {
+            state = state * 1664525u + 1013904223u;
+            row[x] = static_cast<unsigned char>(((x + y) & 0xff) / 2 + (state >> 25));
+        }
+    }
+
+    return image;
+}
+
+template<typename Function>
+static double measure(int iterations, Function function)
+{
+    double best{1e30};
+
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+
+    return best;
+}
+
+static int compare(const Myst::Image& a, const Myst::Image& b)
+{
+    int difference{0};
+
+    for (std::size_t i = 0; i < a.Pixels.size(); ++i) {
+        difference = std::max(difference, std::abs(a.Pixels[i] - b.Pixels[i]));
+    }
+
+    return difference;
+}
+
+int main(int argc, char* argv[])
+{
+    int size{2048};
+    int iterations{5};
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            size = std::max(2, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cerr << "usage: myst-bench-mipchain [--size <n>] [--iterations <n>]"
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    static const Config kConfigs[]{
+        {"rgba8 box", 4, Myst::MipFilter::Box, false, false},
+        {"rgb8 box", 3, Myst::MipFilter::Box, false, false},
+        {"rgba8 box srgb", 4, Myst::MipFilter::Box, true, false},
+        {"rgba8 kaiser srgb", 4, Myst::MipFilter::Kaiser, true, false},
+        {"rgb8 kaiser normal", 3, Myst::MipFilter::Kaiser, false, true},
+    };
+
+    const Myst::SimdLevel best = Myst::GetSimdLevel();
+    const double megapixels = static_cast<double>(size) * size / 1e6;
+
+    std::cout << "myst-bench-mipchain: " << size << "x" << size
+              << ", best of " << iterations << ", cpu supports "
+              << Myst::GetSimdLevelName(best) << std::endl;
+
+    std::cout << std::left << std::setw(22) << "config" << std::setw(8) << "simd"
+              << std::right << std::setw(12) << "MP/s" << std::setw(10)
+              << "speedup" << std::setw(10) << "max diff" << std::endl;
+
+    for (const Config& config : kConfigs) {
+        Myst::Image image = createImage(size, config.Channels);
+        Myst::MipOptions options;
+        options.Filter = config.Filter;
+        options.SRGB = config.SRGB;
+        options.NormalMap = config.NormalMap;
+
+        Myst::Image reference;
+        double scalar{0.0};
+
+        for (int level = 0; level <= static_cast<int>(best); ++level) {
+            options.Simd = static_cast<Myst::SimdLevel>(level);
+
+            Myst::Image result;
+            double seconds = measure(iterations, [&]() {
+                result = Myst::Downsample(image, options);
+            });
+
+            if (level == 0) {
+                reference = result;
+                scalar = seconds;
+            }
+
+            std::cout << std::left << std::setw(22) << config.Name << std::setw(8)
+                      << Myst::GetSimdLevelName(options.Simd) << std::right
+                      << std::fixed << std::setprecision(1) << std::setw(12)
+                      << megapixels / seconds << std::setw(9)
+                      << std::setprecision(2) << scalar / seconds << "x"
+                      << std::setw(10) << compare(reference, result) << std::endl;
+        }
+    }
+
+    // Whole chains, single-threaded against bands run as jobs.
+    Myst::JobSystem jobs;
+    Myst::Image image = createImage(size, 4);
+    Myst::MipOptions options;
+    options.Filter = Myst::MipFilter::Kaiser;
+    options.SRGB = true;
+
+    double serial = measure(iterations, [&]() {
+        Myst::GenerateMipChain(image, options);
+    });
+    double parallel = measure(iterations, [&]() {
+        Myst::GenerateMipChain(image, options, jobs);
+    });
+
+    std::cout << "chain (kaiser srgb, " << Myst::GetSimdLevelName(best)
+              << "): " << std::setprecision(2) << serial * 1e3 << " ms serial, "
+              << parallel * 1e3 << " ms on " << jobs.GetThreadCount()
+              << " threads (" << serial / parallel << "x)" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,205 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "Core/JobSystem.hpp"
+#include "Geometry/Model.hpp"
+
+// A grid of wavy patches with positions, texture coordinates and normals, the
+// way DCC tools export them: one object per patch, quads, relative precision
+// of six decimals.
+static std::string createObj(int objects, int resolution)
+{
+    std::string obj;
+    char line[160];
+
+    obj.reserve(static_cast<std::size_t>(objects) * resolution * resolution * 150);
+
+    const int columns = static_cast<int>(std::ceil(std::sqrt(objects)));
+    std::size_t base{1};
+
+    for (int object = 0; object < objects; ++object) {
+        const float originX = static_cast<float>(object % columns) * 1.1f;
+        const float originZ = static_cast<float>(object / columns) * 1.1f;
+
+        std::snprintf(line, sizeof(line), "o patch_%d\nusemtl crate\n", object);
+        obj += line;
+
+        for (int y = 0; y <= resolution; ++y) {
+            for (int x = 0; x <= resolution; ++x) {
+                float u = static_cast<float>(x) / resolution;
+                float v = static_cast<float>(y) / resolution;
+                float height = 0.05f * std::sin(u * 12.0f + object) * std::cos(v * 9.0f);
+
+                std::snprintf(
+                    line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n",
+                    originX + u, height, originZ + v, u, v, -0.3f * std::cos(u * 12.0f),
+                    0.9f, 0.1f * std::sin(v * 9.0f));
+                obj += line;
+            }
+        }
+
+        const std::size_t row = static_cast<std::size_t>(resolution) + 1;
+
+        for (int y = 0; y < resolution; ++y) {
+            for (int x = 0; x < resolution; ++x) {
+                std::size_t a = base + y * row + x;
+                std::size_t b = a + 1;
+                std::size_t c = a + row + 1;
+                std::size_t d = a + row;
+
+                std::snprintf(
+                    line, sizeof(line), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n",
+                    a, a, a, b, b, b, c, c, c, d, d, d);
+                obj += line;
+            }
+        }
+
+        base += row * row;
+    }
+
+    return obj;
+}
+
+template<typename Function>
+static double measure(int iterations, Function function)
+{
+    double best{1e30};
+
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+
+    return best;
+}
+
+int main(int argc, char* argv[])
+{
+    int objects{64};
+    int resolution{128};
+    int iterations{3};
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--objects") == 0 && i + 1 < argc) {
+            objects = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--resolution") == 0 && i + 1 < argc) {
+            resolution = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cerr << "usage: myst-bench-objparse [--objects <n>] "
+                         "[--resolution <n>] [--iterations <n>]"
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    const std::string obj = createObj(objects, resolution);
+    const double megabytes = static_cast<double>(obj.size()) / 1e6;
+
+    // Through the file system too, to include the mapping and page faults.
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "myst-bench-objparse.obj";
+
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(obj.data(), static_cast<std::streamsize>(obj.size()));
+
+        if (!file) {
+            std::cerr << "myst: unable to write " << path << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << "myst-bench-objparse: " << objects << " objects, "
+              << std::fixed << std::setprecision(1) << megabytes << " MB, "
+              << 2 * objects * resolution * resolution << " triangles, best of "
+              << iterations << std::endl;
+
+    std::cout << std::left << std::setw(10) << "threads" << std::setw(20) << "mode"
+              << std::right << std::setw(12) << "ms" << std::setw(12) << "MB/s"
+              << std::setw(10) << "speedup" << std::endl;
+
+    const unsigned int hardware = std::max(1u, std::thread::hardware_concurrency());
+    // Single thread timings per mode, to show the scaling.
+    double serial[3]{};
+
+    for (unsigned int threads = 1;; threads = std::min(threads * 2, hardware)) {
+        Myst::JobSystem jobs(threads);
+
+        struct Mode
+        {
+            const char* Name;
+            bool FromFile;
+            bool Optimize;
+        };
+
+        static const Mode kModes[]{
+            {"parse (memory)", false, false},
+            {"parse (mapped)", true, false},
+            {"parse + optimize", true, true},
+        };
+
+        for (int m = 0; m < 3; ++m) {
+            const Mode& mode = kModes[m];
+            Myst::ModelLoadOptions options;
+            options.Optimize = mode.Optimize;
+
+            std::size_t triangles{0};
+            double seconds = measure(iterations, [&]() {
+                Myst::Model model;
+
+                if (mode.FromFile) {
+                    Myst::LoadModel(path.string(), jobs, model, options);
+                } else {
+                    Myst::LoadObj(obj.data(), obj.size(), jobs, model, options);
+                }
+
+                triangles = model.GetTriangleCount();
+            });
+
+            if (threads == 1) {
+                serial[m] = seconds;
+            }
+
+            if (triangles != static_cast<std::size_t>(2) * objects * resolution * resolution) {
+                std::cerr << "myst: loaded " << triangles << " triangles" << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            std::cout << std::left << std::setw(10) << threads << std::setw(20)
+                      << mode.Name << std::right << std::setprecision(1)
+                      << std::setw(12) << seconds * 1e3 << std::setw(12)
+                      << megabytes / seconds << std::setw(9) << std::setprecision(2)
+                      << serial[m] / seconds << "x" << std::endl;
+        }
+
+        if (threads == hardware) {
+            break;
+        }
+    }
+
+    std::filesystem::remove(path);
+
+    return EXIT_SUCCESS;
+}
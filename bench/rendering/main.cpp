@@ -0,0 +1,472 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "Core/Json.hpp"
+
+// Renders each stress scene with `myst --headless`, gathers the reports and
+// compares them against a saved baseline. Runs from the source directory,
+// where the assets are.
+//
+// GPU times are only as good as the driver's timestamps: software drivers
+// such as llvmpipe render on the CPU, which shows in the CPU and frame times
+// instead.
+
+struct Scene
+{
+    const char* Name;
+    const char* Description;
+    // What the scene has `Count` of, scaled by --scale.
+    std::size_t Count;
+};
+
+static const Scene kScenes[]{
+    {"cubes", "crates", 20000},
+    {"lights", "point lights over 2000 crates", 1024},
+    {"materials", "textured materials over 4096 crates", 512},
+    {"shaders", "shader variants over 4096 crates", 64},
+    {"large-mesh", "triangles in a single mesh", 1000000},
+};
+
+// The metrics compared against a baseline, as paths into a scene's results.
+// All of them are better lower.
+static const char* const kMetrics[]{
+    "cpu_ms.mean", "cpu_ms.p95", "cpu_ms.p99",
+    "gpu_ms.mean", "gpu_ms.p95", "gpu_ms.p99",
+    "frame_ms.mean", "frame_ms.p95", "frame_ms.p99",
+    "draw_calls", "program_switches", "state_changes",
+    "peak_resident_kib", "texture_kib",
+};
+
+static std::string quote(const std::string& argument)
+{
+    std::string quoted{"'"};
+
+    for (char c : argument) {
+        quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+    }
+
+    return quoted + "'";
+}
+
+static bool readJson(const std::string& filepath, Myst::JsonValue& value)
+{
+    std::ifstream ifs(filepath, std::ios::binary);
+    const std::string data{std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+
+    if (!ifs || !Myst::JsonValue::Parse(data.data(), data.size(), value)) {
+        std::cerr << "myst-bench: could not read \"" << filepath << "\"" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static const Myst::JsonValue& lookUp(const Myst::JsonValue& scene, const std::string& metric)
+{
+    const std::size_t dot = metric.find('.');
+
+    if (dot == std::string::npos) {
+        return scene[metric];
+    }
+
+    return scene[metric.substr(0, dot)][metric.substr(dot + 1)];
+}
+
+// A UV sphere of about `triangles` triangles, as an OBJ file in the
+// temporary directory, written once per size.
+static std::string writeSphere(std::size_t triangles)
+{
+    const std::filesystem::path filepath =
+        std::filesystem::temp_directory_path() /
+        ("myst-bench-sphere-" + std::to_string(triangles) + ".obj");
+
+    if (std::filesystem::exists(filepath)) {
+        return filepath.string();
+    }
+
+    const std::size_t segments = std::max<std::size_t>(
+        4, static_cast<std::size_t>(std::sqrt(static_cast<double>(triangles))));
+    const std::size_t rings = std::max<std::size_t>(2, triangles / (2 * segments));
+
+    std::ofstream ofs(filepath, std::ios::binary | std::ios::trunc);
+    char line[128];
+
+    for (std::size_t ring = 0; ring <= rings; ++ring) {
+        const double v = static_cast<double>(ring) / rings;
+        const double theta = v * 3.14159265358979;
+
+        for (std::size_t segment = 0; segment <= segments; ++segment) {
+            const double u = static_cast<double>(segment) / segments;
+            const double phi = u * 6.28318530717959;
+            const double x = std::sin(theta) * std::cos(phi);
+            const double y = std::cos(theta);
+            const double z = std::sin(theta) * std::sin(phi);
+
+            std::snprintf(
+                line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n", x, y,
+                z, u, 1.0 - v, x, y, z);
+            ofs << line;
+        }
+    }
+
+    for (std::size_t ring = 0; ring < rings; ++ring) {
+        for (std::size_t segment = 0; segment < segments; ++segment) {
+            const std::size_t a = ring * (segments + 1) + segment + 1;
+            const std::size_t b = a + segments + 1;
+
+            std::snprintf(
+                line, sizeof(line), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, a, b, b, b,
+                a + 1, a + 1, a + 1);
+            ofs << line;
+            std::snprintf(
+                line, sizeof(line), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a + 1, a + 1,
+                a + 1, b, b, b, b + 1, b + 1, b + 1);
+            ofs << line;
+        }
+    }
+
+    if (!ofs) {
+        std::cerr << "myst-bench: could not write \"" << filepath.string() << "\""
+                  << std::endl;
+        return std::string();
+    }
+
+    return filepath.string();
+}
+
+static bool getArguments(const Scene& scene, std::size_t count, std::vector<std::string>& arguments)
+{
+    const std::string n = std::to_string(count);
+
+    if (std::strcmp(scene.Name, "cubes") == 0) {
+        arguments = {"--stress", n};
+    } else if (std::strcmp(scene.Name, "lights") == 0) {
+        arguments = {"--stress", "2000", "--lights", n};
+    } else if (std::strcmp(scene.Name, "materials") == 0) {
+        arguments = {"--stress", "4096", "--materials", n};
+    } else if (std::strcmp(scene.Name, "shaders") == 0) {
+        arguments = {"--stress", "4096", "--shader-variants", n};
+    } else if (std::strcmp(scene.Name, "large-mesh") == 0) {
+        const std::string filepath = writeSphere(count);
+
+        if (filepath.empty()) {
+            return false;
+        }
+
+        arguments = {"--model", filepath};
+    }
+
+    return true;
+}
+
+// Runs a scene and adds what its report says to `writer`.
+static bool runScene(
+    const std::string& myst, const Scene& scene, std::size_t count, std::size_t frames,
+    const std::vector<std::string>& extra, Myst::JsonWriter& writer, std::string& renderer)
+{
+    std::vector<std::string> arguments;
+
+    if (!getArguments(scene, count, arguments)) {
+        return false;
+    }
+
+    arguments.insert(arguments.end(), extra.begin(), extra.end());
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path();
+    const std::string reportPath =
+        (directory / ("myst-bench-" + std::string(scene.Name) + ".json")).string();
+    const std::string logPath =
+        (directory / ("myst-bench-" + std::string(scene.Name) + ".log")).string();
+
+    std::string command = quote(myst) + " --headless --frames " + std::to_string(frames) +
+                          " --report " + quote(reportPath);
+
+    for (const std::string& argument : arguments) {
+        command += " " + quote(argument);
+    }
+
+    command += " > " + quote(logPath) + " 2>&1";
+
+    std::error_code error;
+    std::filesystem::remove(reportPath, error);
+
+    Myst::JsonValue report;
+
+    if (std::system(command.c_str()) != 0 || !readJson(reportPath, report)) {
+        std::cerr << "myst-bench: " << scene.Name << " failed, see \"" << logPath << "\""
+                  << std::endl;
+        return false;
+    }
+
+    renderer = report["renderer"].AsString();
+
+    writer.BeginObject();
+    writer.Member("name", scene.Name);
+    writer.Member("count", count);
+
+    writer.Key("arguments");
+    writer.BeginArray();
+
+    for (const std::string& argument : arguments) {
+        writer.Value(argument);
+    }
+
+    writer.EndArray();
+
+    for (const char* key : {"cpu_ms", "gpu_ms", "frame_ms"}) {
+        const Myst::JsonValue& times = report[key];
+
+        writer.Key(key);
+        writer.BeginObject();
+        writer.Member("mean", times["mean"].AsNumber());
+        writer.Member("p50", times["median"].AsNumber());
+        writer.Member("p95", times["p95"].AsNumber());
+        writer.Member("p99", times["p99"].AsNumber());
+        writer.EndObject();
+    }
+
+    for (const char* key : {"draw_calls", "program_switches", "state_changes"}) {
+        writer.Member(key, report[key]["mean"].AsNumber());
+    }
+
+    writer.Member("peak_resident_kib", report["memory"]["peak_resident_kib"].AsNumber());
+    writer.Member("texture_kib", report["memory"]["texture_kib"].AsNumber());
+    writer.EndObject();
+
+    return true;
+}
+
+static void printResults(const Myst::JsonValue& results)
+{
+    std::printf(
+        "%-12s %10s %9s %9s %9s %9s %9s %10s %10s %9s\n", "scene", "count", "cpu ms",
+        "cpu p99", "gpu ms", "gpu p99", "frame ms", "draws", "states", "peak MiB");
+
+    const Myst::JsonValue& scenes = results["scenes"];
+
+    for (std::size_t i = 0; i < scenes.GetSize(); ++i) {
+        const Myst::JsonValue& scene = scenes[i];
+
+        std::printf(
+            "%-12s %10.0f %9.2f %9.2f %9.2f %9.2f %9.2f %10.0f %10.0f %9.1f\n",
+            scene["name"].AsString().c_str(), scene["count"].AsNumber(),
+            scene["cpu_ms"]["mean"].AsNumber(), scene["cpu_ms"]["p99"].AsNumber(),
+            scene["gpu_ms"]["mean"].AsNumber(), scene["gpu_ms"]["p99"].AsNumber(),
+            scene["frame_ms"]["mean"].AsNumber(), scene["draw_calls"].AsNumber(),
+            scene["state_changes"].AsNumber(), scene["peak_resident_kib"].AsNumber() / 1024.0);
+    }
+}
+
+// Prints every metric that moved by more than `threshold` percent, and
+// returns whether none got worse.
+static bool compareResults(
+    const Myst::JsonValue& baseline, const Myst::JsonValue& results, double threshold)
+{
+    std::size_t worse{0};
+    std::size_t better{0};
+
+    const Myst::JsonValue& scenes = results["scenes"];
+    const Myst::JsonValue& baseScenes = baseline["scenes"];
+
+    for (std::size_t i = 0; i < scenes.GetSize(); ++i) {
+        const Myst::JsonValue& scene = scenes[i];
+        const Myst::JsonValue* base{nullptr};
+
+        for (std::size_t j = 0; j < baseScenes.GetSize(); ++j) {
+            if (baseScenes[j]["name"].AsString() == scene["name"].AsString()) {
+                base = &baseScenes[j];
+            }
+        }
+
+        if (base == nullptr) {
+            std::printf("%-12s not in the baseline\n", scene["name"].AsString().c_str());
+            continue;
+        }
+
+        if ((*base)["count"].AsNumber() != scene["count"].AsNumber()) {
+            std::printf(
+                "%-12s counts differ, %.0f in the baseline and %.0f now\n",
+                scene["name"].AsString().c_str(), (*base)["count"].AsNumber(),
+                scene["count"].AsNumber());
+            continue;
+        }
+
+        for (const char* metric : kMetrics) {
+            const double before = lookUp(*base, metric).AsNumber();
+            const double after = lookUp(scene, metric).AsNumber();
+
+            if (before <= 0.0) {
+                continue;
+            }
+
+            const double change = (after - before) / before * 100.0;
+
+            if (std::abs(change) <= threshold) {
+                continue;
+            }
+
+            std::printf(
+                "%-12s %-18s %12.3f -> %12.3f  %+7.1f%%  %s\n", scene["name"].AsString().c_str(),
+                metric, before, after, change, change > 0.0 ? "worse" : "better");
+
+            if (change > 0.0) {
+                ++worse;
+            } else {
+                ++better;
+            }
+        }
+    }
+
+    std::printf(
+        "myst-bench: %zu metrics worse, %zu better by more than %.1f%%\n", worse, better,
+        threshold);
+
+    return worse == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string myst = (std::filesystem::path(argv[0]).parent_path() / "myst").string();
+    std::size_t frames{300};
+    double scale{1.0};
+    std::string only;
+    std::string outputPath{"myst-bench.json"};
+    const char* baselinePath{nullptr};
+    const char* loadPath{nullptr};
+    double threshold{5.0};
+    std::vector<std::string> extra;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--myst") == 0 && i + 1 < argc) {
+            myst = argv[++i];
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = std::max<std::size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            scale = std::max(1e-3, std::strtod(argv[++i], nullptr));
+        } else if (std::strcmp(argv[i], "--scenes") == 0 && i + 1 < argc) {
+            only = "," + std::string(argv[++i]) + ",";
+        } else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+            loadPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = std::strtod(argv[++i], nullptr);
+        } else if (std::strcmp(argv[i], "--") == 0) {
+            extra.assign(argv + i + 1, argv + argc);
+            break;
+        } else {
+            std::cerr << "usage: myst-bench [--myst <path>] [--frames <n>]\n"
+                         "    [--scale <f>] [--scenes <a,b,...>] [--output <results.json>]\n"
+                         "    [--compare <baseline.json> [--threshold <percent>]]\n"
+                         "    [--load <results.json>] [-- <myst arguments>]\n"
+                         "scenes:\n";
+
+            for (const Scene& scene : kScenes) {
+                std::fprintf(
+                    stderr, "  %-12s %8zu %s\n", scene.Name, scene.Count, scene.Description);
+            }
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    Myst::JsonValue results;
+
+    // Saved results are compared as they are, without running anything.
+    if (loadPath != nullptr) {
+        if (!readJson(loadPath, results)) {
+            return EXIT_FAILURE;
+        }
+    } else {
+        Myst::JsonWriter writer;
+        std::string renderer;
+        bool failed{false};
+
+        writer.BeginObject();
+        writer.Key("scenes");
+        writer.BeginArray();
+
+        for (const Scene& scene : kScenes) {
+            if (!only.empty() &&
+                only.find("," + std::string(scene.Name) + ",") == std::string::npos) {
+                continue;
+            }
+
+            const std::size_t count = std::max<std::size_t>(
+                1, static_cast<std::size_t>(std::llround(scene.Count * scale)));
+
+            std::cout << "myst-bench: " << scene.Name << ", " << count << " "
+                      << scene.Description << ", " << frames << " frames" << std::endl;
+
+            failed = !runScene(myst, scene, count, frames, extra, writer, renderer) || failed;
+        }
+
+        writer.EndArray();
+        writer.Member("renderer", renderer);
+        writer.Member("frames", frames);
+
+        writer.Key("arguments");
+        writer.BeginArray();
+
+        for (const std::string& argument : extra) {
+            writer.Value(argument);
+        }
+
+        writer.EndArray();
+        writer.EndObject();
+
+        const std::string& json = writer.GetString();
+
+        if (!writer.Save(outputPath) ||
+            !Myst::JsonValue::Parse(json.data(), json.size(), results)) {
+            return EXIT_FAILURE;
+        }
+
+        std::cout << "myst-bench: wrote \"" << outputPath << "\", on " << renderer
+                  << std::endl;
+
+        if (failed) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    printResults(results);
+
+    if (baselinePath != nullptr) {
+        Myst::JsonValue baseline;
+
+        if (!readJson(baselinePath, baseline)) {
+            return EXIT_FAILURE;
+        }
+
+        if (baseline["renderer"].AsString() != results["renderer"].AsString()) {
+            std::cout << "myst-bench: the baseline ran on "
+                      << baseline["renderer"].AsString() << std::endl;
+        }
+
+        if (!compareResults(baseline, results, threshold)) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,47 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Core/FixedTimestep.hpp"
+
+#include <algorithm>
+
+namespace Myst
+{
+    FixedTimestep::FixedTimestep(std::uint64_t step, std::uint32_t maxTicks)
+        : mStep(std::max<std::uint64_t>(step, 1))
+        , mMaxTicks(std::max<std::uint32_t>(maxTicks, 1))
+        , mTime(0)
+        , mTicks(0)
+        , mDropped(0)
+    {
+        // Nothing to do.
+    }
+
+    std::uint32_t FixedTimestep::Advance(std::uint64_t elapsed)
+    {
+        mTime += elapsed;
+
+        std::uint64_t ticks = (mTime + mStep - 1) / mStep - mTicks;
+
+        if (ticks > mMaxTicks) {
+            mDropped += ticks - mMaxTicks;
+            ticks = mMaxTicks;
+            mTime = (mTicks + ticks) * mStep;
+        }
+
+        mTicks += ticks;
+
+        return static_cast<std::uint32_t>(ticks);
+    }
+
+    float FixedTimestep::GetAlpha() const
+    {
+        const std::uint64_t ahead = mTicks * mStep - mTime;
+
+        return 1.0f - static_cast<float>(ahead) / static_cast<float>(mStep);
+    }
+}
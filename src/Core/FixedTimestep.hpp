@@ -0,0 +1,60 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace Myst
+{
+    // Turns the time frames take into whole ticks of a fixed step, so that
+    // the simulation costs and behaves the same whatever the frame rate.
+    //
+    // The simulation runs up to a tick ahead of real time, starting from its
+    // initial state as tick 0. Frames are drawn in between its last two
+    // ticks, GetAlpha() of the way from one to the other. Times are in
+    // nanoseconds, so that frame and tick steps that match do so exactly.
+    class FixedTimestep
+    {
+    public:
+        explicit FixedTimestep(std::uint64_t step, std::uint32_t maxTicks = 8);
+
+        std::uint64_t GetStep() const
+        {
+            return mStep;
+        }
+
+        // The ticks simulated so far, after the initial state.
+        std::uint64_t GetTicks() const
+        {
+            return mTicks;
+        }
+
+        // The ticks left out to keep up, see Advance().
+        std::uint64_t GetDropped() const
+        {
+            return mDropped;
+        }
+
+        // Moves real time on by `elapsed`, and returns the number of ticks to
+        // simulate to catch up with it. Past the most ticks per frame, the
+        // rest are dropped: after a stall, the simulation falls behind real
+        // time rather than taking ever longer to catch up.
+        std::uint32_t Advance(std::uint64_t elapsed);
+
+        // Where real time falls between the last two ticks, in (0, 1].
+        float GetAlpha() const;
+
+    private:
+        std::uint64_t mStep;
+        std::uint32_t mMaxTicks;
+
+        std::uint64_t mTime;
+        std::uint64_t mTicks;
+        std::uint64_t mDropped;
+    };
+}
@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Core/FramePacer.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#include "Core/Profiler.hpp"
+
+namespace Myst
+{
+    namespace
+    {
+        // How far short of a deadline sleeping stops and spinning takes over.
+        constexpr std::chrono::microseconds kSpinMargin{1000};
+    }
+
+    FramePacer::FramePacer()
+        : mPeriod(Clock::duration::zero())
+        , mMode(Mode::Limit)
+        , mWork{}
+        , mFrames(0)
+        , mWaited(0)
+        , mStats{}
+    {
+        // Nothing to do.
+    }
+
+    void FramePacer::SetTargetRate(double rate)
+    {
+        mPeriod = rate > 0.0 ? std::chrono::duration_cast<Clock::duration>(
+                                   std::chrono::duration<double>(1.0 / rate))
+                             : Clock::duration::zero();
+        mDeadline = Clock::time_point{};
+    }
+
+    void FramePacer::BeginFrame()
+    {
+        const Clock::time_point now = Clock::now();
+
+        if (!IsEnabled()) {
+            mFrameStart = now;
+            return;
+        }
+
+        if (mDeadline == Clock::time_point{}) {
+            mDeadline = now + mPeriod;
+        }
+
+        // Until there are frames to go by, low latency starts them straight
+        // away.
+        if (mMode == Mode::LowLatency && mFrames > 0) {
+            const Clock::duration work =
+                *std::max_element(mWork, mWork + std::min(mFrames, kHistory));
+
+            WaitUntil(mDeadline - work - kSpinMargin);
+        }
+
+        mFrameStart = Clock::now();
+        mWaited = mFrameStart - now;
+    }
+
+    void FramePacer::EndFrame()
+    {
+        const Clock::time_point end = Clock::now();
+
+        mWork[mFrames % kHistory] = end - mFrameStart;
+        ++mFrames;
+
+        if (!IsEnabled()) {
+            return;
+        }
+
+        if (end > mDeadline) {
+            ++mStats.Missed;
+            mDeadline = end + mPeriod;
+        } else {
+            if (mMode == Mode::Limit) {
+                WaitUntil(mDeadline);
+                mWaited += Clock::now() - end;
+            }
+
+            mDeadline += mPeriod;
+        }
+
+        mStats.Waited = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(mWaited).count());
+    }
+
+    void FramePacer::WaitUntil(Clock::time_point deadline)
+    {
+        MYST_PROFILE_SCOPE("Pace frame");
+
+        if (deadline - Clock::now() > kSpinMargin) {
+            std::this_thread::sleep_until(deadline - kSpinMargin);
+        }
+
+        while (Clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
+}
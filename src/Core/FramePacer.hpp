@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace Myst
+{
+    // Paces frames to a target rate, each frame ending a period after the
+    // last. A frame that runs late moves the ones after it back rather than
+    // having them rush to make up for it.
+    //
+    // Waits sleep until shortly before their deadline and spin the rest of
+    // the way, since sleeps overshoot by as much as a scheduler tick.
+    class FramePacer
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        enum class Mode
+        {
+            // Waits out what's left of the period once the frame is done.
+            Limit,
+
+            // Waits before the frame starts instead, for as long as the
+            // slowest of the last frames would leave spare, so that input is
+            // read as late as it can be and the frame still ends on time.
+            LowLatency,
+        };
+
+        struct Stats
+        {
+            // Waited before and after the last frame, in nanoseconds.
+            std::uint64_t Waited;
+
+            // Frames that ended past their deadline.
+            std::uint64_t Missed;
+        };
+
+        static constexpr std::size_t kHistory{16};
+
+        FramePacer();
+
+        bool IsEnabled() const
+        {
+            return mPeriod.count() > 0;
+        }
+
+        Mode GetMode() const
+        {
+            return mMode;
+        }
+
+        const Stats& GetStats() const
+        {
+            return mStats;
+        }
+
+        // In frames per second; 0 leaves frames unpaced.
+        void SetTargetRate(double rate);
+
+        void SetMode(Mode mode)
+        {
+            mMode = mode;
+        }
+
+        // Called before the frame reads its input.
+        void BeginFrame();
+
+        // Called once the frame is presented.
+        void EndFrame();
+
+        static void WaitUntil(Clock::time_point deadline);
+
+    private:
+        Clock::duration mPeriod;
+        Mode mMode;
+
+        // When the current frame is due to end.
+        Clock::time_point mDeadline;
+        Clock::time_point mFrameStart;
+
+        // How long the last frames took, leaving out the waits.
+        Clock::duration mWork[kHistory];
+        std::size_t mFrames;
+
+        Clock::duration mWaited;
+
+        Stats mStats;
+    };
+}
@@ -0,0 +1,173 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Core/FrameReport.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <numeric>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+#include "Core/Hash.hpp"
+#include "Core/Json.hpp"
+#include "Core/Profiler.hpp"
+
+namespace Myst
+{
+    namespace
+    {
+        std::string FormatChecksum(std::uint64_t checksum)
+        {
+            char buffer[17];
+            std::snprintf(
+                buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(checksum));
+
+            return buffer;
+        }
+
+        void WriteSummary(JsonWriter& writer, const char* key, std::vector<double> values)
+        {
+            writer.Key(key);
+            writer.BeginObject();
+
+            if (!values.empty()) {
+                std::sort(values.begin(), values.end());
+
+                auto percentile = [&values](double p) {
+                    return values[static_cast<std::size_t>(p * (values.size() - 1) + 0.5)];
+                };
+
+                writer.Member(
+                    "mean", std::accumulate(values.begin(), values.end(), 0.0) / values.size());
+                writer.Member("min", values.front());
+                writer.Member("median", percentile(0.5));
+                writer.Member("p95", percentile(0.95));
+                writer.Member("p99", percentile(0.99));
+                writer.Member("max", values.back());
+            }
+
+            writer.EndObject();
+        }
+
+        void WriteTimes(JsonWriter& writer, const char* key, const std::vector<double>& times)
+        {
+            writer.Key(key);
+            writer.BeginArray();
+
+            for (double time : times) {
+                writer.Value(time);
+            }
+
+            writer.EndArray();
+        }
+    }
+
+    bool FrameReport::Save(const std::string& filepath) const
+    {
+        JsonWriter writer;
+        writer.BeginObject();
+        writer.Member("renderer", Renderer);
+        writer.Member("version", Version);
+
+        writer.Key("arguments");
+        writer.BeginArray();
+
+        for (const std::string& argument : Arguments) {
+            writer.Value(argument);
+        }
+
+        writer.EndArray();
+
+        writer.Member("width", Width);
+        writer.Member("height", Height);
+        writer.Member("timestep", static_cast<double>(Timestep));
+        writer.Member("tick_step", static_cast<double>(TickStep));
+        writer.Member("frames", FrameTimes.size());
+        writer.Member("ticks", Ticks);
+        writer.Member("dropped_ticks", DroppedTicks);
+        writer.Member("missed_frames", MissedFrames);
+
+        WriteSummary(writer, "cpu_ms", CpuTimes);
+        WriteSummary(writer, "gpu_ms", GpuTimes);
+        WriteSummary(writer, "frame_ms", FrameTimes);
+        WriteSummary(writer, "latency_ms", Latencies);
+        WriteSummary(writer, "draw_calls", DrawCalls);
+        WriteSummary(writer, "program_switches", ProgramSwitches);
+        WriteSummary(writer, "state_changes", StateChanges);
+
+        writer.Key("memory");
+        writer.BeginObject();
+        writer.Member("peak_resident_kib", GetPeakMemory() / 1024);
+        writer.Member("texture_kib", TextureMemory / 1024);
+        writer.EndObject();
+
+        WriteTimes(writer, "cpu_times_ms", CpuTimes);
+        WriteTimes(writer, "gpu_times_ms", GpuTimes);
+        WriteTimes(writer, "frame_times_ms", FrameTimes);
+        WriteTimes(writer, "latency_times_ms", Latencies);
+
+        if (Profiler::Get().GetFrameCount() > 0) {
+            writer.Key("profile");
+            writer.BeginArray();
+
+            for (const Profiler::ScopeStats& scope : Profiler::Get().GetStats()) {
+                writer.BeginObject();
+                writer.Member("group", scope.Group);
+                writer.Member("name", scope.Name);
+                writer.Member("calls", scope.Calls);
+                writer.Member("mean_ms", scope.Mean);
+                writer.Member("max_ms", scope.Max);
+                writer.EndObject();
+            }
+
+            writer.EndArray();
+        }
+
+        if (!Checksums.empty()) {
+            writer.Member(
+                "checksum", FormatChecksum(Hash(
+                                Checksums.data(), Checksums.size() * sizeof(std::uint64_t))));
+
+            writer.Key("checksums");
+            writer.BeginArray();
+
+            for (std::uint64_t checksum : Checksums) {
+                writer.Value(FormatChecksum(checksum));
+            }
+
+            writer.EndArray();
+        }
+
+        writer.EndObject();
+
+        if (!writer.Save(filepath)) {
+            return false;
+        }
+
+        std::cout << "myst: wrote a report of " << FrameTimes.size() << " frames to \""
+                  << filepath << "\"" << std::endl;
+
+        return true;
+    }
+
+    std::size_t FrameReport::GetPeakMemory()
+    {
+#if defined(__linux__)
+        struct rusage usage;
+
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+            return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+        }
+#endif
+
+        return 0;
+    }
+}
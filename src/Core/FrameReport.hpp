@@ -0,0 +1,56 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Myst
+{
+    // What a run keeps of every frame, saved as JSON with a summary of each
+    // series and the profile, if one was taken. Frame times are from the
+    // start of a frame until its commands have been submitted, as "cpu", and
+    // until they have been executed, as "frame". GPU times are only measured
+    // headless.
+    struct FrameReport
+    {
+        std::string Renderer;
+        std::string Version;
+        std::vector<std::string> Arguments;
+
+        int Width{0};
+        int Height{0};
+        float Timestep{0.0f};
+        float TickStep{0.0f};
+
+        std::vector<double> CpuTimes;
+        std::vector<double> GpuTimes;
+        std::vector<double> FrameTimes;
+        // From reading input to presenting the frame it went into.
+        std::vector<double> Latencies;
+
+        std::vector<double> DrawCalls;
+        std::vector<double> ProgramSwitches;
+        std::vector<double> StateChanges;
+
+        std::vector<std::uint64_t> Checksums;
+
+        std::uint64_t Ticks{0};
+        std::uint64_t DroppedTicks{0};
+        std::uint64_t MissedFrames{0};
+
+        std::size_t TextureMemory{0};
+
+        bool Save(const std::string& filepath) const;
+
+        // Peak resident memory of the process, or zero where unknown.
+        static std::size_t GetPeakMemory();
+    };
+}
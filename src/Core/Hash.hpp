@@ -0,0 +1,42 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Myst
+{
+    constexpr std::uint64_t kHashSeed{0xcbf29ce484222325ull};
+
+    // 64-bit FNV-1a. It's not the fastest hash around, but it's stable across
+    // runs and platforms, which is what on-disk cache keys need.
+    inline std::uint64_t Hash(
+        const void* data, std::size_t size, std::uint64_t seed = kHashSeed)
+    {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        std::uint64_t hash{seed};
+
+        for (std::size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+
+        return hash;
+    }
+
+    inline std::uint64_t Hash(
+        const std::string& value, std::uint64_t seed = kHashSeed)
+    {
+        // Mix in the length so that concatenations of different strings don't
+        // collide ("ab" + "c" vs. "a" + "bc").
+        std::uint64_t size{value.size()};
+        return Hash(value.data(), value.size(), Hash(&size, sizeof(size), seed));
+    }
+}
@@ -0,0 +1,276 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Core/JobSystem.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include "Core/Profiler.hpp"
+
+namespace Myst
+{
+    namespace
+    {
+        // The system and deque of the worker running on this thread, if any.
+        thread_local const void* tSystem{nullptr};
+        thread_local std::size_t tWorker{0};
+    }
+
+    JobSystem::JobSystem(unsigned int threads)
+        : mMainThread(std::this_thread::get_id())
+    {
+        // Jobs nobody waits on, such as texture decodes, only run on workers,
+        // so there's always at least one.
+        if (threads == 0) {
+            threads = std::max(2u, std::thread::hardware_concurrency());
+        }
+
+        for (unsigned int i = 1; i < threads; ++i) {
+            mWorkers.push_back(std::make_unique<Worker>());
+        }
+
+        // Started once every deque exists, since they steal from each other.
+        for (std::size_t i = 0; i < mWorkers.size(); ++i) {
+            mWorkers[i]->Thread = std::thread(&JobSystem::RunWorker, this, i);
+        }
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            mStopping = true;
+        }
+
+        mWake.notify_all();
+
+        for (const auto& worker : mWorkers) {
+            worker->Thread.join();
+        }
+    }
+
+    void JobSystem::Run(std::function<void()> job, Counter* counter, Counter* after)
+    {
+        if (counter != nullptr) {
+            counter->mValue.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (after != nullptr) {
+            std::lock_guard<std::mutex> lock(after->mMutex);
+
+            // Finish() takes the same lock once the count drops to zero, so
+            // the continuation is either seen there or scheduled here.
+            if (!after->IsDone()) {
+                after->mContinuations.emplace_back(std::move(job), counter);
+                return;
+            }
+        }
+
+        Schedule({std::move(job), counter});
+    }
+
+    void JobSystem::Wait(Counter& counter)
+    {
+        while (!counter.IsDone()) {
+            // The counter may be waiting on GL work.
+            if (IsMainThread()) {
+                ExecuteMainThreadJobs();
+            }
+
+            if (!TryRunJob()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::ParallelFor(
+        std::size_t count, std::size_t grain,
+        const std::function<void(std::size_t, std::size_t)>& function)
+    {
+        if (count == 0) {
+            return;
+        }
+
+        // A few ranges per thread leaves room for stealing when they're
+        // uneven.
+        const std::size_t ranges = static_cast<std::size_t>(GetThreadCount()) * 4;
+        const std::size_t step = std::max({grain, std::size_t{1}, (count + ranges - 1) / ranges});
+
+        Counter counter;
+
+        for (std::size_t begin = step; begin < count; begin += step) {
+            const std::size_t end = std::min(count, begin + step);
+            Run([&function, begin, end]() { function(begin, end); }, &counter);
+        }
+
+        function(0, std::min(count, step));
+        Wait(counter);
+    }
+
+    void JobSystem::RunOnMainThread(std::function<void()> job, Counter* counter)
+    {
+        if (counter != nullptr) {
+            counter->mValue.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::lock_guard<std::mutex> lock(mMainMutex);
+        mMainJobs.push_back({std::move(job), counter});
+    }
+
+    void JobSystem::ExecuteMainThreadJobs()
+    {
+        MYST_PROFILE_SCOPE("JobSystem::ExecuteMainThreadJobs");
+
+        std::vector<Job> jobs;
+
+        {
+            std::lock_guard<std::mutex> lock(mMainMutex);
+            jobs.swap(mMainJobs);
+        }
+
+        for (Job& job : jobs) {
+            job.Function();
+            Finish(job.Signal);
+        }
+    }
+
+    void JobSystem::Schedule(Job job)
+    {
+        if (tSystem == this) {
+            Worker& worker = *mWorkers[tWorker];
+            std::lock_guard<std::mutex> lock(worker.Mutex);
+            worker.Jobs.push_back(std::move(job));
+        } else {
+            std::lock_guard<std::mutex> lock(mSharedMutex);
+            mShared.push_back(std::move(job));
+        }
+
+        mQueued.fetch_add(1, std::memory_order_release);
+
+        // Taking the lock orders this with a worker checking mQueued before
+        // it sleeps, so the wake-up can't be lost.
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+        }
+
+        mWake.notify_one();
+    }
+
+    bool JobSystem::TryRunJob()
+    {
+        Job job;
+
+        if (!TryTakeJob(job)) {
+            return false;
+        }
+
+        job.Function();
+        Finish(job.Signal);
+
+        return true;
+    }
+
+    bool JobSystem::TryTakeJob(Job& job)
+    {
+        if (mQueued.load(std::memory_order_acquire) == 0) {
+            return false;
+        }
+
+        const bool isWorker = tSystem == this;
+
+        // Newest first from our own deque, while it's still in cache.
+        if (isWorker) {
+            Worker& worker = *mWorkers[tWorker];
+            std::lock_guard<std::mutex> lock(worker.Mutex);
+
+            if (!worker.Jobs.empty()) {
+                job = std::move(worker.Jobs.back());
+                worker.Jobs.pop_back();
+                mQueued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mSharedMutex);
+
+            if (!mShared.empty()) {
+                job = std::move(mShared.front());
+                mShared.pop_front();
+                mQueued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        // Oldest first from everyone else's, which tend to be the largest.
+        const std::size_t first = isWorker ? tWorker + 1 : 0;
+
+        for (std::size_t i = 0; i < mWorkers.size(); ++i) {
+            Worker& victim = *mWorkers[(first + i) % mWorkers.size()];
+            std::lock_guard<std::mutex> lock(victim.Mutex);
+
+            if (!victim.Jobs.empty()) {
+                job = std::move(victim.Jobs.front());
+                victim.Jobs.pop_front();
+                mQueued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void JobSystem::Finish(Counter* counter)
+    {
+        if (counter == nullptr) {
+            return;
+        }
+
+        std::vector<std::pair<std::function<void()>, Counter*>> continuations;
+
+        // Lowered under the lock, so that a waiter can't destroy the counter
+        // before we're done with it.
+        {
+            std::lock_guard<std::mutex> lock(counter->mMutex);
+
+            if (counter->mValue.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                continuations.swap(counter->mContinuations);
+            }
+        }
+
+        for (auto& continuation : continuations) {
+            Schedule({std::move(continuation.first), continuation.second});
+        }
+    }
+
+    void JobSystem::RunWorker(std::size_t index)
+    {
+        tSystem = this;
+        tWorker = index;
+
+#if defined(MYST_PROFILING)
+        Profiler::Get().SetThreadName("Worker " + std::to_string(index + 1));
+#endif
+
+        while (true) {
+            if (TryRunJob()) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mSleepMutex);
+
+            mWake.wait(lock, [this]() {
+                return mStopping || mQueued.load(std::memory_order_acquire) > 0;
+            });
+
+            if (mStopping) {
+                return;
+            }
+        }
+    }
+}
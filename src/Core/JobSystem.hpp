@@ -0,0 +1,144 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Myst
+{
+    // A work-stealing job scheduler. Every worker owns a deque: it pushes and
+    // pops its own jobs at the back, while idle workers steal from the front
+    // of the others'. Jobs from other threads go through a shared queue.
+    //
+    // Completion is tracked with counters rather than a global wait: a job
+    // may signal a counter when it finishes, and may be held back until
+    // another counter reaches zero. Waiting on a counter runs other jobs in
+    // the meantime, so jobs can wait on jobs they spawn.
+    //
+    // Jobs must not touch GL; whatever needs the context goes through the
+    // main thread queue, drained once per frame by the thread that created
+    // the system.
+    class JobSystem
+    {
+    public:
+        class Counter
+        {
+        public:
+            Counter() = default;
+
+            // Waits for the job that lowered it to zero to let go of it.
+            ~Counter()
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+            }
+
+            Counter(const Counter&) = delete;
+            Counter& operator=(const Counter&) = delete;
+
+            bool IsDone() const
+            {
+                return mValue.load(std::memory_order_acquire) == 0;
+            }
+
+        private:
+            friend class JobSystem;
+
+            std::atomic<std::uint32_t> mValue{0};
+
+            // Jobs held back until the counter reaches zero.
+            std::mutex mMutex;
+            std::vector<std::pair<std::function<void()>, Counter*>> mContinuations;
+        };
+
+        // Threads that run jobs, counting the calling thread, which helps
+        // while it waits. Zero picks one per hardware thread, and at least
+        // two.
+        JobSystem(unsigned int threads = 0);
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        unsigned int GetThreadCount() const
+        {
+            return static_cast<unsigned int>(mWorkers.size()) + 1;
+        }
+
+        // Queues `job`, once `after` reaches zero if given. `counter` is
+        // raised now and lowered when the job has run.
+        void Run(
+            std::function<void()> job, Counter* counter = nullptr, Counter* after = nullptr);
+
+        // Runs other jobs until `counter` reaches zero.
+        void Wait(Counter& counter);
+
+        // Splits [0, count) into ranges of at least `grain` items and calls
+        // function(begin, end) for each, in parallel, returning when all are
+        // done.
+        void ParallelFor(
+            std::size_t count, std::size_t grain,
+            const std::function<void(std::size_t, std::size_t)>& function);
+
+        // Queues `job` for ExecuteMainThreadJobs(), from any thread.
+        void RunOnMainThread(std::function<void()> job, Counter* counter = nullptr);
+
+        // Runs the jobs queued for the main thread so far.
+        void ExecuteMainThreadJobs();
+
+    private:
+        struct Job
+        {
+            std::function<void()> Function;
+            Counter* Signal;
+        };
+
+        // Padded so that workers' locks don't share cache lines.
+        struct alignas(64) Worker
+        {
+            std::thread Thread;
+            std::mutex Mutex;
+            std::deque<Job> Jobs;
+        };
+
+        void Schedule(Job job);
+        bool TryRunJob();
+        bool TryTakeJob(Job& job);
+        void Finish(Counter* counter);
+        void RunWorker(std::size_t index);
+
+        bool IsMainThread() const
+        {
+            return std::this_thread::get_id() == mMainThread;
+        }
+
+    private:
+        std::vector<std::unique_ptr<Worker>> mWorkers;
+
+        std::mutex mSharedMutex;
+        std::deque<Job> mShared;
+
+        std::mutex mMainMutex;
+        std::vector<Job> mMainJobs;
+        std::thread::id mMainThread;
+
+        // Jobs queued but not taken yet, for workers to sleep on.
+        std::atomic<std::size_t> mQueued{0};
+        std::mutex mSleepMutex;
+        std::condition_variable mWake;
+        bool mStopping{false};
+    };
+}
@@ -0,0 +1,545 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Core/Json.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace Myst
+{
+    namespace
+    {
+        const JsonValue kNull{};
+
+        // Nesting deeper than this is treated as malformed rather than risking
+        // the stack.
+        constexpr int kMaxDepth{256};
+
+        void AppendUtf8(std::string& out, unsigned int codepoint)
+        {
+            if (codepoint < 0x80) {
+                out += static_cast<char>(codepoint);
+            } else if (codepoint < 0x800) {
+                out += static_cast<char>(0xc0 | (codepoint >> 6));
+                out += static_cast<char>(0x80 | (codepoint & 0x3f));
+            } else if (codepoint < 0x10000) {
+                out += static_cast<char>(0xe0 | (codepoint >> 12));
+                out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f));
+                out += static_cast<char>(0x80 | (codepoint & 0x3f));
+            } else {
+                out += static_cast<char>(0xf0 | (codepoint >> 18));
+                out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3f));
+                out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3f));
+                out += static_cast<char>(0x80 | (codepoint & 0x3f));
+            }
+        }
+    }
+
+    class JsonParser
+    {
+    public:
+        JsonParser(const char* data, std::size_t size)
+            : mCursor(data)
+            , mEnd(data + size)
+        {
+            // Nothing to do.
+        }
+
+        bool ParseDocument(JsonValue& out)
+        {
+            if (!ParseValue(out, 0)) {
+                return false;
+            }
+
+            SkipWhitespace();
+
+            return mCursor == mEnd;
+        }
+
+    private:
+        void SkipWhitespace()
+        {
+            while (mCursor < mEnd &&
+                   (*mCursor == ' ' || *mCursor == '\t' || *mCursor == '\n' ||
+                    *mCursor == '\r')) {
+                ++mCursor;
+            }
+        }
+
+        bool Consume(const char* literal)
+        {
+            std::size_t length = std::strlen(literal);
+
+            if (static_cast<std::size_t>(mEnd - mCursor) < length ||
+                std::strncmp(mCursor, literal, length) != 0) {
+                return false;
+            }
+
+            mCursor += length;
+            return true;
+        }
+
+        bool ParseValue(JsonValue& out, int depth)
+        {
+            SkipWhitespace();
+
+            if (mCursor == mEnd || depth > kMaxDepth) {
+                return false;
+            }
+
+            switch (*mCursor) {
+                case '{': return ParseObject(out, depth);
+                case '[': return ParseArray(out, depth);
+                case '"':
+                    out.mType = JsonValue::Type::String;
+                    return ParseString(out.mString);
+                case 't':
+                    out.mType = JsonValue::Type::Bool;
+                    out.mBool = true;
+                    return Consume("true");
+                case 'f':
+                    out.mType = JsonValue::Type::Bool;
+                    out.mBool = false;
+                    return Consume("false");
+                case 'n':
+                    out.mType = JsonValue::Type::Null;
+                    return Consume("null");
+                default: break;
+            }
+
+            return ParseNumber(out);
+        }
+
+        bool ParseNumber(JsonValue& out)
+        {
+            // strtod() needs a terminator, and numbers are short.
+            char buffer[64];
+            std::size_t length{0};
+
+            while (mCursor + length < mEnd && length + 1 < sizeof(buffer) &&
+                   std::strchr("+-0123456789.eE", mCursor[length]) != nullptr) {
+                buffer[length] = mCursor[length];
+                ++length;
+            }
+
+            buffer[length] = '\0';
+
+            char* end{nullptr};
+            out.mType = JsonValue::Type::Number;
+            out.mNumber = std::strtod(buffer, &end);
+
+            if (length == 0 || end != buffer + length) {
+                return false;
+            }
+
+            mCursor += length;
+            return true;
+        }
+
+        bool ParseHex(unsigned int& value)
+        {
+            if (mEnd - mCursor < 4) {
+                return false;
+            }
+
+            value = 0;
+
+            for (int i = 0; i < 4; ++i) {
+                char c = *mCursor++;
+                value <<= 4;
+
+                if (c >= '0' && c <= '9') {
+                    value |= static_cast<unsigned int>(c - '0');
+                } else if (c >= 'a' && c <= 'f') {
+                    value |= static_cast<unsigned int>(c - 'a' + 10);
+                } else if (c >= 'A' && c <= 'F') {
+                    value |= static_cast<unsigned int>(c - 'A' + 10);
+                } else {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        bool ParseString(std::string& out)
+        {
+            ++mCursor;
+
+            while (mCursor < mEnd && *mCursor != '"') {
+                char c = *mCursor++;
+
+                if (c != '\\') {
+                    out += c;
+                    continue;
+                }
+
+                if (mCursor == mEnd) {
+                    return false;
+                }
+
+                switch (*mCursor++) {
+                    case '"': out += '"'; break;
+                    case '\\': out += '\\'; break;
+                    case '/': out += '/'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'u': {
+                        unsigned int codepoint;
+
+                        if (!ParseHex(codepoint)) {
+                            return false;
+                        }
+
+                        // Surrogate pairs encode code points above the BMP.
+                        if (codepoint >= 0xd800 && codepoint < 0xdc00 &&
+                            Consume("\\u")) {
+                            unsigned int low;
+
+                            if (!ParseHex(low)) {
+                                return false;
+                            }
+
+                            codepoint = 0x10000 + ((codepoint - 0xd800) << 10) +
+                                        (low - 0xdc00);
+                        }
+
+                        AppendUtf8(out, codepoint);
+                        break;
+                    }
+                    default: return false;
+                }
+            }
+
+            if (mCursor == mEnd) {
+                return false;
+            }
+
+            ++mCursor;
+            return true;
+        }
+
+        bool ParseArray(JsonValue& out, int depth)
+        {
+            out.mType = JsonValue::Type::Array;
+            ++mCursor;
+            SkipWhitespace();
+
+            if (mCursor < mEnd && *mCursor == ']') {
+                ++mCursor;
+                return true;
+            }
+
+            while (true) {
+                out.mValues.emplace_back();
+
+                if (!ParseValue(out.mValues.back(), depth + 1)) {
+                    return false;
+                }
+
+                SkipWhitespace();
+
+                if (mCursor == mEnd) {
+                    return false;
+                }
+
+                char c = *mCursor++;
+
+                if (c == ']') {
+                    return true;
+                }
+
+                if (c != ',') {
+                    return false;
+                }
+            }
+        }
+
+        bool ParseObject(JsonValue& out, int depth)
+        {
+            out.mType = JsonValue::Type::Object;
+            ++mCursor;
+            SkipWhitespace();
+
+            if (mCursor < mEnd && *mCursor == '}') {
+                ++mCursor;
+                return true;
+            }
+
+            while (true) {
+                SkipWhitespace();
+
+                if (mCursor == mEnd || *mCursor != '"') {
+                    return false;
+                }
+
+                out.mKeys.emplace_back();
+                out.mValues.emplace_back();
+
+                if (!ParseString(out.mKeys.back())) {
+                    return false;
+                }
+
+                SkipWhitespace();
+
+                if (mCursor == mEnd || *mCursor++ != ':') {
+                    return false;
+                }
+
+                if (!ParseValue(out.mValues.back(), depth + 1)) {
+                    return false;
+                }
+
+                SkipWhitespace();
+
+                if (mCursor == mEnd) {
+                    return false;
+                }
+
+                char c = *mCursor++;
+
+                if (c == '}') {
+                    return true;
+                }
+
+                if (c != ',') {
+                    return false;
+                }
+            }
+        }
+
+    private:
+        const char* mCursor;
+        const char* mEnd;
+    };
+
+    bool JsonValue::Has(const std::string& key) const
+    {
+        for (const std::string& candidate : mKeys) {
+            if (candidate == key) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    const JsonValue& JsonValue::operator[](std::size_t index) const
+    {
+        if (mType != Type::Array || index >= mValues.size()) {
+            return kNull;
+        }
+
+        return mValues[index];
+    }
+
+    const JsonValue& JsonValue::operator[](const std::string& key) const
+    {
+        for (std::size_t i = 0; i < mKeys.size(); ++i) {
+            if (mKeys[i] == key) {
+                return mValues[i];
+            }
+        }
+
+        return kNull;
+    }
+
+    bool JsonValue::Parse(const char* data, std::size_t size, JsonValue& out)
+    {
+        out = JsonValue{};
+        JsonParser parser(data, size);
+
+        if (!parser.ParseDocument(out)) {
+            std::cerr << "myst: malformed JSON" << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    void JsonWriter::BeginObject()
+    {
+        BeginValue(true);
+        mOutput += '{';
+        mScopes.push_back({false, true, true});
+    }
+
+    void JsonWriter::EndObject()
+    {
+        const Scope scope = mScopes.back();
+        mScopes.pop_back();
+
+        if (!scope.Empty) {
+            NewLine();
+        }
+
+        mOutput += '}';
+    }
+
+    void JsonWriter::BeginArray()
+    {
+        BeginValue(true);
+        mOutput += '[';
+        mScopes.push_back({true, true, false});
+    }
+
+    void JsonWriter::EndArray()
+    {
+        const Scope scope = mScopes.back();
+        mScopes.pop_back();
+
+        if (scope.Multiline) {
+            NewLine();
+        }
+
+        mOutput += ']';
+    }
+
+    void JsonWriter::Key(const std::string& key)
+    {
+        Scope& scope = mScopes.back();
+
+        if (!scope.Empty) {
+            mOutput += ',';
+        }
+
+        scope.Empty = false;
+        NewLine();
+        WriteString(key);
+        mOutput += ": ";
+    }
+
+    void JsonWriter::Null()
+    {
+        BeginValue(false);
+        mOutput += "null";
+    }
+
+    void JsonWriter::Value(bool value)
+    {
+        BeginValue(false);
+        mOutput += value ? "true" : "false";
+    }
+
+    void JsonWriter::Value(double value)
+    {
+        if (!std::isfinite(value)) {
+            Null();
+            return;
+        }
+
+        // Enough digits for measurements, without the noise of a full
+        // round trip.
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.10g", value);
+
+        BeginValue(false);
+        mOutput += buffer;
+    }
+
+    void JsonWriter::Value(long long value)
+    {
+        BeginValue(false);
+        mOutput += std::to_string(value);
+    }
+
+    void JsonWriter::Value(unsigned long long value)
+    {
+        BeginValue(false);
+        mOutput += std::to_string(value);
+    }
+
+    void JsonWriter::Value(const std::string& value)
+    {
+        BeginValue(false);
+        WriteString(value);
+    }
+
+    void JsonWriter::Value(const char* value)
+    {
+        Value(std::string(value));
+    }
+
+    bool JsonWriter::Save(const std::string& filepath) const
+    {
+        std::ofstream ofs(filepath, std::ios::binary | std::ios::trunc);
+
+        if (ofs) {
+            ofs << mOutput << '\n';
+        }
+
+        if (!ofs) {
+            std::cerr << "myst: could not write \"" << filepath << "\"" << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    void JsonWriter::BeginValue(bool container)
+    {
+        // Object members were separated by Key() already.
+        if (mScopes.empty() || !mScopes.back().Array) {
+            return;
+        }
+
+        Scope& scope = mScopes.back();
+
+        if (!scope.Empty) {
+            mOutput += ',';
+        }
+
+        if (container) {
+            scope.Multiline = true;
+            NewLine();
+        } else if (!scope.Empty) {
+            mOutput += ' ';
+        }
+
+        scope.Empty = false;
+    }
+
+    void JsonWriter::NewLine()
+    {
+        mOutput += '\n';
+        mOutput.append(mScopes.size() * 2, ' ');
+    }
+
+    void JsonWriter::WriteString(const std::string& value)
+    {
+        mOutput += '"';
+
+        for (char c : value) {
+            switch (c) {
+                case '"': mOutput += "\\\""; break;
+                case '\\': mOutput += "\\\\"; break;
+                case '\n': mOutput += "\\n"; break;
+                case '\r': mOutput += "\\r"; break;
+                case '\t': mOutput += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char buffer[8];
+                        std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                        mOutput += buffer;
+                    } else {
+                        mOutput += c;
+                    }
+                    break;
+            }
+        }
+
+        mOutput += '"';
+    }
+}
@@ -0,0 +1,201 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Myst
+{
+    // A parsed JSON document. Lookups of missing keys or indices return a
+    // shared null value, so optional fields can be chained without checks.
+    class JsonValue
+    {
+    public:
+        enum class Type
+        {
+            Null,
+            Bool,
+            Number,
+            String,
+            Array,
+            Object,
+        };
+
+        JsonValue() = default;
+
+        Type GetType() const
+        {
+            return mType;
+        }
+
+        bool IsNull() const
+        {
+            return mType == Type::Null;
+        }
+
+        bool IsNumber() const
+        {
+            return mType == Type::Number;
+        }
+
+        bool IsString() const
+        {
+            return mType == Type::String;
+        }
+
+        bool IsArray() const
+        {
+            return mType == Type::Array;
+        }
+
+        bool IsObject() const
+        {
+            return mType == Type::Object;
+        }
+
+        bool AsBool(bool fallback = false) const
+        {
+            return mType == Type::Bool ? mBool : fallback;
+        }
+
+        double AsNumber(double fallback = 0.0) const
+        {
+            return mType == Type::Number ? mNumber : fallback;
+        }
+
+        // Numbers that aren't exactly an int, such as 1.5, 1e999 or 2^31,
+        // read as `fallback` too, so untrusted indices never get truncated.
+        int AsInt(int fallback = 0) const
+        {
+            if (mType != Type::Number || std::floor(mNumber) != mNumber ||
+                mNumber < static_cast<double>(INT_MIN) ||
+                mNumber > static_cast<double>(INT_MAX)) {
+                return fallback;
+            }
+
+            return static_cast<int>(mNumber);
+        }
+
+        const std::string& AsString() const
+        {
+            return mString;
+        }
+
+        // Elements of an array, or members of an object.
+        std::size_t GetSize() const
+        {
+            return mValues.size();
+        }
+
+        bool Has(const std::string& key) const;
+
+        const JsonValue& operator[](std::size_t index) const;
+        const JsonValue& operator[](const std::string& key) const;
+
+        // Negative indices, such as a missing index read with AsInt(-1), find
+        // nothing.
+        const JsonValue& operator[](int index) const
+        {
+            return (*this)[index < 0 ? GetSize() : static_cast<std::size_t>(index)];
+        }
+
+        const JsonValue& operator[](const char* key) const
+        {
+            return (*this)[std::string(key)];
+        }
+
+        // Object keys, in document order.
+        const std::vector<std::string>& GetKeys() const
+        {
+            return mKeys;
+        }
+
+        static bool Parse(const char* data, std::size_t size, JsonValue& out);
+
+    private:
+        friend class JsonParser;
+
+        Type mType{Type::Null};
+        bool mBool{false};
+        double mNumber{0.0};
+        std::string mString;
+
+        // Array elements, or object values matching `mKeys`.
+        std::vector<JsonValue> mValues;
+        std::vector<std::string> mKeys;
+    };
+
+    // Writes a JSON document front to back. Object members go on lines of
+    // their own; arrays stay on one line unless they hold objects or arrays.
+    // Non-finite numbers are written as null.
+    class JsonWriter
+    {
+    public:
+        const std::string& GetString() const
+        {
+            return mOutput;
+        }
+
+        void BeginObject();
+        void EndObject();
+        void BeginArray();
+        void EndArray();
+
+        // Names the next value, which must follow inside an object.
+        void Key(const std::string& key);
+
+        void Null();
+        void Value(bool value);
+        void Value(double value);
+        void Value(long long value);
+        void Value(unsigned long long value);
+        void Value(const std::string& value);
+        void Value(const char* value);
+
+        template <typename T>
+        std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value>
+        Value(T value)
+        {
+            if (std::is_signed<T>::value) {
+                Value(static_cast<long long>(value));
+            } else {
+                Value(static_cast<unsigned long long>(value));
+            }
+        }
+
+        template <typename T>
+        void Member(const std::string& key, const T& value)
+        {
+            Key(key);
+            Value(value);
+        }
+
+        bool Save(const std::string& filepath) const;
+
+    private:
+        struct Scope
+        {
+            bool Array;
+            bool Empty;
+            bool Multiline;
+        };
+
+        void BeginValue(bool container);
+        void NewLine();
+        void WriteString(const std::string& value);
+
+    private:
+        std::string mOutput;
+        std::vector<Scope> mScopes;
+    };
+}
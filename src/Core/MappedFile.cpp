@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Core/MappedFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Myst
+{
+    MappedFile::MappedFile()
+        : mData(nullptr)
+        , mSize(0)
+    {
+        // Nothing to do.
+    }
+
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+    bool MappedFile::Open(const std::string& filepath)
+    {
+        Close();
+
+        int fd = open(filepath.c_str(), O_RDONLY);
+
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat info;
+
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            close(fd);
+            return false;
+        }
+
+        void* data = mmap(
+            nullptr, static_cast<std::size_t>(info.st_size), PROT_READ,
+            MAP_PRIVATE, fd, 0);
+
+        // The mapping stays valid after the descriptor is closed.
+        close(fd);
+
+        if (data == MAP_FAILED) {
+            return false;
+        }
+
+        mData = static_cast<const unsigned char*>(data);
+        mSize = static_cast<std::size_t>(info.st_size);
+
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (mData != nullptr) {
+            munmap(const_cast<unsigned char*>(mData), mSize);
+        }
+
+        mData = nullptr;
+        mSize = 0;
+    }
+}
@@ -0,0 +1,48 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace Myst
+{
+    // A read-only memory mapping of an entire file. Pages are faulted in by the
+    // OS as they're touched, so nothing is copied up front.
+    class MappedFile
+    {
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool IsOpen() const
+        {
+            return mData != nullptr;
+        }
+
+        const unsigned char* GetData() const
+        {
+            return mData;
+        }
+
+        std::size_t GetSize() const
+        {
+            return mSize;
+        }
+
+        bool Open(const std::string& filepath);
+        void Close();
+
+    private:
+        const unsigned char* mData;
+        std::size_t mSize;
+    };
+}
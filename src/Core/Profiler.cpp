@@ -0,0 +1,250 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Core/Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <tuple>
+
+#include "Core/Json.hpp"
+
+namespace Myst
+{
+    namespace
+    {
+        thread_local void* tTrack{nullptr};
+    }
+
+    Profiler& Profiler::Get()
+    {
+        static Profiler profiler;
+
+        return profiler;
+    }
+
+    std::uint64_t Profiler::Now()
+    {
+        static const auto epoch = std::chrono::steady_clock::now();
+
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - epoch)
+                .count());
+    }
+
+    Profiler::Profiler()
+        : mEnabled(false)
+        , mCapturing(false)
+        , mFrames(0)
+    {
+        Now();
+    }
+
+    Profiler::Track& Profiler::GetThreadTrack()
+    {
+        if (!tTrack) {
+            std::lock_guard<std::mutex> lock(mTracksMutex);
+
+            mTracks.push_back(std::make_unique<Track>());
+            mTracks.back()->Name = "Thread " + std::to_string(mTracks.size());
+            mTracks.back()->Group = "CPU";
+            tTrack = mTracks.back().get();
+        }
+
+        return *static_cast<Track*>(tTrack);
+    }
+
+    void Profiler::SetThreadName(const std::string& name)
+    {
+        Track& track = GetThreadTrack();
+
+        std::lock_guard<std::mutex> lock(mTracksMutex);
+        track.Name = name;
+    }
+
+    std::uint32_t Profiler::AddTrack(const std::string& name, const std::string& group)
+    {
+        std::lock_guard<std::mutex> lock(mTracksMutex);
+
+        mTracks.push_back(std::make_unique<Track>());
+        mTracks.back()->Name = name;
+        mTracks.back()->Group = group;
+
+        return static_cast<std::uint32_t>(mTracks.size() - 1);
+    }
+
+    void Profiler::AddScope(const char* name, std::uint64_t start, std::uint64_t end)
+    {
+        Track& track = GetThreadTrack();
+
+        std::lock_guard<std::mutex> lock(track.Mutex);
+        track.Scopes.push_back({name, start, end, 0});
+    }
+
+    void Profiler::AddScope(
+        std::uint32_t track, const char* name, std::uint64_t start, std::uint64_t end)
+    {
+        Track* target;
+
+        {
+            std::lock_guard<std::mutex> lock(mTracksMutex);
+            target = mTracks[track].get();
+        }
+
+        std::lock_guard<std::mutex> lock(target->Mutex);
+        target->Scopes.push_back({name, start, end, track});
+    }
+
+    void Profiler::Collect()
+    {
+        mCollected.clear();
+
+        for (std::size_t i = 0; i < mTracks.size(); ++i) {
+            std::lock_guard<std::mutex> trackLock(mTracks[i]->Mutex);
+
+            for (Scope scope : mTracks[i]->Scopes) {
+                scope.Track = static_cast<std::uint32_t>(i);
+                mCollected.push_back(scope);
+            }
+
+            mTracks[i]->Scopes.clear();
+        }
+    }
+
+    void Profiler::EndFrame()
+    {
+        std::lock_guard<std::mutex> lock(mTracksMutex);
+
+        Collect();
+
+        const std::size_t slot = mFrames % kWindow;
+
+        for (auto& series : mSeries) {
+            series.second.Time[slot] = 0;
+            series.second.Calls[slot] = 0;
+        }
+
+        for (const Scope& scope : mCollected) {
+            Series& series = mSeries[{mTracks[scope.Track]->Group, scope.Name}];
+            series.Time[slot] += scope.End - scope.Start;
+            series.Calls[slot] += 1;
+        }
+
+        if (mCapturing) {
+            mTrace.insert(mTrace.end(), mCollected.begin(), mCollected.end());
+        }
+
+        ++mFrames;
+    }
+
+    void Profiler::Flush()
+    {
+        std::lock_guard<std::mutex> lock(mTracksMutex);
+
+        Collect();
+
+        if (mCapturing) {
+            mTrace.insert(mTrace.end(), mCollected.begin(), mCollected.end());
+        }
+    }
+
+    std::vector<Profiler::ScopeStats> Profiler::GetStats() const
+    {
+        std::vector<ScopeStats> stats;
+
+        const std::size_t frames = std::min(mFrames, kWindow);
+
+        if (frames == 0) {
+            return stats;
+        }
+
+        for (const auto& series : mSeries) {
+            std::uint64_t time{0};
+            std::uint64_t max{0};
+            std::uint64_t calls{0};
+
+            for (std::size_t i = 0; i < frames; ++i) {
+                time += series.second.Time[i];
+                max = std::max(max, series.second.Time[i]);
+                calls += series.second.Calls[i];
+            }
+
+            if (calls == 0) {
+                continue;
+            }
+
+            stats.push_back(
+                {series.first.first, series.first.second,
+                 static_cast<double>(calls) / static_cast<double>(frames),
+                 static_cast<double>(time) / static_cast<double>(frames) * 1e-6,
+                 static_cast<double>(max) * 1e-6});
+        }
+
+        std::sort(stats.begin(), stats.end(), [](const ScopeStats& a, const ScopeStats& b) {
+            return std::tie(a.Group, b.Mean) < std::tie(b.Group, a.Mean);
+        });
+
+        return stats;
+    }
+
+    bool Profiler::SaveTrace(const std::string& filepath) const
+    {
+        JsonWriter writer;
+
+        writer.BeginObject();
+        writer.Member("displayTimeUnit", "ms");
+        writer.Key("traceEvents");
+        writer.BeginArray();
+
+        {
+            std::lock_guard<std::mutex> lock(mTracksMutex);
+
+            for (std::size_t i = 0; i < mTracks.size(); ++i) {
+                writer.BeginObject();
+                writer.Member("name", "thread_name");
+                writer.Member("ph", "M");
+                writer.Member("pid", 1);
+                writer.Member("tid", i);
+                writer.Key("args");
+                writer.BeginObject();
+                writer.Member("name", mTracks[i]->Name);
+                writer.EndObject();
+                writer.EndObject();
+
+                // Keeps the GPU below the threads.
+                writer.BeginObject();
+                writer.Member("name", "thread_sort_index");
+                writer.Member("ph", "M");
+                writer.Member("pid", 1);
+                writer.Member("tid", i);
+                writer.Key("args");
+                writer.BeginObject();
+                writer.Member("sort_index", mTracks[i]->Group == "CPU" ? i : mTracks.size() + i);
+                writer.EndObject();
+                writer.EndObject();
+            }
+
+            for (const Scope& scope : mTrace) {
+                writer.BeginObject();
+                writer.Member("name", scope.Name);
+                writer.Member("cat", mTracks[scope.Track]->Group);
+                writer.Member("ph", "X");
+                writer.Member("ts", static_cast<double>(scope.Start) * 1e-3);
+                writer.Member("dur", static_cast<double>(scope.End - scope.Start) * 1e-3);
+                writer.Member("pid", 1);
+                writer.Member("tid", scope.Track);
+                writer.EndObject();
+            }
+        }
+
+        writer.EndArray();
+        writer.EndObject();
+
+        return writer.Save(filepath);
+    }
+}
@@ -0,0 +1,184 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Myst
+{
+    // Collects timed scopes from every thread, and from the GPU through
+    // GLGpuProfiler, on tracks of their own. Scopes are kept per frame to
+    // build rolling statistics, and for the whole run while capturing, to be
+    // saved as a Chrome trace (chrome://tracing, or ui.perfetto.dev).
+    //
+    // Each thread writes to its own track, so threads only ever contend with
+    // EndFrame() collecting what they recorded. Scope names are kept by
+    // pointer and must outlive the profiler: string literals, in practice.
+    //
+    // Scopes are placed with MYST_PROFILE_SCOPE(), which compiles to nothing
+    // unless MYST_PROFILING is defined, and costs an atomic load while the
+    // profiler is disabled.
+    class Profiler
+    {
+    public:
+        // Times are in milliseconds per frame, over the frames in the window.
+        struct ScopeStats
+        {
+            // The track's group: "CPU" for threads, "GPU" for the GPU.
+            std::string Group;
+            std::string Name;
+            double Calls;
+            double Mean;
+            double Max;
+        };
+
+        static constexpr std::size_t kWindow{120};
+
+        static Profiler& Get();
+
+        // Nanoseconds on a steady clock, from the first call.
+        static std::uint64_t Now();
+
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        bool IsEnabled() const
+        {
+            return mEnabled.load(std::memory_order_relaxed);
+        }
+
+        void SetEnabled(bool enabled)
+        {
+            mEnabled.store(enabled, std::memory_order_relaxed);
+        }
+
+        // Keeps every scope from the next EndFrame() on, for SaveTrace().
+        void SetCapturing(bool capturing)
+        {
+            mCapturing = capturing;
+        }
+
+        std::size_t GetFrameCount() const
+        {
+            return mFrames;
+        }
+
+        // Names the calling thread's track.
+        void SetThreadName(const std::string& name);
+
+        // Adds a track for scopes that don't run on a thread of their own.
+        std::uint32_t AddTrack(const std::string& name, const std::string& group);
+
+        // Records a scope that ran between `start` and `end`, as given by
+        // Now(), on the calling thread's track or on `track`.
+        void AddScope(const char* name, std::uint64_t start, std::uint64_t end);
+        void AddScope(std::uint32_t track, const char* name, std::uint64_t start, std::uint64_t end);
+
+        // Collects the scopes recorded since the last call into the
+        // statistics, and into the trace while capturing. Called once per
+        // frame by the main thread.
+        void EndFrame();
+
+        // Collects the scopes recorded since the last frame into the trace
+        // alone, for when there is no next frame.
+        void Flush();
+
+        // Sorted by group, then by mean time, longest first.
+        std::vector<ScopeStats> GetStats() const;
+
+        bool SaveTrace(const std::string& filepath) const;
+
+    private:
+        struct Scope
+        {
+            const char* Name;
+            std::uint64_t Start;
+            std::uint64_t End;
+            std::uint32_t Track;
+        };
+
+        struct Track
+        {
+            std::string Name;
+            std::string Group;
+
+            std::mutex Mutex;
+            std::vector<Scope> Scopes;
+        };
+
+        // One scope name's totals over the last kWindow frames.
+        struct Series
+        {
+            std::uint64_t Time[kWindow]{};
+            std::uint32_t Calls[kWindow]{};
+        };
+
+        Profiler();
+
+        Track& GetThreadTrack();
+
+        // Moves every track's scopes into mCollected.
+        void Collect();
+
+    private:
+        std::atomic<bool> mEnabled;
+        bool mCapturing;
+
+        mutable std::mutex mTracksMutex;
+        std::vector<std::unique_ptr<Track>> mTracks;
+
+        std::size_t mFrames;
+        std::map<std::pair<std::string, std::string>, Series> mSeries;
+
+        // Scopes collected for this frame, and for the trace.
+        std::vector<Scope> mCollected;
+        std::vector<Scope> mTrace;
+    };
+
+    class ProfileScope
+    {
+    public:
+        explicit ProfileScope(const char* name)
+            : mName(Profiler::Get().IsEnabled() ? name : nullptr)
+            , mStart(mName ? Profiler::Now() : 0)
+        {
+            // Nothing to do.
+        }
+
+        ~ProfileScope()
+        {
+            if (mName) {
+                Profiler::Get().AddScope(mName, mStart, Profiler::Now());
+            }
+        }
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        const char* mName;
+        std::uint64_t mStart;
+    };
+}
+
+#define MYST_PROFILE_CONCAT_(a, b) a##b
+#define MYST_PROFILE_CONCAT(a, b) MYST_PROFILE_CONCAT_(a, b)
+
+#if defined(MYST_PROFILING)
+#define MYST_PROFILE_SCOPE(name) \
+    ::Myst::ProfileScope MYST_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define MYST_PROFILE_SCOPE(name) static_cast<void>(0)
+#endif
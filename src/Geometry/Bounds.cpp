@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Geometry/Bounds.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#include <glm/gtc/packing.hpp>
+
+namespace Myst
+{
+    namespace
+    {
+        glm::vec3 ReadPosition(
+            const MeshData& mesh, const VertexElement& element, std::size_t index)
+        {
+            const unsigned char* data = mesh.GetVertex(index) + element.Offset;
+
+            switch (element.Format) {
+                case VertexFormat::Float3: {
+                    glm::vec3 position;
+                    std::memcpy(&position, data, sizeof(position));
+                    return position;
+                }
+                case VertexFormat::Half4: {
+                    std::uint64_t packed;
+                    std::memcpy(&packed, data, sizeof(packed));
+                    return glm::vec3(glm::unpackHalf4x16(packed));
+                }
+                case VertexFormat::Snorm16x4: {
+                    std::uint64_t packed;
+                    std::memcpy(&packed, data, sizeof(packed));
+
+                    const VertexDequantization& dequantization = mesh.Dequantization;
+                    return dequantization.PositionOffset +
+                           glm::vec3(glm::unpackSnorm4x16(packed)) *
+                               dequantization.PositionScale;
+                }
+                default: return glm::vec3(0.0f);
+            }
+        }
+    }
+
+    std::vector<glm::vec3> ReadPositions(const MeshData& mesh)
+    {
+        const VertexElement* position = mesh.Layout.Find(VertexAttribute::Position);
+        const std::size_t count = mesh.GetVertexCount();
+
+        if (position == nullptr) {
+            return {};
+        }
+
+        std::vector<glm::vec3> positions(count);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            positions[i] = ReadPosition(mesh, *position, i);
+        }
+
+        return positions;
+    }
+
+    BoundingBox ComputeBoundingBox(const MeshData& mesh)
+    {
+        const VertexElement* position = mesh.Layout.Find(VertexAttribute::Position);
+        const std::size_t count = mesh.GetVertexCount();
+
+        if (position == nullptr || count == 0) {
+            return {};
+        }
+
+        BoundingBox box{glm::vec3(1e30f), glm::vec3(-1e30f)};
+
+        for (std::size_t i = 0; i < count; ++i) {
+            glm::vec3 value = ReadPosition(mesh, *position, i);
+
+            box.Min = glm::min(box.Min, value);
+            box.Max = glm::max(box.Max, value);
+        }
+
+        return box;
+    }
+
+    BoundingSphere ComputeBoundingSphere(const MeshData& mesh)
+    {
+        const VertexElement* position = mesh.Layout.Find(VertexAttribute::Position);
+        const std::size_t count = mesh.GetVertexCount();
+
+        if (position == nullptr || count == 0) {
+            return {};
+        }
+
+        BoundingSphere sphere{ComputeBoundingBox(mesh).GetCenter(), 0.0f};
+
+        for (std::size_t i = 0; i < count; ++i) {
+            sphere.Radius = std::max(
+                sphere.Radius,
+                glm::length(ReadPosition(mesh, *position, i) - sphere.Center));
+        }
+
+        return sphere;
+    }
+}
@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Geometry/VertexLayout.hpp"
+
+namespace Myst
+{
+    struct BoundingSphere
+    {
+        glm::vec3 Center{0.0f};
+        float Radius{0.0f};
+    };
+
+    struct BoundingBox
+    {
+        glm::vec3 Min{0.0f};
+        glm::vec3 Max{0.0f};
+
+        glm::vec3 GetCenter() const
+        {
+            return (Min + Max) * 0.5f;
+        }
+
+        glm::vec3 GetExtents() const
+        {
+            return (Max - Min) * 0.5f;
+        }
+    };
+
+    // The sphere around `sphere` once transformed; non-uniform scales grow the
+    // radius by the largest axis.
+    inline BoundingSphere TransformBounds(
+        const BoundingSphere& sphere, const glm::mat4& transform)
+    {
+        float scale = std::max(
+            glm::length(glm::vec3(transform[0])),
+            std::max(
+                glm::length(glm::vec3(transform[1])),
+                glm::length(glm::vec3(transform[2]))));
+
+        return {glm::vec3(transform * glm::vec4(sphere.Center, 1.0f)), sphere.Radius * scale};
+    }
+
+    // The axis-aligned box around `box` once transformed.
+    inline BoundingBox TransformBounds(const BoundingBox& box, const glm::mat4& transform)
+    {
+        glm::mat3 absolute(transform);
+        absolute[0] = glm::abs(absolute[0]);
+        absolute[1] = glm::abs(absolute[1]);
+        absolute[2] = glm::abs(absolute[2]);
+
+        const glm::vec3 center = glm::vec3(transform * glm::vec4(box.GetCenter(), 1.0f));
+        const glm::vec3 extents = absolute * box.GetExtents();
+
+        return {center - extents, center + extents};
+    }
+
+    // The mesh's positions, dequantized if need be.
+    std::vector<glm::vec3> ReadPositions(const MeshData& mesh);
+
+    // Bounds of the mesh's positions, dequantized if need be.
+    BoundingBox ComputeBoundingBox(const MeshData& mesh);
+
+    // Centered on the bounding box, which is loose but stable under edits.
+    BoundingSphere ComputeBoundingSphere(const MeshData& mesh);
+}
@@ -0,0 +1,356 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Geometry/Bvh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Core/Profiler.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define MYST_BVH_X86 1
+#include <immintrin.h>
+#endif
+
+namespace Myst
+{
+    namespace
+    {
+        // The frustum planes broadcast once per cull, with the absolute
+        // normals that turn a box's extents into its projected radius.
+        struct CullPlanes
+        {
+#if defined(MYST_BVH_X86)
+            __m128 X[6], Y[6], Z[6], W[6];
+            __m128 AbsX[6], AbsY[6], AbsZ[6];
+#else
+            glm::vec4 Planes[6];
+#endif
+
+            explicit CullPlanes(const Frustum& frustum)
+            {
+                for (int i = 0; i < 6; ++i) {
+                    const glm::vec4& plane = frustum.Planes[i];
+#if defined(MYST_BVH_X86)
+                    X[i] = _mm_set1_ps(plane.x);
+                    Y[i] = _mm_set1_ps(plane.y);
+                    Z[i] = _mm_set1_ps(plane.z);
+                    W[i] = _mm_set1_ps(plane.w);
+                    AbsX[i] = _mm_set1_ps(std::abs(plane.x));
+                    AbsY[i] = _mm_set1_ps(std::abs(plane.y));
+                    AbsZ[i] = _mm_set1_ps(std::abs(plane.z));
+#else
+                    Planes[i] = plane;
+#endif
+                }
+            }
+        };
+
+        // Sets bit i of `outside` if child i is entirely outside a plane, and
+        // of `inside` if it's entirely inside all of them.
+        template <typename Node>
+        void TestNode(
+            const Node& node, const CullPlanes& planes, unsigned int& outside,
+            unsigned int& inside)
+        {
+#if defined(MYST_BVH_X86)
+            const __m128 half = _mm_set1_ps(0.5f);
+            const __m128 minX = _mm_load_ps(node.MinX);
+            const __m128 minY = _mm_load_ps(node.MinY);
+            const __m128 minZ = _mm_load_ps(node.MinZ);
+            const __m128 maxX = _mm_load_ps(node.MaxX);
+            const __m128 maxY = _mm_load_ps(node.MaxY);
+            const __m128 maxZ = _mm_load_ps(node.MaxZ);
+
+            const __m128 cx = _mm_mul_ps(_mm_add_ps(minX, maxX), half);
+            const __m128 cy = _mm_mul_ps(_mm_add_ps(minY, maxY), half);
+            const __m128 cz = _mm_mul_ps(_mm_add_ps(minZ, maxZ), half);
+            const __m128 ex = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+            const __m128 ey = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+            const __m128 ez = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+
+            __m128 out = _mm_setzero_ps();
+            __m128 in = _mm_cmpeq_ps(out, out);
+
+            for (int i = 0; i < 6; ++i) {
+                const __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(planes.X[i], cx), _mm_mul_ps(planes.Y[i], cy)),
+                    _mm_add_ps(_mm_mul_ps(planes.Z[i], cz), planes.W[i]));
+                const __m128 radius = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(planes.AbsX[i], ex), _mm_mul_ps(planes.AbsY[i], ey)),
+                    _mm_mul_ps(planes.AbsZ[i], ez));
+
+                out = _mm_or_ps(out, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+                in = _mm_and_ps(in, _mm_cmpge_ps(distance, radius));
+            }
+
+            outside = static_cast<unsigned int>(_mm_movemask_ps(out));
+            inside = static_cast<unsigned int>(_mm_movemask_ps(in));
+#else
+            outside = 0;
+            inside = 0;
+
+            for (unsigned int slot = 0; slot < 4; ++slot) {
+                const glm::vec3 min(node.MinX[slot], node.MinY[slot], node.MinZ[slot]);
+                const glm::vec3 max(node.MaxX[slot], node.MaxY[slot], node.MaxZ[slot]);
+                const glm::vec3 center = (min + max) * 0.5f;
+                const glm::vec3 extents = (max - min) * 0.5f;
+                bool isInside{true};
+
+                for (const glm::vec4& plane : planes.Planes) {
+                    const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+                    const float radius = glm::dot(glm::abs(glm::vec3(plane)), extents);
+
+                    if (distance + radius < 0.0f) {
+                        outside |= 1u << slot;
+                    }
+
+                    isInside = isInside && distance >= radius;
+                }
+
+                inside |= static_cast<unsigned int>(isInside) << slot;
+            }
+#endif
+        }
+
+        BoundingBox Merge(const BoundingBox& a, const BoundingBox& b)
+        {
+            return {glm::min(a.Min, b.Min), glm::max(a.Max, b.Max)};
+        }
+    }
+
+    void Bvh::Build(const std::vector<BoundingBox>& bounds)
+    {
+        const std::uint32_t count = static_cast<std::uint32_t>(bounds.size());
+
+        mBounds = bounds;
+        mNodes.clear();
+        mDirty.clear();
+        mDirtyFlags.clear();
+        mObjectNode.assign(count, 0);
+        mObjectSlot.assign(count, 0);
+        mOrder.resize(count);
+        mCentroids.resize(count);
+
+        for (std::uint32_t i = 0; i < count; ++i) {
+            mOrder[i] = i;
+            mCentroids[i] = bounds[i].GetCenter();
+        }
+
+        if (count > 0) {
+            // A four-wide tree over n objects has fewer than n / 3 nodes.
+            mNodes.reserve(count / 3 + 1);
+            BuildNode(0, count, -1, 0);
+        }
+
+        mDirtyFlags.assign(mNodes.size(), 0);
+        mCentroids.clear();
+        mCentroids.shrink_to_fit();
+    }
+
+    std::int32_t Bvh::BuildNode(
+        std::uint32_t first, std::uint32_t count, std::int32_t parent,
+        std::uint32_t parentSlot)
+    {
+        const std::int32_t index = static_cast<std::int32_t>(mNodes.size());
+
+        Node node;
+        node.First = first;
+        node.Count = count;
+        node.Parent = parent;
+        node.ParentSlot = parentSlot;
+
+        for (std::uint32_t slot = 0; slot < kWidth; ++slot) {
+            node.Children[slot] = kEmpty;
+            node.MinX[slot] = node.MinY[slot] = node.MinZ[slot] = 0.0f;
+            node.MaxX[slot] = node.MaxY[slot] = node.MaxZ[slot] = 0.0f;
+        }
+
+        mNodes.push_back(node);
+
+        // Split at the median of the centroids along the widest axis, twice,
+        // which gives up to four groups of about the same size.
+        std::uint32_t groups[kWidth + 1]{first, first, first, first, first + count};
+
+        auto split = [&](std::uint32_t begin, std::uint32_t end) {
+            glm::vec3 min(std::numeric_limits<float>::max());
+            glm::vec3 max(-std::numeric_limits<float>::max());
+
+            for (std::uint32_t i = begin; i < end; ++i) {
+                min = glm::min(min, mCentroids[mOrder[i]]);
+                max = glm::max(max, mCentroids[mOrder[i]]);
+            }
+
+            const glm::vec3 size = max - min;
+            const int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+            const std::uint32_t middle = begin + (end - begin) / 2;
+
+            std::nth_element(
+                mOrder.begin() + begin, mOrder.begin() + middle, mOrder.begin() + end,
+                [&](std::uint32_t a, std::uint32_t b) {
+                    return mCentroids[a][axis] < mCentroids[b][axis];
+                });
+
+            return middle;
+        };
+
+        std::uint32_t slots{0};
+
+        if (count <= kWidth) {
+            for (std::uint32_t i = 0; i < count; ++i) {
+                groups[i] = first + i;
+            }
+
+            groups[count] = first + count;
+            slots = count;
+        } else {
+            const std::uint32_t middle = split(first, first + count);
+
+            groups[1] = split(first, middle);
+            groups[2] = middle;
+            groups[3] = split(middle, first + count);
+            slots = kWidth;
+        }
+
+        for (std::uint32_t slot = 0; slot < slots; ++slot) {
+            const std::uint32_t begin = groups[slot];
+            const std::uint32_t size = groups[slot + 1] - begin;
+
+            if (size == 1) {
+                const std::uint32_t object = mOrder[begin];
+
+                mNodes[index].Children[slot] = ~static_cast<std::int32_t>(object);
+                mObjectNode[object] = static_cast<std::uint32_t>(index);
+                mObjectSlot[object] = static_cast<std::uint8_t>(slot);
+                SetSlot(mNodes[index], slot, mBounds[object]);
+            } else {
+                const std::int32_t child = BuildNode(begin, size, index, slot);
+
+                mNodes[index].Children[slot] = child;
+                SetSlot(mNodes[index], slot, GetNodeBounds(mNodes[child]));
+            }
+        }
+
+        return index;
+    }
+
+    void Bvh::SetSlot(Node& node, std::uint32_t slot, const BoundingBox& box)
+    {
+        node.MinX[slot] = box.Min.x;
+        node.MinY[slot] = box.Min.y;
+        node.MinZ[slot] = box.Min.z;
+        node.MaxX[slot] = box.Max.x;
+        node.MaxY[slot] = box.Max.y;
+        node.MaxZ[slot] = box.Max.z;
+    }
+
+    BoundingBox Bvh::GetNodeBounds(const Node& node) const
+    {
+        BoundingBox bounds{
+            glm::vec3(std::numeric_limits<float>::max()),
+            glm::vec3(-std::numeric_limits<float>::max())};
+
+        for (std::uint32_t slot = 0; slot < kWidth; ++slot) {
+            if (node.Children[slot] != kEmpty) {
+                bounds = Merge(
+                    bounds,
+                    {{node.MinX[slot], node.MinY[slot], node.MinZ[slot]},
+                     {node.MaxX[slot], node.MaxY[slot], node.MaxZ[slot]}});
+            }
+        }
+
+        return bounds;
+    }
+
+    void Bvh::MarkDirty(std::int32_t node)
+    {
+        if (mDirtyFlags[node] == 0) {
+            mDirtyFlags[node] = 1;
+            mDirty.push_back(node);
+            std::push_heap(mDirty.begin(), mDirty.end());
+        }
+    }
+
+    void Bvh::Update(std::uint32_t object, const BoundingBox& bounds)
+    {
+        mBounds[object] = bounds;
+
+        const std::int32_t node = static_cast<std::int32_t>(mObjectNode[object]);
+        SetSlot(mNodes[node], mObjectSlot[object], bounds);
+        MarkDirty(node);
+    }
+
+    void Bvh::Refit()
+    {
+        // Children always come after their parent, so popping the largest
+        // index first finishes a node's subtree before the node itself.
+        while (!mDirty.empty()) {
+            std::pop_heap(mDirty.begin(), mDirty.end());
+            const std::int32_t index = mDirty.back();
+            mDirty.pop_back();
+            mDirtyFlags[index] = 0;
+
+            const Node& node = mNodes[index];
+
+            if (node.Parent >= 0) {
+                SetSlot(mNodes[node.Parent], node.ParentSlot, GetNodeBounds(node));
+                MarkDirty(node.Parent);
+            }
+        }
+    }
+
+    void Bvh::Cull(const Frustum& frustum, std::vector<std::uint32_t>& visible)
+    {
+        MYST_PROFILE_SCOPE("Bvh::Cull");
+
+        const std::size_t visibleBefore = visible.size();
+        mStats = {};
+
+        if (mNodes.empty()) {
+            return;
+        }
+
+        const CullPlanes planes(frustum);
+
+        mStack.clear();
+        mStack.push_back(0);
+
+        while (!mStack.empty()) {
+            const Node& node = mNodes[mStack.back()];
+            mStack.pop_back();
+            ++mStats.NodesVisited;
+
+            unsigned int outside, inside;
+            TestNode(node, planes, outside, inside);
+
+            for (std::uint32_t slot = 0; slot < kWidth; ++slot) {
+                const std::int32_t child = node.Children[slot];
+
+                if (child == kEmpty || (outside & (1u << slot)) != 0) {
+                    continue;
+                }
+
+                if (child < 0) {
+                    visible.push_back(static_cast<std::uint32_t>(~child));
+                } else if ((inside & (1u << slot)) != 0) {
+                    // Everything below is visible too.
+                    const Node& accepted = mNodes[child];
+                    visible.insert(
+                        visible.end(), mOrder.begin() + accepted.First,
+                        mOrder.begin() + accepted.First + accepted.Count);
+                    ++mStats.NodesAccepted;
+                } else {
+                    mStack.push_back(child);
+                }
+            }
+        }
+
+        mStats.Visible = visible.size() - visibleBefore;
+    }
+}
@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Geometry/Bounds.hpp"
+#include "Geometry/Frustum.hpp"
+
+namespace Myst
+{
+    // A four-wide bounding volume hierarchy over object bounds. Each node
+    // keeps its children's boxes side by side, so culling tests all four
+    // against a plane with one SIMD operation. Children are either nodes or
+    // single objects, and every node covers a contiguous run of objects, so a
+    // node that's entirely inside the frustum is accepted without descending.
+    //
+    // Moving objects are handled by refitting: boxes grow or shrink along
+    // their path to the root, but the tree's shape stays. Rebuild when the
+    // objects have drifted far from where the tree was built.
+    class Bvh
+    {
+    public:
+        struct Stats
+        {
+            std::size_t NodesVisited;
+            std::size_t NodesAccepted;
+            std::size_t Visible;
+        };
+
+        std::size_t GetObjectCount() const
+        {
+            return mBounds.size();
+        }
+
+        std::size_t GetNodeCount() const
+        {
+            return mNodes.size();
+        }
+
+        const BoundingBox& GetBounds(std::uint32_t object) const
+        {
+            return mBounds[object];
+        }
+
+        // Statistics of the last Cull().
+        const Stats& GetStats() const
+        {
+            return mStats;
+        }
+
+        // Object i has bounds[i]. Replaces any previous tree.
+        void Build(const std::vector<BoundingBox>& bounds);
+
+        // Queues an object's new bounds for the next Refit().
+        void Update(std::uint32_t object, const BoundingBox& bounds);
+
+        // Propagates the updated bounds towards the root, touching only the
+        // nodes above updated objects.
+        void Refit();
+
+        // Appends the objects whose boxes intersect `frustum`, in no
+        // particular order.
+        void Cull(const Frustum& frustum, std::vector<std::uint32_t>& visible);
+
+    private:
+        static constexpr std::uint32_t kWidth{4};
+
+        // Child slots are node indices, or objects stored as ~index, or empty.
+        static constexpr std::int32_t kEmpty{INT32_MIN};
+
+        struct alignas(16) Node
+        {
+            float MinX[kWidth];
+            float MinY[kWidth];
+            float MinZ[kWidth];
+            float MaxX[kWidth];
+            float MaxY[kWidth];
+            float MaxZ[kWidth];
+            std::int32_t Children[kWidth];
+
+            // The node's run in mOrder.
+            std::uint32_t First;
+            std::uint32_t Count;
+
+            std::int32_t Parent;
+            std::uint32_t ParentSlot;
+        };
+
+        std::int32_t BuildNode(
+            std::uint32_t first, std::uint32_t count, std::int32_t parent,
+            std::uint32_t parentSlot);
+
+        void SetSlot(Node& node, std::uint32_t slot, const BoundingBox& box);
+        BoundingBox GetNodeBounds(const Node& node) const;
+
+        void MarkDirty(std::int32_t node);
+
+    private:
+        std::vector<Node> mNodes;
+        std::vector<BoundingBox> mBounds;
+
+        // Objects in tree order, and where each is referenced.
+        std::vector<std::uint32_t> mOrder;
+        std::vector<std::uint32_t> mObjectNode;
+        std::vector<std::uint8_t> mObjectSlot;
+
+        // Nodes waiting for Refit(), as a max-heap so children come before
+        // their parents, and centroids while building.
+        std::vector<std::int32_t> mDirty;
+        std::vector<std::uint8_t> mDirtyFlags;
+        std::vector<glm::vec3> mCentroids;
+
+        std::vector<std::int32_t> mStack;
+
+        Stats mStats;
+    };
+}
@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "Geometry/Bounds.hpp"
+
+namespace Myst
+{
+    // The six clip planes of a view-projection matrix, pointing inwards and
+    // normalized, so a plane's dot product is a signed distance.
+    struct Frustum
+    {
+        enum Plane
+        {
+            Left,
+            Right,
+            Bottom,
+            Top,
+            Near,
+            Far,
+        };
+
+        glm::vec4 Planes[6];
+
+        static Frustum FromMatrix(const glm::mat4& viewProjection)
+        {
+            // Gribb and Hartmann: each plane is the fourth row plus or minus
+            // one of the others. GL clip space spans -w..w on all three axes.
+            glm::mat4 m = glm::transpose(viewProjection);
+            Frustum frustum;
+
+            frustum.Planes[Left] = m[3] + m[0];
+            frustum.Planes[Right] = m[3] - m[0];
+            frustum.Planes[Bottom] = m[3] + m[1];
+            frustum.Planes[Top] = m[3] - m[1];
+            frustum.Planes[Near] = m[3] + m[2];
+            frustum.Planes[Far] = m[3] - m[2];
+
+            for (glm::vec4& plane : frustum.Planes) {
+                plane /= glm::length(glm::vec3(plane));
+            }
+
+            return frustum;
+        }
+
+        bool Intersects(const BoundingSphere& sphere) const
+        {
+            for (const glm::vec4& plane : Planes) {
+                if (glm::dot(glm::vec3(plane), sphere.Center) + plane.w < -sphere.Radius) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        bool Intersects(const BoundingBox& box) const
+        {
+            glm::vec3 center = box.GetCenter();
+            glm::vec3 extents = box.GetExtents();
+
+            for (const glm::vec4& plane : Planes) {
+                float radius = glm::dot(extents, glm::abs(glm::vec3(plane)));
+
+                if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    };
+}
@@ -0,0 +1,476 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Core/Json.hpp"
+#include "Geometry/MeshOptimizer.hpp"
+#include "Geometry/Model.hpp"
+
+namespace Myst
+{
+    namespace
+    {
+        constexpr std::uint32_t kGlbMagic{0x46546c67};  // "glTF"
+        constexpr std::uint32_t kJsonChunk{0x4e4f534a}; // "JSON"
+        constexpr std::uint32_t kBinChunk{0x004e4942};  // "BIN\0"
+
+        constexpr int kUnsignedByte{5121};
+        constexpr int kUnsignedShort{5123};
+        constexpr int kUnsignedInt{5125};
+        constexpr int kFloat{5126};
+
+        constexpr int kTriangles{4};
+
+        // Node hierarchies deeper than this are assumed to be cyclic.
+        constexpr int kMaxNodeDepth{64};
+
+        // A validated window onto an accessor's elements in the BIN chunk.
+        struct AccessorView
+        {
+            const unsigned char* Data{nullptr};
+            std::size_t Count{0};
+            std::size_t Stride{0};
+            int ComponentType{0};
+            bool Normalized{false};
+
+            bool IsValid() const
+            {
+                return Data != nullptr;
+            }
+        };
+
+        struct Primitive
+        {
+            std::size_t Mesh;
+            std::string Name;
+            std::string Material;
+            AccessorView Positions;
+            AccessorView Normals;
+            AccessorView TexCoords;
+            AccessorView Indices;
+        };
+
+        std::uint32_t ReadU32(const unsigned char* data)
+        {
+            std::uint32_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        int GetComponentCount(const std::string& type)
+        {
+            if (type == "SCALAR") return 1;
+            if (type == "VEC2") return 2;
+            if (type == "VEC3") return 3;
+            if (type == "VEC4") return 4;
+
+            return 0;
+        }
+
+        std::size_t GetComponentSize(int componentType)
+        {
+            switch (componentType) {
+                case 5120:
+                case kUnsignedByte: return 1;
+                case 5122:
+                case kUnsignedShort: return 2;
+                case kUnsignedInt:
+                case kFloat: return 4;
+                default: return 0;
+            }
+        }
+
+        // Reads a byte offset, length, stride or count, which when missing
+        // is `fallback`. Negative, fractional or huge numbers are rejected,
+        // the last before they reach 2^53 and stop being exact.
+        bool GetSize(const JsonValue& value, std::size_t fallback, std::size_t& out)
+        {
+            if (value.IsNull()) {
+                out = fallback;
+                return true;
+            }
+
+            const double number = value.AsNumber(-1.0);
+
+            if (number < 0.0 || number >= 9007199254740992.0 ||
+                std::floor(number) != number) {
+                return false;
+            }
+
+            out = static_cast<std::size_t>(number);
+            return true;
+        }
+
+        // Checks that the accessor is `components` wide and lies within the
+        // binary chunk. Embedded or external buffers aren't supported.
+        bool GetAccessorView(
+            const JsonValue& document,
+            const JsonValue& index,
+            int components,
+            const unsigned char* binary,
+            std::size_t binarySize,
+            AccessorView& view)
+        {
+            const JsonValue& accessor = document["accessors"][index.AsInt(-1)];
+
+            if (!accessor.IsObject() || accessor.Has("sparse")) {
+                return false;
+            }
+
+            const JsonValue& bufferView =
+                document["bufferViews"][accessor["bufferView"].AsInt(-1)];
+
+            if (!bufferView.IsObject() || bufferView["buffer"].AsInt(-1) != 0 ||
+                GetComponentCount(accessor["type"].AsString()) != components) {
+                return false;
+            }
+
+            int componentType = accessor["componentType"].AsInt();
+            std::size_t elementSize = GetComponentSize(componentType) * components;
+            std::size_t stride;
+            std::size_t count;
+            std::size_t viewOffset;
+            std::size_t viewLength;
+            std::size_t accessorOffset;
+
+            if (!GetSize(bufferView["byteStride"], elementSize, stride) ||
+                !GetSize(accessor["count"], 0, count) ||
+                !GetSize(bufferView["byteOffset"], 0, viewOffset) ||
+                !GetSize(bufferView["byteLength"], 0, viewLength) ||
+                !GetSize(accessor["byteOffset"], 0, accessorOffset)) {
+                return false;
+            }
+
+            // Written so nothing can overflow: the last element needs only
+            // its own size, not a whole stride.
+            if (elementSize == 0 || count == 0 || stride < elementSize ||
+                viewOffset > binarySize || viewLength > binarySize - viewOffset ||
+                accessorOffset > viewLength ||
+                elementSize > viewLength - accessorOffset ||
+                count - 1 > (viewLength - accessorOffset - elementSize) / stride) {
+                return false;
+            }
+
+            view.Data = binary + viewOffset + accessorOffset;
+            view.Count = count;
+            view.Stride = stride;
+            view.ComponentType = componentType;
+            view.Normalized = accessor["normalized"].AsBool();
+
+            return true;
+        }
+
+        float ReadComponent(const AccessorView& view, std::size_t element, int component)
+        {
+            const unsigned char* data = view.Data + element * view.Stride;
+
+            switch (view.ComponentType) {
+                case kFloat: {
+                    float value;
+                    std::memcpy(&value, data + component * 4, sizeof(value));
+                    return value;
+                }
+                case kUnsignedShort: {
+                    std::uint16_t value;
+                    std::memcpy(&value, data + component * 2, sizeof(value));
+                    return view.Normalized ? value / 65535.0f : value;
+                }
+                case kUnsignedByte: {
+                    std::uint8_t value = data[component];
+                    return view.Normalized ? value / 255.0f : value;
+                }
+                default: return 0.0f;
+            }
+        }
+
+        void BuildMesh(const Primitive& primitive, const ModelLoadOptions& options, ModelMesh& mesh)
+        {
+            const std::size_t count = primitive.Positions.Count;
+
+            mesh.Data.Layout = GetModelLayout();
+            mesh.Data.Vertices.resize(count * 32);
+
+            unsigned char* out = mesh.Data.Vertices.data();
+
+            for (std::size_t i = 0; i < count; ++i) {
+                float values[8] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+                std::memcpy(
+                    values, primitive.Positions.Data + i * primitive.Positions.Stride,
+                    sizeof(float) * 3);
+
+                if (primitive.Normals.IsValid()) {
+                    std::memcpy(
+                        values + 3, primitive.Normals.Data + i * primitive.Normals.Stride,
+                        sizeof(float) * 3);
+                }
+
+                // glTF puts the texture origin at the top left.
+                if (primitive.TexCoords.IsValid()) {
+                    values[6] = ReadComponent(primitive.TexCoords, i, 0);
+                    values[7] = 1.0f - ReadComponent(primitive.TexCoords, i, 1);
+                }
+
+                std::memcpy(out + i * sizeof(values), values, sizeof(values));
+            }
+
+            const AccessorView& indices = primitive.Indices;
+
+            if (indices.IsValid()) {
+                mesh.Data.Indices.resize(indices.Count - indices.Count % 3);
+
+                for (std::size_t i = 0; i < mesh.Data.Indices.size(); ++i) {
+                    const unsigned char* data = indices.Data + i * indices.Stride;
+                    std::uint32_t index;
+
+                    if (indices.ComponentType == kUnsignedInt) {
+                        std::memcpy(&index, data, sizeof(index));
+                    } else if (indices.ComponentType == kUnsignedShort) {
+                        std::uint16_t value;
+                        std::memcpy(&value, data, sizeof(value));
+                        index = value;
+                    } else {
+                        index = data[0];
+                    }
+
+                    // Out of range indices collapse the triangle instead of
+                    // reading past the vertices.
+                    mesh.Data.Indices[i] = index < count ? index : 0;
+                }
+            } else {
+                mesh.Data.Indices.resize(count - count % 3);
+
+                for (std::size_t i = 0; i < mesh.Data.Indices.size(); ++i) {
+                    mesh.Data.Indices[i] = static_cast<std::uint32_t>(i);
+                }
+            }
+
+            if (!primitive.Normals.IsValid()) {
+                GenerateNormals(mesh.Data);
+            }
+
+            if (options.Optimize) {
+                OptimizeMesh(mesh.Data);
+            }
+        }
+
+        glm::mat4 GetNodeTransform(const JsonValue& node)
+        {
+            const JsonValue& matrix = node["matrix"];
+
+            if (matrix.GetSize() == 16) {
+                glm::mat4 result;
+
+                for (int i = 0; i < 16; ++i) {
+                    result[i / 4][i % 4] = static_cast<float>(matrix[i].AsNumber());
+                }
+
+                return result;
+            }
+
+            const JsonValue& t = node["translation"];
+            const JsonValue& r = node["rotation"];
+            const JsonValue& s = node["scale"];
+
+            glm::vec3 translation(
+                t[0].AsNumber(0.0), t[1].AsNumber(0.0), t[2].AsNumber(0.0));
+            glm::quat rotation(
+                static_cast<float>(r[3].AsNumber(1.0)), static_cast<float>(r[0].AsNumber(0.0)),
+                static_cast<float>(r[1].AsNumber(0.0)), static_cast<float>(r[2].AsNumber(0.0)));
+            glm::vec3 scale(s[0].AsNumber(1.0), s[1].AsNumber(1.0), s[2].AsNumber(1.0));
+
+            return glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) *
+                   glm::scale(glm::mat4(1.0f), scale);
+        }
+
+        void AddNodeInstances(
+            const JsonValue& document,
+            const JsonValue& index,
+            const glm::mat4& parent,
+            const std::vector<std::vector<std::size_t>>& meshPrimitives,
+            int depth,
+            Model& model)
+        {
+            const JsonValue& node = document["nodes"][index.AsInt(-1)];
+
+            if (!node.IsObject() || depth > kMaxNodeDepth) {
+                return;
+            }
+
+            glm::mat4 transform = parent * GetNodeTransform(node);
+            int mesh = node["mesh"].AsInt(-1);
+
+            if (mesh >= 0 && static_cast<std::size_t>(mesh) < meshPrimitives.size()) {
+                for (std::size_t primitive : meshPrimitives[mesh]) {
+                    model.Instances.push_back({primitive, transform});
+                }
+            }
+
+            const JsonValue& children = node["children"];
+
+            for (std::size_t i = 0; i < children.GetSize(); ++i) {
+                AddNodeInstances(
+                    document, children[i], transform, meshPrimitives, depth + 1, model);
+            }
+        }
+    }
+
+    bool LoadGlb(
+        const unsigned char* data,
+        std::size_t size,
+        JobSystem& jobs,
+        Model& model,
+        const ModelLoadOptions& options)
+    {
+        if (size < 20 || ReadU32(data) != kGlbMagic || ReadU32(data + 4) != 2) {
+            std::cerr << "myst: not a glTF 2.0 binary" << std::endl;
+            return false;
+        }
+
+        const char* json{nullptr};
+        std::size_t jsonSize{0};
+        const unsigned char* binary{nullptr};
+        std::size_t binarySize{0};
+
+        size = std::min<std::size_t>(size, ReadU32(data + 8));
+
+        for (std::size_t offset = 12; offset + 8 <= size;) {
+            std::size_t length = ReadU32(data + offset);
+            std::uint32_t type = ReadU32(data + offset + 4);
+
+            if (length > size - offset - 8) {
+                break;
+            }
+
+            if (type == kJsonChunk && json == nullptr) {
+                json = reinterpret_cast<const char*>(data + offset + 8);
+                jsonSize = length;
+            } else if (type == kBinChunk && binary == nullptr) {
+                binary = data + offset + 8;
+                binarySize = length;
+            }
+
+            offset += 8 + length;
+        }
+
+        JsonValue document;
+
+        if (json == nullptr || !JsonValue::Parse(json, jsonSize, document)) {
+            std::cerr << "myst: missing or invalid glTF JSON chunk" << std::endl;
+            return false;
+        }
+
+        // Validate everything up front, so the tasks can't fail.
+        std::vector<Primitive> primitives;
+        std::vector<std::vector<std::size_t>> meshPrimitives;
+        const JsonValue& meshes = document["meshes"];
+        const std::size_t firstMesh = model.Meshes.size();
+
+        for (std::size_t i = 0; i < meshes.GetSize(); ++i) {
+            const JsonValue& gltfMesh = meshes[i];
+            const JsonValue& gltfPrimitives = gltfMesh["primitives"];
+
+            meshPrimitives.emplace_back();
+
+            for (std::size_t j = 0; j < gltfPrimitives.GetSize(); ++j) {
+                const JsonValue& gltfPrimitive = gltfPrimitives[j];
+                const JsonValue& attributes = gltfPrimitive["attributes"];
+                Primitive primitive{};
+
+                const JsonValue& mode = gltfPrimitive["mode"];
+
+                if ((!mode.IsNull() && mode.AsInt(-1) != kTriangles) ||
+                    !GetAccessorView(
+                        document, attributes["POSITION"], 3, binary, binarySize,
+                        primitive.Positions) ||
+                    primitive.Positions.ComponentType != kFloat) {
+                    std::cerr << "myst: skipping unsupported glTF primitive "
+                              << gltfMesh["name"].AsString() << "[" << j << "]"
+                              << std::endl;
+                    continue;
+                }
+
+                if (GetAccessorView(
+                        document, attributes["NORMAL"], 3, binary, binarySize,
+                        primitive.Normals) &&
+                    (primitive.Normals.ComponentType != kFloat ||
+                     primitive.Normals.Count != primitive.Positions.Count)) {
+                    primitive.Normals = {};
+                }
+
+                if (GetAccessorView(
+                        document, attributes["TEXCOORD_0"], 2, binary, binarySize,
+                        primitive.TexCoords) &&
+                    primitive.TexCoords.Count != primitive.Positions.Count) {
+                    primitive.TexCoords = {};
+                }
+
+                if (gltfPrimitive.Has("indices") &&
+                    !GetAccessorView(
+                        document, gltfPrimitive["indices"], 1, binary, binarySize,
+                        primitive.Indices)) {
+                    std::cerr << "myst: invalid glTF index accessor" << std::endl;
+                    return false;
+                }
+
+                primitive.Mesh = firstMesh + primitives.size();
+                primitive.Name = gltfMesh["name"].AsString();
+                primitive.Material = std::to_string(gltfPrimitive["material"].AsInt(-1));
+                meshPrimitives.back().push_back(primitive.Mesh);
+                primitives.push_back(primitive);
+            }
+        }
+
+        model.Meshes.resize(firstMesh + primitives.size());
+
+        JobSystem::Counter built;
+
+        for (const Primitive& primitive : primitives) {
+            ModelMesh& mesh = model.Meshes[primitive.Mesh];
+            mesh.Name = primitive.Name;
+            mesh.Material = primitive.Material;
+
+            jobs.Run(
+                [&primitive, &options, &mesh]() { BuildMesh(primitive, options, mesh); },
+                &built);
+        }
+
+        // Instances come from the default scene's node hierarchy, or one per
+        // mesh when the file has no scenes.
+        const JsonValue& sceneIndex = document["scene"];
+        const JsonValue& scene =
+            document["scenes"][sceneIndex.IsNull() ? 0 : sceneIndex.AsInt(-1)];
+
+        if (scene.IsObject()) {
+            const JsonValue& nodes = scene["nodes"];
+
+            for (std::size_t i = 0; i < nodes.GetSize(); ++i) {
+                AddNodeInstances(
+                    document, nodes[i], glm::mat4(1.0f), meshPrimitives, 0, model);
+            }
+        } else {
+            for (const Primitive& primitive : primitives) {
+                model.Instances.push_back({primitive.Mesh, glm::mat4(1.0f)});
+            }
+        }
+
+        jobs.Wait(built);
+
+        return true;
+    }
+}
@@ -0,0 +1,506 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Geometry/MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <numeric>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include "Core/Hash.hpp"
+
+namespace Myst
+{
+    namespace
+    {
+        constexpr std::uint32_t kInvalid{~0u};
+
+        // Tuning from Forsyth's original write-up.
+        constexpr int kForsythCacheSize{32};
+        constexpr float kCacheDecayPower{1.5f};
+        constexpr float kLastTriangleScore{0.75f};
+        constexpr float kValenceBoostScale{2.0f};
+        constexpr float kValenceBoostPower{0.5f};
+
+        // Clusters smaller than this aren't worth sorting separately.
+        constexpr std::size_t kMinClusterTriangles{16};
+
+        float GetVertexScore(int cachePosition, std::uint32_t remaining)
+        {
+            if (remaining == 0) {
+                return -1.0f;
+            }
+
+            float score{0.0f};
+
+            if (cachePosition >= 0) {
+                if (cachePosition < 3) {
+                    // The triangle that was just added; using it again right
+                    // away is a little worse than the next few entries.
+                    score = kLastTriangleScore;
+                } else {
+                    float scale = 1.0f / (kForsythCacheSize - 3);
+                    score = std::pow(
+                        1.0f - (cachePosition - 3) * scale, kCacheDecayPower);
+                }
+            }
+
+            // Favour vertices with few triangles left, so they're finished
+            // off instead of lingering.
+            return score + kValenceBoostScale *
+                               std::pow(static_cast<float>(remaining),
+                                        -kValenceBoostPower);
+        }
+
+        std::vector<std::uint32_t> GetIdentityIndices(std::size_t count)
+        {
+            std::vector<std::uint32_t> indices(count);
+            std::iota(indices.begin(), indices.end(), 0u);
+
+            return indices;
+        }
+
+        glm::vec3 GetPosition(const MeshData& mesh, std::uint32_t index)
+        {
+            const VertexElement* element = mesh.Layout.Find(VertexAttribute::Position);
+            glm::vec3 position{0.0f};
+
+            std::memcpy(
+                &position, mesh.GetVertex(index) + element->Offset,
+                sizeof(position));
+
+            return position;
+        }
+
+        // A FIFO post-transform cache. Entries are timestamps, so it never has
+        // to be searched or cleared.
+        class FifoCache
+        {
+        public:
+            FifoCache(std::size_t vertexCount, unsigned int size)
+                : mTimestamps(vertexCount, 0)
+                , mTime(size + 1)
+                , mSize(size)
+            {
+                // Nothing to do.
+            }
+
+            // Returns whether the vertex had to be transformed.
+            bool Access(std::uint32_t vertex)
+            {
+                if (mTime - mTimestamps[vertex] > mSize) {
+                    mTimestamps[vertex] = mTime++;
+                    return true;
+                }
+
+                return false;
+            }
+
+            void Flush()
+            {
+                mTime += mSize + 1;
+            }
+
+        private:
+            std::vector<std::uint32_t> mTimestamps;
+            std::uint32_t mTime;
+            std::uint32_t mSize;
+        };
+    }
+
+    void MeshOptimizationReport::Print(
+        const std::string& name, std::ostream& out) const
+    {
+        out << "myst: " << name << ": " << VerticesBefore << " -> "
+            << VerticesAfter << " vertices, " << Triangles << " triangles, ACMR "
+            << std::fixed << std::setprecision(2) << Before.ACMR << " -> "
+            << After.ACMR << ", ATVR " << Before.ATVR << " -> " << After.ATVR
+            << std::defaultfloat << std::endl;
+    }
+
+    VertexCacheStats AnalyzeVertexCache(
+        const std::vector<std::uint32_t>& indices,
+        std::size_t vertexCount,
+        unsigned int cacheSize)
+    {
+        FifoCache cache(vertexCount, cacheSize);
+        std::vector<bool> used(vertexCount, false);
+        std::size_t misses{0};
+        std::size_t unique{0};
+
+        for (std::uint32_t index : indices) {
+            misses += cache.Access(index) ? 1 : 0;
+
+            if (!used[index]) {
+                used[index] = true;
+                ++unique;
+            }
+        }
+
+        std::size_t triangles = indices.size() / 3;
+
+        return {
+            triangles == 0 ? 0.0f : static_cast<float>(misses) / triangles,
+            unique == 0 ? 0.0f : static_cast<float>(misses) / unique,
+        };
+    }
+
+    void WeldVertices(MeshData& mesh)
+    {
+        const std::size_t stride = mesh.Layout.GetStride();
+        const std::size_t count = mesh.GetVertexCount();
+
+        if (mesh.Indices.empty()) {
+            mesh.Indices = GetIdentityIndices(count);
+        }
+
+        std::unordered_multimap<std::uint64_t, std::uint32_t> lookup;
+        std::vector<std::uint32_t> remap(count, kInvalid);
+        std::vector<unsigned char> vertices;
+
+        lookup.reserve(count);
+        vertices.reserve(mesh.Vertices.size());
+
+        for (std::size_t i = 0; i < count; ++i) {
+            const unsigned char* vertex = mesh.GetVertex(i);
+            std::uint64_t key = Hash(vertex, stride);
+            auto range = lookup.equal_range(key);
+
+            for (auto it = range.first; it != range.second; ++it) {
+                if (std::memcmp(vertices.data() + it->second * stride, vertex, stride) == 0) {
+                    remap[i] = it->second;
+                    break;
+                }
+            }
+
+            if (remap[i] == kInvalid) {
+                remap[i] = static_cast<std::uint32_t>(vertices.size() / stride);
+                vertices.insert(vertices.end(), vertex, vertex + stride);
+                lookup.emplace(key, remap[i]);
+            }
+        }
+
+        for (std::uint32_t& index : mesh.Indices) {
+            index = remap[index];
+        }
+
+        mesh.Vertices = std::move(vertices);
+    }
+
+    void OptimizeVertexCache(
+        std::vector<std::uint32_t>& indices, std::size_t vertexCount)
+    {
+        const std::size_t triangleCount = indices.size() / 3;
+
+        if (triangleCount == 0) {
+            return;
+        }
+
+        // Triangles per vertex, as one flat array with an offset per vertex.
+        // The live part of each vertex's list shrinks as triangles are added.
+        std::vector<std::uint32_t> remaining(vertexCount, 0);
+        std::vector<std::uint32_t> offsets(vertexCount + 1, 0);
+
+        for (std::uint32_t index : indices) {
+            ++remaining[index];
+        }
+
+        for (std::size_t i = 0; i < vertexCount; ++i) {
+            offsets[i + 1] = offsets[i] + remaining[i];
+        }
+
+        std::vector<std::uint32_t> adjacency(indices.size());
+        std::vector<std::uint32_t> fill(offsets.begin(), offsets.end() - 1);
+
+        for (std::size_t i = 0; i < indices.size(); ++i) {
+            adjacency[fill[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+        }
+
+        std::vector<int> cachePosition(vertexCount, -1);
+        std::vector<float> vertexScores(vertexCount);
+        std::vector<float> triangleScores(triangleCount, 0.0f);
+        std::vector<bool> emitted(triangleCount, false);
+
+        for (std::size_t i = 0; i < vertexCount; ++i) {
+            vertexScores[i] = GetVertexScore(-1, remaining[i]);
+        }
+
+        for (std::size_t i = 0; i < indices.size(); ++i) {
+            triangleScores[i / 3] += vertexScores[indices[i]];
+        }
+
+        std::vector<std::uint32_t> output;
+        std::vector<std::uint32_t> cache;
+        std::vector<std::uint32_t> next;
+
+        output.reserve(indices.size());
+        cache.reserve(kForsythCacheSize + 3);
+        next.reserve(kForsythCacheSize + 3);
+
+        std::uint32_t best = static_cast<std::uint32_t>(
+            std::max_element(triangleScores.begin(), triangleScores.end()) -
+            triangleScores.begin());
+        std::size_t cursor{0};
+
+        while (output.size() < indices.size()) {
+            if (best == kInvalid) {
+                // Nothing in the cache leads anywhere; continue with the next
+                // untouched part of the mesh.
+                while (emitted[cursor]) {
+                    ++cursor;
+                }
+
+                best = static_cast<std::uint32_t>(cursor);
+            }
+
+            const std::uint32_t* triangle = &indices[best * 3];
+            emitted[best] = true;
+
+            next.assign(triangle, triangle + 3);
+
+            for (int k = 0; k < 3; ++k) {
+                std::uint32_t vertex = triangle[k];
+                output.push_back(vertex);
+
+                // Drop the triangle from the vertex's live list.
+                std::uint32_t* begin = &adjacency[offsets[vertex]];
+                std::uint32_t* end = begin + remaining[vertex];
+                std::iter_swap(std::find(begin, end, best), end - 1);
+                --remaining[vertex];
+            }
+
+            for (std::uint32_t vertex : cache) {
+                if (std::find(next.begin(), next.end(), vertex) == next.end()) {
+                    next.push_back(vertex);
+                }
+            }
+
+            // Vertices that fall out of the cache lose their cache bonus.
+            for (std::size_t i = kForsythCacheSize; i < next.size(); ++i) {
+                cachePosition[next[i]] = -1;
+            }
+
+            best = kInvalid;
+            float bestScore{-1.0f};
+
+            for (std::size_t i = 0; i < next.size(); ++i) {
+                std::uint32_t vertex = next[i];
+
+                if (i < kForsythCacheSize) {
+                    cachePosition[vertex] = static_cast<int>(i);
+                }
+
+                float score = GetVertexScore(cachePosition[vertex], remaining[vertex]);
+                float delta = score - vertexScores[vertex];
+                vertexScores[vertex] = score;
+
+                for (std::uint32_t j = 0; j < remaining[vertex]; ++j) {
+                    std::uint32_t t = adjacency[offsets[vertex] + j];
+                    triangleScores[t] += delta;
+
+                    if (triangleScores[t] > bestScore) {
+                        bestScore = triangleScores[t];
+                        best = t;
+                    }
+                }
+            }
+
+            next.resize(std::min<std::size_t>(next.size(), kForsythCacheSize));
+            std::swap(cache, next);
+        }
+
+        indices = std::move(output);
+    }
+
+    void OptimizeOverdraw(MeshData& mesh, float threshold)
+    {
+        std::vector<std::uint32_t>& indices = mesh.Indices;
+        const std::size_t triangleCount = indices.size() / 3;
+        const std::size_t vertexCount = mesh.GetVertexCount();
+
+        const VertexElement* position = mesh.Layout.Find(VertexAttribute::Position);
+
+        if (triangleCount == 0 || position == nullptr ||
+            position->Format != VertexFormat::Float3) {
+            return;
+        }
+
+        // Hard boundaries are where the cache has run dry anyway (all three
+        // vertices miss), so reordering there costs nothing.
+        std::vector<std::size_t> hard{0};
+        std::vector<std::uint8_t> misses(triangleCount);
+        FifoCache cache(vertexCount, 16);
+
+        for (std::size_t t = 0; t < triangleCount; ++t) {
+            for (int k = 0; k < 3; ++k) {
+                misses[t] += cache.Access(indices[t * 3 + k]) ? 1 : 0;
+            }
+
+            if (misses[t] == 3 && t > 0 && t - hard.back() >= kMinClusterTriangles) {
+                hard.push_back(t);
+            }
+        }
+
+        hard.push_back(triangleCount);
+
+        // Soft boundaries split hard clusters further, wherever the part so
+        // far already has an ACMR within `threshold` of the whole cluster.
+        std::vector<std::size_t> boundaries;
+
+        for (std::size_t c = 0; c + 1 < hard.size(); ++c) {
+            std::size_t first = hard[c];
+            std::size_t last = hard[c + 1];
+
+            std::size_t total{0};
+
+            for (std::size_t t = first; t < last; ++t) {
+                total += misses[t];
+            }
+
+            float target = static_cast<float>(total) / (last - first) * threshold;
+            std::size_t start = first;
+            std::size_t count{0};
+
+            cache.Flush();
+            boundaries.push_back(first);
+
+            for (std::size_t t = first; t < last; ++t) {
+                for (int k = 0; k < 3; ++k) {
+                    count += cache.Access(indices[t * 3 + k]) ? 1 : 0;
+                }
+
+                std::size_t size = t + 1 - start;
+
+                if (size >= kMinClusterTriangles && last - (t + 1) >= kMinClusterTriangles &&
+                    static_cast<float>(count) / size <= target) {
+                    start = t + 1;
+                    count = 0;
+                    cache.Flush();
+                    boundaries.push_back(start);
+                }
+            }
+        }
+
+        boundaries.push_back(triangleCount);
+
+        // Clusters facing away from the mesh centre are likely in front of
+        // the rest, so they go first.
+        struct Cluster
+        {
+            std::size_t First;
+            std::size_t Last;
+            float Sort;
+        };
+
+        std::vector<Cluster> clusters;
+        std::vector<glm::vec3> centroids;
+        std::vector<glm::vec3> normals;
+        glm::vec3 meshCentroid{0.0f};
+        float meshArea{0.0f};
+
+        for (std::size_t c = 0; c + 1 < boundaries.size(); ++c) {
+            glm::vec3 centroid{0.0f};
+            glm::vec3 normal{0.0f};
+            float area{0.0f};
+
+            for (std::size_t t = boundaries[c]; t < boundaries[c + 1]; ++t) {
+                glm::vec3 a = GetPosition(mesh, indices[t * 3]);
+                glm::vec3 b = GetPosition(mesh, indices[t * 3 + 1]);
+                glm::vec3 d = GetPosition(mesh, indices[t * 3 + 2]);
+
+                glm::vec3 cross = glm::cross(b - a, d - a);
+                float weight = glm::length(cross);
+
+                centroid += (a + b + d) * (weight / 3.0f);
+                normal += cross;
+                area += weight;
+            }
+
+            meshCentroid += centroid;
+            meshArea += area;
+
+            centroids.push_back(area > 0.0f ? centroid / area : centroid);
+            normals.push_back(normal);
+            clusters.push_back({boundaries[c], boundaries[c + 1], 0.0f});
+        }
+
+        if (meshArea > 0.0f) {
+            meshCentroid /= meshArea;
+        }
+
+        for (std::size_t c = 0; c < clusters.size(); ++c) {
+            float length = glm::length(normals[c]);
+
+            clusters[c].Sort = length > 0.0f
+                ? glm::dot(centroids[c] - meshCentroid, normals[c] / length)
+                : 0.0f;
+        }
+
+        std::stable_sort(
+            clusters.begin(), clusters.end(),
+            [](const Cluster& a, const Cluster& b) { return a.Sort > b.Sort; });
+
+        std::vector<std::uint32_t> output;
+        output.reserve(indices.size());
+
+        for (const Cluster& cluster : clusters) {
+            output.insert(
+                output.end(), indices.begin() + cluster.First * 3,
+                indices.begin() + cluster.Last * 3);
+        }
+
+        indices = std::move(output);
+    }
+
+    void OptimizeVertexFetch(MeshData& mesh)
+    {
+        const std::size_t stride = mesh.Layout.GetStride();
+        std::vector<std::uint32_t> remap(mesh.GetVertexCount(), kInvalid);
+        std::vector<unsigned char> vertices;
+        vertices.reserve(mesh.Vertices.size());
+
+        for (std::uint32_t& index : mesh.Indices) {
+            if (remap[index] == kInvalid) {
+                remap[index] = static_cast<std::uint32_t>(vertices.size() / stride);
+
+                const unsigned char* vertex = mesh.GetVertex(index);
+                vertices.insert(vertices.end(), vertex, vertex + stride);
+            }
+
+            index = remap[index];
+        }
+
+        // Vertices no triangle refers to are dropped as well.
+        mesh.Vertices = std::move(vertices);
+    }
+
+    MeshOptimizationReport OptimizeMesh(MeshData& mesh)
+    {
+        MeshOptimizationReport report{};
+        report.VerticesBefore = mesh.GetVertexCount();
+        report.Before = AnalyzeVertexCache(
+            mesh.Indices.empty() ? GetIdentityIndices(report.VerticesBefore)
+                                 : mesh.Indices,
+            report.VerticesBefore);
+
+        WeldVertices(mesh);
+        OptimizeVertexCache(mesh.Indices, mesh.GetVertexCount());
+        OptimizeOverdraw(mesh);
+        OptimizeVertexFetch(mesh);
+
+        report.VerticesAfter = mesh.GetVertexCount();
+        report.Triangles = mesh.Indices.size() / 3;
+        report.After = AnalyzeVertexCache(mesh.Indices, report.VerticesAfter);
+
+        return report;
+    }
+}
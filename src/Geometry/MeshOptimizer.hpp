@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Geometry/VertexLayout.hpp"
+
+namespace Myst
+{
+    struct VertexCacheStats
+    {
+        // Average cache miss ratio: vertex shader invocations per triangle,
+        // between 0.5 (ideal) and 3.
+        float ACMR;
+        // Average transform to vertex ratio: invocations per unique vertex,
+        // 1 being ideal.
+        float ATVR;
+    };
+
+    struct MeshOptimizationReport
+    {
+        std::size_t VerticesBefore;
+        std::size_t VerticesAfter;
+        std::size_t Triangles;
+        VertexCacheStats Before;
+        VertexCacheStats After;
+
+        void Print(const std::string& name, std::ostream& out = std::cout) const;
+    };
+
+    // Simulates a FIFO post-transform cache, which is what most hardware
+    // behaves closest to.
+    VertexCacheStats AnalyzeVertexCache(
+        const std::vector<std::uint32_t>& indices,
+        std::size_t vertexCount,
+        unsigned int cacheSize = 16);
+
+    // Merges bitwise identical vertices and builds the index buffer. A mesh
+    // that already has indices keeps its triangles, remapped.
+    void WeldVertices(MeshData& mesh);
+
+    // Reorders triangles for post-transform cache hits (Forsyth's linear-speed
+    // algorithm).
+    void OptimizeVertexCache(
+        std::vector<std::uint32_t>& indices, std::size_t vertexCount);
+
+    // Splits cache-optimized triangles into clusters and draws outward facing
+    // clusters first, so they occlude the rest. `threshold` bounds how much
+    // worse the ACMR may get in exchange (1.05 allows 5%). Needs float
+    // positions, so run it before quantizing.
+    void OptimizeOverdraw(MeshData& mesh, float threshold = 1.05f);
+
+    // Reorders vertices by first use, so fetches walk the buffer forwards.
+    void OptimizeVertexFetch(MeshData& mesh);
+
+    // Runs all of the above in order.
+    MeshOptimizationReport OptimizeMesh(MeshData& mesh);
+}
@@ -0,0 +1,143 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Geometry/Model.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#include "Core/MappedFile.hpp"
+
+namespace Myst
+{
+    namespace
+    {
+        bool HasExtension(const std::string& filepath, const char* extension)
+        {
+            std::size_t length = std::strlen(extension);
+
+            if (filepath.size() < length) {
+                return false;
+            }
+
+            for (std::size_t i = 0; i < length; ++i) {
+                char c = filepath[filepath.size() - length + i];
+
+                if (c >= 'A' && c <= 'Z') {
+                    c = static_cast<char>(c - 'A' + 'a');
+                }
+
+                if (c != extension[i]) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    }
+
+    std::size_t Model::GetTriangleCount() const
+    {
+        std::size_t triangles{0};
+
+        for (const ModelMesh& mesh : Meshes) {
+            triangles += mesh.Data.Indices.size() / 3;
+        }
+
+        return triangles;
+    }
+
+    VertexLayout GetModelLayout()
+    {
+        VertexLayout layout;
+        layout.Add(VertexAttribute::Position, VertexFormat::Float3)
+            .Add(VertexAttribute::Normal, VertexFormat::Float3)
+            .Add(VertexAttribute::TexCoord, VertexFormat::Float2);
+
+        return layout;
+    }
+
+    bool LoadModel(
+        const std::string& filepath,
+        JobSystem& jobs,
+        Model& model,
+        const ModelLoadOptions& options)
+    {
+        MappedFile file;
+
+        if (!file.Open(filepath)) {
+            std::cerr << "myst: unable to open model " << filepath << std::endl;
+            return false;
+        }
+
+        bool loaded{false};
+
+        if (HasExtension(filepath, ".obj")) {
+            loaded = LoadObj(
+                reinterpret_cast<const char*>(file.GetData()), file.GetSize(),
+                jobs, model, options);
+        } else if (HasExtension(filepath, ".glb")) {
+            loaded = LoadGlb(file.GetData(), file.GetSize(), jobs, model, options);
+        } else {
+            std::cerr << "myst: unsupported model format " << filepath << std::endl;
+            return false;
+        }
+
+        if (!loaded) {
+            std::cerr << "myst: failed to load model " << filepath << std::endl;
+        }
+
+        return loaded;
+    }
+
+    void GenerateNormals(MeshData& mesh)
+    {
+        const std::size_t stride = mesh.Layout.GetStride();
+        const std::size_t count = mesh.GetVertexCount();
+        const VertexElement* position = mesh.Layout.Find(VertexAttribute::Position);
+        const VertexElement* normal = mesh.Layout.Find(VertexAttribute::Normal);
+
+        if (position == nullptr || normal == nullptr) {
+            return;
+        }
+
+        std::vector<glm::vec3> normals(count, glm::vec3(0.0f));
+
+        auto readPosition = [&](std::uint32_t index) {
+            glm::vec3 value;
+            std::memcpy(
+                &value, mesh.Vertices.data() + index * stride + position->Offset,
+                sizeof(value));
+            return value;
+        };
+
+        for (std::size_t i = 0; i + 2 < mesh.Indices.size(); i += 3) {
+            std::uint32_t a = mesh.Indices[i];
+            std::uint32_t b = mesh.Indices[i + 1];
+            std::uint32_t c = mesh.Indices[i + 2];
+
+            // The cross product's length is twice the area, which weights
+            // large faces more.
+            glm::vec3 p0 = readPosition(a);
+            glm::vec3 face = glm::cross(readPosition(b) - p0, readPosition(c) - p0);
+
+            normals[a] += face;
+            normals[b] += face;
+            normals[c] += face;
+        }
+
+        for (std::size_t i = 0; i < count; ++i) {
+            float length = glm::length(normals[i]);
+            glm::vec3 value = length > 0.0f ? normals[i] / length
+                                            : glm::vec3(0.0f, 1.0f, 0.0f);
+
+            std::memcpy(
+                mesh.Vertices.data() + i * stride + normal->Offset, &value,
+                sizeof(value));
+        }
+    }
+}
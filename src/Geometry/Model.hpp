@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Core/JobSystem.hpp"
+#include "Geometry/VertexLayout.hpp"
+
+namespace Myst
+{
+    // One draw's worth of triangles, in the GetModelLayout() format.
+    struct ModelMesh
+    {
+        std::string Name;
+        std::string Material;
+        MeshData Data;
+    };
+
+    struct ModelInstance
+    {
+        std::size_t Mesh;
+        glm::mat4 Transform{1.0f};
+    };
+
+    struct Model
+    {
+        std::vector<ModelMesh> Meshes;
+        std::vector<ModelInstance> Instances;
+
+        std::size_t GetTriangleCount() const;
+    };
+
+    struct ModelLoadOptions
+    {
+        // Runs OptimizeMesh() on every mesh, in parallel.
+        bool Optimize{true};
+        // Files are split into chunks of at least this many bytes, one task
+        // each.
+        std::size_t ChunkSize{1u << 20};
+    };
+
+    // Float3 positions and normals, Float2 texture coordinates.
+    VertexLayout GetModelLayout();
+
+    // Loads a Wavefront OBJ (`.obj`) or binary glTF (`.glb`) file, picked by
+    // extension. The file is memory-mapped and parsed as jobs.
+    bool LoadModel(
+        const std::string& filepath,
+        JobSystem& jobs,
+        Model& model,
+        const ModelLoadOptions& options = {});
+
+    // Parses an OBJ file in memory. Each object, group and material change
+    // starts a new mesh; polygons are fan triangulated.
+    bool LoadObj(
+        const char* data,
+        std::size_t size,
+        JobSystem& jobs,
+        Model& model,
+        const ModelLoadOptions& options = {});
+
+    // Parses a glTF 2.0 binary container in memory. Only triangle lists with
+    // float attributes are supported; node transforms become instances.
+    bool LoadGlb(
+        const unsigned char* data,
+        std::size_t size,
+        JobSystem& jobs,
+        Model& model,
+        const ModelLoadOptions& options = {});
+
+    // Smooth, area weighted normals from indexed triangles. Expects the
+    // model vertex layout.
+    void GenerateNormals(MeshData& mesh);
+}
@@ -0,0 +1,663 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Geometry/MeshOptimizer.hpp"
+#include "Geometry/Model.hpp"
+
+// OBJ files are parsed in two passes over the same line-aligned chunks. The
+// first counts the elements in each chunk, which gives every chunk its offset
+// into the shared arrays; the second parses values straight into place. No
+// chunk ever builds its own arrays that would need to be stitched together.
+
+namespace Myst
+{
+    namespace
+    {
+        // Absolute, zero-based indices into the attribute arrays. Negative
+        // when the face didn't reference the attribute.
+        struct Corner
+        {
+            std::int32_t Position;
+            std::int32_t TexCoord;
+            std::int32_t Normal;
+        };
+
+        enum class LineType
+        {
+            Other,
+            Position,
+            TexCoord,
+            Normal,
+            Face,
+            Object,
+            Material,
+        };
+
+        struct Split
+        {
+            std::size_t Triangle;
+            LineType Type;
+            std::string Name;
+        };
+
+        struct Chunk
+        {
+            const char* Begin;
+            const char* End;
+
+            std::size_t Positions{0};
+            std::size_t TexCoords{0};
+            std::size_t Normals{0};
+            std::size_t Triangles{0};
+
+            std::size_t PositionBase{0};
+            std::size_t TexCoordBase{0};
+            std::size_t NormalBase{0};
+            std::size_t TriangleBase{0};
+
+            // Object and material changes, at chunk-relative triangles.
+            std::vector<Split> Splits;
+            bool Failed{false};
+        };
+
+        struct MeshRange
+        {
+            std::size_t FirstTriangle;
+            std::size_t LastTriangle;
+            std::string Name;
+            std::string Material;
+        };
+
+        // Attribute arrays for the whole file.
+        struct Attributes
+        {
+            std::vector<float> Positions;
+            std::vector<float> TexCoords;
+            std::vector<float> Normals;
+            std::vector<Corner> Corners;
+        };
+
+        constexpr std::uint32_t kEmpty{0xffffffffu};
+
+        inline bool IsSpace(char c)
+        {
+            return c == ' ' || c == '\t';
+        }
+
+        inline bool IsLineEnd(char c)
+        {
+            return c == '\n' || c == '\r';
+        }
+
+        inline bool IsDigit(char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        inline const char* SkipSpaces(const char* p, const char* end)
+        {
+            while (p < end && IsSpace(*p)) {
+                ++p;
+            }
+
+            return p;
+        }
+
+        inline const char* SkipLine(const char* p, const char* end)
+        {
+            while (p < end && *p != '\n') {
+                ++p;
+            }
+
+            return p < end ? p + 1 : end;
+        }
+
+        inline const char* SkipToken(const char* p, const char* end)
+        {
+            while (p < end && !IsSpace(*p) && !IsLineEnd(*p)) {
+                ++p;
+            }
+
+            return p;
+        }
+
+        // Classifies the line at `p` and returns where its arguments start.
+        const char* ReadLineType(const char* p, const char* end, LineType& type)
+        {
+            p = SkipSpaces(p, end);
+            type = LineType::Other;
+
+            auto keyword = [&](const char* name, std::size_t length) {
+                return static_cast<std::size_t>(end - p) > length &&
+                       std::memcmp(p, name, length) == 0 && IsSpace(p[length]);
+            };
+
+            if (keyword("v", 1)) {
+                type = LineType::Position;
+                return p + 2;
+            }
+
+            if (keyword("vt", 2)) {
+                type = LineType::TexCoord;
+                return p + 3;
+            }
+
+            if (keyword("vn", 2)) {
+                type = LineType::Normal;
+                return p + 3;
+            }
+
+            if (keyword("f", 1)) {
+                type = LineType::Face;
+                return p + 2;
+            }
+
+            if (keyword("o", 1) || keyword("g", 1)) {
+                type = LineType::Object;
+                return p + 2;
+            }
+
+            if (keyword("usemtl", 6)) {
+                type = LineType::Material;
+                return p + 7;
+            }
+
+            return p;
+        }
+
+        std::string ReadName(const char* p, const char* end)
+        {
+            p = SkipSpaces(p, end);
+            const char* last = p;
+
+            while (last < end && !IsLineEnd(*last)) {
+                ++last;
+            }
+
+            while (last > p && IsSpace(last[-1])) {
+                --last;
+            }
+
+            return std::string(p, last);
+        }
+
+        // Much faster than strtof(), which also depends on the locale. Accurate
+        // to within an ulp or so for the values OBJ exporters write.
+        const char* ParseFloat(const char* p, const char* end, float& value)
+        {
+            static const double kPowers[] = {
+                1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+            };
+
+            p = SkipSpaces(p, end);
+
+            bool negative{false};
+
+            if (p < end && (*p == '-' || *p == '+')) {
+                negative = *p == '-';
+                ++p;
+            }
+
+            std::uint64_t mantissa{0};
+            int digits{0};
+            int exponent{0};
+
+            for (; p < end && IsDigit(*p); ++p) {
+                if (digits < 19) {
+                    mantissa = mantissa * 10 + static_cast<unsigned int>(*p - '0');
+                    digits += mantissa != 0;
+                } else {
+                    ++exponent;
+                }
+            }
+
+            if (p < end && *p == '.') {
+                for (++p; p < end && IsDigit(*p); ++p) {
+                    if (digits < 19) {
+                        mantissa = mantissa * 10 + static_cast<unsigned int>(*p - '0');
+                        digits += mantissa != 0;
+                        --exponent;
+                    }
+                }
+            }
+
+            if (p < end && (*p == 'e' || *p == 'E')) {
+                ++p;
+
+                bool negativeExponent{false};
+
+                if (p < end && (*p == '-' || *p == '+')) {
+                    negativeExponent = *p == '-';
+                    ++p;
+                }
+
+                int power{0};
+
+                for (; p < end && IsDigit(*p); ++p) {
+                    power = std::min(power * 10 + (*p - '0'), 1000);
+                }
+
+                exponent += negativeExponent ? -power : power;
+            }
+
+            double result = static_cast<double>(mantissa);
+
+            if (exponent < 0 && exponent >= -22) {
+                result /= kPowers[-exponent];
+            } else if (exponent > 0 && exponent <= 22) {
+                result *= kPowers[exponent];
+            } else if (exponent != 0) {
+                result *= std::pow(10.0, exponent);
+            }
+
+            value = static_cast<float>(negative ? -result : result);
+            return p;
+        }
+
+        const char* ParseIndex(const char* p, const char* end, long& value)
+        {
+            bool negative{false};
+
+            if (p < end && *p == '-') {
+                negative = true;
+                ++p;
+            }
+
+            value = 0;
+
+            for (; p < end && IsDigit(*p); ++p) {
+                value = value * 10 + (*p - '0');
+            }
+
+            if (negative) {
+                value = -value;
+            }
+
+            return p;
+        }
+
+        // Resolves a one-based (or negative, relative) index against the
+        // `count` elements defined so far, out of `total` in the file.
+        std::int32_t ResolveIndex(long index, std::size_t count, std::size_t total, bool& valid)
+        {
+            long resolved = index > 0 ? index - 1 : static_cast<long>(count) + index;
+
+            if (index == 0 || resolved < 0 || static_cast<std::size_t>(resolved) >= total) {
+                valid = false;
+                return -1;
+            }
+
+            return static_cast<std::int32_t>(resolved);
+        }
+
+        void CountChunk(Chunk& chunk)
+        {
+            const char* p = chunk.Begin;
+            const char* end = chunk.End;
+
+            while (p < end) {
+                LineType type;
+                const char* arguments = ReadLineType(p, end, type);
+
+                switch (type) {
+                    case LineType::Position: ++chunk.Positions; break;
+                    case LineType::TexCoord: ++chunk.TexCoords; break;
+                    case LineType::Normal: ++chunk.Normals; break;
+                    case LineType::Face: {
+                        std::size_t vertices{0};
+                        const char* q = SkipSpaces(arguments, end);
+
+                        while (q < end && !IsLineEnd(*q)) {
+                            ++vertices;
+                            q = SkipSpaces(SkipToken(q, end), end);
+                        }
+
+                        chunk.Triangles += vertices >= 3 ? vertices - 2 : 0;
+                        break;
+                    }
+                    case LineType::Object:
+                    case LineType::Material:
+                        chunk.Splits.push_back(
+                            {chunk.Triangles, type, ReadName(arguments, end)});
+                        break;
+                    case LineType::Other: break;
+                }
+
+                p = SkipLine(arguments, end);
+            }
+        }
+
+        void ParseChunk(Chunk& chunk, Attributes& attributes)
+        {
+            const char* p = chunk.Begin;
+            const char* end = chunk.End;
+
+            const std::size_t totalPositions = attributes.Positions.size() / 3;
+            const std::size_t totalTexCoords = attributes.TexCoords.size() / 2;
+            const std::size_t totalNormals = attributes.Normals.size() / 3;
+
+            float* positions = attributes.Positions.data() + chunk.PositionBase * 3;
+            float* texCoords = attributes.TexCoords.data() + chunk.TexCoordBase * 2;
+            float* normals = attributes.Normals.data() + chunk.NormalBase * 3;
+            Corner* corners = attributes.Corners.data() + chunk.TriangleBase * 3;
+
+            std::size_t positionCount{chunk.PositionBase};
+            std::size_t texCoordCount{chunk.TexCoordBase};
+            std::size_t normalCount{chunk.NormalBase};
+
+            while (p < end) {
+                LineType type;
+                const char* q = ReadLineType(p, end, type);
+
+                switch (type) {
+                    case LineType::Position:
+                        q = ParseFloat(q, end, positions[0]);
+                        q = ParseFloat(q, end, positions[1]);
+                        q = ParseFloat(q, end, positions[2]);
+                        positions += 3;
+                        ++positionCount;
+                        break;
+                    case LineType::TexCoord:
+                        q = ParseFloat(q, end, texCoords[0]);
+                        q = ParseFloat(q, end, texCoords[1]);
+                        texCoords += 2;
+                        ++texCoordCount;
+                        break;
+                    case LineType::Normal:
+                        q = ParseFloat(q, end, normals[0]);
+                        q = ParseFloat(q, end, normals[1]);
+                        q = ParseFloat(q, end, normals[2]);
+                        normals += 3;
+                        ++normalCount;
+                        break;
+                    case LineType::Face: {
+                        Corner first{};
+                        Corner previous{};
+                        std::size_t vertices{0};
+                        bool valid{true};
+
+                        q = SkipSpaces(q, end);
+
+                        while (q < end && !IsLineEnd(*q)) {
+                            // v, v/vt, v//vn or v/vt/vn.
+                            Corner corner{-1, -1, -1};
+                            long index;
+
+                            q = ParseIndex(q, end, index);
+                            corner.Position = ResolveIndex(
+                                index, positionCount, totalPositions, valid);
+
+                            if (q < end && *q == '/') {
+                                ++q;
+
+                                if (q < end && *q != '/') {
+                                    q = ParseIndex(q, end, index);
+                                    corner.TexCoord = ResolveIndex(
+                                        index, texCoordCount, totalTexCoords, valid);
+                                }
+
+                                if (q < end && *q == '/') {
+                                    q = ParseIndex(q + 1, end, index);
+                                    corner.Normal = ResolveIndex(
+                                        index, normalCount, totalNormals, valid);
+                                }
+                            }
+
+                            if (vertices == 0) {
+                                first = corner;
+                            } else if (vertices >= 2) {
+                                corners[0] = first;
+                                corners[1] = previous;
+                                corners[2] = corner;
+                                corners += 3;
+                            }
+
+                            previous = corner;
+                            ++vertices;
+
+                            q = SkipSpaces(SkipToken(q, end), end);
+                        }
+
+                        chunk.Failed |= !valid;
+                        break;
+                    }
+                    case LineType::Object:
+                    case LineType::Material:
+                    case LineType::Other: break;
+                }
+
+                p = SkipLine(q, end);
+            }
+        }
+
+        // Builds a mesh from a run of triangles, merging corners that
+        // reference the same attributes.
+        void BuildMesh(
+            const Attributes& attributes,
+            const MeshRange& range,
+            const ModelLoadOptions& options,
+            ModelMesh& mesh)
+        {
+            const std::size_t cornerCount = (range.LastTriangle - range.FirstTriangle) * 3;
+            const Corner* corners = attributes.Corners.data() + range.FirstTriangle * 3;
+
+            mesh.Name = range.Name;
+            mesh.Material = range.Material;
+            mesh.Data.Layout = GetModelLayout();
+            mesh.Data.Indices.resize(cornerCount);
+            mesh.Data.Vertices.resize(cornerCount * 32);
+
+            // Open addressing on the corner's indices, storing vertex numbers.
+            std::size_t capacity{16};
+
+            while (capacity < cornerCount * 2) {
+                capacity *= 2;
+            }
+
+            std::vector<std::uint32_t> table(capacity, kEmpty);
+            std::vector<std::uint32_t> firstCorner;
+            firstCorner.reserve(cornerCount);
+
+            unsigned char* out = mesh.Data.Vertices.data();
+            bool missingNormals{false};
+
+            for (std::size_t i = 0; i < cornerCount; ++i) {
+                const Corner& corner = corners[i];
+
+                std::uint64_t key =
+                    static_cast<std::uint32_t>(corner.Position) * 0x9e3779b97f4a7c15ull ^
+                    static_cast<std::uint32_t>(corner.TexCoord) * 0xc2b2ae3d27d4eb4full ^
+                    static_cast<std::uint32_t>(corner.Normal) * 0x165667b19e3779f9ull;
+                std::size_t slot = static_cast<std::size_t>(key >> 32) & (capacity - 1);
+
+                while (table[slot] != kEmpty) {
+                    const Corner& other = corners[firstCorner[table[slot]]];
+
+                    if (other.Position == corner.Position &&
+                        other.TexCoord == corner.TexCoord &&
+                        other.Normal == corner.Normal) {
+                        break;
+                    }
+
+                    slot = (slot + 1) & (capacity - 1);
+                }
+
+                if (table[slot] == kEmpty) {
+                    std::uint32_t vertex = static_cast<std::uint32_t>(firstCorner.size());
+                    float values[8] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+                    std::memcpy(
+                        values, attributes.Positions.data() + corner.Position * 3,
+                        sizeof(float) * 3);
+
+                    if (corner.Normal >= 0) {
+                        std::memcpy(
+                            values + 3, attributes.Normals.data() + corner.Normal * 3,
+                            sizeof(float) * 3);
+                    } else {
+                        missingNormals = true;
+                    }
+
+                    if (corner.TexCoord >= 0) {
+                        std::memcpy(
+                            values + 6, attributes.TexCoords.data() + corner.TexCoord * 2,
+                            sizeof(float) * 2);
+                    }
+
+                    std::memcpy(out + vertex * sizeof(values), values, sizeof(values));
+
+                    table[slot] = vertex;
+                    firstCorner.push_back(static_cast<std::uint32_t>(i));
+                }
+
+                mesh.Data.Indices[i] = table[slot];
+            }
+
+            // Shrinking never reallocates.
+            mesh.Data.Vertices.resize(firstCorner.size() * 32);
+
+            if (missingNormals) {
+                GenerateNormals(mesh.Data);
+            }
+
+            if (options.Optimize) {
+                OptimizeMesh(mesh.Data);
+            }
+        }
+    }
+
+    bool LoadObj(
+        const char* data,
+        std::size_t size,
+        JobSystem& jobs,
+        Model& model,
+        const ModelLoadOptions& options)
+    {
+        // Line aligned chunks, so no line straddles two tasks.
+        std::vector<Chunk> chunks;
+        const char* end = data + size;
+        const std::size_t chunkSize = std::max<std::size_t>(options.ChunkSize, 1);
+
+        for (const char* p = data; p < end;) {
+            const char* last = p + std::min<std::size_t>(chunkSize, end - p);
+            last = last < end ? SkipLine(last, end) : end;
+
+            Chunk chunk;
+            chunk.Begin = p;
+            chunk.End = last;
+            chunks.push_back(std::move(chunk));
+
+            p = last;
+        }
+
+        JobSystem::Counter counted;
+
+        for (Chunk& chunk : chunks) {
+            jobs.Run([&chunk]() { CountChunk(chunk); }, &counted);
+        }
+
+        jobs.Wait(counted);
+
+        Attributes attributes;
+        std::size_t positions{0};
+        std::size_t texCoords{0};
+        std::size_t normals{0};
+        std::size_t triangles{0};
+
+        for (Chunk& chunk : chunks) {
+            chunk.PositionBase = positions;
+            chunk.TexCoordBase = texCoords;
+            chunk.NormalBase = normals;
+            chunk.TriangleBase = triangles;
+
+            positions += chunk.Positions;
+            texCoords += chunk.TexCoords;
+            normals += chunk.Normals;
+            triangles += chunk.Triangles;
+        }
+
+        attributes.Positions.resize(positions * 3);
+        attributes.TexCoords.resize(texCoords * 2);
+        attributes.Normals.resize(normals * 3);
+        attributes.Corners.resize(triangles * 3);
+
+        JobSystem::Counter parsed;
+
+        for (Chunk& chunk : chunks) {
+            jobs.Run([&chunk, &attributes]() { ParseChunk(chunk, attributes); }, &parsed);
+        }
+
+        jobs.Wait(parsed);
+
+        for (const Chunk& chunk : chunks) {
+            if (chunk.Failed) {
+                std::cerr << "myst: OBJ face references a missing vertex" << std::endl;
+                return false;
+            }
+        }
+
+        // Every object, group or material change that has triangles before
+        // the next one becomes a mesh.
+        std::vector<MeshRange> ranges;
+        MeshRange current{0, 0, "default", ""};
+
+        for (const Chunk& chunk : chunks) {
+            for (const Split& split : chunk.Splits) {
+                std::size_t triangle = chunk.TriangleBase + split.Triangle;
+
+                if (triangle > current.FirstTriangle) {
+                    current.LastTriangle = triangle;
+                    ranges.push_back(current);
+                    current.FirstTriangle = triangle;
+                }
+
+                if (split.Type == LineType::Object) {
+                    current.Name = split.Name;
+                } else {
+                    current.Material = split.Name;
+                }
+            }
+        }
+
+        if (triangles > current.FirstTriangle) {
+            current.LastTriangle = triangles;
+            ranges.push_back(current);
+        }
+
+        const std::size_t firstMesh = model.Meshes.size();
+        model.Meshes.resize(firstMesh + ranges.size());
+
+        JobSystem::Counter meshes;
+
+        for (std::size_t i = 0; i < ranges.size(); ++i) {
+            ModelMesh& mesh = model.Meshes[firstMesh + i];
+            const MeshRange& range = ranges[i];
+
+            jobs.Run(
+                [&attributes, &range, &options, &mesh]() {
+                    BuildMesh(attributes, range, options, mesh);
+                },
+                &meshes);
+
+            model.Instances.push_back({firstMesh + i, glm::mat4(1.0f)});
+        }
+
+        jobs.Wait(meshes);
+
+        return true;
+    }
+}
@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace Myst
+{
+    // The value doubles as the attribute location in the shaders.
+    enum class VertexAttribute : std::uint32_t
+    {
+        Position = 0,
+        Normal = 1,
+        TexCoord = 2,
+    };
+
+    enum class VertexFormat
+    {
+        Float2,
+        Float3,
+
+        // Quantized formats. The ones marked with bounds are decoded with the
+        // mesh's VertexDequantization.
+        Half2,
+        Half4,
+        Snorm16x4,  // Positions, with bounds. W is unused.
+        Unorm16x2,  // Texture coordinates, with bounds.
+        Oct16,      // Unit vectors, octahedral encoded in two snorm16.
+        Snorm10x3,  // Unit vectors as GL_INT_2_10_10_10_REV. W is unused.
+    };
+
+    // Maps quantized positions and texture coordinates back to their original
+    // range: value = offset + quantized * scale.
+    struct VertexDequantization
+    {
+        glm::vec3 PositionOffset{0.0f};
+        glm::vec3 PositionScale{1.0f};
+        glm::vec2 TexCoordOffset{0.0f};
+        glm::vec2 TexCoordScale{1.0f};
+    };
+
+    struct VertexElement
+    {
+        VertexAttribute Attribute;
+        VertexFormat Format;
+        std::uint32_t Offset;
+    };
+
+    // Describes a single interleaved vertex. Elements are packed in the order
+    // they're added.
+    class VertexLayout
+    {
+    public:
+        VertexLayout& Add(VertexAttribute attribute, VertexFormat format)
+        {
+            mElements.push_back({attribute, format, mStride});
+            mStride += GetFormatSize(format);
+
+            return *this;
+        }
+
+        const std::vector<VertexElement>& GetElements() const
+        {
+            return mElements;
+        }
+
+        std::uint32_t GetStride() const
+        {
+            return mStride;
+        }
+
+        const VertexElement* Find(VertexAttribute attribute) const
+        {
+            for (const VertexElement& element : mElements) {
+                if (element.Attribute == attribute) {
+                    return &element;
+                }
+            }
+
+            return nullptr;
+        }
+
+        static std::uint32_t GetFormatSize(VertexFormat format)
+        {
+            switch (format) {
+                case VertexFormat::Float2: return 8;
+                case VertexFormat::Float3: return 12;
+                case VertexFormat::Half2: return 4;
+                case VertexFormat::Half4: return 8;
+                case VertexFormat::Snorm16x4: return 8;
+                case VertexFormat::Unorm16x2: return 4;
+                case VertexFormat::Oct16: return 4;
+                case VertexFormat::Snorm10x3: return 4;
+            }
+
+            return 0;
+        }
+
+    private:
+        std::vector<VertexElement> mElements;
+        std::uint32_t mStride{0};
+    };
+
+    // Interleaved vertices on the CPU. Without indices, every three vertices
+    // form a triangle.
+    struct MeshData
+    {
+        VertexLayout Layout;
+        std::vector<unsigned char> Vertices;
+        std::vector<std::uint32_t> Indices;
+        VertexDequantization Dequantization;
+
+        std::size_t GetVertexCount() const
+        {
+            std::uint32_t stride = Layout.GetStride();
+            return stride == 0 ? 0 : Vertices.size() / stride;
+        }
+
+        const unsigned char* GetVertex(std::size_t index) const
+        {
+            return Vertices.data() + index * Layout.GetStride();
+        }
+    };
+}
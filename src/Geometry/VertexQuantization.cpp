@@ -0,0 +1,225 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Geometry/VertexQuantization.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <glm/gtc/packing.hpp>
+
+namespace Myst
+{
+    namespace
+    {
+        bool IsFloat(VertexFormat format)
+        {
+            return format == VertexFormat::Float2 || format == VertexFormat::Float3;
+        }
+
+        glm::vec3 ReadFloat(const unsigned char* data, VertexFormat format)
+        {
+            glm::vec3 value{0.0f};
+            std::memcpy(&value, data, VertexLayout::GetFormatSize(format));
+
+            return value;
+        }
+
+        template<typename T>
+        void Write(unsigned char* data, const T& value)
+        {
+            std::memcpy(data, &value, sizeof(value));
+        }
+
+        VertexFormat GetTarget(
+            const VertexElement& element, const VertexQuantization& quantization)
+        {
+            if (!IsFloat(element.Format)) {
+                return element.Format;
+            }
+
+            switch (element.Attribute) {
+                case VertexAttribute::Position: return quantization.Position;
+                case VertexAttribute::Normal: return quantization.Normal;
+                case VertexAttribute::TexCoord: return quantization.TexCoord;
+            }
+
+            return element.Format;
+        }
+
+        // Bounds of a float attribute over the whole mesh.
+        void GetBounds(
+            const MeshData& mesh,
+            const VertexElement& element,
+            glm::vec3& min,
+            glm::vec3& max)
+        {
+            min = glm::vec3(std::numeric_limits<float>::max());
+            max = glm::vec3(std::numeric_limits<float>::lowest());
+
+            for (std::size_t i = 0; i < mesh.GetVertexCount(); ++i) {
+                glm::vec3 value = ReadFloat(mesh.GetVertex(i) + element.Offset, element.Format);
+
+                min = glm::min(min, value);
+                max = glm::max(max, value);
+            }
+        }
+
+        std::uint16_t PackSnorm16(float value)
+        {
+            return static_cast<std::uint16_t>(static_cast<std::int16_t>(
+                std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f)));
+        }
+
+        std::uint16_t PackUnorm16(float value)
+        {
+            return static_cast<std::uint16_t>(
+                std::round(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+        }
+    }
+
+    MeshData QuantizeMesh(
+        const MeshData& mesh, const VertexQuantization& quantization)
+    {
+        MeshData result;
+        result.Indices = mesh.Indices;
+        result.Dequantization = mesh.Dequantization;
+
+        std::vector<VertexFormat> targets;
+
+        for (const VertexElement& element : mesh.Layout.GetElements()) {
+            targets.push_back(GetTarget(element, quantization));
+            result.Layout.Add(element.Attribute, targets.back());
+        }
+
+        const std::size_t count = mesh.GetVertexCount();
+        const std::uint32_t stride = result.Layout.GetStride();
+
+        result.Vertices.resize(count * stride);
+
+        for (std::size_t e = 0; e < targets.size(); ++e) {
+            const VertexElement& source = mesh.Layout.GetElements()[e];
+            const VertexElement& target = result.Layout.GetElements()[e];
+
+            if (!IsFloat(source.Format) || IsFloat(target.Format)) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    std::memcpy(
+                        result.Vertices.data() + i * stride + target.Offset,
+                        mesh.GetVertex(i) + source.Offset,
+                        VertexLayout::GetFormatSize(source.Format));
+                }
+
+                continue;
+            }
+
+            // Bounded formats map the attribute's range onto the full range of
+            // the integer type; the shader applies the inverse.
+            glm::vec3 offset{0.0f};
+            glm::vec3 scale{1.0f};
+
+            if (target.Format == VertexFormat::Snorm16x4 &&
+                source.Attribute == VertexAttribute::Position) {
+                glm::vec3 min, max;
+                GetBounds(mesh, source, min, max);
+
+                offset = (min + max) * 0.5f;
+                scale = glm::max((max - min) * 0.5f, glm::vec3(1e-8f));
+
+                result.Dequantization.PositionOffset = offset;
+                result.Dequantization.PositionScale = scale;
+            } else if (
+                target.Format == VertexFormat::Unorm16x2 &&
+                source.Attribute == VertexAttribute::TexCoord) {
+                glm::vec3 min, max;
+                GetBounds(mesh, source, min, max);
+
+                offset = min;
+                scale = glm::max(max - min, glm::vec3(1e-8f));
+
+                result.Dequantization.TexCoordOffset = glm::vec2(offset);
+                result.Dequantization.TexCoordScale = glm::vec2(scale);
+            }
+
+            for (std::size_t i = 0; i < count; ++i) {
+                glm::vec3 value = ReadFloat(mesh.GetVertex(i) + source.Offset, source.Format);
+                glm::vec3 normalized = (value - offset) / scale;
+                unsigned char* out = result.Vertices.data() + i * stride + target.Offset;
+
+                switch (target.Format) {
+                    case VertexFormat::Half2:
+                        Write(out, glm::packHalf2x16(glm::vec2(value)));
+                        break;
+
+                    case VertexFormat::Half4:
+                        Write(out, glm::packHalf4x16(glm::vec4(value, 0.0f)));
+                        break;
+
+                    case VertexFormat::Snorm16x4: {
+                        std::uint16_t packed[4]{
+                            PackSnorm16(normalized.x), PackSnorm16(normalized.y),
+                            PackSnorm16(normalized.z), 0};
+                        Write(out, packed);
+                        break;
+                    }
+
+                    case VertexFormat::Unorm16x2: {
+                        std::uint16_t packed[2]{
+                            PackUnorm16(normalized.x), PackUnorm16(normalized.y)};
+                        Write(out, packed);
+                        break;
+                    }
+
+                    case VertexFormat::Oct16:
+                        Write(out, EncodeOctahedral(value));
+                        break;
+
+                    case VertexFormat::Snorm10x3:
+                        Write(out, glm::packSnorm3x10_1x2(
+                                       glm::vec4(glm::normalize(value), 0.0f)));
+                        break;
+
+                    default: break;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    std::uint32_t EncodeOctahedral(const glm::vec3& direction)
+    {
+        // Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower
+        // half over the upper one.
+        glm::vec3 n = direction /
+            (std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z));
+        glm::vec2 encoded(n.x, n.y);
+
+        if (n.z < 0.0f) {
+            encoded.x = (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+            encoded.y = (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+        }
+
+        return static_cast<std::uint32_t>(PackSnorm16(encoded.x)) |
+               static_cast<std::uint32_t>(PackSnorm16(encoded.y)) << 16;
+    }
+
+    glm::vec3 DecodeOctahedral(std::uint32_t encoded)
+    {
+        glm::vec2 e(
+            std::max(static_cast<std::int16_t>(encoded & 0xffff) / 32767.0f, -1.0f),
+            std::max(static_cast<std::int16_t>(encoded >> 16) / 32767.0f, -1.0f));
+        glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+        float t = std::max(-n.z, 0.0f);
+
+        n.x += n.x >= 0.0f ? -t : t;
+        n.y += n.y >= 0.0f ? -t : t;
+
+        return glm::normalize(n);
+    }
+}
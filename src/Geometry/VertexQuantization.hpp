@@ -0,0 +1,37 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Geometry/VertexLayout.hpp"
+
+namespace Myst
+{
+    // Target formats per attribute. The defaults pack position, normal and
+    // texture coordinates into 16 bytes, down from 32.
+    struct VertexQuantization
+    {
+        VertexFormat Position{VertexFormat::Snorm16x4};
+        VertexFormat Normal{VertexFormat::Oct16};
+        VertexFormat TexCoord{VertexFormat::Unorm16x2};
+    };
+
+    // Converts a mesh with float attributes to the requested formats and fills
+    // in its dequantization bounds. Attributes that are already quantized, or
+    // asked to stay float, are copied as they are.
+    MeshData QuantizeMesh(
+        const MeshData& mesh,
+        const VertexQuantization& quantization = VertexQuantization{});
+
+    // The inverse lives in `assets/shaders/include/vertex.glsl`.
+    std::uint32_t EncodeOctahedral(const glm::vec3& direction);
+    glm::vec3 DecodeOctahedral(std::uint32_t encoded);
+}
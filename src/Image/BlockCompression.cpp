@@ -0,0 +1,471 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Image/BlockCompression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace Myst
+{
+    namespace
+    {
+        // Finds the direction of greatest variance in `channels` dimensions
+        // through a few rounds of power iteration on the covariance matrix,
+        // then returns the block's extremes along it.
+        void FitEndpoints(
+            const unsigned char* rgba,
+            int channels,
+            float* minimum,
+            float* maximum)
+        {
+            float mean[4]{};
+
+            for (int i = 0; i < 16; ++i) {
+                for (int c = 0; c < channels; ++c) {
+                    mean[c] += rgba[i * 4 + c];
+                }
+            }
+
+            for (int c = 0; c < channels; ++c) {
+                mean[c] /= 16.0f;
+            }
+
+            float covariance[4][4]{};
+
+            for (int i = 0; i < 16; ++i) {
+                for (int a = 0; a < channels; ++a) {
+                    for (int b = 0; b < channels; ++b) {
+                        covariance[a][b] += (rgba[i * 4 + a] - mean[a]) *
+                                            (rgba[i * 4 + b] - mean[b]);
+                    }
+                }
+            }
+
+            float axis[4]{1.0f, 1.0f, 1.0f, 1.0f};
+
+            for (int iteration = 0; iteration < 8; ++iteration) {
+                float next[4]{};
+                float length{0.0f};
+
+                for (int a = 0; a < channels; ++a) {
+                    for (int b = 0; b < channels; ++b) {
+                        next[a] += covariance[a][b] * axis[b];
+                    }
+
+                    length = std::max(length, std::fabs(next[a]));
+                }
+
+                if (length < 1e-6f) {
+                    break;
+                }
+
+                for (int a = 0; a < channels; ++a) {
+                    axis[a] = next[a] / length;
+                }
+            }
+
+            float lengthSquared{0.0f};
+
+            for (int c = 0; c < channels; ++c) {
+                lengthSquared += axis[c] * axis[c];
+            }
+
+            float low{0.0f};
+            float high{0.0f};
+
+            for (int i = 0; i < 16; ++i) {
+                float t{0.0f};
+
+                for (int c = 0; c < channels; ++c) {
+                    t += (rgba[i * 4 + c] - mean[c]) * axis[c];
+                }
+
+                t /= lengthSquared;
+                low = std::min(low, t);
+                high = std::max(high, t);
+            }
+
+            for (int c = 0; c < channels; ++c) {
+                minimum[c] = std::clamp(mean[c] + axis[c] * low, 0.0f, 255.0f);
+                maximum[c] = std::clamp(mean[c] + axis[c] * high, 0.0f, 255.0f);
+            }
+        }
+
+        int Distance(const int* a, const unsigned char* b, int channels)
+        {
+            int result{0};
+
+            for (int c = 0; c < channels; ++c) {
+                int delta = a[c] - b[c];
+                result += delta * delta;
+            }
+
+            return result;
+        }
+
+        std::uint16_t PackRGB565(const float* color)
+        {
+            int r = static_cast<int>(std::lround(color[0] * 31.0f / 255.0f));
+            int g = static_cast<int>(std::lround(color[1] * 63.0f / 255.0f));
+            int b = static_cast<int>(std::lround(color[2] * 31.0f / 255.0f));
+
+            return static_cast<std::uint16_t>((r << 11) | (g << 5) | b);
+        }
+
+        void UnpackRGB565(std::uint16_t packed, int* color)
+        {
+            int r = (packed >> 11) & 31;
+            int g = (packed >> 5) & 63;
+            int b = packed & 31;
+
+            color[0] = (r << 3) | (r >> 2);
+            color[1] = (g << 2) | (g >> 4);
+            color[2] = (b << 3) | (b >> 2);
+        }
+
+        void EncodeColorBlock(const unsigned char* rgba, unsigned char* output)
+        {
+            float minimum[3];
+            float maximum[3];
+
+            FitEndpoints(rgba, 3, minimum, maximum);
+
+            std::uint16_t c0 = PackRGB565(maximum);
+            std::uint16_t c1 = PackRGB565(minimum);
+
+            // c0 > c1 selects four-colour mode, which is the only one used.
+            if (c0 < c1) {
+                std::swap(c0, c1);
+            }
+
+            std::uint32_t indices{0};
+
+            if (c0 != c1) {
+                int palette[4][3];
+
+                UnpackRGB565(c0, palette[0]);
+                UnpackRGB565(c1, palette[1]);
+
+                for (int c = 0; c < 3; ++c) {
+                    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+                }
+
+                for (int i = 0; i < 16; ++i) {
+                    int best{0};
+                    int bestDistance = Distance(palette[0], rgba + i * 4, 3);
+
+                    for (int p = 1; p < 4; ++p) {
+                        int distance = Distance(palette[p], rgba + i * 4, 3);
+
+                        if (distance < bestDistance) {
+                            best = p;
+                            bestDistance = distance;
+                        }
+                    }
+
+                    indices |= static_cast<std::uint32_t>(best) << (2 * i);
+                }
+            }
+
+            output[0] = static_cast<unsigned char>(c0 & 0xff);
+            output[1] = static_cast<unsigned char>(c0 >> 8);
+            output[2] = static_cast<unsigned char>(c1 & 0xff);
+            output[3] = static_cast<unsigned char>(c1 >> 8);
+
+            for (int i = 0; i < 4; ++i) {
+                output[4 + i] = static_cast<unsigned char>(indices >> (8 * i));
+            }
+        }
+
+        // BC4: a single channel, taken from `channel` of each RGBA pixel.
+        void EncodeChannelBlock(
+            const unsigned char* rgba, int channel, unsigned char* output)
+        {
+            int low{255};
+            int high{0};
+
+            for (int i = 0; i < 16; ++i) {
+                low = std::min(low, static_cast<int>(rgba[i * 4 + channel]));
+                high = std::max(high, static_cast<int>(rgba[i * 4 + channel]));
+            }
+
+            std::memset(output, 0, 8);
+            output[0] = static_cast<unsigned char>(high);
+            output[1] = static_cast<unsigned char>(low);
+
+            if (high == low) {
+                return;
+            }
+
+            // With a0 > a1 the palette holds six interpolated values, which
+            // map onto indices 2..7 in order from a0 towards a1.
+            int palette[8];
+            palette[0] = high;
+            palette[1] = low;
+
+            for (int i = 1; i < 7; ++i) {
+                palette[i + 1] = ((7 - i) * high + i * low) / 7;
+            }
+
+            std::uint64_t indices{0};
+
+            for (int i = 0; i < 16; ++i) {
+                int value = rgba[i * 4 + channel];
+                int best{0};
+                int bestDistance{256};
+
+                for (int p = 0; p < 8; ++p) {
+                    int distance = std::abs(palette[p] - value);
+
+                    if (distance < bestDistance) {
+                        best = p;
+                        bestDistance = distance;
+                    }
+                }
+
+                indices |= static_cast<std::uint64_t>(best) << (3 * i);
+            }
+
+            for (int i = 0; i < 6; ++i) {
+                output[2 + i] = static_cast<unsigned char>(indices >> (8 * i));
+            }
+        }
+
+        class BitWriter
+        {
+        public:
+            BitWriter(unsigned char* output)
+                : mOutput(output)
+                , mPosition(0)
+            {
+                std::memset(mOutput, 0, 16);
+            }
+
+            void Write(std::uint32_t value, int bits)
+            {
+                for (int i = 0; i < bits; ++i, ++mPosition) {
+                    if ((value >> i) & 1) {
+                        mOutput[mPosition / 8] |= 1 << (mPosition % 8);
+                    }
+                }
+            }
+
+        private:
+            unsigned char* mOutput;
+            int mPosition;
+        };
+
+        // Quantizes an 8-bit endpoint to BC7 mode 6 precision: 7 bits per
+        // channel plus one p-bit shared by all four channels.
+        void QuantizeEndpoint(const float* color, int* quantized, int& pbit)
+        {
+            int bestError{-1};
+
+            for (int p = 0; p < 2; ++p) {
+                int candidate[4];
+                int error{0};
+
+                for (int c = 0; c < 4; ++c) {
+                    int value = static_cast<int>(std::lround((color[c] - p) / 2.0f));
+                    candidate[c] = std::clamp(value, 0, 127);
+
+                    int delta = ((candidate[c] << 1) | p) - static_cast<int>(color[c]);
+                    error += delta * delta;
+                }
+
+                if (bestError < 0 || error < bestError) {
+                    bestError = error;
+                    pbit = p;
+                    std::copy(candidate, candidate + 4, quantized);
+                }
+            }
+        }
+
+        void ReadBlock(
+            const Image& image, int blockX, int blockY, unsigned char* rgba)
+        {
+            for (int y = 0; y < 4; ++y) {
+                const unsigned char* row =
+                    image.GetRow(std::min(blockY * 4 + y, image.Height - 1));
+
+                for (int x = 0; x < 4; ++x) {
+                    // Pixels past the edge repeat the last column/row, so they
+                    // don't skew the endpoints.
+                    int source = std::min(blockX * 4 + x, image.Width - 1);
+                    const unsigned char* pixel = row + source * image.Channels;
+                    unsigned char* target = rgba + (y * 4 + x) * 4;
+
+                    switch (image.Channels) {
+                        case 1:
+                            target[0] = target[1] = target[2] = pixel[0];
+                            target[3] = 255;
+                            break;
+
+                        case 2:
+                            target[0] = pixel[0];
+                            target[1] = pixel[1];
+                            target[2] = 0;
+                            target[3] = 255;
+                            break;
+
+                        case 3:
+                            std::memcpy(target, pixel, 3);
+                            target[3] = 255;
+                            break;
+
+                        default:
+                            std::memcpy(target, pixel, 4);
+                            break;
+                    }
+                }
+            }
+        }
+    }
+
+    std::size_t GetBlockSize(BlockFormat format)
+    {
+        return format == BlockFormat::BC1 ? 8 : 16;
+    }
+
+    std::size_t GetCompressedSize(BlockFormat format, int width, int height)
+    {
+        std::size_t blocksX = static_cast<std::size_t>((width + 3) / 4);
+        std::size_t blocksY = static_cast<std::size_t>((height + 3) / 4);
+
+        return blocksX * blocksY * GetBlockSize(format);
+    }
+
+    void EncodeBC1(const unsigned char* rgba, unsigned char* output)
+    {
+        EncodeColorBlock(rgba, output);
+    }
+
+    void EncodeBC3(const unsigned char* rgba, unsigned char* output)
+    {
+        EncodeChannelBlock(rgba, 3, output);
+        EncodeColorBlock(rgba, output + 8);
+    }
+
+    void EncodeBC5(const unsigned char* rgba, unsigned char* output)
+    {
+        EncodeChannelBlock(rgba, 0, output);
+        EncodeChannelBlock(rgba, 1, output + 8);
+    }
+
+    void EncodeBC7(const unsigned char* rgba, unsigned char* output)
+    {
+        static const int kWeights[16]{
+            0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        float minimum[4];
+        float maximum[4];
+
+        FitEndpoints(rgba, 4, minimum, maximum);
+
+        int endpoints[2][4];
+        int pbits[2];
+
+        QuantizeEndpoint(minimum, endpoints[0], pbits[0]);
+        QuantizeEndpoint(maximum, endpoints[1], pbits[1]);
+
+        int palette[16][4];
+
+        for (int i = 0; i < 16; ++i) {
+            for (int c = 0; c < 4; ++c) {
+                int e0 = (endpoints[0][c] << 1) | pbits[0];
+                int e1 = (endpoints[1][c] << 1) | pbits[1];
+
+                palette[i][c] = ((64 - kWeights[i]) * e0 + kWeights[i] * e1 + 32) >> 6;
+            }
+        }
+
+        int indices[16];
+
+        for (int i = 0; i < 16; ++i) {
+            int bestDistance = Distance(palette[0], rgba + i * 4, 4);
+            indices[i] = 0;
+
+            for (int p = 1; p < 16; ++p) {
+                int distance = Distance(palette[p], rgba + i * 4, 4);
+
+                if (distance < bestDistance) {
+                    indices[i] = p;
+                    bestDistance = distance;
+                }
+            }
+        }
+
+        // The first index is stored without its top bit, so it has to be
+        // below 8; swapping the endpoints mirrors every index.
+        if (indices[0] >= 8) {
+            std::swap(endpoints[0], endpoints[1]);
+            std::swap(pbits[0], pbits[1]);
+
+            for (int& index : indices) {
+                index = 15 - index;
+            }
+        }
+
+        BitWriter writer(output);
+        writer.Write(1 << 6, 7);
+
+        for (int c = 0; c < 4; ++c) {
+            writer.Write(static_cast<std::uint32_t>(endpoints[0][c]), 7);
+            writer.Write(static_cast<std::uint32_t>(endpoints[1][c]), 7);
+        }
+
+        writer.Write(static_cast<std::uint32_t>(pbits[0]), 1);
+        writer.Write(static_cast<std::uint32_t>(pbits[1]), 1);
+        writer.Write(static_cast<std::uint32_t>(indices[0]), 3);
+
+        for (int i = 1; i < 16; ++i) {
+            writer.Write(static_cast<std::uint32_t>(indices[i]), 4);
+        }
+    }
+
+    void CompressBlockRows(
+        const Image& image,
+        BlockFormat format,
+        int firstRow,
+        int lastRow,
+        unsigned char* output)
+    {
+        int blocksX = (image.Width + 3) / 4;
+        std::size_t blockSize = GetBlockSize(format);
+        unsigned char rgba[64];
+
+        for (int by = firstRow; by < lastRow; ++by) {
+            for (int bx = 0; bx < blocksX; ++bx) {
+                unsigned char* block =
+                    output + (static_cast<std::size_t>(by) * blocksX + bx) * blockSize;
+
+                ReadBlock(image, bx, by, rgba);
+
+                switch (format) {
+                    case BlockFormat::BC1: EncodeBC1(rgba, block); break;
+                    case BlockFormat::BC3: EncodeBC3(rgba, block); break;
+                    case BlockFormat::BC5: EncodeBC5(rgba, block); break;
+                    case BlockFormat::BC7: EncodeBC7(rgba, block); break;
+                }
+            }
+        }
+    }
+
+    std::vector<unsigned char> Compress(const Image& image, BlockFormat format)
+    {
+        std::vector<unsigned char> output(
+            GetCompressedSize(format, image.Width, image.Height));
+
+        CompressBlockRows(image, format, 0, (image.Height + 3) / 4, output.data());
+
+        return output;
+    }
+}
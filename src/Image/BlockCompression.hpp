@@ -0,0 +1,44 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Image/Image.hpp"
+
+namespace Myst
+{
+    enum class BlockFormat
+    {
+        BC1, // RGB, 4 bpp.
+        BC3, // RGBA with separately encoded alpha, 8 bpp.
+        BC5, // Two independent channels (e.g. normal map XY), 8 bpp.
+        BC7, // RGBA, 8 bpp, highest quality (mode 6 only).
+    };
+
+    std::size_t GetBlockSize(BlockFormat format);
+    std::size_t GetCompressedSize(BlockFormat format, int width, int height);
+
+    // Every encoder takes a 4x4 block of RGBA pixels, row by row.
+    void EncodeBC1(const unsigned char* rgba, unsigned char* output);
+    void EncodeBC3(const unsigned char* rgba, unsigned char* output);
+    void EncodeBC5(const unsigned char* rgba, unsigned char* output);
+    void EncodeBC7(const unsigned char* rgba, unsigned char* output);
+
+    // Compresses a rectangle of block rows, [firstRow, lastRow), so callers
+    // can spread a large image over several threads.
+    void CompressBlockRows(
+        const Image& image,
+        BlockFormat format,
+        int firstRow,
+        int lastRow,
+        unsigned char* output);
+
+    std::vector<unsigned char> Compress(const Image& image, BlockFormat format);
+}
@@ -0,0 +1,180 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Image/CookedTexture.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace Myst
+{
+    namespace
+    {
+        // Level data is aligned so it can be read with aligned loads straight
+        // from the mapping.
+        constexpr std::uint64_t kAlignment{16};
+
+        std::uint64_t Align(std::uint64_t value)
+        {
+            return (value + kAlignment - 1) / kAlignment * kAlignment;
+        }
+
+        // The bytes GL reads for a level, with rows tightly packed.
+        std::uint64_t GetLevelSize(CookedFormat format, std::uint64_t width, std::uint64_t height)
+        {
+            const std::uint64_t blocks = ((width + 3) / 4) * ((height + 3) / 4);
+
+            switch (format) {
+                case CookedFormat::R8: return width * height;
+                case CookedFormat::RG8: return width * height * 2;
+                case CookedFormat::RGB8: return width * height * 3;
+                case CookedFormat::RGBA8: return width * height * 4;
+                case CookedFormat::BC1: return blocks * 8;
+                case CookedFormat::BC3:
+                case CookedFormat::BC5:
+                case CookedFormat::BC7: return blocks * 16;
+            }
+
+            return 0;
+        }
+    }
+
+    const char* GetCookedFormatName(CookedFormat format)
+    {
+        switch (format) {
+            case CookedFormat::R8: return "r8";
+            case CookedFormat::RG8: return "rg8";
+            case CookedFormat::RGB8: return "rgb8";
+            case CookedFormat::RGBA8: return "rgba8";
+            case CookedFormat::BC1: return "bc1";
+            case CookedFormat::BC3: return "bc3";
+            case CookedFormat::BC5: return "bc5";
+            case CookedFormat::BC7: return "bc7";
+        }
+
+        return "unknown";
+    }
+
+    bool IsCookedTexture(const std::string& filepath)
+    {
+        std::string extension{kCookedTextureExtension};
+
+        return filepath.size() > extension.size() &&
+               filepath.compare(
+                   filepath.size() - extension.size(), extension.size(),
+                   extension) == 0;
+    }
+
+    bool ParseCookedTexture(
+        const unsigned char* data,
+        std::size_t size,
+        const CookedTextureHeader*& header,
+        const CookedTextureLevel*& levels)
+    {
+        if (size < sizeof(CookedTextureHeader)) {
+            return false;
+        }
+
+        header = reinterpret_cast<const CookedTextureHeader*>(data);
+
+        if (header->Magic != kCookedTextureMagic ||
+            header->Version != kCookedTextureVersion || header->Levels == 0 ||
+            header->Levels > 32 || header->Width == 0 || header->Height == 0 ||
+            static_cast<std::uint32_t>(header->Format) >
+                static_cast<std::uint32_t>(CookedFormat::BC7)) {
+            return false;
+        }
+
+        std::size_t tableEnd = sizeof(CookedTextureHeader) +
+                               header->Levels * sizeof(CookedTextureLevel);
+
+        if (size < tableEnd) {
+            return false;
+        }
+
+        levels = reinterpret_cast<const CookedTextureLevel*>(
+            data + sizeof(CookedTextureHeader));
+
+        // GL reads as much as the level's size and format call for, whatever
+        // the table says, so the two must agree. Each level halves the one
+        // before it, as the cooker builds them.
+        for (std::uint32_t i = 0; i < header->Levels; ++i) {
+            const std::uint32_t width = std::max<std::uint32_t>(header->Width >> i, 1);
+            const std::uint32_t height = std::max<std::uint32_t>(header->Height >> i, 1);
+
+            if (levels[i].Width != width || levels[i].Height != height ||
+                levels[i].Size != GetLevelSize(header->Format, width, height) ||
+                levels[i].Offset < tableEnd || levels[i].Offset > size ||
+                levels[i].Size > size - levels[i].Offset) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool WriteCookedTexture(
+        const std::string& filepath,
+        CookedFormat format,
+        std::uint32_t flags,
+        const std::vector<std::vector<unsigned char>>& levels,
+        const std::vector<std::pair<int, int>>& sizes)
+    {
+        if (levels.empty() || levels.size() != sizes.size()) {
+            return false;
+        }
+
+        CookedTextureHeader header{
+            kCookedTextureMagic,
+            kCookedTextureVersion,
+            format,
+            flags,
+            static_cast<std::uint32_t>(sizes[0].first),
+            static_cast<std::uint32_t>(sizes[0].second),
+            static_cast<std::uint32_t>(levels.size()),
+            0};
+
+        std::vector<CookedTextureLevel> table(levels.size());
+        std::uint64_t offset = Align(
+            sizeof(CookedTextureHeader) + table.size() * sizeof(CookedTextureLevel));
+
+        for (std::size_t i = 0; i < levels.size(); ++i) {
+            table[i].Width = static_cast<std::uint32_t>(sizes[i].first);
+            table[i].Height = static_cast<std::uint32_t>(sizes[i].second);
+            table[i].Offset = offset;
+            table[i].Size = levels[i].size();
+
+            offset = Align(offset + levels[i].size());
+        }
+
+        std::ofstream ofs(filepath, std::ios::binary | std::ios::trunc);
+
+        if (!ofs.is_open()) {
+            std::cerr << "myst: could not write \"" << filepath << "\"" << std::endl;
+            return false;
+        }
+
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        ofs.write(
+            reinterpret_cast<const char*>(table.data()),
+            static_cast<std::streamsize>(table.size() * sizeof(CookedTextureLevel)));
+
+        for (std::size_t i = 0; i < levels.size(); ++i) {
+            // Pad up to the level's offset.
+            while (static_cast<std::uint64_t>(ofs.tellp()) < table[i].Offset) {
+                ofs.put('\0');
+            }
+
+            ofs.write(
+                reinterpret_cast<const char*>(levels[i].data()),
+                static_cast<std::streamsize>(levels[i].size()));
+        }
+
+        return static_cast<bool>(ofs);
+    }
+}
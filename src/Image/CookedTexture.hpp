@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Myst
+{
+    // The `.mtex` format written by `myst-cook`: a header, a table with one
+    // entry per mip level, then the level data. Everything is little-endian
+    // and laid out so the file can be memory-mapped and handed to GL as is.
+    constexpr std::uint32_t kCookedTextureMagic{0x5845544d}; // "MTEX"
+    constexpr std::uint32_t kCookedTextureVersion{1};
+    constexpr const char* kCookedTextureExtension{".mtex"};
+
+    enum class CookedFormat : std::uint32_t
+    {
+        R8 = 0,
+        RG8 = 1,
+        RGB8 = 2,
+        RGBA8 = 3,
+        BC1 = 4,
+        BC3 = 5,
+        BC5 = 6,
+        BC7 = 7,
+    };
+
+    enum CookedFlags : std::uint32_t
+    {
+        kCookedSRGB = 1 << 0,
+        kCookedNormalMap = 1 << 1,
+    };
+
+    struct CookedTextureHeader
+    {
+        std::uint32_t Magic;
+        std::uint32_t Version;
+        CookedFormat Format;
+        std::uint32_t Flags;
+        std::uint32_t Width;
+        std::uint32_t Height;
+        std::uint32_t Levels;
+        std::uint32_t Reserved;
+    };
+
+    struct CookedTextureLevel
+    {
+        std::uint32_t Width;
+        std::uint32_t Height;
+        std::uint64_t Offset;
+        std::uint64_t Size;
+    };
+
+    static_assert(sizeof(CookedTextureHeader) == 32, "unexpected padding");
+    static_assert(sizeof(CookedTextureLevel) == 24, "unexpected padding");
+
+    const char* GetCookedFormatName(CookedFormat format);
+    bool IsCookedTexture(const std::string& filepath);
+
+    // Validates the header and level table of a mapped file. On success the
+    // returned pointers point into `data`.
+    bool ParseCookedTexture(
+        const unsigned char* data,
+        std::size_t size,
+        const CookedTextureHeader*& header,
+        const CookedTextureLevel*& levels);
+
+    bool WriteCookedTexture(
+        const std::string& filepath,
+        CookedFormat format,
+        std::uint32_t flags,
+        const std::vector<std::vector<unsigned char>>& levels,
+        const std::vector<std::pair<int, int>>& sizes);
+}
@@ -0,0 +1,50 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace Myst
+{
+    // Tightly packed 8-bit image data on the CPU, one byte per channel.
+    struct Image
+    {
+        int Width{0};
+        int Height{0};
+        int Channels{0};
+
+        std::vector<unsigned char> Pixels;
+
+        Image() = default;
+
+        Image(int width, int height, int channels)
+            : Width(width)
+            , Height(height)
+            , Channels(channels)
+            , Pixels(static_cast<std::size_t>(width) * height * channels)
+        {
+            // Nothing to do.
+        }
+
+        std::size_t GetRowSize() const
+        {
+            return static_cast<std::size_t>(Width) * Channels;
+        }
+
+        unsigned char* GetRow(int y)
+        {
+            return Pixels.data() + GetRowSize() * y;
+        }
+
+        const unsigned char* GetRow(int y) const
+        {
+            return Pixels.data() + GetRowSize() * y;
+        }
+    };
+}
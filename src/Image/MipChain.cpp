@@ -0,0 +1,1015 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Image/MipChain.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define MYST_MIP_X86 1
+#include <immintrin.h>
+#endif
+
+// The AVX2 kernels are compiled for AVX2 individually, so the rest of the
+// build doesn't need -mavx2 and still runs on older CPUs.
+#if defined(MYST_MIP_X86) && defined(__GNUC__)
+#define MYST_MIP_AVX2 1
+#define MYST_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace Myst
+{
+    namespace
+    {
+        constexpr int kMaxTaps{6};
+        constexpr int kSRGBEncodeSize{16384};
+
+        // Taps are relative to 2x (or 2y) in the source image.
+        struct Kernel
+        {
+            int First;
+            int Count;
+            float Weights[kMaxTaps];
+        };
+
+        struct Tables
+        {
+            // Linear values and then sRGB ones, indexed by whether a channel
+            // is sRGB-encoded.
+            float Decode[2][256];
+            unsigned char EncodeSRGB[kSRGBEncodeSize + 1];
+        };
+
+        double BesselI0(double x)
+        {
+            double sum{1.0};
+            double term{1.0};
+
+            for (int k = 1; k < 32; ++k) {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                sum += term;
+            }
+
+            return sum;
+        }
+
+        Kernel BuildKernel(MipFilter filter)
+        {
+            if (filter == MipFilter::Box) {
+                return {0, 2, {0.5f, 0.5f}};
+            }
+
+            // A Lanczos-like sinc for a 2:1 reduction, windowed over three
+            // source pixels on either side of the output centre.
+            constexpr double kPi{3.14159265358979323846};
+            constexpr double kRadius{3.0};
+            constexpr double kBeta{4.0};
+
+            Kernel kernel{-2, 6, {}};
+            double weights[kMaxTaps];
+            double sum{0.0};
+
+            for (int i = 0; i < kernel.Count; ++i) {
+                double distance = (kernel.First + i) - 0.5;
+                double x = distance * 0.5 * kPi;
+                double t = distance / kRadius;
+
+                weights[i] = (std::sin(x) / x) *
+                             BesselI0(kBeta * std::sqrt(1.0 - t * t)) /
+                             BesselI0(kBeta);
+                sum += weights[i];
+            }
+
+            for (int i = 0; i < kernel.Count; ++i) {
+                kernel.Weights[i] = static_cast<float>(weights[i] / sum);
+            }
+
+            return kernel;
+        }
+
+        const Kernel& GetKernel(MipFilter filter)
+        {
+            static const Kernel box{BuildKernel(MipFilter::Box)};
+            static const Kernel kaiser{BuildKernel(MipFilter::Kaiser)};
+
+            return filter == MipFilter::Box ? box : kaiser;
+        }
+
+        Tables BuildTables()
+        {
+            Tables tables{};
+
+            for (int i = 0; i < 256; ++i) {
+                float value = i / 255.0f;
+
+                tables.Decode[0][i] = value;
+                tables.Decode[1][i] = value <= 0.04045f
+                    ? value / 12.92f
+                    : std::pow((value + 0.055f) / 1.055f, 2.4f);
+            }
+
+            for (int i = 0; i <= kSRGBEncodeSize; ++i) {
+                float value = static_cast<float>(i) / kSRGBEncodeSize;
+                float encoded = value <= 0.0031308f
+                    ? value * 12.92f
+                    : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+
+                tables.EncodeSRGB[i] =
+                    static_cast<unsigned char>(encoded * 255.0f + 0.5f);
+            }
+
+            return tables;
+        }
+
+        const Tables& GetTables()
+        {
+            static const Tables tables{BuildTables()};
+            return tables;
+        }
+
+        // Grey + alpha images only have one colour channel.
+        int GetColourChannels(int channels)
+        {
+            return channels == 2 ? 1 : std::min(channels, 3);
+        }
+
+        // Plain 8-bit data with a box filter doesn't need the float pipeline.
+        bool IsIntegerBox(const MipOptions& options)
+        {
+            return options.Filter == MipFilter::Box && !options.SRGB &&
+                   !options.NormalMap;
+        }
+
+        SimdLevel GetEffectiveLevel(const MipOptions& options)
+        {
+            return std::min(options.Simd, GetSimdLevel());
+        }
+
+        // Integer box filter ------------------------------------------------
+
+        void BoxRowScalar(
+            const unsigned char* row0,
+            const unsigned char* row1,
+            int sourceWidth,
+            int first,
+            int width,
+            int channels,
+            unsigned char* out)
+        {
+            for (int x = first; x < width; ++x) {
+                int x0 = std::min(2 * x, sourceWidth - 1) * channels;
+                int x1 = std::min(2 * x + 1, sourceWidth - 1) * channels;
+
+                for (int c = 0; c < channels; ++c) {
+                    int sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+                    out[x * channels + c] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        }
+
+#if defined(MYST_MIP_X86)
+        // Sums two vertically adjacent 4-pixel RGBA spans and then adjacent
+        // pixel pairs, leaving two rounded averages in 16-bit lanes.
+        __m128i BoxQuadSSE2(__m128i row0, __m128i row1)
+        {
+            const __m128i zero = _mm_setzero_si128();
+
+            __m128i lo = _mm_add_epi16(
+                _mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+            __m128i hi = _mm_add_epi16(
+                _mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+            __m128i sum = _mm_add_epi16(
+                _mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+
+            return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+        }
+
+        // Sums two vertically adjacent 8-pixel RGB spans and then adjacent
+        // pixel pairs, leaving four rounded averages in the low 12 bytes.
+        __m128i BoxTripleSSE2(const unsigned char* a, const unsigned char* b)
+        {
+            const __m128i zero = _mm_setzero_si128();
+
+            __m128i row0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+            __m128i row1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+            __m128i tail0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + 16));
+            __m128i tail1 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + 16));
+
+            // The 24 channel sums of the two rows, in 16-bit lanes.
+            __m128i v0 = _mm_add_epi16(
+                _mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+            __m128i v1 = _mm_add_epi16(
+                _mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+            __m128i v2 = _mm_add_epi16(
+                _mm_unpacklo_epi8(tail0, zero), _mm_unpacklo_epi8(tail1, zero));
+
+            // Lane i of s is v[i] + v[i + 3], a channel plus the same channel
+            // of the next pixel.
+            __m128i s0 = _mm_add_epi16(
+                v0, _mm_or_si128(_mm_srli_si128(v0, 6), _mm_slli_si128(v1, 10)));
+            __m128i s1 = _mm_add_epi16(
+                v1, _mm_or_si128(_mm_srli_si128(v1, 6), _mm_slli_si128(v2, 10)));
+            __m128i s2 = _mm_add_epi16(v2, _mm_srli_si128(v2, 6));
+
+            // Pixel pairs start every six lanes, so the averages are s[0-2],
+            // s[6-8], s[12-14] and s[18-20].
+            const __m128i keep0 = _mm_setr_epi16(-1, -1, -1, 0, 0, 0, 0, 0);
+            const __m128i keep1 = _mm_setr_epi16(0, 0, 0, -1, -1, 0, 0, 0);
+            const __m128i keep2 = _mm_setr_epi16(0, 0, 0, 0, 0, -1, 0, 0);
+            const __m128i keep3 = _mm_setr_epi16(0, 0, 0, 0, 0, 0, -1, -1);
+            const __m128i keep4 = _mm_setr_epi16(-1, 0, 0, 0, 0, 0, 0, 0);
+            const __m128i keep5 = _mm_setr_epi16(0, -1, -1, -1, 0, 0, 0, 0);
+
+            __m128i lo = _mm_or_si128(
+                _mm_or_si128(
+                    _mm_and_si128(s0, keep0),
+                    _mm_and_si128(_mm_srli_si128(s0, 6), keep1)),
+                _mm_or_si128(
+                    _mm_and_si128(_mm_slli_si128(s1, 10), keep2),
+                    _mm_and_si128(_mm_slli_si128(s1, 4), keep3)));
+            __m128i hi = _mm_or_si128(
+                _mm_and_si128(_mm_srli_si128(s1, 12), keep4),
+                _mm_and_si128(_mm_srli_si128(s2, 2), keep5));
+
+            const __m128i two = _mm_set1_epi16(2);
+
+            return _mm_packus_epi16(
+                _mm_srli_epi16(_mm_add_epi16(lo, two), 2),
+                _mm_srli_epi16(_mm_add_epi16(hi, two), 2));
+        }
+
+        void BoxRowSSE2(
+            const unsigned char* row0,
+            const unsigned char* row1,
+            int sourceWidth,
+            int width,
+            int channels,
+            unsigned char* out)
+        {
+            int x{0};
+
+            if (channels == 3) {
+                // Four output pixels from eight input pixels per iteration.
+                for (; 2 * (x + 4) <= sourceWidth; x += 4) {
+                    __m128i packed = BoxTripleSSE2(row0 + 6 * x, row1 + 6 * x);
+
+                    // Only 12 bytes are written, so that bands filled on
+                    // other threads are never touched.
+                    int last = _mm_cvtsi128_si32(_mm_srli_si128(packed, 8));
+
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 3 * x), packed);
+                    std::memcpy(out + 3 * x + 8, &last, sizeof(last));
+                }
+            }
+
+            if (channels == 4) {
+                // Four output pixels from eight input pixels per iteration.
+                for (; 2 * (x + 4) <= sourceWidth; x += 4) {
+                    const unsigned char* a = row0 + 8 * x;
+                    const unsigned char* b = row1 + 8 * x;
+
+                    __m128i first = BoxQuadSSE2(
+                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(a)),
+                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+                    __m128i second = BoxQuadSSE2(
+                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 16)),
+                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 16)));
+
+                    _mm_storeu_si128(
+                        reinterpret_cast<__m128i*>(out + 4 * x),
+                        _mm_packus_epi16(first, second));
+                }
+            }
+
+            BoxRowScalar(row0, row1, sourceWidth, x, width, channels, out);
+        }
+#endif
+
+#if defined(MYST_MIP_AVX2)
+        MYST_TARGET_AVX2 __m256i BoxQuadAVX2(__m256i row0, __m256i row1)
+        {
+            const __m256i zero = _mm256_setzero_si256();
+
+            __m256i lo = _mm256_add_epi16(
+                _mm256_unpacklo_epi8(row0, zero), _mm256_unpacklo_epi8(row1, zero));
+            __m256i hi = _mm256_add_epi16(
+                _mm256_unpackhi_epi8(row0, zero), _mm256_unpackhi_epi8(row1, zero));
+            __m256i sum = _mm256_add_epi16(
+                _mm256_unpacklo_epi64(lo, hi), _mm256_unpackhi_epi64(lo, hi));
+
+            return _mm256_srli_epi16(
+                _mm256_add_epi16(sum, _mm256_set1_epi16(2)), 2);
+        }
+
+        MYST_TARGET_AVX2 __m256i LoadLanesAVX2(
+            const unsigned char* low, const unsigned char* high)
+        {
+            return _mm256_inserti128_si256(
+                _mm256_castsi128_si256(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(low))),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(high)), 1);
+        }
+
+        // Sums two vertically adjacent 16-pixel RGB spans and then adjacent
+        // pixel pairs, leaving eight rounded averages in the low 24 bytes.
+        //
+        // Each 128-bit lane covers four input pixels: the shuffle puts the
+        // channels of a pixel pair next to each other, and maddubs adds them.
+        MYST_TARGET_AVX2 __m256i BoxTripleAVX2(
+            const unsigned char* a, const unsigned char* b)
+        {
+            const __m256i pairs = _mm256_setr_epi8(
+                0, 3, 1, 4, 2, 5, 6, 9, 7, 10, 8, 11, -1, -1, -1, -1,
+                0, 3, 1, 4, 2, 5, 6, 9, 7, 10, 8, 11, -1, -1, -1, -1);
+
+            // The last four pixels are loaded from 4 bytes early, so that
+            // nothing past the 48 bytes is read.
+            const __m256i shifted = _mm256_setr_epi8(
+                0, 3, 1, 4, 2, 5, 6, 9, 7, 10, 8, 11, -1, -1, -1, -1,
+                4, 7, 5, 8, 6, 9, 10, 13, 11, 14, 12, 15, -1, -1, -1, -1);
+            const __m256i ones = _mm256_set1_epi8(1);
+            const __m256i two = _mm256_set1_epi16(2);
+
+            // Input pixels 0-3 and 8-11, then 4-7 and 12-15.
+            __m256i first = _mm256_add_epi16(
+                _mm256_maddubs_epi16(
+                    _mm256_shuffle_epi8(LoadLanesAVX2(a, a + 24), pairs), ones),
+                _mm256_maddubs_epi16(
+                    _mm256_shuffle_epi8(LoadLanesAVX2(b, b + 24), pairs), ones));
+            __m256i second = _mm256_add_epi16(
+                _mm256_maddubs_epi16(
+                    _mm256_shuffle_epi8(LoadLanesAVX2(a + 12, a + 32), shifted), ones),
+                _mm256_maddubs_epi16(
+                    _mm256_shuffle_epi8(LoadLanesAVX2(b + 12, b + 32), shifted), ones));
+
+            __m256i packed = _mm256_packus_epi16(
+                _mm256_srli_epi16(_mm256_add_epi16(first, two), 2),
+                _mm256_srli_epi16(_mm256_add_epi16(second, two), 2));
+
+            // Each lane holds 6 + 2 + 6 + 2 bytes; close the gaps and then
+            // move the two lanes' 12 bytes together.
+            const __m256i compact = _mm256_setr_epi8(
+                0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1,
+                0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1);
+
+            return _mm256_permutevar8x32_epi32(
+                _mm256_shuffle_epi8(packed, compact),
+                _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        }
+
+        MYST_TARGET_AVX2 void BoxRowAVX2(
+            const unsigned char* row0,
+            const unsigned char* row1,
+            int sourceWidth,
+            int width,
+            int channels,
+            unsigned char* out)
+        {
+            int x{0};
+
+            if (channels == 3) {
+                // Eight output pixels from sixteen input pixels per iteration.
+                for (; 2 * (x + 8) <= sourceWidth; x += 8) {
+                    __m256i packed = BoxTripleAVX2(row0 + 6 * x, row1 + 6 * x);
+
+                    _mm_storeu_si128(
+                        reinterpret_cast<__m128i*>(out + 3 * x),
+                        _mm256_castsi256_si128(packed));
+                    _mm_storel_epi64(
+                        reinterpret_cast<__m128i*>(out + 3 * x + 16),
+                        _mm256_extracti128_si256(packed, 1));
+                }
+            }
+
+            if (channels == 4) {
+                // Eight output pixels from sixteen input pixels per iteration.
+                for (; 2 * (x + 8) <= sourceWidth; x += 8) {
+                    const unsigned char* a = row0 + 8 * x;
+                    const unsigned char* b = row1 + 8 * x;
+
+                    __m256i first = BoxQuadAVX2(
+                        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a)),
+                        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b)));
+                    __m256i second = BoxQuadAVX2(
+                        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + 32)),
+                        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 32)));
+
+                    // Unpacking and packing work within 128-bit lanes, which
+                    // leaves the 64-bit pixel pairs in 0, 2, 1, 3 order.
+                    __m256i packed = _mm256_permute4x64_epi64(
+                        _mm256_packus_epi16(first, second), 0xD8);
+
+                    _mm256_storeu_si256(
+                        reinterpret_cast<__m256i*>(out + 4 * x), packed);
+                }
+            }
+
+            BoxRowScalar(row0, row1, sourceWidth, x, width, channels, out);
+        }
+#endif
+
+        void BoxRow(
+            SimdLevel level,
+            const unsigned char* row0,
+            const unsigned char* row1,
+            int sourceWidth,
+            int width,
+            int channels,
+            unsigned char* out)
+        {
+            switch (level) {
+#if defined(MYST_MIP_AVX2)
+                case SimdLevel::AVX2:
+                    BoxRowAVX2(row0, row1, sourceWidth, width, channels, out);
+                    return;
+#endif
+#if defined(MYST_MIP_X86)
+                case SimdLevel::SSE2:
+                    BoxRowSSE2(row0, row1, sourceWidth, width, channels, out);
+                    return;
+#endif
+                default: break;
+            }
+
+            BoxRowScalar(row0, row1, sourceWidth, 0, width, channels, out);
+        }
+
+        // Float pipeline ----------------------------------------------------
+        //
+        // Rows are decoded to four floats per pixel whatever the channel count,
+        // so a pixel always maps onto a single 128-bit register.
+
+        void DecodeRowScalar(
+            const unsigned char* row,
+            int first,
+            int width,
+            int channels,
+            const MipOptions& options,
+            float* out)
+        {
+            const Tables& tables = GetTables();
+            const int colour = GetColourChannels(channels);
+
+            for (int x = first; x < width; ++x) {
+                float* pixel = out + 4 * x;
+
+                for (int c = 0; c < 4; ++c) {
+                    if (c >= channels) {
+                        pixel[c] = 0.0f;
+                        continue;
+                    }
+
+                    unsigned char value = row[x * channels + c];
+                    pixel[c] = tables.Decode[options.SRGB && c < colour][value];
+
+                    if (options.NormalMap && c < 3) {
+                        pixel[c] = pixel[c] * 2.0f - 1.0f;
+                    }
+                }
+
+                if (options.NormalMap && channels == 2) {
+                    float z = 1.0f - pixel[0] * pixel[0] - pixel[1] * pixel[1];
+                    pixel[2] = std::sqrt(std::max(z, 0.0f));
+                }
+            }
+        }
+
+        void EncodeRowScalar(
+            const float* row,
+            int first,
+            int width,
+            int channels,
+            const MipOptions& options,
+            unsigned char* out)
+        {
+            const Tables& tables = GetTables();
+            const int colour = GetColourChannels(channels);
+
+            for (int x = first; x < width; ++x) {
+                float pixel[4]{row[4 * x], row[4 * x + 1], row[4 * x + 2], row[4 * x + 3]};
+
+                if (options.NormalMap) {
+                    float length = std::sqrt(
+                        pixel[0] * pixel[0] + pixel[1] * pixel[1] +
+                        pixel[2] * pixel[2]);
+                    float scale = length > 0.0f ? 0.5f / length : 0.0f;
+
+                    for (int c = 0; c < 3; ++c) {
+                        pixel[c] = pixel[c] * scale + 0.5f;
+                    }
+                }
+
+                for (int c = 0; c < channels; ++c) {
+                    float value = std::min(std::max(pixel[c], 0.0f), 1.0f);
+
+                    out[x * channels + c] = options.SRGB && c < colour
+                        ? tables.EncodeSRGB[static_cast<int>(value * kSRGBEncodeSize + 0.5f)]
+                        : static_cast<unsigned char>(value * 255.0f + 0.5f);
+                }
+            }
+        }
+
+        // RGBA without a normal map is what nearly every texture is, and the
+        // only layout that maps straight onto vector lanes; the rest stays
+        // scalar.
+        //
+        // The table lookups are done one at a time at both levels: AVX2
+        // gathers measured slower than them.
+        bool IsPlainRGBA(int channels, const MipOptions& options)
+        {
+            return channels == 4 && !options.NormalMap;
+        }
+
+#if defined(MYST_MIP_X86)
+        void DecodeRowSSE2(
+            const unsigned char* row,
+            int width,
+            int channels,
+            const MipOptions& options,
+            float* out)
+        {
+            int x{0};
+
+            if (IsPlainRGBA(channels, options)) {
+                const Tables& tables = GetTables();
+                const float* colour = tables.Decode[options.SRGB];
+                const float* alpha = tables.Decode[0];
+
+                for (; x < width; ++x) {
+                    const unsigned char* pixel = row + 4 * x;
+
+                    _mm_storeu_ps(
+                        out + 4 * x,
+                        _mm_setr_ps(
+                            colour[pixel[0]], colour[pixel[1]], colour[pixel[2]],
+                            alpha[pixel[3]]));
+                }
+            }
+
+            DecodeRowScalar(row, x, width, channels, options, out);
+        }
+
+        void EncodeRowSSE2(
+            const float* row,
+            int width,
+            int channels,
+            const MipOptions& options,
+            unsigned char* out)
+        {
+            int x{0};
+
+            if (IsPlainRGBA(channels, options)) {
+                const unsigned char* encode = GetTables().EncodeSRGB;
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 one = _mm_set1_ps(1.0f);
+                const __m128 half = _mm_set1_ps(0.5f);
+
+                for (; x < width; ++x) {
+                    __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(row + 4 * x), zero), one);
+                    __m128i linear = _mm_cvttps_epi32(
+                        _mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), half));
+                    __m128i bytes = _mm_packs_epi32(linear, linear);
+                    int pixel = _mm_cvtsi128_si32(_mm_packus_epi16(bytes, bytes));
+
+                    std::memcpy(out + 4 * x, &pixel, sizeof(pixel));
+
+                    if (options.SRGB) {
+                        alignas(16) int indices[4];
+
+                        _mm_store_si128(
+                            reinterpret_cast<__m128i*>(indices),
+                            _mm_cvttps_epi32(_mm_add_ps(
+                                _mm_mul_ps(value, _mm_set1_ps(kSRGBEncodeSize)), half)));
+
+                        for (int c = 0; c < 3; ++c) {
+                            out[4 * x + c] = encode[indices[c]];
+                        }
+                    }
+                }
+            }
+
+            EncodeRowScalar(row, x, width, channels, options, out);
+        }
+#endif
+
+        void DecodeRow(
+            SimdLevel level,
+            const unsigned char* row,
+            int width,
+            int channels,
+            const MipOptions& options,
+            float* out)
+        {
+            switch (level) {
+#if defined(MYST_MIP_X86)
+                case SimdLevel::AVX2:
+                case SimdLevel::SSE2:
+                    DecodeRowSSE2(row, width, channels, options, out);
+                    return;
+#endif
+                default: break;
+            }
+
+            DecodeRowScalar(row, 0, width, channels, options, out);
+        }
+
+        void EncodeRow(
+            SimdLevel level,
+            const float* row,
+            int width,
+            int channels,
+            const MipOptions& options,
+            unsigned char* out)
+        {
+            switch (level) {
+#if defined(MYST_MIP_X86)
+                case SimdLevel::AVX2:
+                case SimdLevel::SSE2:
+                    EncodeRowSSE2(row, width, channels, options, out);
+                    return;
+#endif
+                default: break;
+            }
+
+            EncodeRowScalar(row, 0, width, channels, options, out);
+        }
+
+        void FilterVerticalScalar(
+            const float* const* rows,
+            const Kernel& kernel,
+            std::size_t count,
+            float* out)
+        {
+            for (std::size_t i = 0; i < count; ++i) {
+                float sum{0.0f};
+
+                for (int k = 0; k < kernel.Count; ++k) {
+                    sum += rows[k][i] * kernel.Weights[k];
+                }
+
+                out[i] = sum;
+            }
+        }
+
+        void FilterHorizontalScalar(
+            const float* row,
+            int sourceWidth,
+            const Kernel& kernel,
+            int first,
+            int width,
+            float* out)
+        {
+            for (int x = first; x < width; ++x) {
+                float sum[4]{};
+
+                for (int k = 0; k < kernel.Count; ++k) {
+                    int source = std::clamp(2 * x + kernel.First + k, 0, sourceWidth - 1);
+
+                    for (int c = 0; c < 4; ++c) {
+                        sum[c] += row[4 * source + c] * kernel.Weights[k];
+                    }
+                }
+
+                std::copy(sum, sum + 4, out + 4 * x);
+            }
+        }
+
+#if defined(MYST_MIP_X86)
+        void FilterVerticalSSE2(
+            const float* const* rows,
+            const Kernel& kernel,
+            std::size_t count,
+            float* out)
+        {
+            std::size_t i{0};
+
+            for (; i + 4 <= count; i += 4) {
+                __m128 sum = _mm_mul_ps(
+                    _mm_loadu_ps(rows[0] + i), _mm_set1_ps(kernel.Weights[0]));
+
+                for (int k = 1; k < kernel.Count; ++k) {
+                    sum = _mm_add_ps(
+                        sum, _mm_mul_ps(
+                                 _mm_loadu_ps(rows[k] + i),
+                                 _mm_set1_ps(kernel.Weights[k])));
+                }
+
+                _mm_storeu_ps(out + i, sum);
+            }
+
+            const float* tails[kMaxTaps];
+
+            for (int k = 0; k < kernel.Count; ++k) {
+                tails[k] = rows[k] + i;
+            }
+
+            FilterVerticalScalar(tails, kernel, count - i, out + i);
+        }
+
+        void FilterHorizontalSSE2(
+            const float* row,
+            int sourceWidth,
+            const Kernel& kernel,
+            int first,
+            int width,
+            float* out)
+        {
+            for (int x = first; x < width; ++x) {
+                __m128 sum = _mm_setzero_ps();
+
+                for (int k = 0; k < kernel.Count; ++k) {
+                    int source = std::clamp(2 * x + kernel.First + k, 0, sourceWidth - 1);
+
+                    sum = _mm_add_ps(
+                        sum, _mm_mul_ps(
+                                 _mm_loadu_ps(row + 4 * source),
+                                 _mm_set1_ps(kernel.Weights[k])));
+                }
+
+                _mm_storeu_ps(out + 4 * x, sum);
+            }
+        }
+#endif
+
+#if defined(MYST_MIP_AVX2)
+        MYST_TARGET_AVX2 void FilterVerticalAVX2(
+            const float* const* rows,
+            const Kernel& kernel,
+            std::size_t count,
+            float* out)
+        {
+            std::size_t i{0};
+
+            for (; i + 8 <= count; i += 8) {
+                __m256 sum = _mm256_mul_ps(
+                    _mm256_loadu_ps(rows[0] + i),
+                    _mm256_set1_ps(kernel.Weights[0]));
+
+                for (int k = 1; k < kernel.Count; ++k) {
+                    sum = _mm256_add_ps(
+                        sum, _mm256_mul_ps(
+                                 _mm256_loadu_ps(rows[k] + i),
+                                 _mm256_set1_ps(kernel.Weights[k])));
+                }
+
+                _mm256_storeu_ps(out + i, sum);
+            }
+
+            const float* tails[kMaxTaps];
+
+            for (int k = 0; k < kernel.Count; ++k) {
+                tails[k] = rows[k] + i;
+            }
+
+            FilterVerticalScalar(tails, kernel, count - i, out + i);
+        }
+
+        MYST_TARGET_AVX2 void FilterHorizontalAVX2(
+            const float* row,
+            int sourceWidth,
+            const Kernel& kernel,
+            int width,
+            float* out)
+        {
+            int x{0};
+
+            // Two output pixels per iteration, one in each 128-bit lane.
+            for (; x + 2 <= width; x += 2) {
+                __m256 sum = _mm256_setzero_ps();
+
+                for (int k = 0; k < kernel.Count; ++k) {
+                    int first = std::clamp(2 * x + kernel.First + k, 0, sourceWidth - 1);
+                    int second = std::clamp(2 * x + 2 + kernel.First + k, 0, sourceWidth - 1);
+
+                    __m256 pixels = _mm256_insertf128_ps(
+                        _mm256_castps128_ps256(_mm_loadu_ps(row + 4 * first)),
+                        _mm_loadu_ps(row + 4 * second), 1);
+
+                    sum = _mm256_add_ps(
+                        sum, _mm256_mul_ps(pixels, _mm256_set1_ps(kernel.Weights[k])));
+                }
+
+                _mm256_storeu_ps(out + 4 * x, sum);
+            }
+
+            FilterHorizontalSSE2(row, sourceWidth, kernel, x, width, out);
+        }
+#endif
+
+        void FilterVertical(
+            SimdLevel level,
+            const float* const* rows,
+            const Kernel& kernel,
+            std::size_t count,
+            float* out)
+        {
+            switch (level) {
+#if defined(MYST_MIP_AVX2)
+                case SimdLevel::AVX2:
+                    FilterVerticalAVX2(rows, kernel, count, out);
+                    return;
+#endif
+#if defined(MYST_MIP_X86)
+                case SimdLevel::SSE2:
+                    FilterVerticalSSE2(rows, kernel, count, out);
+                    return;
+#endif
+                default: break;
+            }
+
+            FilterVerticalScalar(rows, kernel, count, out);
+        }
+
+        void FilterHorizontal(
+            SimdLevel level,
+            const float* row,
+            int sourceWidth,
+            const Kernel& kernel,
+            int width,
+            float* out)
+        {
+            switch (level) {
+#if defined(MYST_MIP_AVX2)
+                case SimdLevel::AVX2:
+                    FilterHorizontalAVX2(row, sourceWidth, kernel, width, out);
+                    return;
+#endif
+#if defined(MYST_MIP_X86)
+                case SimdLevel::SSE2:
+                    FilterHorizontalSSE2(row, sourceWidth, kernel, 0, width, out);
+                    return;
+#endif
+                default: break;
+            }
+
+            FilterHorizontalScalar(row, sourceWidth, kernel, 0, width, out);
+        }
+
+        Image CreateLevel(const Image& image)
+        {
+            return Image(
+                std::max(1, image.Width / 2), std::max(1, image.Height / 2),
+                image.Channels);
+        }
+    }
+
+    SimdLevel GetSimdLevel()
+    {
+#if defined(MYST_MIP_AVX2)
+        static const SimdLevel level = __builtin_cpu_supports("avx2")
+            ? SimdLevel::AVX2
+            : SimdLevel::SSE2;
+        return level;
+#elif defined(MYST_MIP_X86)
+        return SimdLevel::SSE2;
+#else
+        return SimdLevel::Scalar;
+#endif
+    }
+
+    const char* GetSimdLevelName(SimdLevel level)
+    {
+        switch (level) {
+            case SimdLevel::Scalar: return "scalar";
+            case SimdLevel::SSE2: return "sse2";
+            case SimdLevel::AVX2: return "avx2";
+        }
+
+        return "unknown";
+    }
+
+    Image Downsample(const Image& image, const MipOptions& options)
+    {
+        Image result = CreateLevel(image);
+        DownsampleRows(image, options, 0, result.Height, result);
+
+        return result;
+    }
+
+    void DownsampleRows(
+        const Image& image,
+        const MipOptions& options,
+        int firstRow,
+        int lastRow,
+        Image& result)
+    {
+        if (firstRow >= lastRow) {
+            return;
+        }
+
+        const SimdLevel level = GetEffectiveLevel(options);
+
+        if (IsIntegerBox(options)) {
+            for (int y = firstRow; y < lastRow; ++y) {
+                BoxRow(
+                    level, image.GetRow(std::min(2 * y, image.Height - 1)),
+                    image.GetRow(std::min(2 * y + 1, image.Height - 1)),
+                    image.Width, result.Width, image.Channels, result.GetRow(y));
+            }
+
+            return;
+        }
+
+        const Kernel& kernel = GetKernel(options.Filter);
+        const std::size_t stride = static_cast<std::size_t>(image.Width) * 4;
+
+        // Every source row the band touches is decoded exactly once, into a
+        // ring of as many rows as the kernel has taps: by the time a row is
+        // overwritten, no output row below needs it.
+        int firstSource = std::max(2 * firstRow + kernel.First, 0);
+        int lastSource = std::min(
+            2 * (lastRow - 1) + kernel.First + kernel.Count - 1, image.Height - 1);
+        int nextSource = firstSource;
+
+        std::vector<float> decoded(static_cast<std::size_t>(kernel.Count) * stride);
+        std::vector<float> vertical(stride);
+        std::vector<float> horizontal(static_cast<std::size_t>(result.Width) * 4);
+
+        auto getDecoded = [&](int source) {
+            return decoded.data() + ((source - firstSource) % kernel.Count) * stride;
+        };
+
+        for (int y = firstRow; y < lastRow; ++y) {
+            const int lastTap = std::min(2 * y + kernel.First + kernel.Count - 1, lastSource);
+
+            for (; nextSource <= lastTap; ++nextSource) {
+                DecodeRow(
+                    level, image.GetRow(nextSource), image.Width, image.Channels,
+                    options, getDecoded(nextSource));
+            }
+
+            const float* rows[kMaxTaps];
+
+            for (int k = 0; k < kernel.Count; ++k) {
+                rows[k] = getDecoded(
+                    std::clamp(2 * y + kernel.First + k, firstSource, lastSource));
+            }
+
+            FilterVertical(level, rows, kernel, stride, vertical.data());
+            FilterHorizontal(
+                level, vertical.data(), image.Width, kernel, result.Width,
+                horizontal.data());
+            EncodeRow(
+                level, horizontal.data(), result.Width, result.Channels, options,
+                result.GetRow(y));
+        }
+    }
+
+    std::vector<Image> GenerateMipChain(
+        const Image& image, const MipOptions& options)
+    {
+        std::vector<Image> chain{image};
+
+        while (chain.back().Width > 1 || chain.back().Height > 1) {
+            chain.push_back(Downsample(chain.back(), options));
+        }
+
+        return chain;
+    }
+
+    std::vector<Image> GenerateMipChain(
+        const Image& image, const MipOptions& options, JobSystem& jobs)
+    {
+        std::vector<Image> chain{image};
+
+        // Small levels aren't worth the hand-off.
+        constexpr int kMinBandRows{16};
+        const int bands = static_cast<int>(jobs.GetThreadCount()) * 2;
+
+        while (chain.back().Width > 1 || chain.back().Height > 1) {
+            const Image& source = chain.back();
+            Image result = CreateLevel(source);
+
+            int step = std::max(kMinBandRows, (result.Height + bands - 1) / std::max(bands, 1));
+
+            if (step >= result.Height) {
+                DownsampleRows(source, options, 0, result.Height, result);
+            } else {
+                JobSystem::Counter counter;
+
+                for (int first = 0; first < result.Height; first += step) {
+                    int last = std::min(result.Height, first + step);
+
+                    jobs.Run(
+                        [&source, &options, &result, first, last]() {
+                            DownsampleRows(source, options, first, last, result);
+                        },
+                        &counter);
+                }
+
+                jobs.Wait(counter);
+            }
+
+            chain.push_back(std::move(result));
+        }
+
+        return chain;
+    }
+}
@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "Core/JobSystem.hpp"
+#include "Image/Image.hpp"
+
+namespace Myst
+{
+    enum class MipFilter
+    {
+        // 2x2 average.
+        Box,
+        // 6x6 windowed sinc, which keeps distant levels noticeably sharper.
+        Kaiser,
+    };
+
+    // Ordered from least to most capable.
+    enum class SimdLevel
+    {
+        Scalar,
+        SSE2,
+        AVX2,
+    };
+
+    // The best instruction set both this build and the running CPU support.
+    SimdLevel GetSimdLevel();
+    const char* GetSimdLevelName(SimdLevel level);
+
+    struct MipOptions
+    {
+        MipFilter Filter{MipFilter::Box};
+
+        // The colour channels are sRGB encoded and are filtered in linear
+        // space. Alpha is always linear.
+        bool SRGB{false};
+
+        // RGB (or RG, with Z reconstructed) hold a unit vector that is
+        // renormalized after filtering.
+        bool NormalMap{false};
+
+        // Capped to GetSimdLevel(), so lower levels can be forced for
+        // comparison.
+        SimdLevel Simd{GetSimdLevel()};
+    };
+
+    // Halves an image in both dimensions, rounding down but never below 1x1.
+    // On odd sizes the box filter drops the last row/column, while the Kaiser
+    // taps still reach it; taps past the edge are clamped to it, which is
+    // also how a 1-pixel dimension is kept.
+    Image Downsample(const Image& image, const MipOptions& options = {});
+
+    // Fills rows [firstRow, lastRow) of `result`, which must already have the
+    // downsampled size. Disjoint ranges can be filled concurrently.
+    void DownsampleRows(
+        const Image& image,
+        const MipOptions& options,
+        int firstRow,
+        int lastRow,
+        Image& result);
+
+    // Returns the full chain down to 1x1, with the image itself as level 0.
+    // Safe to call from several threads at once, one texture each.
+    std::vector<Image> GenerateMipChain(
+        const Image& image, const MipOptions& options = {});
+
+    // Same, but splits every level into bands of rows, run as jobs.
+    std::vector<Image> GenerateMipChain(
+        const Image& image, const MipOptions& options, JobSystem& jobs);
+}
@@ -0,0 +1,67 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "OpenGL/GLBuffer.hpp"
+
+namespace Myst
+{
+    GLBuffer::GLBuffer(GLsizeiptr size, GLbitfield flags, const void* data)
+        : mSize(size)
+        , mFlags(flags)
+    {
+        glCreateBuffers(1, &mID);
+        glNamedBufferStorage(mID, size, data, flags);
+    }
+
+    GLBuffer::~GLBuffer()
+    {
+        glDeleteBuffers(1, &mID);
+    }
+
+    void* GLBuffer::Map(GLintptr offset, GLsizeiptr length, GLbitfield access)
+    {
+        void* data = glMapNamedBufferRange(mID, offset, length, access);
+
+        if (data == nullptr) {
+            std::cerr << "gl: failed to map buffer " << mID << std::endl;
+        }
+
+        return data;
+    }
+
+    void GLBuffer::Unmap()
+    {
+        glUnmapNamedBuffer(mID);
+    }
+
+    void GLBuffer::Upload(GLintptr offset, GLsizeiptr size, const void* data)
+    {
+        if ((mFlags & GL_DYNAMIC_STORAGE_BIT) == 0) {
+            std::cerr << "myst: buffer " << mID << " has no dynamic storage"
+                      << std::endl;
+            return;
+        }
+
+        glNamedBufferSubData(mID, offset, size, data);
+    }
+
+    void GLBuffer::Bind(GLenum target)
+    {
+        glBindBuffer(target, mID);
+    }
+
+    void GLBuffer::BindBase(GLenum target, GLuint index)
+    {
+        glBindBufferBase(target, index, mID);
+    }
+
+    void GLBuffer::BindRange(
+        GLenum target, GLuint index, GLintptr offset, GLsizeiptr size)
+    {
+        glBindBufferRange(target, index, mID, offset, size);
+    }
+}
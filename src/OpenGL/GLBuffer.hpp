@@ -0,0 +1,53 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <iostream>
+
+#include <glad/glad.h>
+
+namespace Myst
+{
+    // A buffer object with immutable storage. The flags are passed straight to
+    // glNamedBufferStorage(), so they decide whether the buffer can be mapped
+    // or updated through Upload() afterwards.
+    class GLBuffer
+    {
+    public:
+        GLBuffer(GLsizeiptr size, GLbitfield flags, const void* data = nullptr);
+        ~GLBuffer();
+
+        GLBuffer(const GLBuffer&) = delete;
+        GLBuffer& operator=(const GLBuffer&) = delete;
+
+        GLuint GetID() const
+        {
+            return mID;
+        }
+
+        GLsizeiptr GetSize() const
+        {
+            return mSize;
+        }
+
+        void* Map(GLintptr offset, GLsizeiptr length, GLbitfield access);
+        void Unmap();
+
+        void Upload(GLintptr offset, GLsizeiptr size, const void* data);
+
+        void Bind(GLenum target);
+        void BindBase(GLenum target, GLuint index);
+        void BindRange(
+            GLenum target, GLuint index, GLintptr offset, GLsizeiptr size);
+
+    private:
+        GLuint mID;
+        GLsizeiptr mSize;
+        GLbitfield mFlags;
+    };
+}
@@ -0,0 +1,127 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "OpenGL/GLGpuProfiler.hpp"
+
+#include <algorithm>
+
+namespace Myst
+{
+    GLGpuProfiler::GLGpuProfiler(unsigned int frames, std::size_t maxScopes)
+        : mFrames(std::max(1u, frames))
+        , mFrame(0)
+        , mOffset(0)
+        , mTrack(Profiler::Get().AddTrack("GPU", "GPU"))
+        , mDropped(0)
+    {
+        for (Frame& frame : mFrames) {
+            frame.Queries.resize(maxScopes * 2);
+            glGenQueries(static_cast<GLsizei>(frame.Queries.size()), frame.Queries.data());
+        }
+
+        GLint64 now{0};
+        glGetInteger64v(GL_TIMESTAMP, &now);
+
+        mOffset = static_cast<std::int64_t>(Profiler::Now()) - now;
+    }
+
+    GLGpuProfiler::~GLGpuProfiler()
+    {
+        for (Frame& frame : mFrames) {
+            glDeleteQueries(static_cast<GLsizei>(frame.Queries.size()), frame.Queries.data());
+        }
+    }
+
+    void GLGpuProfiler::BeginFrame()
+    {
+        mOpen.clear();
+
+        mFrame = (mFrame + 1) % mFrames.size();
+        Collect(mFrames[mFrame]);
+    }
+
+    void GLGpuProfiler::Finish()
+    {
+        mOpen.clear();
+
+        glFinish();
+
+        // Oldest first, ending with the current frame.
+        for (std::size_t i = 1; i <= mFrames.size(); ++i) {
+            Collect(mFrames[(mFrame + i) % mFrames.size()]);
+        }
+    }
+
+    void GLGpuProfiler::Begin(const char* name)
+    {
+        Frame& frame = mFrames[mFrame];
+
+        // Leaves room for the ends of the scopes already open.
+        if (frame.Used + mOpen.size() + 2 > frame.Queries.size()) {
+            mOpen.push_back(kNone);
+            return;
+        }
+
+        glQueryCounter(frame.Queries[frame.Used], GL_TIMESTAMP);
+
+        mOpen.push_back(frame.Scopes.size());
+        frame.Scopes.push_back({name, frame.Used++, kNone});
+    }
+
+    void GLGpuProfiler::End()
+    {
+        if (mOpen.empty()) {
+            return;
+        }
+
+        Frame& frame = mFrames[mFrame];
+        const std::size_t scope = mOpen.back();
+        mOpen.pop_back();
+
+        if (scope == kNone) {
+            return;
+        }
+
+        glQueryCounter(frame.Queries[frame.Used], GL_TIMESTAMP);
+        frame.Scopes[scope].End = frame.Used++;
+    }
+
+    void GLGpuProfiler::Collect(Frame& frame)
+    {
+        if (frame.Used > 0) {
+            // Queries complete in order, so the last one stands for all.
+            GLint available{0};
+            glGetQueryObjectiv(frame.Queries[frame.Used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+            if (available) {
+                for (const Scope& scope : frame.Scopes) {
+                    if (scope.End == kNone) {
+                        continue;
+                    }
+
+                    GLuint64 begin{0};
+                    GLuint64 end{0};
+
+                    glGetQueryObjectui64v(frame.Queries[scope.Begin], GL_QUERY_RESULT, &begin);
+                    glGetQueryObjectui64v(frame.Queries[scope.End], GL_QUERY_RESULT, &end);
+
+                    Profiler::Get().AddScope(
+                        mTrack, scope.Name,
+                        static_cast<std::uint64_t>(std::max<std::int64_t>(
+                            0, static_cast<std::int64_t>(begin) + mOffset)),
+                        static_cast<std::uint64_t>(std::max<std::int64_t>(
+                            0, static_cast<std::int64_t>(end) + mOffset)));
+                }
+            } else {
+                ++mDropped;
+            }
+        }
+
+        frame.Used = 0;
+        frame.Scopes.clear();
+    }
+}
@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "Core/Profiler.hpp"
+
+namespace Myst
+{
+    // Times GPU work with timestamp queries, and hands the results to the
+    // Profiler on a "GPU" track, on the same clock as the CPU scopes.
+    //
+    // Every frame in flight has its own pool of queries. A frame's results
+    // are only read once its pool comes around again, `frames` frames later,
+    // and only if the GPU already wrote them; otherwise they are dropped, so
+    // reading them never waits on the GPU.
+    //
+    // Timestamps rather than GL_TIME_ELAPSED, which can't nest: a scope is a
+    // pair of them.
+    class GLGpuProfiler
+    {
+    public:
+        // Scopes past `maxScopes` in a frame are not timed.
+        GLGpuProfiler(unsigned int frames = 4, std::size_t maxScopes = 64);
+        ~GLGpuProfiler();
+
+        GLGpuProfiler(const GLGpuProfiler&) = delete;
+        GLGpuProfiler& operator=(const GLGpuProfiler&) = delete;
+
+        // Frames whose results weren't ready when their pool came around.
+        std::size_t GetDropped() const
+        {
+            return mDropped;
+        }
+
+        // Collects the oldest frame in flight and starts a new one.
+        void BeginFrame();
+
+        // Waits for the GPU, then collects every frame in flight; for when
+        // there is no next frame.
+        void Finish();
+
+        // Scopes nest. `name` must outlive the profiler.
+        void Begin(const char* name);
+        void End();
+
+    private:
+        struct Scope
+        {
+            const char* Name;
+            std::size_t Begin;
+            std::size_t End;
+        };
+
+        struct Frame
+        {
+            std::vector<GLuint> Queries;
+            std::size_t Used{0};
+            std::vector<Scope> Scopes;
+        };
+
+        void Collect(Frame& frame);
+
+    private:
+        std::vector<Frame> mFrames;
+        std::size_t mFrame;
+
+        // Open scopes of the current frame, or kNone for those not timed.
+        std::vector<std::size_t> mOpen;
+
+        // The profiler's clock minus the GPU's, in nanoseconds.
+        std::int64_t mOffset;
+        std::uint32_t mTrack;
+        std::size_t mDropped;
+
+        static constexpr std::size_t kNone{~std::size_t(0)};
+    };
+
+    // Times the enclosing block, if `profiler` isn't null.
+    class GLGpuScope
+    {
+    public:
+        GLGpuScope(GLGpuProfiler* profiler, const char* name)
+            : mProfiler(profiler)
+        {
+            if (mProfiler) {
+                mProfiler->Begin(name);
+            }
+        }
+
+        ~GLGpuScope()
+        {
+            if (mProfiler) {
+                mProfiler->End();
+            }
+        }
+
+        GLGpuScope(const GLGpuScope&) = delete;
+        GLGpuScope& operator=(const GLGpuScope&) = delete;
+
+    private:
+        GLGpuProfiler* mProfiler;
+    };
+}
+
+#if defined(MYST_PROFILING)
+#define MYST_GPU_SCOPE(profiler, name) \
+    ::Myst::GLGpuScope MYST_PROFILE_CONCAT(gpuScope, __LINE__)(profiler, name)
+#else
+#define MYST_GPU_SCOPE(profiler, name) static_cast<void>(0)
+#endif
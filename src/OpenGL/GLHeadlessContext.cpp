@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "OpenGL/GLHeadlessContext.hpp"
+
+#include <iostream>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+namespace Myst
+{
+    GLHeadlessContext::GLHeadlessContext()
+        : mDisplay(EGL_NO_DISPLAY)
+        , mContext(EGL_NO_CONTEXT)
+    {
+        // Nothing to do.
+    }
+
+    GLHeadlessContext::~GLHeadlessContext()
+    {
+        if (mContext != EGL_NO_CONTEXT) {
+            eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext(mDisplay, mContext);
+        }
+
+        if (mDisplay != EGL_NO_DISPLAY) {
+            eglTerminate(mDisplay);
+        }
+    }
+
+    bool GLHeadlessContext::Create()
+    {
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+        if (getPlatformDisplay != nullptr) {
+            mDisplay = getPlatformDisplay(
+                EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+
+        if (mDisplay == EGL_NO_DISPLAY) {
+            mDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+
+        EGLint major, minor;
+
+        if (mDisplay == EGL_NO_DISPLAY || !eglInitialize(mDisplay, &major, &minor)) {
+            std::cerr << "egl: initialization failed" << std::endl;
+            mDisplay = EGL_NO_DISPLAY;
+            return false;
+        }
+
+        if (!eglBindAPI(EGL_OPENGL_API)) {
+            std::cerr << "egl: no OpenGL support" << std::endl;
+            return false;
+        }
+
+        // Without surfaces, the config only picks the context's API.
+        const EGLint configAttributes[] = {
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE,
+        };
+
+        EGLConfig config{nullptr};
+        EGLint configs{0};
+        eglChooseConfig(mDisplay, configAttributes, &config, 1, &configs);
+
+        for (EGLint version : {6, 5}) {
+            const EGLint contextAttributes[] = {
+                EGL_CONTEXT_MAJOR_VERSION, 4,
+                EGL_CONTEXT_MINOR_VERSION, version,
+                EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                EGL_NONE,
+            };
+
+            mContext = eglCreateContext(
+                mDisplay, configs > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT,
+                contextAttributes);
+
+            if (mContext != EGL_NO_CONTEXT) {
+                break;
+            }
+        }
+
+        if (mContext == EGL_NO_CONTEXT) {
+            std::cerr << "egl: context creation failed (0x" << std::hex << eglGetError()
+                      << std::dec << ")" << std::endl;
+            return false;
+        }
+
+        if (!eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, mContext)) {
+            std::cerr << "egl: could not make the context current" << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    void* GLHeadlessContext::GetProcAddress(const char* name)
+    {
+        return reinterpret_cast<void*>(eglGetProcAddress(name));
+    }
+}
@@ -0,0 +1,37 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+namespace Myst
+{
+    // An OpenGL core context without any window or display server, through
+    // EGL's surfaceless platform, which Mesa provides for every driver down
+    // to llvmpipe. There is no default framebuffer: everything has to be
+    // rendered into framebuffer objects.
+    class GLHeadlessContext
+    {
+    public:
+        GLHeadlessContext();
+        ~GLHeadlessContext();
+
+        GLHeadlessContext(const GLHeadlessContext&) = delete;
+        GLHeadlessContext& operator=(const GLHeadlessContext&) = delete;
+
+        // Creates a 4.6 context, or 4.5 if that's the best the driver does,
+        // and makes it current.
+        bool Create();
+
+        // For glad.
+        static void* GetProcAddress(const char* name);
+
+    private:
+        // EGLDisplay and EGLContext, which keeps EGL out of this header.
+        void* mDisplay;
+        void* mContext;
+    };
+}
@@ -0,0 +1,211 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "OpenGL/GLProgramCache.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include "Core/Hash.hpp"
+
+namespace Myst
+{
+    namespace
+    {
+        constexpr std::uint32_t kMagic{0x4250594d}; // "MYPB"
+        constexpr std::uint32_t kVersion{1};
+
+        struct EntryHeader
+        {
+            std::uint32_t Magic;
+            std::uint32_t Version;
+            std::uint64_t Key;
+            std::uint32_t Format;
+            std::uint32_t Size;
+        };
+
+        std::string GetString(GLenum name)
+        {
+            const GLubyte* value = glGetString(name);
+            return value != nullptr ? reinterpret_cast<const char*>(value) : "";
+        }
+    }
+
+    GLProgramCache::GLProgramCache(const std::string& directory)
+        : mDirectory(directory)
+        , mSupported(false)
+    {
+        GLint formats{0};
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+        // Binaries are only valid for the exact driver that produced them, so
+        // the driver identity becomes part of every key.
+        mDriver = GetString(GL_VENDOR) + "\n" + GetString(GL_RENDERER) + "\n" +
+                  GetString(GL_VERSION) + "\n" +
+                  GetString(GL_SHADING_LANGUAGE_VERSION);
+
+        if (formats <= 0) {
+            std::cerr << "myst: driver doesn't support program binaries, "
+                         "shader cache disabled" << std::endl;
+            return;
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(mDirectory, error);
+
+        if (error) {
+            std::cerr << "myst: could not create shader cache directory \""
+                      << mDirectory << "\": " << error.message() << std::endl;
+            return;
+        }
+
+        mSupported = true;
+    }
+
+    GLProgramCache::~GLProgramCache()
+    {
+        // Nothing to do.
+    }
+
+    std::uint64_t GLProgramCache::ComputeKey(
+        const std::vector<const GLShader*>& shaders,
+        const std::string& defines) const
+    {
+        std::uint64_t key{Hash(mDriver)};
+
+        for (const GLShader* shader : shaders) {
+            GLenum type{shader->GetType()};
+
+            key = Hash(&type, sizeof(type), key);
+            key = Hash(shader->GetSource(), key);
+        }
+
+        return Hash(defines, key);
+    }
+
+    bool GLProgramCache::Load(std::uint64_t key, GLShaderProgram& program)
+    {
+        if (!mSupported) {
+            ++mStats.Misses;
+            return false;
+        }
+
+        std::string path{GetEntryPath(key)};
+        std::ifstream ifs(path, std::ios::binary);
+
+        if (!ifs.is_open()) {
+            ++mStats.Misses;
+            return false;
+        }
+
+        EntryHeader header{};
+        ifs.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+        // The binary must fill the rest of the file exactly, which also keeps
+        // a corrupt size from being allocated.
+        std::error_code error;
+        const std::uintmax_t fileSize = std::filesystem::file_size(path, error);
+
+        std::vector<unsigned char> binary;
+
+        if (ifs && !error && header.Magic == kMagic && header.Version == kVersion &&
+            header.Key == key && fileSize - sizeof(header) == header.Size) {
+            binary.resize(header.Size);
+            ifs.read(reinterpret_cast<char*>(binary.data()), header.Size);
+        }
+
+        if (binary.empty() || !ifs ||
+            !program.LoadBinary(
+                header.Format, binary.data(),
+                static_cast<GLsizei>(binary.size()))) {
+            // Stale or corrupt entry; it'll be replaced once the program has
+            // been compiled from source again.
+            ifs.close();
+            std::remove(path.c_str());
+
+            ++mStats.Rejected;
+            ++mStats.Misses;
+            return false;
+        }
+
+        ++mStats.Hits;
+        return true;
+    }
+
+    bool GLProgramCache::Store(std::uint64_t key, const GLShaderProgram& program)
+    {
+        if (!mSupported) {
+            return false;
+        }
+
+        GLenum format{GL_NONE};
+        std::vector<unsigned char> binary;
+
+        if (!program.GetBinary(format, binary)) {
+            std::cerr << "myst: could not retrieve program binary" << std::endl;
+            return false;
+        }
+
+        EntryHeader header{
+            kMagic, kVersion, key, static_cast<std::uint32_t>(format),
+            static_cast<std::uint32_t>(binary.size())};
+
+        // Write to a temporary file first, so a crash halfway through never
+        // leaves a truncated entry behind.
+        std::string path{GetEntryPath(key)};
+        std::string temporary{path + ".tmp"};
+
+        {
+            std::ofstream ofs(temporary, std::ios::binary | std::ios::trunc);
+
+            if (!ofs.is_open()) {
+                std::cerr << "myst: could not write \"" << temporary << "\""
+                          << std::endl;
+                return false;
+            }
+
+            ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            ofs.write(
+                reinterpret_cast<const char*>(binary.data()),
+                static_cast<std::streamsize>(binary.size()));
+
+            if (!ofs) {
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+
+        if (error) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+
+        ++mStats.Stored;
+        return true;
+    }
+
+    void GLProgramCache::PrintStats() const
+    {
+        std::cout << "myst: shader cache: " << mStats.Hits << " hits, "
+                  << mStats.Misses << " misses (" << mStats.Rejected
+                  << " rejected), " << mStats.Stored << " stored" << std::endl;
+    }
+
+    std::string GLProgramCache::GetEntryPath(std::uint64_t key) const
+    {
+        char name[32];
+        std::snprintf(
+            name, sizeof(name), "%016llx.bin",
+            static_cast<unsigned long long>(key));
+
+        return (std::filesystem::path(mDirectory) / name).string();
+    }
+}
@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "OpenGL/GLShader.hpp"
+
+namespace Myst
+{
+    // Persists linked program binaries on disk, so that a warm start can hand
+    // them straight to the driver instead of going through the GLSL compiler.
+    //
+    // Entries are keyed by the shader sources, their defines and the driver
+    // that produced them. Binaries rejected by the driver count as a miss.
+    class GLProgramCache
+    {
+    public:
+        struct Stats
+        {
+            std::size_t Hits{0};
+            std::size_t Misses{0};
+            std::size_t Rejected{0};
+            std::size_t Stored{0};
+        };
+
+        GLProgramCache(const std::string& directory);
+        ~GLProgramCache();
+
+        bool IsSupported() const
+        {
+            return mSupported;
+        }
+
+        const Stats& GetStats() const
+        {
+            return mStats;
+        }
+
+        std::uint64_t ComputeKey(
+            const std::vector<const GLShader*>& shaders,
+            const std::string& defines) const;
+
+        bool Load(std::uint64_t key, GLShaderProgram& program);
+        bool Store(std::uint64_t key, const GLShaderProgram& program);
+
+        void PrintStats() const;
+
+    private:
+        std::string GetEntryPath(std::uint64_t key) const;
+
+    private:
+        std::string mDirectory;
+        std::string mDriver;
+        bool mSupported;
+
+        Stats mStats;
+    };
+}
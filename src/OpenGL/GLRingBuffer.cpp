@@ -0,0 +1,127 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "OpenGL/GLRingBuffer.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "Core/Profiler.hpp"
+
+namespace Myst
+{
+    GLRingBuffer::GLRingBuffer(GLsizeiptr frameSize, unsigned int frames)
+        : mData(nullptr)
+        , mFrameSize(0)
+        , mAlignment(256)
+        , mHead(0)
+        , mFrame(0)
+        , mFences(frames, nullptr)
+        , mOverflowed(false)
+    {
+        GLint uniformAlignment{0};
+        GLint storageAlignment{0};
+
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+
+        // Ranges may be bound as uniform or as shader storage blocks, so they
+        // have to satisfy the stricter of both alignments.
+        mAlignment = std::max<GLsizeiptr>(
+            1, std::max(uniformAlignment, storageAlignment));
+        mFrameSize = (frameSize + mAlignment - 1) / mAlignment * mAlignment;
+
+        const GLbitfield flags =
+            GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        mBuffer = std::make_unique<GLBuffer>(mFrameSize * frames, flags);
+        mData = static_cast<unsigned char*>(
+            mBuffer->Map(0, mFrameSize * frames, flags));
+    }
+
+    GLRingBuffer::~GLRingBuffer()
+    {
+        for (GLsync fence : mFences) {
+            if (fence != nullptr) {
+                glDeleteSync(fence);
+            }
+        }
+
+        if (mData != nullptr) {
+            mBuffer->Unmap();
+        }
+    }
+
+    void GLRingBuffer::BeginFrame()
+    {
+        mFrame = (mFrame + 1) % mFences.size();
+        mHead = 0;
+
+        GLsync& fence = mFences[mFrame];
+
+        if (fence == nullptr) {
+            return;
+        }
+
+        // Normally the region was released frames ago and this returns right
+        // away; it only blocks when the CPU runs too far ahead of the GPU.
+        MYST_PROFILE_SCOPE("GLRingBuffer::BeginFrame");
+
+        GLbitfield flags{0};
+        GLuint64 timeout{0};
+
+        while (true) {
+            GLenum result = glClientWaitSync(fence, flags, timeout);
+
+            if (result == GL_ALREADY_SIGNALED ||
+                result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) {
+                break;
+            }
+
+            flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+            timeout = 1000000;
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    void GLRingBuffer::EndFrame()
+    {
+        mFences[mFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    GLRingBuffer::Range GLRingBuffer::Allocate(GLsizeiptr size)
+    {
+        Range range;
+
+        if (mData == nullptr) {
+            return range;
+        }
+
+        GLsizeiptr aligned = (size + mAlignment - 1) / mAlignment * mAlignment;
+
+        if (mHead + aligned > mFrameSize) {
+            if (!mOverflowed) {
+                std::cerr << "myst: ring buffer exhausted (" << mFrameSize
+                          << " bytes per frame)" << std::endl;
+                mOverflowed = true;
+            }
+
+            return range;
+        }
+
+        range.Buffer = mBuffer->GetID();
+        range.Offset = mFrameSize * mFrame + mHead;
+        range.Size = size;
+        range.Data = mData + range.Offset;
+
+        mHead += aligned;
+
+        return range;
+    }
+}
@@ -0,0 +1,113 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "OpenGL/GLBuffer.hpp"
+#include "OpenGL/GLStateCache.hpp"
+
+namespace Myst
+{
+    // A persistently mapped buffer split into one region per frame in flight.
+    // Every frame writes into its own region, and a fence guards each region
+    // so the CPU never overwrites data the GPU is still reading, without ever
+    // having to orphan or re-map the buffer.
+    class GLRingBuffer
+    {
+    public:
+        struct Range
+        {
+            GLuint Buffer{0};
+            GLintptr Offset{0};
+            GLsizeiptr Size{0};
+            void* Data{nullptr};
+
+            bool IsValid() const
+            {
+                return Data != nullptr;
+            }
+
+            void Bind(GLenum target, GLuint index) const
+            {
+                glBindBufferRange(target, index, Buffer, Offset, Size);
+            }
+
+            void Bind(GLStateCache& state, GLenum target, GLuint index) const
+            {
+                state.BindBufferRange(target, index, Buffer, Offset, Size);
+            }
+        };
+
+        GLRingBuffer(GLsizeiptr frameSize, unsigned int frames = 3);
+        ~GLRingBuffer();
+
+        GLRingBuffer(const GLRingBuffer&) = delete;
+        GLRingBuffer& operator=(const GLRingBuffer&) = delete;
+
+        GLuint GetID() const
+        {
+            return mBuffer->GetID();
+        }
+
+        // Every range starts at a multiple of this.
+        GLsizeiptr GetAlignment() const
+        {
+            return mAlignment;
+        }
+
+        GLsizeiptr GetFrameSize() const
+        {
+            return mFrameSize;
+        }
+
+        GLsizeiptr GetUsed() const
+        {
+            return mHead;
+        }
+
+        GLsizeiptr GetAvailable() const
+        {
+            return mFrameSize - mHead;
+        }
+
+        void BeginFrame();
+        void EndFrame();
+
+        Range Allocate(GLsizeiptr size);
+
+        template <typename T>
+        Range Push(const T& value)
+        {
+            Range range = Allocate(sizeof(T));
+
+            if (range.IsValid()) {
+                std::memcpy(range.Data, &value, sizeof(T));
+            }
+
+            return range;
+        }
+
+    private:
+        std::unique_ptr<GLBuffer> mBuffer;
+        unsigned char* mData;
+
+        GLsizeiptr mFrameSize;
+        GLsizeiptr mAlignment;
+        GLsizeiptr mHead;
+
+        unsigned int mFrame;
+        std::vector<GLsync> mFences;
+
+        bool mOverflowed;
+    };
+}
@@ -21,12 +21,34 @@ namespace Myst
         glDeleteShader(mID);
     }
 
+    bool GLShader::Load()
+    {
+        GLShaderPreprocessor preprocessor;
+        return Load(preprocessor, GLShaderPreprocessor::Defines{});
+    }
+
+    bool GLShader::Load(
+        GLShaderPreprocessor& preprocessor,
+        const GLShaderPreprocessor::Defines& defines)
+    {
+        if (!mSource.empty()) {
+            return true;
+        }
+
+        if (!preprocessor.Process(mFilepath, defines, mSource)) {
+            std::cerr << "myst: could not preprocess file \"" << mFilepath << "\"" << std::endl;
+            mSource.clear();
+            return false;
+        }
+
+        return true;
+    }
+
     bool GLShader::Compile()
     {
         GLint success{0};
 
-        if (!ReadFile()) {
-            std::cerr << "myst: could not read file \"" << mFilepath << "\"" << std::endl;
+        if (!Load()) {
             return false;
         }
 
@@ -40,28 +62,13 @@ namespace Myst
             char info[1024];
             glGetShaderInfoLog(mID, sizeof(info), NULL, info);
             glDeleteShader(mID);
-            std::cerr << "gl: shader compilation failed: " << info << std::endl;
+            std::cerr << "gl: shader compilation failed (" << mFilepath << "): " << info << std::endl;
             return false;
         }
 
         return true;
     }
 
-    bool GLShader::ReadFile()
-    {
-        std::ifstream ifs(mFilepath);
-        std::stringstream buffer;
-
-        if (!ifs.is_open()) {
-            return false;
-        }
-
-        buffer << ifs.rdbuf();
-        mSource = buffer.str();
-
-        return true;
-    }
-
     GLShaderProgram::GLShaderProgram()
     {
         mID = glCreateProgram();
@@ -69,7 +76,7 @@ namespace Myst
 
     GLShaderProgram::~GLShaderProgram()
     {
-        // Nothing to do.
+        glDeleteProgram(mID);
     }
 
     void GLShaderProgram::AttachShader(const GLShader& shader)
@@ -77,6 +84,14 @@ namespace Myst
         glAttachShader(mID, shader.GetID());
     }
 
+    void GLShaderProgram::SetBinaryRetrievable(bool retrievable)
+    {
+        // Only takes effect on the next link.
+        glProgramParameteri(
+            mID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+            retrievable ? GL_TRUE : GL_FALSE);
+    }
+
     bool GLShaderProgram::Link()
     {
         GLint success{0};
@@ -91,9 +106,48 @@ namespace Myst
             return false;
         }
 
+        Reflect();
+
         return true;
     }
 
+    bool GLShaderProgram::LoadBinary(
+        GLenum format, const void* binary, GLsizei size)
+    {
+        GLint success{0};
+
+        glProgramBinary(mID, format, binary, size);
+        glGetProgramiv(mID, GL_LINK_STATUS, &success);
+
+        // A driver is free to reject a binary at any time (e.g. after an
+        // update), which isn't an error: the caller simply has to compile.
+        if (success == GL_FALSE) {
+            return false;
+        }
+
+        Reflect();
+
+        return true;
+    }
+
+    bool GLShaderProgram::GetBinary(
+        GLenum& format, std::vector<unsigned char>& binary) const
+    {
+        GLint length{0};
+
+        glGetProgramiv(mID, GL_PROGRAM_BINARY_LENGTH, &length);
+
+        if (length <= 0) {
+            return false;
+        }
+
+        binary.resize(static_cast<std::size_t>(length));
+        glGetProgramBinary(mID, length, &length, &format, binary.data());
+        binary.resize(static_cast<std::size_t>(length));
+
+        return length > 0;
+    }
+
     void GLShaderProgram::Bind()
     {
         glUseProgram(mID);
@@ -104,33 +158,207 @@ namespace Myst
         glUseProgram(0);
     }
 
-    void GLShaderProgram::SetBool(const std::string& name, bool value) const
+    bool GLShaderProgram::HasUniform(const std::string& name) const
+    {
+        return mUniformIndices.find(name) != mUniformIndices.end();
+    }
+
+    void GLShaderProgram::SetBool(const std::string& name, bool value)
+    {
+        Set(GetUniform<bool>(name), value);
+    }
+
+    void GLShaderProgram::SetFloat(const std::string& name, float value)
+    {
+        Set(GetUniform<float>(name), value);
+    }
+
+    void GLShaderProgram::SetInt(const std::string& name, int value)
+    {
+        Set(GetUniform<int>(name), value);
+    }
+
+    void GLShaderProgram::SetMat3(const std::string& name, const glm::mat3& value)
+    {
+        Set(GetUniform<glm::mat3>(name), value);
+    }
+
+    void GLShaderProgram::SetMat4(const std::string& name, const glm::mat4& value)
+    {
+        Set(GetUniform<glm::mat4>(name), value);
+    }
+
+    void GLShaderProgram::SetVec3(const std::string& name, const glm::vec3& value)
+    {
+        Set(GetUniform<glm::vec3>(name), value);
+    }
+
+    void GLShaderProgram::Reflect()
+    {
+        GLint count{0};
+        GLint maxLength{0};
+
+        mUniforms.clear();
+        mUniformIndices.clear();
+        mShadow.clear();
+
+        glGetProgramiv(mID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(mID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        std::vector<char> buffer(static_cast<std::size_t>(maxLength) + 1);
+        std::size_t shadowSize{0};
+
+        for (GLint i = 0; i < count; ++i) {
+            Uniform uniform;
+            GLsizei length{0};
+
+            glGetActiveUniform(
+                mID, static_cast<GLuint>(i), static_cast<GLsizei>(buffer.size()),
+                &length, &uniform.Size, &uniform.Type, buffer.data());
+
+            std::string name(buffer.data(), static_cast<std::size_t>(length));
+            uniform.Location = glGetUniformLocation(mID, name.c_str());
+
+            // Members of uniform blocks don't have a location and can't be set
+            // through glUniform* anyway.
+            if (uniform.Location < 0) {
+                continue;
+            }
+
+            // Arrays are reported as "name[0]", but should be addressable by
+            // their plain name as well.
+            const std::string suffix{"[0]"};
+
+            if (name.size() > suffix.size() &&
+                name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                name.erase(name.size() - suffix.size());
+            }
+
+            uniform.Offset = shadowSize;
+            shadowSize += UniformTypeSize(uniform.Type);
+
+            mUniformIndices.emplace(name, static_cast<int>(mUniforms.size()));
+            mUniforms.push_back(uniform);
+        }
+
+        mShadow.resize(shadowSize);
+    }
+
+    std::size_t GLShaderProgram::UniformTypeSize(GLenum type)
+    {
+        switch (type) {
+            case GL_FLOAT_VEC2: return 2 * sizeof(float);
+            case GL_FLOAT_VEC3: return 3 * sizeof(float);
+            case GL_FLOAT_VEC4: return 4 * sizeof(float);
+            case GL_FLOAT_MAT3: return 9 * sizeof(float);
+            case GL_FLOAT_MAT4: return 16 * sizeof(float);
+            default: break;
+        }
+
+        // Everything else the traits accept is a single scalar (this includes
+        // booleans and samplers, which are written as integers).
+        return sizeof(float);
+    }
+
+    bool GLUniformTraits<bool>::Accepts(GLenum type)
+    {
+        return type == GL_BOOL || type == GL_INT;
+    }
+
+    void GLUniformTraits<bool>::Upload(
+        GLuint program, GLint location, const bool& value)
+    {
+        glProgramUniform1i(program, location, static_cast<int>(value));
+    }
+
+    bool GLUniformTraits<int>::Accepts(GLenum type)
+    {
+        switch (type) {
+            case GL_INT:
+            case GL_BOOL:
+            case GL_SAMPLER_1D:
+            case GL_SAMPLER_2D:
+            case GL_SAMPLER_3D:
+            case GL_SAMPLER_CUBE:
+            case GL_SAMPLER_2D_ARRAY:
+            case GL_SAMPLER_2D_SHADOW:
+                return true;
+
+            default: break;
+        }
+
+        return false;
+    }
+
+    void GLUniformTraits<int>::Upload(
+        GLuint program, GLint location, const int& value)
+    {
+        glProgramUniform1i(program, location, value);
+    }
+
+    bool GLUniformTraits<float>::Accepts(GLenum type)
+    {
+        return type == GL_FLOAT;
+    }
+
+    void GLUniformTraits<float>::Upload(
+        GLuint program, GLint location, const float& value)
+    {
+        glProgramUniform1f(program, location, value);
+    }
+
+    bool GLUniformTraits<glm::vec2>::Accepts(GLenum type)
+    {
+        return type == GL_FLOAT_VEC2;
+    }
+
+    void GLUniformTraits<glm::vec2>::Upload(
+        GLuint program, GLint location, const glm::vec2& value)
+    {
+        glProgramUniform2fv(program, location, 1, &value[0]);
+    }
+
+    bool GLUniformTraits<glm::vec3>::Accepts(GLenum type)
+    {
+        return type == GL_FLOAT_VEC3;
+    }
+
+    void GLUniformTraits<glm::vec3>::Upload(
+        GLuint program, GLint location, const glm::vec3& value)
+    {
+        glProgramUniform3fv(program, location, 1, &value[0]);
+    }
+
+    bool GLUniformTraits<glm::vec4>::Accepts(GLenum type)
     {
-        glUniform1i(glGetUniformLocation(mID, name.c_str()), (int)value);
+        return type == GL_FLOAT_VEC4;
     }
 
-    void GLShaderProgram::SetFloat(const std::string& name, float value) const
+    void GLUniformTraits<glm::vec4>::Upload(
+        GLuint program, GLint location, const glm::vec4& value)
     {
-        glUniform1f(glGetUniformLocation(mID, name.c_str()), value);
+        glProgramUniform4fv(program, location, 1, &value[0]);
     }
 
-    void GLShaderProgram::SetInt(const std::string& name, int value) const
+    bool GLUniformTraits<glm::mat3>::Accepts(GLenum type)
     {
-        glUniform1i(glGetUniformLocation(mID, name.c_str()), value);
+        return type == GL_FLOAT_MAT3;
     }
 
-    void GLShaderProgram::SetMat3(const std::string& name, const glm::mat3& value) const
+    void GLUniformTraits<glm::mat3>::Upload(
+        GLuint program, GLint location, const glm::mat3& value)
     {
-        glUniformMatrix3fv(glGetUniformLocation(mID, name.c_str()), 1, GL_FALSE, &value[0][0]);
+        glProgramUniformMatrix3fv(program, location, 1, GL_FALSE, &value[0][0]);
     }
 
-    void GLShaderProgram::SetMat4(const std::string& name, const glm::mat4& value) const
+    bool GLUniformTraits<glm::mat4>::Accepts(GLenum type)
     {
-        glUniformMatrix4fv(glGetUniformLocation(mID, name.c_str()), 1, GL_FALSE, &value[0][0]);
+        return type == GL_FLOAT_MAT4;
     }
 
-    void GLShaderProgram::SetVec3(const std::string& name, const glm::vec3& value) const
+    void GLUniformTraits<glm::mat4>::Upload(
+        GLuint program, GLint location, const glm::mat4& value)
     {
-        glUniform3fv(glGetUniformLocation(mID, name.c_str()), 1, &value[0]);
+        glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, &value[0][0]);
     }
 }
@@ -7,16 +7,23 @@
 
 #pragma once
 
+#include <cassert>
+#include <cstddef>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "OpenGL/GLShaderPreprocessor.hpp"
+
 namespace Myst
 {
     class GLShader
@@ -35,10 +42,21 @@ namespace Myst
             return mID;
         }
 
-        bool Compile();
+        const std::string& GetFilepath() const
+        {
+            return mFilepath;
+        }
 
-    private:
-        bool ReadFile();
+        const std::string& GetSource() const
+        {
+            return mSource;
+        }
+
+        bool Load();
+        bool Load(
+            GLShaderPreprocessor& preprocessor,
+            const GLShaderPreprocessor::Defines& defines);
+        bool Compile();
 
     private:
         GLenum mType;
@@ -48,25 +66,239 @@ namespace Myst
         std::string mSource;
     };
 
+    // Maps a C++ value type onto the GL uniform types it may be written to and
+    // the glProgramUniform* call that uploads it. Values are shadowed as the
+    // type GL keeps them as, so that types sharing a uniform compare alike.
+    template <typename T>
+    struct GLUniformTraits;
+
+    template <>
+    struct GLUniformTraits<bool>
+    {
+        using Stored = GLint;
+
+        static bool Accepts(GLenum type);
+        static void Upload(GLuint program, GLint location, const bool& value);
+    };
+
+    template <>
+    struct GLUniformTraits<int>
+    {
+        using Stored = GLint;
+
+        static bool Accepts(GLenum type);
+        static void Upload(GLuint program, GLint location, const int& value);
+    };
+
+    template <>
+    struct GLUniformTraits<float>
+    {
+        using Stored = float;
+
+        static bool Accepts(GLenum type);
+        static void Upload(GLuint program, GLint location, const float& value);
+    };
+
+    template <>
+    struct GLUniformTraits<glm::vec2>
+    {
+        using Stored = glm::vec2;
+
+        static bool Accepts(GLenum type);
+        static void Upload(
+            GLuint program, GLint location, const glm::vec2& value);
+    };
+
+    template <>
+    struct GLUniformTraits<glm::vec3>
+    {
+        using Stored = glm::vec3;
+
+        static bool Accepts(GLenum type);
+        static void Upload(
+            GLuint program, GLint location, const glm::vec3& value);
+    };
+
+    template <>
+    struct GLUniformTraits<glm::vec4>
+    {
+        using Stored = glm::vec4;
+
+        static bool Accepts(GLenum type);
+        static void Upload(
+            GLuint program, GLint location, const glm::vec4& value);
+    };
+
+    template <>
+    struct GLUniformTraits<glm::mat3>
+    {
+        using Stored = glm::mat3;
+
+        static bool Accepts(GLenum type);
+        static void Upload(
+            GLuint program, GLint location, const glm::mat3& value);
+    };
+
+    template <>
+    struct GLUniformTraits<glm::mat4>
+    {
+        using Stored = glm::mat4;
+
+        static bool Accepts(GLenum type);
+        static void Upload(
+            GLuint program, GLint location, const glm::mat4& value);
+    };
+
+    // A typed handle to an active uniform of a linked program. Handles are
+    // resolved once through GLShaderProgram::GetUniform() and are only valid
+    // for the program that produced them, which Set() checks.
+    template <typename T>
+    class GLUniform
+    {
+    public:
+        GLUniform() = default;
+
+        bool IsValid() const
+        {
+            return mIndex >= 0;
+        }
+
+    private:
+        friend class GLShaderProgram;
+
+        GLUniform(GLuint program, int index)
+            : mProgram(program)
+            , mIndex(index)
+        {
+            // Nothing to do.
+        }
+
+    private:
+        GLuint mProgram{0};
+        int mIndex{-1};
+    };
+
     class GLShaderProgram
     {
     public:
+        struct UniformStats
+        {
+            std::size_t Uploads{0};
+            std::size_t Skipped{0};
+        };
+
         GLShaderProgram();
         ~GLShaderProgram();
 
+        GLuint GetID() const
+        {
+            return mID;
+        }
+
+        const UniformStats& GetUniformStats() const
+        {
+            return mUniformStats;
+        }
+
         void AttachShader(const GLShader& shader);
+        void SetBinaryRetrievable(bool retrievable);
         bool Link();
+        bool LoadBinary(GLenum format, const void* binary, GLsizei size);
+        bool GetBinary(GLenum& format, std::vector<unsigned char>& binary) const;
         void Bind();
         void Unbind();
 
-        void SetBool(const std::string& name, bool value) const;
-        void SetFloat(const std::string& name, float value) const;
-        void SetInt(const std::string& name, int value) const;
-        void SetMat3(const std::string& name, const glm::mat3& value) const;
-        void SetMat4(const std::string& name, const glm::mat4& value) const;
-        void SetVec3(const std::string& name, const glm::vec3& value) const;
+        bool HasUniform(const std::string& name) const;
+
+        template <typename T>
+        GLUniform<T> GetUniform(const std::string& name) const;
+
+        // Uploads `value` unless the program already holds it. Array
+        // uniforms are written and shadowed at element 0 only; set other
+        // elements with glProgramUniform* directly, past the shadow.
+        template <typename T>
+        void Set(GLUniform<T> uniform, const T& value);
+
+        void SetBool(const std::string& name, bool value);
+        void SetFloat(const std::string& name, float value);
+        void SetInt(const std::string& name, int value);
+        void SetMat3(const std::string& name, const glm::mat3& value);
+        void SetMat4(const std::string& name, const glm::mat4& value);
+        void SetVec3(const std::string& name, const glm::vec3& value);
+
+    private:
+        struct Uniform
+        {
+            GLint Location{-1};
+            GLenum Type{GL_NONE};
+            GLint Size{0};
+
+            // Offset of the uniform's last uploaded value in the shadow.
+            std::size_t Offset{0};
+            bool Shadowed{false};
+        };
+
+        void Reflect();
+
+        static std::size_t UniformTypeSize(GLenum type);
 
     private:
         GLuint mID;
+
+        std::vector<Uniform> mUniforms;
+        std::unordered_map<std::string, int> mUniformIndices;
+        std::vector<unsigned char> mShadow;
+
+        UniformStats mUniformStats;
     };
+
+    template <typename T>
+    GLUniform<T> GLShaderProgram::GetUniform(const std::string& name) const
+    {
+        auto it = mUniformIndices.find(name);
+
+        if (it == mUniformIndices.end()) {
+            return GLUniform<T>{};
+        }
+
+        if (!GLUniformTraits<T>::Accepts(mUniforms[it->second].Type)) {
+            std::cerr << "myst: uniform \"" << name
+                      << "\" requested with a mismatching type" << std::endl;
+            return GLUniform<T>{};
+        }
+
+        return GLUniform<T>{mID, it->second};
+    }
+
+    template <typename T>
+    void GLShaderProgram::Set(GLUniform<T> uniform, const T& value)
+    {
+        if (!uniform.IsValid()) {
+            return;
+        }
+
+        // A handle from another program would index someone else's table.
+        if (uniform.mProgram != mID ||
+            static_cast<std::size_t>(uniform.mIndex) >= mUniforms.size()) {
+            assert(!"uniform handle used with the wrong program");
+            return;
+        }
+
+        Uniform& entry = mUniforms[uniform.mIndex];
+        unsigned char* shadow = &mShadow[entry.Offset];
+        const auto stored = static_cast<typename GLUniformTraits<T>::Stored>(value);
+
+        // Programs keep their uniform values, so when the shadow already
+        // holds this value the upload would be a no-op for the driver.
+        if (entry.Shadowed && std::memcmp(shadow, &stored, sizeof(stored)) == 0) {
+            ++mUniformStats.Skipped;
+            return;
+        }
+
+        std::memcpy(shadow, &stored, sizeof(stored));
+        entry.Shadowed = true;
+
+        GLUniformTraits<T>::Upload(mID, entry.Location, value);
+        ++mUniformStats.Uploads;
+    }
 }
@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "OpenGL/GLShaderLibrary.hpp"
+
+#include "Core/Hash.hpp"
+#include "Core/Profiler.hpp"
+
+namespace Myst
+{
+    GLShaderLibrary::GLShaderLibrary(GLProgramCache* programCache)
+        : mProgramCache(programCache)
+    {
+        // Nothing to do.
+    }
+
+    GLShaderLibrary::~GLShaderLibrary()
+    {
+        // Nothing to do.
+    }
+
+    void GLShaderLibrary::AddIncludeDirectory(const std::string& directory)
+    {
+        mPreprocessor.AddIncludeDirectory(directory);
+    }
+
+    void GLShaderLibrary::SetGlobalDefine(const std::string& name, const std::string& value)
+    {
+        mGlobalDefines[name] = value;
+    }
+
+    GLShaderProgram* GLShaderLibrary::Get(
+        const std::string& vertexShaderFilepath,
+        const std::string& fragmentShaderFilepath,
+        const GLShaderPreprocessor::Defines& defines)
+    {
+        GLShaderPreprocessor::Defines merged = defines;
+        merged.insert(mGlobalDefines.begin(), mGlobalDefines.end());
+
+        std::uint64_t key = ComputeVariantKey(
+            vertexShaderFilepath, fragmentShaderFilepath, merged);
+
+        return Find(
+            key,
+            {{vertexShaderFilepath, GL_VERTEX_SHADER},
+             {fragmentShaderFilepath, GL_FRAGMENT_SHADER}},
+            merged);
+    }
+
+    GLShaderProgram* GLShaderLibrary::GetCompute(
+        const std::string& computeShaderFilepath,
+        const GLShaderPreprocessor::Defines& defines)
+    {
+        // An empty fragment path can't collide with a graphics variant.
+        std::uint64_t key = ComputeVariantKey(computeShaderFilepath, "", defines);
+
+        return Find(key, {{computeShaderFilepath, GL_COMPUTE_SHADER}}, defines);
+    }
+
+    std::uint64_t GLShaderLibrary::ComputeVariantKey(
+        const std::string& vertexShaderFilepath,
+        const std::string& fragmentShaderFilepath,
+        const GLShaderPreprocessor::Defines& defines)
+    {
+        std::uint64_t key = Hash(vertexShaderFilepath);
+        key = Hash(fragmentShaderFilepath, key);
+
+        return Hash(GLShaderPreprocessor::FormatDefines(defines), key);
+    }
+
+    GLShaderProgram* GLShaderLibrary::Find(
+        std::uint64_t key,
+        const std::vector<Stage>& stages,
+        const GLShaderPreprocessor::Defines& defines)
+    {
+        auto it = mVariants.find(key);
+
+        if (it != mVariants.end()) {
+            return it->second.get();
+        }
+
+        // Failed variants are remembered as well, so a broken shader isn't
+        // recompiled on every draw that asks for it.
+        auto program = Create(stages, defines);
+
+        return mVariants.emplace(key, std::move(program)).first->second.get();
+    }
+
+    std::unique_ptr<GLShaderProgram> GLShaderLibrary::Create(
+        const std::vector<Stage>& stages,
+        const GLShaderPreprocessor::Defines& defines)
+    {
+        MYST_PROFILE_SCOPE("GLShaderLibrary::Create");
+
+        std::vector<std::unique_ptr<GLShader>> shaders;
+        std::vector<const GLShader*> attached;
+
+        for (const Stage& stage : stages) {
+            shaders.push_back(std::make_unique<GLShader>(stage.Filepath, stage.Type));
+            attached.push_back(shaders.back().get());
+
+            if (!shaders.back()->Load(mPreprocessor, defines)) {
+                return nullptr;
+            }
+        }
+
+        std::uint64_t key{0};
+
+        if (mProgramCache != nullptr) {
+            key = mProgramCache->ComputeKey(
+                attached, GLShaderPreprocessor::FormatDefines(defines));
+
+            auto cached = std::make_unique<GLShaderProgram>();
+
+            if (mProgramCache->Load(key, *cached)) {
+                return cached;
+            }
+        }
+
+        auto program = std::make_unique<GLShaderProgram>();
+
+        for (const auto& shader : shaders) {
+            if (!shader->Compile()) {
+                std::cerr << "gl: failed to compile " << shader->GetFilepath()
+                          << std::endl;
+                return nullptr;
+            }
+
+            program->AttachShader(*shader);
+        }
+
+        program->SetBinaryRetrievable(mProgramCache != nullptr);
+
+        if (!program->Link()) {
+            std::cerr << "gl: failed to link program" << std::endl;
+            return nullptr;
+        }
+
+        if (mProgramCache != nullptr) {
+            mProgramCache->Store(key, *program);
+        }
+
+        return program;
+    }
+}
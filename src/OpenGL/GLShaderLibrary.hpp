@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "OpenGL/GLProgramCache.hpp"
+#include "OpenGL/GLShader.hpp"
+#include "OpenGL/GLShaderPreprocessor.hpp"
+
+namespace Myst
+{
+    // Owns every program variant built from a vertex/fragment shader pair, or
+    // a compute shader, and a define set. Variants are compiled on first use
+    // and reused afterwards; when a program cache is given, they're restored
+    // from it instead.
+    class GLShaderLibrary
+    {
+    public:
+        GLShaderLibrary(GLProgramCache* programCache = nullptr);
+        ~GLShaderLibrary();
+
+        std::size_t GetVariantCount() const
+        {
+            return mVariants.size();
+        }
+
+        void AddIncludeDirectory(const std::string& directory);
+
+        // Adds a define to every vertex/fragment variant requested from now
+        // on, for features that are chosen per renderer rather than per
+        // material. Defines passed to Get() take precedence.
+        void SetGlobalDefine(const std::string& name, const std::string& value = "");
+
+        GLShaderProgram* Get(
+            const std::string& vertexShaderFilepath,
+            const std::string& fragmentShaderFilepath,
+            const GLShaderPreprocessor::Defines& defines = {});
+
+        GLShaderProgram* GetCompute(
+            const std::string& computeShaderFilepath,
+            const GLShaderPreprocessor::Defines& defines = {});
+
+        static std::uint64_t ComputeVariantKey(
+            const std::string& vertexShaderFilepath,
+            const std::string& fragmentShaderFilepath,
+            const GLShaderPreprocessor::Defines& defines);
+
+    private:
+        struct Stage
+        {
+            std::string Filepath;
+            GLenum Type;
+        };
+
+        GLShaderProgram* Find(
+            std::uint64_t key,
+            const std::vector<Stage>& stages,
+            const GLShaderPreprocessor::Defines& defines);
+
+        std::unique_ptr<GLShaderProgram> Create(
+            const std::vector<Stage>& stages,
+            const GLShaderPreprocessor::Defines& defines);
+
+    private:
+        GLProgramCache* mProgramCache;
+        GLShaderPreprocessor mPreprocessor;
+        GLShaderPreprocessor::Defines mGlobalDefines;
+
+        std::unordered_map<std::uint64_t, std::unique_ptr<GLShaderProgram>> mVariants;
+    };
+}
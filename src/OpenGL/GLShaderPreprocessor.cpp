@@ -0,0 +1,241 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "OpenGL/GLShaderPreprocessor.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace Myst
+{
+    namespace
+    {
+        constexpr int kMaxIncludeDepth{32};
+
+        // Returns the directive on a line ("version", "include", ...) and sets
+        // `argument` to whatever follows it.
+        std::string ParseDirective(const std::string& line, std::string& argument)
+        {
+            std::size_t start = line.find_first_not_of(" \t");
+
+            if (start == std::string::npos || line[start] != '#') {
+                return "";
+            }
+
+            start = line.find_first_not_of(" \t", start + 1);
+
+            if (start == std::string::npos) {
+                return "";
+            }
+
+            std::size_t end = line.find_first_of(" \t", start);
+            std::string directive = line.substr(start, end - start);
+
+            argument.clear();
+
+            if (end != std::string::npos) {
+                std::size_t first = line.find_first_not_of(" \t", end);
+                std::size_t last = line.find_last_not_of(" \t\r");
+
+                if (first != std::string::npos) {
+                    argument = line.substr(first, last - first + 1);
+                }
+            }
+
+            return directive;
+        }
+    }
+
+    GLShaderPreprocessor::GLShaderPreprocessor()
+    {
+        // Nothing to do.
+    }
+
+    GLShaderPreprocessor::~GLShaderPreprocessor()
+    {
+        // Nothing to do.
+    }
+
+    void GLShaderPreprocessor::AddIncludeDirectory(const std::string& directory)
+    {
+        mIncludeDirectories.push_back(directory);
+    }
+
+    bool GLShaderPreprocessor::Process(
+        const std::string& filepath, const Defines& defines, std::string& output)
+    {
+        std::set<std::string> included;
+
+        output.clear();
+
+        return Expand(filepath, &defines, included, output, 0);
+    }
+
+    std::string GLShaderPreprocessor::FormatDefines(const Defines& defines)
+    {
+        std::string result;
+
+        for (const auto& define : defines) {
+            result += "#define " + define.first;
+
+            if (!define.second.empty()) {
+                result += " " + define.second;
+            }
+
+            result += "\n";
+        }
+
+        return result;
+    }
+
+    bool GLShaderPreprocessor::Expand(
+        const std::string& filepath,
+        const Defines* defines,
+        std::set<std::string>& included,
+        std::string& output,
+        int depth)
+    {
+        if (depth > kMaxIncludeDepth) {
+            std::cerr << "myst: includes nested too deeply in \"" << filepath
+                      << "\"" << std::endl;
+            return false;
+        }
+
+        if (!included.insert(filepath).second) {
+            return true;
+        }
+
+        const std::string* source = ReadFile(filepath);
+
+        if (source == nullptr) {
+            std::cerr << "myst: could not read file \"" << filepath << "\""
+                      << std::endl;
+            return false;
+        }
+
+        int index = GetFileIndex(filepath);
+        int lineNumber = 0;
+
+        std::istringstream stream(*source);
+        std::string line;
+        std::string argument;
+
+        if (depth > 0) {
+            output += "#line 1 " + std::to_string(index) + "\n";
+        }
+
+        while (std::getline(stream, line)) {
+            ++lineNumber;
+
+            std::string directive = ParseDirective(line, argument);
+
+            if (directive == "version" && defines != nullptr) {
+                // Defines have to come after `#version`, which must be the
+                // first statement of the shader.
+                output += line + "\n";
+                output += FormatDefines(*defines);
+                output += "#line " + std::to_string(lineNumber + 1) + " " +
+                          std::to_string(index) + "\n";
+                defines = nullptr;
+                continue;
+            }
+
+            if (directive != "include") {
+                output += line + "\n";
+                continue;
+            }
+
+            if (argument.size() < 2 ||
+                !((argument.front() == '"' && argument.back() == '"') ||
+                  (argument.front() == '<' && argument.back() == '>'))) {
+                std::cerr << "myst: malformed include in \"" << filepath
+                          << "\" on line " << lineNumber << std::endl;
+                return false;
+            }
+
+            std::string name = argument.substr(1, argument.size() - 2);
+            std::string includePath;
+
+            if (!ResolveInclude(filepath, name, includePath)) {
+                std::cerr << "myst: could not resolve include \"" << name
+                          << "\" in \"" << filepath << "\" on line "
+                          << lineNumber << std::endl;
+                return false;
+            }
+
+            if (!Expand(includePath, nullptr, included, output, depth + 1)) {
+                return false;
+            }
+
+            output += "#line " + std::to_string(lineNumber + 1) + " " +
+                      std::to_string(index) + "\n";
+        }
+
+        return true;
+    }
+
+    bool GLShaderPreprocessor::ResolveInclude(
+        const std::string& includer,
+        const std::string& name,
+        std::string& filepath) const
+    {
+        namespace fs = std::filesystem;
+
+        std::vector<fs::path> candidates{fs::path(includer).parent_path() / name};
+
+        for (const std::string& directory : mIncludeDirectories) {
+            candidates.push_back(fs::path(directory) / name);
+        }
+
+        for (const fs::path& candidate : candidates) {
+            std::error_code error;
+
+            if (fs::is_regular_file(candidate, error)) {
+                filepath = candidate.lexically_normal().string();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    const std::string* GLShaderPreprocessor::ReadFile(const std::string& filepath)
+    {
+        auto it = mSources.find(filepath);
+
+        if (it != mSources.end()) {
+            return &it->second;
+        }
+
+        std::ifstream ifs(filepath);
+        std::stringstream buffer;
+
+        if (!ifs.is_open()) {
+            return nullptr;
+        }
+
+        buffer << ifs.rdbuf();
+
+        return &mSources.emplace(filepath, buffer.str()).first->second;
+    }
+
+    int GLShaderPreprocessor::GetFileIndex(const std::string& filepath)
+    {
+        auto it = std::find(mFiles.begin(), mFiles.end(), filepath);
+
+        if (it != mFiles.end()) {
+            return static_cast<int>(it - mFiles.begin());
+        }
+
+        mFiles.push_back(filepath);
+
+        return static_cast<int>(mFiles.size() - 1);
+    }
+}
@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Myst
+{
+    // Expands `#include "file"` directives and injects a set of defines right
+    // after the `#version` line, so that one source file can be specialized
+    // into several variants at compile time.
+    //
+    // Every file is included at most once per shader. `#line` directives are
+    // emitted so driver errors point at the right line, with the source string
+    // number being the file's index in GetFiles().
+    class GLShaderPreprocessor
+    {
+    public:
+        // Sorted by name so the same set always produces the same source (and
+        // therefore the same cache keys).
+        using Defines = std::map<std::string, std::string>;
+
+        GLShaderPreprocessor();
+        ~GLShaderPreprocessor();
+
+        const std::vector<std::string>& GetFiles() const
+        {
+            return mFiles;
+        }
+
+        void AddIncludeDirectory(const std::string& directory);
+
+        bool Process(
+            const std::string& filepath,
+            const Defines& defines,
+            std::string& output);
+
+        static std::string FormatDefines(const Defines& defines);
+
+    private:
+        bool Expand(
+            const std::string& filepath,
+            const Defines* defines,
+            std::set<std::string>& included,
+            std::string& output,
+            int depth);
+
+        bool ResolveInclude(
+            const std::string& includer,
+            const std::string& name,
+            std::string& filepath) const;
+
+        const std::string* ReadFile(const std::string& filepath);
+        int GetFileIndex(const std::string& filepath);
+
+    private:
+        std::vector<std::string> mIncludeDirectories;
+        std::vector<std::string> mFiles;
+
+        // Sources are shared by every variant, so they're read only once.
+        std::unordered_map<std::string, std::string> mSources;
+    };
+}
@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "OpenGL/GLStateCache.hpp"
+
+namespace Myst
+{
+    GLStateCache::GLStateCache()
+        : mStats{}
+    {
+        Invalidate();
+    }
+
+    void GLStateCache::UseProgram(GLuint program)
+    {
+        if (mProgram == program) {
+            ++mStats.Programs.Elided;
+            return;
+        }
+
+        glUseProgram(program);
+        mProgram = program;
+        ++mStats.Programs.Issued;
+    }
+
+    void GLStateCache::BindTexture(GLuint unit, GLuint texture)
+    {
+        if (unit < kTextureUnits) {
+            if (mTextures[unit] == texture) {
+                ++mStats.Textures.Elided;
+                return;
+            }
+
+            mTextures[unit] = texture;
+        }
+
+        glBindTextureUnit(unit, texture);
+        ++mStats.Textures.Issued;
+    }
+
+    void GLStateCache::BindVertexArray(GLuint vertexArray)
+    {
+        if (mVertexArray == vertexArray) {
+            ++mStats.VertexArrays.Elided;
+            return;
+        }
+
+        glBindVertexArray(vertexArray);
+        mVertexArray = vertexArray;
+        ++mStats.VertexArrays.Issued;
+    }
+
+    void GLStateCache::BindBufferRange(
+        GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+    {
+        BufferBinding* bindings{nullptr};
+
+        if (target == GL_UNIFORM_BUFFER) {
+            bindings = mUniformBuffers;
+        } else if (target == GL_SHADER_STORAGE_BUFFER) {
+            bindings = mStorageBuffers;
+        }
+
+        if (bindings != nullptr && index < kBufferBindings) {
+            BufferBinding& binding = bindings[index];
+
+            if (binding.Buffer == buffer && binding.Offset == offset &&
+                binding.Size == size) {
+                ++mStats.Buffers.Elided;
+                return;
+            }
+
+            binding = {buffer, offset, size};
+        }
+
+        glBindBufferRange(target, index, buffer, offset, size);
+        ++mStats.Buffers.Issued;
+    }
+
+    void GLStateCache::Invalidate()
+    {
+        mProgram = kUnknown;
+        mVertexArray = kUnknown;
+
+        for (GLuint& texture : mTextures) {
+            texture = kUnknown;
+        }
+
+        for (GLuint i = 0; i < kBufferBindings; ++i) {
+            mUniformBuffers[i] = {kUnknown, 0, 0};
+            mStorageBuffers[i] = {kUnknown, 0, 0};
+        }
+    }
+}
@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+namespace Myst
+{
+    // Shadows the bindings a draw changes and only forwards those that differ
+    // from what's already bound. Everything that draws through the cache must
+    // also bind through it; after raw GL calls, Invalidate() forgets the
+    // shadowed state so the next bind of each kind is issued again.
+    class GLStateCache
+    {
+    public:
+        // Texture units and indexed buffer bindings beyond these are passed
+        // through uncached.
+        static constexpr GLuint kTextureUnits{16};
+        static constexpr GLuint kBufferBindings{16};
+
+        struct Counter
+        {
+            std::size_t Issued;
+            std::size_t Elided;
+        };
+
+        struct Stats
+        {
+            Counter Programs;
+            Counter Textures;
+            Counter VertexArrays;
+            Counter Buffers;
+
+            std::size_t GetIssued() const
+            {
+                return Programs.Issued + Textures.Issued + VertexArrays.Issued +
+                       Buffers.Issued;
+            }
+
+            std::size_t GetElided() const
+            {
+                return Programs.Elided + Textures.Elided + VertexArrays.Elided +
+                       Buffers.Elided;
+            }
+        };
+
+        GLStateCache();
+
+        GLStateCache(const GLStateCache&) = delete;
+        GLStateCache& operator=(const GLStateCache&) = delete;
+
+        void UseProgram(GLuint program);
+
+        // Binds through glBindTextureUnit(), so no active texture unit is
+        // ever selected.
+        void BindTexture(GLuint unit, GLuint texture);
+
+        void BindVertexArray(GLuint vertexArray);
+
+        // `target` is GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER.
+        void BindBufferRange(
+            GLenum target, GLuint index, GLuint buffer, GLintptr offset,
+            GLsizeiptr size);
+
+        void Invalidate();
+
+        const Stats& GetStats() const
+        {
+            return mStats;
+        }
+
+        void ResetStats()
+        {
+            mStats = {};
+        }
+
+    private:
+        struct BufferBinding
+        {
+            GLuint Buffer;
+            GLintptr Offset;
+            GLsizeiptr Size;
+        };
+
+        // Names that no bind can match, so the first bind of each kind after
+        // Invalidate() is always issued.
+        static constexpr GLuint kUnknown{~0u};
+
+        GLuint mProgram;
+        GLuint mVertexArray;
+        GLuint mTextures[kTextureUnits];
+        BufferBinding mUniformBuffers[kBufferBindings];
+        BufferBinding mStorageBuffers[kBufferBindings];
+
+        Stats mStats;
+    };
+}
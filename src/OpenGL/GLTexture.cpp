@@ -7,11 +7,30 @@
 
 #include "OpenGL/GLTexture.hpp"
 
+#include <algorithm>
+#include <vector>
+
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include "Core/MappedFile.hpp"
+
+// S3TC isn't part of core OpenGL, but it's supported by every desktop driver.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
 namespace Myst
 {
+    GLTexture::GLTexture(GLenum target, Parameters params)
+        : GLTexture("", target, params)
+    {
+        // Nothing to do.
+    }
+
     GLTexture::GLTexture(const std::string& filepath, GLenum target)
         : GLTexture(filepath, target, Parameters{})
     {
@@ -24,15 +43,16 @@ namespace Myst
           mFilepath(filepath),
           mWidth(0),
           mHeight(0),
+          mMemoryUsage(0),
           mParams(params)
     {
-        glGenTextures(1, &mID);
+        glCreateTextures(target, 1, &mID);
         glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &mMaxTextureImageUnits);
     }
 
     GLTexture::~GLTexture()
     {
-        // Nothing to do.
+        glDeleteTextures(1, &mID);
     }
 
     bool GLTexture::Generate()
@@ -47,6 +67,10 @@ namespace Myst
 
     bool GLTexture::Generate(GLint mipmap, GLint depth)
     {
+        if (IsCookedTexture(mFilepath)) {
+            return GenerateCooked();
+        }
+
         // If we don't flip by the y-coordinate the image will be upside down.
         stbi_set_flip_vertically_on_load(true);
 
@@ -64,14 +88,14 @@ namespace Myst
         mHeight = static_cast<unsigned int>(height);
 
         GLenum format{DetermineFormat(channels)};
+        GLsizei levels{GetMipLevels(width, height)};
 
-        Bind();
+        mMemoryUsage = GetStorageSize(
+            mParams.StorageFormat, width, height, levels) *
+            static_cast<std::size_t>(std::max(depth, 1));
 
-        glTexParameteri(mTarget, GL_TEXTURE_MIN_FILTER, mParams.FilterMin);
-        glTexParameteri(mTarget, GL_TEXTURE_MAG_FILTER, mParams.FilterMax);
-        glTexParameteri(mTarget, GL_TEXTURE_WRAP_S, mParams.WrapS);
-        glTexParameteri(mTarget, GL_TEXTURE_WRAP_T, mParams.WrapT);
-        glTexParameteri(mTarget, GL_TEXTURE_WRAP_R, mParams.WrapR);
+        Bind();
+        ApplyParameters();
 
         switch (mTarget) {
             case GL_TEXTURE_1D:
@@ -82,6 +106,11 @@ namespace Myst
                 break;
 
             case GL_TEXTURE_2D:
+                if (mipmap == 0 && UsesMipmaps(mParams.FilterMin)) {
+                    GenerateMipChain2D(width, height, channels, format, data);
+                    break;
+                }
+
                 glTexImage2D(
                     GL_TEXTURE_2D, mipmap, mParams.StorageFormat, mWidth,
                     mHeight, 0, format, GL_UNSIGNED_BYTE, data);
@@ -108,6 +137,188 @@ namespace Myst
         return true;
     }
 
+    bool GLTexture::Allocate(GLsizei width, GLsizei height, GLsizei levels)
+    {
+        if (mTarget != GL_TEXTURE_2D) {
+            std::cerr << "myst: can only allocate 2D textures" << std::endl;
+            return false;
+        }
+
+        mWidth = static_cast<unsigned int>(width);
+        mHeight = static_cast<unsigned int>(height);
+
+        glTextureStorage2D(
+            mID, levels, GetSizedFormat(mParams.StorageFormat), width, height);
+
+        mMemoryUsage =
+            GetStorageSize(mParams.StorageFormat, width, height, levels);
+
+        ApplyParameters();
+
+        return true;
+    }
+
+    void GLTexture::SetImage(
+        GLint level,
+        GLint yOffset,
+        GLsizei width,
+        GLsizei height,
+        GLenum format,
+        const void* pixels)
+    {
+        // Rows of tightly packed RGB data generally aren't 4-byte aligned.
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTextureSubImage2D(
+            mID, level, 0, yOffset, width, height, format, GL_UNSIGNED_BYTE,
+            pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+    void GLTexture::GenerateMipmap()
+    {
+        glGenerateTextureMipmap(mID);
+    }
+
+    void GLTexture::Swap(GLTexture& other)
+    {
+        std::swap(mID, other.mID);
+        std::swap(mWidth, other.mWidth);
+        std::swap(mHeight, other.mHeight);
+        std::swap(mMemoryUsage, other.mMemoryUsage);
+        std::swap(mParams, other.mParams);
+    }
+
+    GLenum GLTexture::GetSizedFormat(GLenum format)
+    {
+        switch (format) {
+            case GL_RED: return GL_R8;
+            case GL_RG: return GL_RG8;
+            case GL_RGB: return GL_RGB8;
+            case GL_RGBA: return GL_RGBA8;
+            case GL_SRGB: return GL_SRGB8;
+            case GL_SRGB_ALPHA: return GL_SRGB8_ALPHA8;
+            default: break;
+        }
+
+        // Already sized (or compressed).
+        return format;
+    }
+
+    GLenum GLTexture::GetPixelFormat(int channels)
+    {
+        switch (channels) {
+            case 1: return GL_RED;
+            case 2: return GL_RG;
+            case 3: return GL_RGB;
+            default: break;
+        }
+
+        return GL_RGBA;
+    }
+
+    GLTexture::CookedFormatInfo GLTexture::GetCookedFormatInfo(
+        const CookedTextureHeader& header)
+    {
+        bool sRGB = (header.Flags & kCookedSRGB) != 0;
+
+        switch (header.Format) {
+            case CookedFormat::R8: return {GL_R8, GL_RED, false};
+            case CookedFormat::RG8: return {GL_RG8, GL_RG, false};
+            case CookedFormat::RGB8:
+                return {sRGB ? GLenum{GL_SRGB8} : GLenum{GL_RGB8}, GL_RGB, false};
+            case CookedFormat::RGBA8:
+                return {
+                    sRGB ? GLenum{GL_SRGB8_ALPHA8} : GLenum{GL_RGBA8}, GL_RGBA,
+                    false};
+            case CookedFormat::BC1:
+                return {
+                    sRGB ? GLenum{GL_COMPRESSED_SRGB_S3TC_DXT1_EXT}
+                         : GLenum{GL_COMPRESSED_RGB_S3TC_DXT1_EXT},
+                    GL_NONE, true};
+            case CookedFormat::BC3:
+                return {
+                    sRGB ? GLenum{GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT}
+                         : GLenum{GL_COMPRESSED_RGBA_S3TC_DXT5_EXT},
+                    GL_NONE, true};
+            case CookedFormat::BC5: return {GL_COMPRESSED_RG_RGTC2, GL_NONE, true};
+            case CookedFormat::BC7:
+                return {
+                    sRGB ? GLenum{GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM}
+                         : GLenum{GL_COMPRESSED_RGBA_BPTC_UNORM},
+                    GL_NONE, true};
+        }
+
+        return {GL_NONE, GL_NONE, false};
+    }
+
+    GLsizei GLTexture::GetMipLevels(GLsizei width, GLsizei height)
+    {
+        GLsizei levels{1};
+        GLsizei size{std::max(width, height)};
+
+        while (size > 1) {
+            size /= 2;
+            ++levels;
+        }
+
+        return levels;
+    }
+
+    std::size_t GLTexture::GetTexelSize(GLenum format)
+    {
+        switch (GetSizedFormat(format)) {
+            case GL_R8: return 1;
+            case GL_RG8: return 2;
+            default: break;
+        }
+
+        // Drivers pad three-channel formats to four bytes per texel.
+        return 4;
+    }
+
+    std::size_t GLTexture::GetStorageSize(
+        GLenum format, GLsizei width, GLsizei height, GLsizei levels)
+    {
+        std::size_t texelSize{GetTexelSize(format)};
+        std::size_t size{0};
+
+        for (GLsizei level = 0; level < levels; ++level) {
+            size += static_cast<std::size_t>(std::max(width >> level, 1)) *
+                    static_cast<std::size_t>(std::max(height >> level, 1)) *
+                    texelSize;
+        }
+
+        return size;
+    }
+
+    bool GLTexture::UsesMipmaps(GLenum filter)
+    {
+        return filter != GL_NEAREST && filter != GL_LINEAR;
+    }
+
+    bool GLTexture::IsSRGBFormat(GLenum format)
+    {
+        switch (format) {
+            case GL_SRGB:
+            case GL_SRGB_ALPHA:
+            case GL_SRGB8:
+            case GL_SRGB8_ALPHA8: return true;
+            default: break;
+        }
+
+        return false;
+    }
+
+    MipOptions GLTexture::GetMipOptions(const Parameters& params)
+    {
+        MipOptions options;
+        options.Filter = params.MipmapFilter;
+        options.SRGB = IsSRGBFormat(params.StorageFormat);
+        options.NormalMap = params.NormalMap;
+
+        return options;
+    }
+
     void GLTexture::Bind()
     {
         Bind(0);
@@ -127,6 +338,93 @@ namespace Myst
         glBindTexture(mTarget, 0);
     }
 
+    bool GLTexture::GenerateCooked()
+    {
+        MappedFile file;
+
+        if (!file.Open(mFilepath)) {
+            std::cerr << "myst: failed to map (" << mFilepath << ")" << std::endl;
+            return false;
+        }
+
+        const CookedTextureHeader* header{nullptr};
+        const CookedTextureLevel* levels{nullptr};
+
+        if (!ParseCookedTexture(file.GetData(), file.GetSize(), header, levels)) {
+            std::cerr << "myst: invalid cooked texture (" << mFilepath << ")"
+                      << std::endl;
+            return false;
+        }
+
+        if (mTarget != GL_TEXTURE_2D) {
+            std::cerr << "myst: cooked textures must be 2D" << std::endl;
+            return false;
+        }
+
+        CookedFormatInfo info = GetCookedFormatInfo(*header);
+
+        mWidth = header->Width;
+        mHeight = header->Height;
+        mMemoryUsage = 0;
+
+        for (std::uint32_t level = 0; level < header->Levels; ++level) {
+            mMemoryUsage += static_cast<std::size_t>(levels[level].Size);
+        }
+
+        Bind();
+        ApplyParameters();
+
+        // The mip chain was built offline, so only the levels that are present
+        // may be sampled.
+        glTexParameteri(mTarget, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(mTarget, GL_TEXTURE_MAX_LEVEL, header->Levels - 1);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        for (std::uint32_t level = 0; level < header->Levels; ++level) {
+            const unsigned char* data = file.GetData() + levels[level].Offset;
+
+            if (info.Compressed) {
+                glCompressedTexImage2D(
+                    GL_TEXTURE_2D, level, info.InternalFormat,
+                    levels[level].Width, levels[level].Height, 0,
+                    static_cast<GLsizei>(levels[level].Size), data);
+            } else {
+                glTexImage2D(
+                    GL_TEXTURE_2D, level, info.InternalFormat,
+                    levels[level].Width, levels[level].Height, 0,
+                    info.DataFormat, GL_UNSIGNED_BYTE, data);
+            }
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        Unbind();
+
+        return true;
+    }
+
+    void GLTexture::GenerateMipChain2D(
+        int width, int height, int channels, GLenum format, const unsigned char* data)
+    {
+        Image image(width, height, channels);
+        std::copy(data, data + image.Pixels.size(), image.Pixels.begin());
+
+        // glGenerateMipmap() box filters sRGB data in the wrong space on some
+        // drivers and can't treat normal maps as vectors, so the chain is
+        // built on the CPU instead.
+        std::vector<Image> chain = GenerateMipChain(image, GetMipOptions(mParams));
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        for (std::size_t level = 0; level < chain.size(); ++level) {
+            glTexImage2D(
+                GL_TEXTURE_2D, static_cast<GLint>(level), mParams.StorageFormat,
+                chain[level].Width, chain[level].Height, 0, format,
+                GL_UNSIGNED_BYTE, chain[level].Pixels.data());
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
     GLenum GLTexture::DetermineFormat(int channels)
     {
         switch (channels) {
@@ -137,4 +435,13 @@ namespace Myst
 
         return mParams.DataFormat;
     }
+
+    void GLTexture::ApplyParameters()
+    {
+        glTextureParameteri(mID, GL_TEXTURE_MIN_FILTER, mParams.FilterMin);
+        glTextureParameteri(mID, GL_TEXTURE_MAG_FILTER, mParams.FilterMax);
+        glTextureParameteri(mID, GL_TEXTURE_WRAP_S, mParams.WrapS);
+        glTextureParameteri(mID, GL_TEXTURE_WRAP_T, mParams.WrapT);
+        glTextureParameteri(mID, GL_TEXTURE_WRAP_R, mParams.WrapR);
+    }
 }
@@ -7,17 +7,28 @@
 
 #pragma once
 
+#include <cstddef>
 #include <iostream>
 #include <string>
 #include <utility>
 
 #include <glad/glad.h>
 
+#include "Image/CookedTexture.hpp"
+#include "Image/MipChain.hpp"
+
 namespace Myst
 {
     class GLTexture
     {
     public:
+        struct CookedFormatInfo
+        {
+            GLenum InternalFormat;
+            GLenum DataFormat;
+            bool Compressed;
+        };
+
         struct Parameters
         {
             GLenum DataFormat{GL_RED};
@@ -27,13 +38,22 @@ namespace Myst
             GLenum WrapS{GL_REPEAT};
             GLenum WrapT{GL_REPEAT};
             GLenum WrapR{GL_REPEAT};
+
+            // How 2D mipmaps are built on the CPU. sRGB filtering follows from
+            // the storage format.
+            MipFilter MipmapFilter{MipFilter::Box};
+            bool NormalMap{false};
         };
 
+        GLTexture(GLenum target, Parameters params);
         GLTexture(const std::string& filepath, GLenum target);
         GLTexture(
             const std::string& filepath, GLenum target, Parameters params);
         ~GLTexture();
 
+        GLTexture(const GLTexture&) = delete;
+        GLTexture& operator=(const GLTexture&) = delete;
+
         GLuint GetID() const
         {
             return mID;
@@ -54,16 +74,63 @@ namespace Myst
             return mHeight;
         }
 
+        const Parameters& GetParameters() const
+        {
+            return mParams;
+        }
+
+        // Estimated video memory held by the texture, including mipmaps.
+        std::size_t GetMemoryUsage() const
+        {
+            return mMemoryUsage;
+        }
+
         bool Generate();
         bool Generate(GLint mipmap);
         bool Generate(GLint mipmap, GLint depth);
 
+        // Allocates immutable storage for a 2D texture, to be filled through
+        // SetImage() afterwards.
+        bool Allocate(GLsizei width, GLsizei height, GLsizei levels);
+        void SetImage(
+            GLint level,
+            GLint yOffset,
+            GLsizei width,
+            GLsizei height,
+            GLenum format,
+            const void* pixels);
+        void GenerateMipmap();
+
+        // Exchanges the underlying GL objects, so a fully uploaded texture can
+        // replace a placeholder without invalidating pointers to either.
+        void Swap(GLTexture& other);
+
         void Bind();
         void Bind(GLint unit);
         void Unbind();
 
+        static GLenum GetSizedFormat(GLenum format);
+        static GLenum GetPixelFormat(int channels);
+        static CookedFormatInfo GetCookedFormatInfo(
+            const CookedTextureHeader& header);
+        static GLsizei GetMipLevels(GLsizei width, GLsizei height);
+        static bool UsesMipmaps(GLenum filter);
+        static bool IsSRGBFormat(GLenum format);
+        static MipOptions GetMipOptions(const Parameters& params);
+        static std::size_t GetTexelSize(GLenum format);
+        static std::size_t GetStorageSize(
+            GLenum format, GLsizei width, GLsizei height, GLsizei levels);
+
     private:
+        bool GenerateCooked();
+        void GenerateMipChain2D(
+            int width,
+            int height,
+            int channels,
+            GLenum format,
+            const unsigned char* data);
         GLenum DetermineFormat(int channels);
+        void ApplyParameters();
 
     private:
         GLuint mID;
@@ -73,6 +140,7 @@ namespace Myst
         std::string mFilepath;
         unsigned int mWidth;
         unsigned int mHeight;
+        std::size_t mMemoryUsage;
 
         Parameters mParams;
     };
@@ -0,0 +1,236 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "OpenGL/GLTextureArray.hpp"
+
+#include <algorithm>
+
+#include <stb_image.h>
+
+#include "Core/MappedFile.hpp"
+#include "Image/CookedTexture.hpp"
+#include "Image/MipChain.hpp"
+
+namespace Myst
+{
+    GLTextureArray::GLTextureArray(
+        GLsizei width,
+        GLsizei height,
+        GLsizei layers,
+        GLsizei levels,
+        GLenum internalFormat,
+        GLTexture::Parameters params)
+        : mWidth(width)
+        , mHeight(height)
+        , mLayers(layers)
+        , mLevels(levels)
+        , mInternalFormat(internalFormat)
+        , mParams(params)
+        , mUsedLayers(0)
+    {
+        glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &mID);
+        glTextureStorage3D(mID, levels, internalFormat, width, height, layers);
+
+        glTextureParameteri(mID, GL_TEXTURE_MIN_FILTER, params.FilterMin);
+        glTextureParameteri(mID, GL_TEXTURE_MAG_FILTER, params.FilterMax);
+        glTextureParameteri(mID, GL_TEXTURE_WRAP_S, params.WrapS);
+        glTextureParameteri(mID, GL_TEXTURE_WRAP_T, params.WrapT);
+    }
+
+    GLTextureArray::~GLTextureArray()
+    {
+        glDeleteTextures(1, &mID);
+    }
+
+    GLint GLTextureArray::AllocateLayer()
+    {
+        if (IsFull()) {
+            return -1;
+        }
+
+        return mUsedLayers++;
+    }
+
+    void GLTextureArray::SetLayer(
+        GLint layer,
+        GLint level,
+        GLsizei width,
+        GLsizei height,
+        GLenum format,
+        const void* pixels)
+    {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTextureSubImage3D(
+            mID, level, 0, 0, layer, width, height, 1, format,
+            GL_UNSIGNED_BYTE, pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+    void GLTextureArray::SetCompressedLayer(
+        GLint layer,
+        GLint level,
+        GLsizei width,
+        GLsizei height,
+        GLsizei size,
+        const void* data)
+    {
+        glCompressedTextureSubImage3D(
+            mID, level, 0, 0, layer, width, height, 1, mInternalFormat, size,
+            data);
+    }
+
+    void GLTextureArray::Bind(GLint unit)
+    {
+        glBindTextureUnit(static_cast<GLuint>(unit), mID);
+    }
+
+    bool GLTextureArray::IsCompatible(
+        GLsizei width,
+        GLsizei height,
+        GLsizei levels,
+        GLenum internalFormat,
+        const GLTexture::Parameters& params) const
+    {
+        return mWidth == width && mHeight == height && mLevels == levels &&
+               mInternalFormat == internalFormat &&
+               mParams.FilterMin == params.FilterMin &&
+               mParams.FilterMax == params.FilterMax &&
+               mParams.WrapS == params.WrapS && mParams.WrapT == params.WrapT;
+    }
+
+    GLTextureArrayPool::GLTextureArrayPool(GLsizei layersPerArray)
+        : mLayersPerArray(layersPerArray)
+    {
+        // Nothing to do.
+    }
+
+    GLTextureArrayPool::~GLTextureArrayPool()
+    {
+        // Nothing to do.
+    }
+
+    GLTextureArrayPool::Slot GLTextureArrayPool::Add(
+        const std::string& filepath, GLTexture::Parameters params)
+    {
+        if (IsCookedTexture(filepath)) {
+            return AddCooked(filepath, params);
+        }
+
+        stbi_set_flip_vertically_on_load(true);
+
+        int width, height, channels{0};
+        unsigned char* data{
+            stbi_load(filepath.c_str(), &width, &height, &channels, 0)};
+
+        if (data == nullptr) {
+            std::cerr << "stb: failed to load (" << filepath << ")" << std::endl;
+            return Slot{};
+        }
+
+        Image image(width, height, channels);
+        std::copy(data, data + image.Pixels.size(), image.Pixels.begin());
+        stbi_image_free(data);
+
+        return Add(image, params);
+    }
+
+    GLTextureArrayPool::Slot GLTextureArrayPool::Add(
+        const Image& image, GLTexture::Parameters params)
+    {
+        // Layers can't have their mips generated individually on the GPU, so
+        // the chain is built on the CPU instead.
+        std::vector<Image> chain = GLTexture::UsesMipmaps(params.FilterMin)
+            ? GenerateMipChain(image, GLTexture::GetMipOptions(params))
+            : std::vector<Image>{image};
+
+        Slot slot = Allocate(
+            image.Width, image.Height, static_cast<GLsizei>(chain.size()),
+            GLTexture::GetSizedFormat(params.StorageFormat), params);
+
+        if (!slot.IsValid()) {
+            return slot;
+        }
+
+        GLenum format = GLTexture::GetPixelFormat(image.Channels);
+
+        for (std::size_t level = 0; level < chain.size(); ++level) {
+            slot.Array->SetLayer(
+                slot.Layer, static_cast<GLint>(level), chain[level].Width,
+                chain[level].Height, format, chain[level].Pixels.data());
+        }
+
+        return slot;
+    }
+
+    GLTextureArrayPool::Slot GLTextureArrayPool::AddCooked(
+        const std::string& filepath, GLTexture::Parameters params)
+    {
+        MappedFile file;
+        const CookedTextureHeader* header{nullptr};
+        const CookedTextureLevel* levels{nullptr};
+
+        if (!file.Open(filepath) ||
+            !ParseCookedTexture(file.GetData(), file.GetSize(), header, levels)) {
+            std::cerr << "myst: invalid cooked texture (" << filepath << ")"
+                      << std::endl;
+            return Slot{};
+        }
+
+        GLTexture::CookedFormatInfo info = GLTexture::GetCookedFormatInfo(*header);
+        Slot slot = Allocate(
+            static_cast<GLsizei>(header->Width),
+            static_cast<GLsizei>(header->Height),
+            static_cast<GLsizei>(header->Levels), info.InternalFormat, params);
+
+        if (!slot.IsValid()) {
+            return slot;
+        }
+
+        for (std::uint32_t level = 0; level < header->Levels; ++level) {
+            const unsigned char* data = file.GetData() + levels[level].Offset;
+            GLsizei width = static_cast<GLsizei>(levels[level].Width);
+            GLsizei height = static_cast<GLsizei>(levels[level].Height);
+
+            if (info.Compressed) {
+                slot.Array->SetCompressedLayer(
+                    slot.Layer, static_cast<GLint>(level), width, height,
+                    static_cast<GLsizei>(levels[level].Size), data);
+            } else {
+                slot.Array->SetLayer(
+                    slot.Layer, static_cast<GLint>(level), width, height,
+                    info.DataFormat, data);
+            }
+        }
+
+        return slot;
+    }
+
+    GLTextureArrayPool::Slot GLTextureArrayPool::Allocate(
+        GLsizei width,
+        GLsizei height,
+        GLsizei levels,
+        GLenum internalFormat,
+        const GLTexture::Parameters& params)
+    {
+        auto it = std::find_if(
+            mArrays.begin(), mArrays.end(),
+            [&](const std::unique_ptr<GLTextureArray>& array) {
+                return !array->IsFull() &&
+                       array->IsCompatible(
+                           width, height, levels, internalFormat, params);
+            });
+
+        if (it == mArrays.end()) {
+            mArrays.push_back(std::make_unique<GLTextureArray>(
+                width, height, mLayersPerArray, levels, internalFormat,
+                params));
+            it = mArrays.end() - 1;
+        }
+
+        return Slot{it->get(), (*it)->AllocateLayer()};
+    }
+}
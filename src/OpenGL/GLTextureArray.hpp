@@ -0,0 +1,169 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "Image/Image.hpp"
+#include "OpenGL/GLTexture.hpp"
+
+namespace Myst
+{
+    // A 2D array texture with immutable storage. All layers share the same
+    // size, format and mip count, so textures packed into one array can be
+    // used by many materials behind a single binding.
+    class GLTextureArray
+    {
+    public:
+        GLTextureArray(
+            GLsizei width,
+            GLsizei height,
+            GLsizei layers,
+            GLsizei levels,
+            GLenum internalFormat,
+            GLTexture::Parameters params);
+        ~GLTextureArray();
+
+        GLTextureArray(const GLTextureArray&) = delete;
+        GLTextureArray& operator=(const GLTextureArray&) = delete;
+
+        GLuint GetID() const
+        {
+            return mID;
+        }
+
+        GLsizei GetWidth() const
+        {
+            return mWidth;
+        }
+
+        GLsizei GetHeight() const
+        {
+            return mHeight;
+        }
+
+        GLsizei GetLevels() const
+        {
+            return mLevels;
+        }
+
+        GLenum GetInternalFormat() const
+        {
+            return mInternalFormat;
+        }
+
+        GLsizei GetLayerCount() const
+        {
+            return mLayers;
+        }
+
+        GLsizei GetUsedLayers() const
+        {
+            return mUsedLayers;
+        }
+
+        bool IsFull() const
+        {
+            return mUsedLayers >= mLayers;
+        }
+
+        // Returns the index of a fresh layer, or -1 when the array is full.
+        GLint AllocateLayer();
+
+        void SetLayer(
+            GLint layer,
+            GLint level,
+            GLsizei width,
+            GLsizei height,
+            GLenum format,
+            const void* pixels);
+        void SetCompressedLayer(
+            GLint layer,
+            GLint level,
+            GLsizei width,
+            GLsizei height,
+            GLsizei size,
+            const void* data);
+
+        void Bind(GLint unit);
+
+        bool IsCompatible(
+            GLsizei width,
+            GLsizei height,
+            GLsizei levels,
+            GLenum internalFormat,
+            const GLTexture::Parameters& params) const;
+
+    private:
+        GLuint mID;
+
+        GLsizei mWidth;
+        GLsizei mHeight;
+        GLsizei mLayers;
+        GLsizei mLevels;
+        GLenum mInternalFormat;
+        GLTexture::Parameters mParams;
+
+        GLsizei mUsedLayers;
+    };
+
+    // Packs textures into layers of shared arrays, grouped by size and
+    // format, and hands out (array, layer) pairs for shaders to index into.
+    class GLTextureArrayPool
+    {
+    public:
+        struct Slot
+        {
+            GLTextureArray* Array{nullptr};
+            GLint Layer{-1};
+
+            bool IsValid() const
+            {
+                return Array != nullptr;
+            }
+        };
+
+        GLTextureArrayPool(GLsizei layersPerArray = 64);
+        ~GLTextureArrayPool();
+
+        const std::vector<std::unique_ptr<GLTextureArray>>& GetArrays() const
+        {
+            return mArrays;
+        }
+
+        // Loads an image file (or a cooked `.mtex` texture) into a layer.
+        Slot Add(
+            const std::string& filepath,
+            GLTexture::Parameters params = GLTexture::Parameters{});
+
+        // Uploads an 8-bit image and its CPU-generated mip chain into a layer.
+        Slot Add(
+            const Image& image,
+            GLTexture::Parameters params = GLTexture::Parameters{});
+
+    private:
+        Slot AddCooked(
+            const std::string& filepath, GLTexture::Parameters params);
+        Slot Allocate(
+            GLsizei width,
+            GLsizei height,
+            GLsizei levels,
+            GLenum internalFormat,
+            const GLTexture::Parameters& params);
+
+    private:
+        GLsizei mLayersPerArray;
+        std::vector<std::unique_ptr<GLTextureArray>> mArrays;
+    };
+}
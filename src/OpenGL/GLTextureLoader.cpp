@@ -0,0 +1,228 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "OpenGL/GLTextureLoader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <stb_image.h>
+
+#include "Core/Profiler.hpp"
+
+namespace Myst
+{
+    GLTextureLoader::GLTextureLoader(JobSystem& jobs, GLsizeiptr uploadBudget)
+        : mJobs(jobs)
+        , mInbox(std::make_shared<Inbox>())
+        , mPending(0)
+    {
+        mStaging = std::make_unique<GLRingBuffer>(uploadBudget);
+    }
+
+    GLTextureLoader::~GLTextureLoader()
+    {
+        // Nothing to do.
+    }
+
+    GLTextureLoader::Handle GLTextureLoader::Load(
+        const std::string& filepath, GLTexture::Parameters params)
+    {
+        auto request = std::make_shared<Request>();
+        request->Filepath = filepath;
+        request->Params = params;
+
+        // Cooked textures need no decoding and are uploaded straight from the
+        // mapped file, so there's nothing to gain from deferring them.
+        if (IsCookedTexture(filepath)) {
+            request->Texture =
+                std::make_unique<GLTexture>(filepath, GL_TEXTURE_2D, params);
+            request->Status = request->Texture->Generate() ? State::Ready
+                                                           : State::Failed;
+            return Handle(request);
+        }
+
+        request->Texture = std::make_unique<GLTexture>(GL_TEXTURE_2D, params);
+
+        // Until the real data arrives the texture is a single mid-grey texel,
+        // which is neutral enough for both colour and specular maps.
+        const unsigned char placeholder[4]{128, 128, 128, 255};
+
+        request->Texture->Allocate(1, 1, 1);
+        request->Texture->SetImage(0, 0, 1, 1, GL_RGBA, placeholder);
+
+        std::weak_ptr<Inbox> inbox = mInbox;
+        JobSystem& jobs = mJobs;
+
+        // The request is handed back to the main thread rather than released
+        // by the worker: if the handle is gone by then, the worker would be
+        // the one deleting the texture, without a GL context.
+        mJobs.Run([request, inbox, &jobs]() mutable {
+            Decode(*request);
+
+            jobs.RunOnMainThread([request = std::move(request), inbox]() {
+                if (auto target = inbox.lock()) {
+                    std::lock_guard<std::mutex> lock(target->Mutex);
+                    target->Requests.push_back(request);
+                }
+            });
+        });
+
+        ++mPending;
+
+        return Handle(request);
+    }
+
+    void GLTextureLoader::Update()
+    {
+        MYST_PROFILE_SCOPE("GLTextureLoader::Update");
+
+        {
+            std::lock_guard<std::mutex> lock(mInbox->Mutex);
+
+            for (auto& request : mInbox->Requests) {
+                if (request->Status == State::Failed) {
+                    --mPending;
+                    continue;
+                }
+
+                mUploads.push_back(std::move(request));
+            }
+
+            mInbox->Requests.clear();
+        }
+
+        if (mUploads.empty()) {
+            return;
+        }
+
+        mStaging->BeginFrame();
+
+        // Textures are uploaded strictly in order, so the oldest request is
+        // always the one that becomes ready first.
+        while (!mUploads.empty() && Upload(*mUploads.front())) {
+            Finish(*mUploads.front());
+            mUploads.pop_front();
+            --mPending;
+        }
+
+        mStaging->EndFrame();
+    }
+
+    void GLTextureLoader::Decode(Request& request)
+    {
+        MYST_PROFILE_SCOPE("GLTextureLoader::Decode");
+
+        // The flag is thread-local, so each worker has to set it itself.
+        stbi_set_flip_vertically_on_load_thread(true);
+
+        int width, height, channels{0};
+        unsigned char* data{
+            stbi_load(request.Filepath.c_str(), &width, &height, &channels, 0)};
+
+        if (data == nullptr) {
+            std::cerr << "stb: failed to load (" << request.Filepath << ")"
+                      << std::endl;
+            request.Status = State::Failed;
+            return;
+        }
+
+        Image image(width, height, channels);
+        std::copy(data, data + image.Pixels.size(), image.Pixels.begin());
+        stbi_image_free(data);
+
+        // Every worker builds the chain of its own texture, so textures are
+        // filtered in parallel with each other.
+        if (GLTexture::UsesMipmaps(request.Params.FilterMin)) {
+            request.Levels = GenerateMipChain(
+                image, GLTexture::GetMipOptions(request.Params));
+        } else {
+            request.Levels.push_back(std::move(image));
+        }
+
+        request.Status = State::Uploading;
+    }
+
+    bool GLTextureLoader::Upload(Request& request)
+    {
+        const Image& base = request.Levels.front();
+
+        if (!request.Staging) {
+            request.Staging =
+                std::make_unique<GLTexture>(GL_TEXTURE_2D, request.Params);
+            request.Staging->Allocate(
+                base.Width, base.Height,
+                static_cast<GLsizei>(request.Levels.size()));
+        }
+
+        GLenum format = GLTexture::GetPixelFormat(base.Channels);
+
+        while (request.NextLevel < request.Levels.size()) {
+            const Image& image = request.Levels[request.NextLevel];
+            GLint level = static_cast<GLint>(request.NextLevel);
+
+            GLsizeiptr rowSize = static_cast<GLsizeiptr>(image.GetRowSize());
+            GLsizeiptr fits = mStaging->GetAvailable() / rowSize;
+            GLsizeiptr rows = std::min<GLsizeiptr>(image.Height - request.NextRow, fits);
+
+            if (rows <= 0) {
+                // A single row that doesn't fit in an entire frame's budget
+                // would never make progress, so send it directly instead.
+                if (rowSize > mStaging->GetFrameSize()) {
+                    request.Staging->SetImage(
+                        level, request.NextRow, image.Width,
+                        image.Height - request.NextRow, format,
+                        image.GetRow(request.NextRow));
+                    ++request.NextLevel;
+                    request.NextRow = 0;
+                    continue;
+                }
+
+                return false;
+            }
+
+            GLRingBuffer::Range range = mStaging->Allocate(rows * rowSize);
+
+            if (!range.IsValid()) {
+                return false;
+            }
+
+            std::memcpy(range.Data, image.GetRow(request.NextRow), range.Size);
+
+            // With a pixel unpack buffer bound, the "pointer" is an offset into
+            // it.
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, range.Buffer);
+            request.Staging->SetImage(
+                level, request.NextRow, image.Width, static_cast<GLsizei>(rows),
+                format, reinterpret_cast<const void*>(range.Offset));
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+            request.NextRow += static_cast<int>(rows);
+
+            if (request.NextRow >= image.Height) {
+                ++request.NextLevel;
+                request.NextRow = 0;
+            }
+        }
+
+        return true;
+    }
+
+    void GLTextureLoader::Finish(Request& request)
+    {
+        // The placeholder ends up in the staging texture and is deleted with
+        // it, while the handle's texture now holds the real data.
+        request.Texture->Swap(*request.Staging);
+        request.Staging.reset();
+
+        request.Levels.clear();
+        request.Levels.shrink_to_fit();
+
+        request.Status = State::Ready;
+    }
+}
@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "Core/JobSystem.hpp"
+#include "Image/Image.hpp"
+#include "OpenGL/GLRingBuffer.hpp"
+#include "OpenGL/GLTexture.hpp"
+
+namespace Myst
+{
+    // Loads 2D textures without stalling the render thread. Images are decoded
+    // and have their mip chains built as jobs, then every level is
+    // streamed to the GPU through a persistently mapped pixel buffer, with at
+    // most `uploadBudget` bytes per frame.
+    //
+    // The texture behind a handle exists right away and shows a placeholder
+    // until its data has been uploaded completely, so it can be bound (and
+    // referenced by materials) before it's ready. Cooked textures are loaded
+    // immediately instead.
+    class GLTextureLoader
+    {
+    public:
+        enum class State
+        {
+            Decoding,
+            Uploading,
+            Ready,
+            Failed,
+        };
+
+    private:
+        struct Request
+        {
+            std::string Filepath;
+            std::unique_ptr<GLTexture> Texture;
+            std::atomic<State> Status{State::Decoding};
+
+            // Written by the decoding worker, read on the render thread once
+            // the request has been handed over.
+            GLTexture::Parameters Params;
+            std::vector<Image> Levels;
+
+            // Render thread only.
+            std::unique_ptr<GLTexture> Staging;
+            std::size_t NextLevel{0};
+            int NextRow{0};
+        };
+
+        // Shared with the workers, so decodes that finish after the loader is
+        // gone don't write into freed memory.
+        struct Inbox
+        {
+            std::mutex Mutex;
+            std::vector<std::shared_ptr<Request>> Requests;
+        };
+
+    public:
+        class Handle
+        {
+        public:
+            Handle() = default;
+
+            bool IsValid() const
+            {
+                return mRequest != nullptr;
+            }
+
+            State GetState() const
+            {
+                return mRequest->Status.load();
+            }
+
+            bool IsReady() const
+            {
+                return IsValid() && GetState() == State::Ready;
+            }
+
+            bool HasFailed() const
+            {
+                return IsValid() && GetState() == State::Failed;
+            }
+
+            // Always usable; shows the placeholder until IsReady().
+            GLTexture* GetTexture() const
+            {
+                return mRequest->Texture.get();
+            }
+
+        private:
+            friend class GLTextureLoader;
+
+            explicit Handle(std::shared_ptr<Request> request)
+                : mRequest(std::move(request))
+            {
+                // Nothing to do.
+            }
+
+        private:
+            std::shared_ptr<Request> mRequest;
+        };
+
+        GLTextureLoader(JobSystem& jobs, GLsizeiptr uploadBudget = 4 << 20);
+        ~GLTextureLoader();
+
+        std::size_t GetPendingCount() const
+        {
+            return mPending;
+        }
+
+        Handle Load(
+            const std::string& filepath,
+            GLTexture::Parameters params = GLTexture::Parameters{});
+
+        // Uploads as much decoded data as the budget allows. Must be called
+        // once per frame on the thread that owns the GL context, which must
+        // also run the job system's main thread jobs: decoded requests come
+        // back through them.
+        void Update();
+
+    private:
+        static void Decode(Request& request);
+        bool Upload(Request& request);
+        void Finish(Request& request);
+
+    private:
+        JobSystem& mJobs;
+        std::shared_ptr<Inbox> mInbox;
+
+        std::unique_ptr<GLRingBuffer> mStaging;
+        std::deque<std::shared_ptr<Request>> mUploads;
+        std::size_t mPending;
+    };
+}
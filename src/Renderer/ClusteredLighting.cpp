@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Renderer/ClusteredLighting.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "Core/Profiler.hpp"
+#include "Renderer/UniformBlocks.hpp"
+
+namespace Myst
+{
+    namespace
+    {
+        constexpr GLsizeiptr kInitialFrameSize{1 << 20};
+
+        // Generous room for the ring's alignment of each of the ranges.
+        constexpr GLsizeiptr kAlignmentSlack{7 * 256};
+
+        GLRingBuffer::Range PushArray(GLRingBuffer& ring, const void* data, std::size_t size)
+        {
+            // Storage blocks can't be bound empty.
+            GLRingBuffer::Range range =
+                ring.Allocate(static_cast<GLsizeiptr>(std::max<std::size_t>(size, 16)));
+
+            if (range.IsValid() && size > 0) {
+                std::memcpy(range.Data, data, size);
+            }
+
+            return range;
+        }
+    }
+
+    ClusteredLighting::ClusteredLighting(
+        std::uint32_t tilesX, std::uint32_t tilesY, std::uint32_t slices)
+        : mGrid(tilesX, tilesY, slices)
+        , mRing(std::make_unique<GLRingBuffer>(kInitialFrameSize))
+        , mFrameActive(false)
+    {
+        // Nothing to do.
+    }
+
+    void ClusteredLighting::BeginFrame()
+    {
+        mRing->BeginFrame();
+        mFrameActive = true;
+    }
+
+    void ClusteredLighting::EndFrame()
+    {
+        if (mFrameActive) {
+            mRing->EndFrame();
+            mFrameActive = false;
+        }
+    }
+
+    void ClusteredLighting::Update(
+        const LightSet& lights, const glm::mat4& view, const glm::mat4& projection,
+        float near, float far, const glm::vec2& viewportSize, GLStateCache& state)
+    {
+        MYST_PROFILE_SCOPE("ClusteredLighting::Update");
+
+        mGrid.Build(lights, view, projection, near, far);
+
+        const std::size_t count = lights.GetSize();
+        const std::size_t vectorsSize = count * sizeof(glm::vec4);
+        const std::size_t clustersSize = mGrid.GetClusters().size() * sizeof(glm::uvec2);
+        const std::size_t indicesSize = mGrid.GetIndices().size() * sizeof(std::uint32_t);
+
+        const GLsizeiptr frameSize = static_cast<GLsizeiptr>(
+            3 * vectorsSize + clustersSize + indicesSize + sizeof(LightGridBlock)) +
+            kAlignmentSlack;
+
+        // A new ring has no frames in flight, so it can be used right away;
+        // the old one is only freed once the GPU is done with it.
+        if (frameSize > mRing->GetAvailable()) {
+            GLsizeiptr size = std::max(mRing->GetFrameSize(), kInitialFrameSize);
+
+            while (size < frameSize) {
+                size *= 2;
+            }
+
+            std::cerr << "myst: growing the light ring to " << (size >> 10) << " KiB per frame"
+                      << std::endl;
+
+            mRing->EndFrame();
+            mRing = std::make_unique<GLRingBuffer>(size);
+            mRing->BeginFrame();
+            mFrameActive = true;
+        }
+
+        // The positions are interleaved with the radii here, as the shader
+        // reads them together.
+        GLRingBuffer::Range positions = mRing->Allocate(
+            static_cast<GLsizeiptr>(std::max<std::size_t>(vectorsSize, 16)));
+
+        if (positions.IsValid()) {
+            auto* out = static_cast<glm::vec4*>(positions.Data);
+
+            for (std::size_t i = 0; i < count; ++i) {
+                out[i] = glm::vec4(
+                    lights.GetPositionX()[i], lights.GetPositionY()[i],
+                    lights.GetPositionZ()[i], lights.GetRadius()[i]);
+            }
+        }
+
+        GLRingBuffer::Range colors =
+            PushArray(*mRing, lights.GetColors().data(), vectorsSize);
+        GLRingBuffer::Range attenuations =
+            PushArray(*mRing, lights.GetAttenuations().data(), vectorsSize);
+        GLRingBuffer::Range clusters =
+            PushArray(*mRing, mGrid.GetClusters().data(), clustersSize);
+        GLRingBuffer::Range indices =
+            PushArray(*mRing, mGrid.GetIndices().data(), indicesSize);
+
+        LightGridBlock block{};
+        block.Size = glm::uvec4(
+            mGrid.GetTilesX(), mGrid.GetTilesY(), mGrid.GetSlices(),
+            static_cast<std::uint32_t>(count));
+        block.Scale = glm::vec4(
+            static_cast<float>(mGrid.GetTilesX()) / viewportSize.x,
+            static_cast<float>(mGrid.GetTilesY()) / viewportSize.y,
+            mGrid.GetSliceScale(), mGrid.GetSliceBias());
+
+        GLRingBuffer::Range grid = mRing->Push(block);
+
+        if (!positions.IsValid() || !colors.IsValid() || !attenuations.IsValid() ||
+            !clusters.IsValid() || !indices.IsValid() || !grid.IsValid()) {
+            return;
+        }
+
+        grid.Bind(state, GL_UNIFORM_BUFFER, kLightGridBlockBinding);
+        positions.Bind(state, GL_SHADER_STORAGE_BUFFER, kLightPositionBufferBinding);
+        colors.Bind(state, GL_SHADER_STORAGE_BUFFER, kLightColorBufferBinding);
+        attenuations.Bind(state, GL_SHADER_STORAGE_BUFFER, kLightAttenuationBufferBinding);
+        clusters.Bind(state, GL_SHADER_STORAGE_BUFFER, kLightClusterBufferBinding);
+        indices.Bind(state, GL_SHADER_STORAGE_BUFFER, kLightIndexBufferBinding);
+    }
+}
@@ -0,0 +1,57 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "OpenGL/GLRingBuffer.hpp"
+#include "OpenGL/GLStateCache.hpp"
+#include "Renderer/LightGrid.hpp"
+#include "Scene/Light.hpp"
+
+namespace Myst
+{
+    // Feeds the `CLUSTERED_LIGHTING` shader variants: every frame the lights
+    // are binned into a LightGrid on the CPU, and the lights, in their
+    // structure-of-arrays form, the clusters and the light index lists are
+    // streamed into storage buffers of their own ring.
+    class ClusteredLighting
+    {
+    public:
+        ClusteredLighting(
+            std::uint32_t tilesX = 16, std::uint32_t tilesY = 9, std::uint32_t slices = 24);
+
+        ClusteredLighting(const ClusteredLighting&) = delete;
+        ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+
+        const LightGrid& GetGrid() const
+        {
+            return mGrid;
+        }
+
+        // Brackets the frame, like GLRingBuffer. Call EndFrame() after the
+        // last draw that shades with the lights.
+        void BeginFrame();
+        void EndFrame();
+
+        // Bins and uploads `lights` for this view and binds the buffers. The
+        // ring grows when a frame's data doesn't fit.
+        void Update(
+            const LightSet& lights, const glm::mat4& view, const glm::mat4& projection,
+            float near, float far, const glm::vec2& viewportSize, GLStateCache& state);
+
+    private:
+        LightGrid mGrid;
+        std::unique_ptr<GLRingBuffer> mRing;
+        bool mFrameActive;
+    };
+}
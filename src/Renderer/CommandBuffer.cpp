@@ -0,0 +1,51 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Renderer/CommandBuffer.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace Myst
+{
+    CommandBuffer::CommandBuffer(std::size_t alignment)
+        : mCapacity(0)
+        , mHead(0)
+        , mAlignment(std::max<std::size_t>(1, alignment))
+    {
+        // Nothing to do.
+    }
+
+    void CommandBuffer::Reset()
+    {
+        mCommands.clear();
+        mHead = 0;
+    }
+
+    std::uint32_t CommandBuffer::Allocate(std::size_t size)
+    {
+        const std::size_t offset = (mHead + mAlignment - 1) / mAlignment * mAlignment;
+
+        if (offset + size > mCapacity) {
+            // Growing is the only time recording allocates, and only until
+            // the buffer has seen its largest frame.
+            const std::size_t capacity = std::max(offset + size, mCapacity * 2);
+            std::unique_ptr<unsigned char[]> payload(new unsigned char[capacity]);
+
+            if (mHead > 0) {
+                std::memcpy(payload.get(), mPayload.get(), mHead);
+            }
+
+            mPayload = std::move(payload);
+            mCapacity = capacity;
+        }
+
+        mHead = offset + size;
+
+        return static_cast<std::uint32_t>(offset);
+    }
+}
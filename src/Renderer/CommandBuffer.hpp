@@ -0,0 +1,114 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "OpenGL/GLShader.hpp"
+#include "Renderer/Material.hpp"
+#include "Renderer/Mesh.hpp"
+
+namespace Myst
+{
+    // A draw as recorded off the GL thread. Blocks live in the recording
+    // buffer's payload, by offset, until the queue copies them into the ring.
+    struct DrawCommand
+    {
+        // As made by RenderQueue::MakeKey().
+        std::uint64_t Key;
+
+        GLShaderProgram* Program;
+        const Myst::Material* Material;
+        Myst::Mesh* Mesh;
+
+        // Bound to the object block and the instance buffer, if the size
+        // isn't zero.
+        std::uint32_t ObjectOffset;
+        std::uint32_t ObjectSize;
+        std::uint32_t InstancesOffset;
+        std::uint32_t InstancesSize;
+        std::uint32_t InstanceCount;
+    };
+
+    // Draw commands and the blocks they read, recorded by one job at a time
+    // into linear storage that is rewound rather than freed, so that once it
+    // has grown to a frame's needs recording no longer allocates. Nothing in
+    // here touches GL: buffers are filled on worker threads and handed to
+    // RenderQueue::Submit() on the GL thread.
+    class CommandBuffer
+    {
+    public:
+        // Payload offsets are kept to `alignment`, which must be the ring's.
+        explicit CommandBuffer(std::size_t alignment = 256);
+
+        CommandBuffer(const CommandBuffer&) = delete;
+        CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+        CommandBuffer(CommandBuffer&&) = default;
+        CommandBuffer& operator=(CommandBuffer&&) = default;
+
+        const std::vector<DrawCommand>& GetCommands() const
+        {
+            return mCommands;
+        }
+
+        std::size_t GetSize() const
+        {
+            return mCommands.size();
+        }
+
+        const unsigned char* GetPayload() const
+        {
+            return mPayload.get();
+        }
+
+        std::size_t GetPayloadSize() const
+        {
+            return mHead;
+        }
+
+        // Drops the recorded commands and payload, keeping the storage.
+        void Reset();
+
+        void Record(const DrawCommand& command)
+        {
+            mCommands.push_back(command);
+        }
+
+        // Reserves `size` bytes of payload and returns their offset. The
+        // bytes are uninitialized, and GetData() pointers into the payload
+        // are invalidated.
+        std::uint32_t Allocate(std::size_t size);
+
+        void* GetData(std::uint32_t offset)
+        {
+            return mPayload.get() + offset;
+        }
+
+        template <typename T>
+        std::uint32_t Push(const T& value)
+        {
+            const std::uint32_t offset = Allocate(sizeof(T));
+            std::memcpy(GetData(offset), &value, sizeof(T));
+
+            return offset;
+        }
+
+    private:
+        std::vector<DrawCommand> mCommands;
+
+        std::unique_ptr<unsigned char[]> mPayload;
+        std::size_t mCapacity;
+        std::size_t mHead;
+        std::size_t mAlignment;
+    };
+}
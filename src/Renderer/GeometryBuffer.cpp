@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Renderer/GeometryBuffer.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace Myst
+{
+    namespace
+    {
+        bool HaveSameLayout(const VertexLayout& a, const VertexLayout& b)
+        {
+            if (a.GetStride() != b.GetStride() ||
+                a.GetElements().size() != b.GetElements().size()) {
+                return false;
+            }
+
+            for (std::size_t i = 0; i < a.GetElements().size(); ++i) {
+                const VertexElement& x = a.GetElements()[i];
+                const VertexElement& y = b.GetElements()[i];
+
+                if (x.Attribute != y.Attribute || x.Format != y.Format ||
+                    x.Offset != y.Offset) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    }
+
+    GeometryBuffer::GeometryBuffer(const VertexLayout& layout)
+        : mLayout(layout)
+    {
+        // Nothing to do.
+    }
+
+    int GeometryBuffer::Add(const MeshData& mesh)
+    {
+        if (IsUploaded() || !HaveSameLayout(mesh.Layout, mLayout)) {
+            std::cerr << "myst: mesh doesn't fit the geometry buffer" << std::endl;
+            return -1;
+        }
+
+        Entry entry{};
+        entry.FirstIndex = static_cast<GLuint>(mIndices.size());
+        entry.IndexCount = static_cast<GLuint>(mesh.Indices.size());
+        entry.BaseVertex = static_cast<GLint>(mVertices.size() / mLayout.GetStride());
+        entry.Bounds = ComputeBoundingSphere(mesh);
+        entry.Dequantization = mesh.Dequantization;
+
+        mVertices.insert(mVertices.end(), mesh.Vertices.begin(), mesh.Vertices.end());
+        mIndices.insert(mIndices.end(), mesh.Indices.begin(), mesh.Indices.end());
+        mEntries.push_back(entry);
+
+        return static_cast<int>(mEntries.size() - 1);
+    }
+
+    void GeometryBuffer::Upload()
+    {
+        if (IsUploaded()) {
+            return;
+        }
+
+        // Zero sized buffers aren't allowed.
+        mVertices.resize(std::max<std::size_t>(mVertices.size(), mLayout.GetStride()));
+        mIndices.resize(std::max<std::size_t>(mIndices.size(), 1));
+
+        mVertexBuffer = std::make_unique<GLBuffer>(
+            static_cast<GLsizeiptr>(mVertices.size()), 0, mVertices.data());
+        mIndexBuffer = std::make_unique<GLBuffer>(
+            static_cast<GLsizeiptr>(mIndices.size() * sizeof(std::uint32_t)), 0,
+            mIndices.data());
+
+        std::vector<unsigned char>().swap(mVertices);
+        std::vector<std::uint32_t>().swap(mIndices);
+    }
+}
@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "Geometry/Bounds.hpp"
+#include "Geometry/VertexLayout.hpp"
+#include "OpenGL/GLBuffer.hpp"
+
+namespace Myst
+{
+    // Many meshes of one vertex layout packed into a single vertex and index
+    // buffer, so they can all be drawn by one multi-draw. Meshes are added on
+    // the CPU and uploaded together.
+    class GeometryBuffer
+    {
+    public:
+        struct Entry
+        {
+            GLuint FirstIndex;
+            GLuint IndexCount;
+            GLint BaseVertex;
+            BoundingSphere Bounds;
+            VertexDequantization Dequantization;
+        };
+
+        explicit GeometryBuffer(const VertexLayout& layout);
+
+        GeometryBuffer(const GeometryBuffer&) = delete;
+        GeometryBuffer& operator=(const GeometryBuffer&) = delete;
+
+        const VertexLayout& GetLayout() const
+        {
+            return mLayout;
+        }
+
+        const std::vector<Entry>& GetEntries() const
+        {
+            return mEntries;
+        }
+
+        bool IsUploaded() const
+        {
+            return mVertexBuffer != nullptr;
+        }
+
+        GLuint GetVertexBuffer() const
+        {
+            return mVertexBuffer ? mVertexBuffer->GetID() : 0;
+        }
+
+        GLuint GetIndexBuffer() const
+        {
+            return mIndexBuffer ? mIndexBuffer->GetID() : 0;
+        }
+
+        // Returns the mesh's index, or -1 if its layout doesn't match or the
+        // buffer was already uploaded.
+        int Add(const MeshData& mesh);
+
+        // Moves everything added into immutable GL buffers and releases the
+        // CPU copies.
+        void Upload();
+
+    private:
+        VertexLayout mLayout;
+        std::vector<Entry> mEntries;
+
+        std::vector<unsigned char> mVertices;
+        std::vector<std::uint32_t> mIndices;
+
+        std::unique_ptr<GLBuffer> mVertexBuffer;
+        std::unique_ptr<GLBuffer> mIndexBuffer;
+    };
+}
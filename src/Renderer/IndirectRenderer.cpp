@@ -0,0 +1,318 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Renderer/IndirectRenderer.hpp"
+
+#include <algorithm>
+
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include "Core/Profiler.hpp"
+#include "Renderer/Mesh.hpp"
+
+namespace Myst
+{
+    namespace
+    {
+        constexpr GLuint kObjectAttribute{3};
+        constexpr GLuint kGroupSize{64};
+
+        void BindStorage(GLStateCache& state, GLuint index, const GLBuffer& buffer)
+        {
+            state.BindBufferRange(
+                GL_SHADER_STORAGE_BUFFER, index, buffer.GetID(), 0, buffer.GetSize());
+        }
+
+        GLuint GetGroupCount(std::size_t items)
+        {
+            return static_cast<GLuint>((items + kGroupSize - 1) / kGroupSize);
+        }
+
+        ObjectData MakeObject(std::uint32_t mesh, const glm::mat4& transform)
+        {
+            ObjectData object{};
+            object.Model = transform;
+            object.Normal = glm::mat3x4(glm::inverseTranspose(glm::mat3(transform)));
+            object.Mesh = mesh;
+
+            return object;
+        }
+    }
+
+    IndirectRenderer::IndirectRenderer(
+        GLShaderLibrary& shaderLibrary,
+        GLRingBuffer& ring,
+        const GeometryBuffer& geometry,
+        const std::string& vertexShaderFilepath,
+        const std::string& fragmentShaderFilepath,
+        const std::string& cullShaderFilepath)
+        : mShaderLibrary(shaderLibrary)
+        , mRing(ring)
+        , mGeometry(geometry)
+        , mVertexShaderFilepath(vertexShaderFilepath)
+        , mFragmentShaderFilepath(fragmentShaderFilepath)
+        , mCullProgram(nullptr)
+        , mCompactProgram(nullptr)
+        , mMaterial(nullptr)
+        , mProgram(nullptr)
+        , mMeshObjectCounts(geometry.GetEntries().size(), 0)
+        , mDirtyBegin(0)
+        , mDirtyEnd(0)
+        , mObjectsAdded(false)
+        , mVertexArray(0)
+        , mIndirectCount(false)
+        , mStats{}
+    {
+        mCullProgram = mShaderLibrary.GetCompute(cullShaderFilepath);
+        mCompactProgram = mShaderLibrary.GetCompute(
+            cullShaderFilepath, {{"CULL_COMPACT", ""}});
+
+        // glMultiDrawElementsIndirectCount() is core in 4.6 only; older
+        // contexts, llvmpipe's 4.5 among them, draw every command instead and
+        // let the empty ones fall through.
+        mIndirectCount = GLAD_GL_VERSION_4_6 && glMultiDrawElementsIndirectCount != nullptr;
+
+        const std::vector<GeometryBuffer::Entry>& entries = mGeometry.GetEntries();
+        std::vector<MeshInfo> meshes;
+        meshes.reserve(std::max<std::size_t>(entries.size(), 1));
+
+        for (const GeometryBuffer::Entry& entry : entries) {
+            const VertexDequantization& dequantization = entry.Dequantization;
+
+            MeshInfo mesh{};
+            mesh.Sphere = glm::vec4(entry.Bounds.Center, entry.Bounds.Radius);
+            mesh.PositionOffset = glm::vec4(dequantization.PositionOffset, 0.0f);
+            mesh.PositionScale = glm::vec4(dequantization.PositionScale, 0.0f);
+            mesh.TexCoordTransform = glm::vec4(
+                dequantization.TexCoordOffset, dequantization.TexCoordScale);
+            meshes.push_back(mesh);
+        }
+
+        meshes.resize(std::max<std::size_t>(meshes.size(), 1));
+        mMeshBuffer = std::make_unique<GLBuffer>(
+            static_cast<GLsizeiptr>(meshes.size() * sizeof(MeshInfo)), 0, meshes.data());
+
+        const GLsizeiptr commandsSize = static_cast<GLsizeiptr>(
+            meshes.size() * sizeof(DrawElementsIndirectCommand));
+
+        mCommandTemplate = std::make_unique<GLBuffer>(commandsSize, GL_DYNAMIC_STORAGE_BIT);
+        mCommandBuffer = std::make_unique<GLBuffer>(commandsSize, 0);
+        mCompactedBuffer = std::make_unique<GLBuffer>(commandsSize, 0);
+        mDrawCountBuffer = std::make_unique<GLBuffer>(sizeof(GLuint), 0);
+
+        // The mesh attributes come from the shared buffers; the visible object
+        // list is an instanced attribute, so each command's base instance
+        // offsets it to the mesh's part of the list.
+        const VertexLayout& layout = mGeometry.GetLayout();
+
+        glCreateVertexArrays(1, &mVertexArray);
+        glVertexArrayVertexBuffer(
+            mVertexArray, 0, mGeometry.GetVertexBuffer(), 0,
+            static_cast<GLsizei>(layout.GetStride()));
+        glVertexArrayElementBuffer(mVertexArray, mGeometry.GetIndexBuffer());
+        Mesh::ApplyLayout(mVertexArray, layout, 0);
+
+        glEnableVertexArrayAttrib(mVertexArray, kObjectAttribute);
+        glVertexArrayAttribIFormat(mVertexArray, kObjectAttribute, 1, GL_UNSIGNED_INT, 0);
+        glVertexArrayAttribBinding(mVertexArray, kObjectAttribute, 1);
+        glVertexArrayBindingDivisor(mVertexArray, 1, 1);
+    }
+
+    IndirectRenderer::~IndirectRenderer()
+    {
+        glDeleteVertexArrays(1, &mVertexArray);
+    }
+
+    std::uint32_t IndirectRenderer::Add(std::uint32_t mesh, const glm::mat4& transform)
+    {
+        mObjects.push_back(MakeObject(mesh, transform));
+        ++mMeshObjectCounts[mesh];
+        mObjectsAdded = true;
+
+        return static_cast<std::uint32_t>(mObjects.size() - 1);
+    }
+
+    void IndirectRenderer::SetTransform(std::uint32_t object, const glm::mat4& transform)
+    {
+        mObjects[object] = MakeObject(mObjects[object].Mesh, transform);
+
+        if (mDirtyBegin == mDirtyEnd) {
+            mDirtyBegin = object;
+            mDirtyEnd = object + 1;
+        } else {
+            mDirtyBegin = std::min<std::size_t>(mDirtyBegin, object);
+            mDirtyEnd = std::max<std::size_t>(mDirtyEnd, object + 1);
+        }
+    }
+
+    void IndirectRenderer::UploadObjects()
+    {
+        if (mObjectsAdded) {
+            const GLsizeiptr size =
+                static_cast<GLsizeiptr>(mObjects.size() * sizeof(ObjectData));
+
+            if (!mObjectBuffer || mObjectBuffer->GetSize() < size) {
+                mObjectBuffer = std::make_unique<GLBuffer>(size * 2, GL_DYNAMIC_STORAGE_BIT);
+                mVisibleBuffer = std::make_unique<GLBuffer>(
+                    static_cast<GLsizeiptr>(mObjects.size() * 2 * sizeof(GLuint)), 0);
+
+                glVertexArrayVertexBuffer(
+                    mVertexArray, 1, mVisibleBuffer->GetID(), 0, sizeof(GLuint));
+            }
+
+            mObjectBuffer->Upload(0, size, mObjects.data());
+
+            // Each mesh's visible objects go after those of the meshes before
+            // it; the cull pass counts the instances up from zero.
+            const std::vector<GeometryBuffer::Entry>& entries = mGeometry.GetEntries();
+            std::vector<DrawElementsIndirectCommand> commands(entries.size());
+            GLuint baseInstance{0};
+
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                commands[i].Count = entries[i].IndexCount;
+                commands[i].InstanceCount = 0;
+                commands[i].FirstIndex = entries[i].FirstIndex;
+                commands[i].BaseVertex = entries[i].BaseVertex;
+                commands[i].BaseInstance = baseInstance;
+
+                baseInstance += mMeshObjectCounts[i];
+            }
+
+            mCommandTemplate->Upload(
+                0, static_cast<GLsizeiptr>(commands.size() * sizeof(DrawElementsIndirectCommand)),
+                commands.data());
+
+            mObjectsAdded = false;
+            mDirtyBegin = mDirtyEnd = 0;
+        } else if (mDirtyBegin != mDirtyEnd) {
+            mObjectBuffer->Upload(
+                static_cast<GLintptr>(mDirtyBegin * sizeof(ObjectData)),
+                static_cast<GLsizeiptr>((mDirtyEnd - mDirtyBegin) * sizeof(ObjectData)),
+                mObjects.data() + mDirtyBegin);
+
+            mDirtyBegin = mDirtyEnd = 0;
+        }
+    }
+
+    void IndirectRenderer::Draw(
+        const Frustum& frustum, const Material& material, GLStateCache& state)
+    {
+        MYST_PROFILE_SCOPE("IndirectRenderer::Draw");
+
+        const std::size_t meshCount = mGeometry.GetEntries().size();
+
+        mStats.Objects = mObjects.size();
+        mStats.Commands = meshCount;
+        mStats.IndirectCount = mIndirectCount;
+
+        if (!IsValid() || mObjects.empty() || meshCount == 0) {
+            return;
+        }
+
+        if (mMaterial != &material) {
+            GLShaderPreprocessor::Defines defines = material.GetShaderDefines();
+            GLShaderPreprocessor::Defines meshDefines =
+                Mesh::GetShaderDefines(mGeometry.GetLayout());
+
+            defines.insert(meshDefines.begin(), meshDefines.end());
+            defines.emplace("GPU_DRIVEN", "");
+
+            mProgram = mShaderLibrary.Get(
+                mVertexShaderFilepath, mFragmentShaderFilepath, defines);
+            mMaterial = &material;
+        }
+
+        if (mProgram == nullptr) {
+            return;
+        }
+
+        UploadObjects();
+
+        CullBlock cull{};
+        std::copy(std::begin(frustum.Planes), std::end(frustum.Planes), cull.Planes);
+        cull.ObjectCount = static_cast<std::uint32_t>(mObjects.size());
+        cull.CommandCount = static_cast<std::uint32_t>(meshCount);
+
+        GLRingBuffer::Range cullRange = mRing.Push(cull);
+        GLRingBuffer::Range materialRange = mRing.Push(material.GetBlock());
+
+        if (!cullRange.IsValid() || !materialRange.IsValid()) {
+            return;
+        }
+
+        // Start from commands without instances.
+        glCopyNamedBufferSubData(
+            mCommandTemplate->GetID(), mCommandBuffer->GetID(), 0, 0,
+            static_cast<GLsizeiptr>(meshCount * sizeof(DrawElementsIndirectCommand)));
+
+        cullRange.Bind(state, GL_UNIFORM_BUFFER, kCullBlockBinding);
+        BindStorage(state, kObjectBufferBinding, *mObjectBuffer);
+        BindStorage(state, kMeshBufferBinding, *mMeshBuffer);
+        BindStorage(state, kCommandBufferBinding, *mCommandBuffer);
+        BindStorage(state, kVisibleBufferBinding, *mVisibleBuffer);
+
+        state.UseProgram(mCullProgram->GetID());
+        glDispatchCompute(GetGroupCount(mObjects.size()), 1, 1);
+
+        if (mIndirectCount) {
+            GLuint zero{0};
+            glClearNamedBufferData(
+                mDrawCountBuffer->GetID(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+            BindStorage(state, kDrawCountBufferBinding, *mDrawCountBuffer);
+            BindStorage(state, kCompactedCommandBufferBinding, *mCompactedBuffer);
+
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            state.UseProgram(mCompactProgram->GetID());
+            glDispatchCompute(GetGroupCount(meshCount), 1, 1);
+        }
+
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+        state.UseProgram(mProgram->GetID());
+        material.Bind(state);
+        materialRange.Bind(state, GL_UNIFORM_BUFFER, kMaterialBlockBinding);
+        state.BindVertexArray(mVertexArray);
+
+        if (mIndirectCount) {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mCompactedBuffer->GetID());
+            glBindBuffer(GL_PARAMETER_BUFFER, mDrawCountBuffer->GetID());
+            glMultiDrawElementsIndirectCount(
+                GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0,
+                static_cast<GLsizei>(meshCount), 0);
+        } else {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mCommandBuffer->GetID());
+            glMultiDrawElementsIndirect(
+                GL_TRIANGLES, GL_UNSIGNED_INT, nullptr,
+                static_cast<GLsizei>(meshCount), 0);
+        }
+    }
+
+    std::size_t IndirectRenderer::ReadVisibleCount() const
+    {
+        const std::size_t meshCount = mGeometry.GetEntries().size();
+        std::vector<DrawElementsIndirectCommand> commands(meshCount);
+
+        if (meshCount == 0) {
+            return 0;
+        }
+
+        glGetNamedBufferSubData(
+            mCommandBuffer->GetID(), 0,
+            static_cast<GLsizeiptr>(meshCount * sizeof(DrawElementsIndirectCommand)),
+            commands.data());
+
+        std::size_t visible{0};
+
+        for (const DrawElementsIndirectCommand& command : commands) {
+            visible += command.InstanceCount;
+        }
+
+        return visible;
+    }
+}
@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Geometry/Frustum.hpp"
+#include "OpenGL/GLBuffer.hpp"
+#include "OpenGL/GLRingBuffer.hpp"
+#include "OpenGL/GLShader.hpp"
+#include "OpenGL/GLShaderLibrary.hpp"
+#include "OpenGL/GLStateCache.hpp"
+#include "Renderer/GeometryBuffer.hpp"
+#include "Renderer/Material.hpp"
+#include "Renderer/UniformBlocks.hpp"
+
+namespace Myst
+{
+    // Draws every object of a geometry buffer with one material, leaving the
+    // per-object work to the GPU. Objects live in a persistent storage buffer;
+    // each frame a compute pass frustum culls them, fills one indirect command
+    // per mesh and a list of visible objects, and a single multi-draw renders
+    // the lot. Only objects whose transform changed cost any CPU time.
+    class IndirectRenderer
+    {
+    public:
+        struct Stats
+        {
+            std::size_t Objects;
+            std::size_t Commands;
+
+            // Whether the draw count came from the GPU, which needs GL 4.6.
+            bool IndirectCount;
+        };
+
+        IndirectRenderer(
+            GLShaderLibrary& shaderLibrary,
+            GLRingBuffer& ring,
+            const GeometryBuffer& geometry,
+            const std::string& vertexShaderFilepath,
+            const std::string& fragmentShaderFilepath,
+            const std::string& cullShaderFilepath);
+        ~IndirectRenderer();
+
+        IndirectRenderer(const IndirectRenderer&) = delete;
+        IndirectRenderer& operator=(const IndirectRenderer&) = delete;
+
+        bool IsValid() const
+        {
+            return mCullProgram != nullptr && mCompactProgram != nullptr;
+        }
+
+        const Stats& GetStats() const
+        {
+            return mStats;
+        }
+
+        // Adds an object drawing the geometry buffer's `mesh`; returns its
+        // index for SetTransform().
+        std::uint32_t Add(std::uint32_t mesh, const glm::mat4& transform);
+        void SetTransform(std::uint32_t object, const glm::mat4& transform);
+
+        // Culls against `frustum` and draws everything visible. Expects the
+        // frame and view blocks to be bound.
+        void Draw(const Frustum& frustum, const Material& material, GLStateCache& state);
+
+        // Reads back how many objects survived the last cull. Stalls until
+        // the GPU caught up, so only use it for statistics.
+        std::size_t ReadVisibleCount() const;
+
+    private:
+        void UploadObjects();
+
+    private:
+        GLShaderLibrary& mShaderLibrary;
+        GLRingBuffer& mRing;
+        const GeometryBuffer& mGeometry;
+        std::string mVertexShaderFilepath;
+        std::string mFragmentShaderFilepath;
+
+        GLShaderProgram* mCullProgram;
+        GLShaderProgram* mCompactProgram;
+
+        // The draw program of the last material drawn with.
+        const Material* mMaterial;
+        GLShaderProgram* mProgram;
+
+        std::vector<ObjectData> mObjects;
+        std::vector<std::uint32_t> mMeshObjectCounts;
+
+        // The range of mObjects that changed since the last upload. Adding
+        // objects moves the meshes' ranges in the visible list, which
+        // rebuilds the commands too.
+        std::size_t mDirtyBegin;
+        std::size_t mDirtyEnd;
+        bool mObjectsAdded;
+
+        std::unique_ptr<GLBuffer> mObjectBuffer;
+        std::unique_ptr<GLBuffer> mMeshBuffer;
+        std::unique_ptr<GLBuffer> mCommandTemplate;
+        std::unique_ptr<GLBuffer> mCommandBuffer;
+        std::unique_ptr<GLBuffer> mCompactedBuffer;
+        std::unique_ptr<GLBuffer> mDrawCountBuffer;
+        std::unique_ptr<GLBuffer> mVisibleBuffer;
+
+        GLuint mVertexArray;
+        bool mIndirectCount;
+
+        Stats mStats;
+    };
+}
@@ -0,0 +1,327 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Renderer/InstancedRenderer.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include "Core/Profiler.hpp"
+
+namespace Myst
+{
+    namespace
+    {
+        InstanceData MakeInstance(const glm::mat4& transform)
+        {
+            InstanceData instance;
+            instance.Model = transform;
+            instance.Normal = glm::mat3x4(glm::inverseTranspose(glm::mat3(transform)));
+
+            return instance;
+        }
+    }
+
+    InstancedRenderer::InstancedRenderer(
+        GLShaderLibrary& shaderLibrary,
+        GLRingBuffer& ring,
+        const std::string& vertexShaderFilepath,
+        const std::string& fragmentShaderFilepath)
+        : mShaderLibrary(shaderLibrary)
+        , mRing(ring)
+        , mVertexShaderFilepath(vertexShaderFilepath)
+        , mFragmentShaderFilepath(fragmentShaderFilepath)
+        , mInstancing(true)
+        , mStats{}
+    {
+        // Nothing to do.
+    }
+
+    void InstancedRenderer::Submit(
+        Mesh& mesh, const Material& material, const glm::mat4& transform)
+    {
+        std::uint32_t batch = GetBatch(mesh, material);
+
+        ++mBatches[batch].Count;
+        mSubmissions.push_back({batch, transform});
+    }
+
+    void InstancedRenderer::Flush(RenderQueue& queue, const glm::vec3& viewPosition)
+    {
+        MYST_PROFILE_SCOPE("InstancedRenderer::Flush");
+
+        mStats = {};
+        mStats.Instances = mSubmissions.size();
+
+        for (const Batch& batch : mBatches) {
+            mStats.Batches += batch.Count > 0;
+        }
+
+        if (mInstancing) {
+            FlushInstanced(queue, viewPosition);
+        } else {
+            FlushSingle(queue, viewPosition);
+        }
+
+        for (Batch& batch : mBatches) {
+            batch.Count = 0;
+            batch.Cursor = nullptr;
+        }
+
+        mSubmissions.clear();
+    }
+
+    std::uint32_t InstancedRenderer::GetBatch(Mesh& mesh, const Material& material)
+    {
+        auto key = std::make_pair<const Mesh*, const Material*>(&mesh, &material);
+        auto it = mBatchLookup.find(key);
+
+        if (it != mBatchLookup.end()) {
+            return it->second;
+        }
+
+        Batch batch{};
+        batch.Mesh = &mesh;
+        batch.Material = &material;
+
+        std::uint32_t index = static_cast<std::uint32_t>(mBatches.size());
+        mBatches.push_back(batch);
+        mBatchLookup.emplace(key, index);
+
+        return index;
+    }
+
+    GLShaderProgram* InstancedRenderer::GetProgram(const Batch& batch, bool instanced)
+    {
+        GLShaderPreprocessor::Defines defines = batch.Material->GetShaderDefines();
+        GLShaderPreprocessor::Defines meshDefines = batch.Mesh->GetShaderDefines();
+        defines.insert(meshDefines.begin(), meshDefines.end());
+
+        if (instanced) {
+            defines.emplace("INSTANCED", "");
+        }
+
+        return mShaderLibrary.Get(mVertexShaderFilepath, mFragmentShaderFilepath, defines);
+    }
+
+    void InstancedRenderer::FlushInstanced(
+        RenderQueue& queue, const glm::vec3& viewPosition)
+    {
+        // Each batch gets its own range, so it can be bound at offset zero and
+        // indexed by gl_InstanceID alone.
+        for (Batch& batch : mBatches) {
+            if (batch.Count == 0) {
+                continue;
+            }
+
+            batch.Instances = mRing.Allocate(
+                static_cast<GLsizeiptr>(batch.Count * sizeof(InstanceData)));
+            batch.Cursor = static_cast<InstanceData*>(batch.Instances.Data);
+            batch.Depth = std::numeric_limits<float>::max();
+        }
+
+        // Submissions are scattered into their batch's range as they come,
+        // which keeps the submission order within a batch.
+        for (const Submission& submission : mSubmissions) {
+            Batch& batch = mBatches[submission.Batch];
+
+            if (batch.Cursor != nullptr) {
+                *batch.Cursor++ = MakeInstance(submission.Transform);
+                batch.Depth = std::min(
+                    batch.Depth,
+                    glm::distance(viewPosition, glm::vec3(submission.Transform[3])));
+            }
+        }
+
+        for (Batch& batch : mBatches) {
+            if (batch.Count == 0 || !batch.Instances.IsValid()) {
+                continue;
+            }
+
+            if (batch.Program == nullptr) {
+                batch.Program = GetProgram(batch, true);
+            }
+
+            if (batch.Program == nullptr) {
+                continue;
+            }
+
+            ObjectBlock object{};
+            object.Model = glm::mat4(1.0f);
+            batch.Mesh->SetObjectBlock(object);
+
+            RenderItem item;
+            item.Program = batch.Program;
+            item.Material = batch.Material;
+            item.Mesh = batch.Mesh;
+            item.Object = mRing.Push(object);
+            item.Instances = batch.Instances;
+            item.InstanceCount = static_cast<GLsizei>(batch.Count);
+
+            if (!item.Object.IsValid()) {
+                continue;
+            }
+
+            queue.Submit(RenderPass::Main, item, batch.Depth);
+            ++mStats.DrawCalls;
+        }
+    }
+
+    void InstancedRenderer::FlushSingle(
+        RenderQueue& queue, const glm::vec3& viewPosition)
+    {
+        for (const Submission& submission : mSubmissions) {
+            Batch& batch = mBatches[submission.Batch];
+
+            if (batch.SingleProgram == nullptr) {
+                batch.SingleProgram = GetProgram(batch, false);
+            }
+
+            if (batch.SingleProgram == nullptr) {
+                continue;
+            }
+
+            InstanceData instance = MakeInstance(submission.Transform);
+
+            ObjectBlock object{};
+            object.Model = instance.Model;
+            object.Normal = instance.Normal;
+            batch.Mesh->SetObjectBlock(object);
+
+            RenderItem item;
+            item.Program = batch.SingleProgram;
+            item.Material = batch.Material;
+            item.Mesh = batch.Mesh;
+            item.Object = mRing.Push(object);
+
+            if (!item.Object.IsValid()) {
+                continue;
+            }
+
+            queue.Submit(
+                RenderPass::Main, item,
+                glm::distance(viewPosition, glm::vec3(submission.Transform[3])));
+            ++mStats.DrawCalls;
+        }
+    }
+
+    std::uint32_t InstancedRenderer::Prepare(
+        Mesh& mesh, const Material& material, RenderQueue& queue)
+    {
+        const std::uint32_t index = GetBatch(mesh, material);
+        Batch& batch = mBatches[index];
+
+        if (mInstancing) {
+            if (batch.Program == nullptr) {
+                batch.Program = GetProgram(batch, true);
+            }
+
+            batch.ProgramID = queue.GetProgramID(batch.Program);
+        } else {
+            if (batch.SingleProgram == nullptr) {
+                batch.SingleProgram = GetProgram(batch, false);
+            }
+
+            batch.SingleProgramID = queue.GetProgramID(batch.SingleProgram);
+        }
+
+        batch.MaterialID = queue.GetMaterialID(batch.Material);
+
+        return index;
+    }
+
+    void InstancedRenderer::Record(
+        CommandBuffer& commands, Instance* instances, std::size_t count,
+        const glm::vec3& viewPosition) const
+    {
+        MYST_PROFILE_SCOPE("InstancedRenderer::Record");
+
+        if (!mInstancing) {
+            for (std::size_t i = 0; i < count; ++i) {
+                const Instance& instance = instances[i];
+                const Batch& batch = mBatches[instance.Batch];
+
+                if (batch.SingleProgram == nullptr) {
+                    continue;
+                }
+
+                ObjectBlock object{};
+                object.Model = *instance.Model;
+                object.Normal = *instance.Normal;
+                batch.Mesh->SetObjectBlock(object);
+
+                DrawCommand command{};
+                command.Key = RenderQueue::MakeKey(
+                    RenderPass::Main, false, batch.SingleProgramID, batch.MaterialID,
+                    glm::distance(viewPosition, glm::vec3((*instance.Model)[3])));
+                command.Program = batch.SingleProgram;
+                command.Material = batch.Material;
+                command.Mesh = batch.Mesh;
+                command.ObjectOffset = commands.Push(object);
+                command.ObjectSize = sizeof(ObjectBlock);
+                command.InstanceCount = 1;
+
+                commands.Record(command);
+            }
+
+            return;
+        }
+
+        // Runs of the same batch become one draw each, with the instances
+        // written straight into the payload.
+        std::sort(instances, instances + count, [](const Instance& a, const Instance& b) {
+            return a.Batch < b.Batch;
+        });
+
+        for (std::size_t first = 0, last = 0; first < count; first = last) {
+            const Batch& batch = mBatches[instances[first].Batch];
+
+            for (last = first + 1;
+                 last < count && instances[last].Batch == instances[first].Batch; ++last) {
+                // Nothing to do.
+            }
+
+            if (batch.Program == nullptr) {
+                continue;
+            }
+
+            const std::uint32_t instanceCount = static_cast<std::uint32_t>(last - first);
+            const std::uint32_t offset = commands.Allocate(instanceCount * sizeof(InstanceData));
+            InstanceData* cursor = static_cast<InstanceData*>(commands.GetData(offset));
+            float depth = std::numeric_limits<float>::max();
+
+            for (std::size_t i = first; i < last; ++i) {
+                cursor->Model = *instances[i].Model;
+                cursor->Normal = *instances[i].Normal;
+                ++cursor;
+
+                depth = std::min(
+                    depth, glm::distance(viewPosition, glm::vec3((*instances[i].Model)[3])));
+            }
+
+            ObjectBlock object{};
+            object.Model = glm::mat4(1.0f);
+            batch.Mesh->SetObjectBlock(object);
+
+            DrawCommand command{};
+            command.Key = RenderQueue::MakeKey(
+                RenderPass::Main, false, batch.ProgramID, batch.MaterialID, depth);
+            command.Program = batch.Program;
+            command.Material = batch.Material;
+            command.Mesh = batch.Mesh;
+            command.ObjectOffset = commands.Push(object);
+            command.ObjectSize = sizeof(ObjectBlock);
+            command.InstancesOffset = offset;
+            command.InstancesSize = instanceCount * sizeof(InstanceData);
+            command.InstanceCount = instanceCount;
+
+            commands.Record(command);
+        }
+    }
+}
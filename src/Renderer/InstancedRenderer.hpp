@@ -0,0 +1,164 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "OpenGL/GLRingBuffer.hpp"
+#include "OpenGL/GLShader.hpp"
+#include "OpenGL/GLShaderLibrary.hpp"
+#include "Renderer/CommandBuffer.hpp"
+#include "Renderer/Material.hpp"
+#include "Renderer/Mesh.hpp"
+#include "Renderer/RenderQueue.hpp"
+
+namespace Myst
+{
+    // Collects (mesh, material, transform) submissions over a frame and turns
+    // each distinct mesh/material pair into a single instanced draw. The
+    // instances' matrices are written into the ring and read by the vertex
+    // shader from the `INSTANCED` storage buffer.
+    //
+    // Draws can also be recorded in parallel: batches are prepared up front
+    // on the GL thread, after which Record() turns lists of instances into
+    // command buffers from any number of jobs at once.
+    class InstancedRenderer
+    {
+    public:
+        struct Stats
+        {
+            std::size_t Instances;
+            std::size_t Batches;
+            std::size_t DrawCalls;
+        };
+
+        // An instance to record, by prepared batch. The matrices are read
+        // by Record() and only need to live that long.
+        struct Instance
+        {
+            std::uint32_t Batch;
+            const glm::mat4* Model;
+            const glm::mat3x4* Normal;
+        };
+
+        InstancedRenderer(
+            GLShaderLibrary& shaderLibrary,
+            GLRingBuffer& ring,
+            const std::string& vertexShaderFilepath,
+            const std::string& fragmentShaderFilepath);
+
+        InstancedRenderer(const InstancedRenderer&) = delete;
+        InstancedRenderer& operator=(const InstancedRenderer&) = delete;
+
+        // Without instancing every submission is drawn on its own, through
+        // the object block. Only useful for comparison.
+        void SetInstancing(bool enabled)
+        {
+            mInstancing = enabled;
+        }
+
+        bool IsInstancing() const
+        {
+            return mInstancing;
+        }
+
+        // Statistics of the last Flush().
+        const Stats& GetStats() const
+        {
+            return mStats;
+        }
+
+        // The mesh and material must outlive the renderer: batches and their
+        // programs are kept across frames.
+        void Submit(Mesh& mesh, const Material& material, const glm::mat4& transform);
+
+        // Records this frame's submissions into `queue` and clears them.
+        // Batches are keyed by the distance of their nearest instance.
+        void Flush(RenderQueue& queue, const glm::vec3& viewPosition);
+
+        // Returns the batch of a mesh and material for Record(), building
+        // its program for the current instancing mode and registering its
+        // sort IDs with `queue`. Must not run while anything is recording.
+        std::uint32_t Prepare(Mesh& mesh, const Material& material, RenderQueue& queue);
+
+        // Records `instances` into `commands`: one instanced draw per batch
+        // among them, or one draw each without instancing. The instances are
+        // sorted by batch on the way. Safe to call from several threads, each
+        // with its own buffer.
+        void Record(
+            CommandBuffer& commands, Instance* instances, std::size_t count,
+            const glm::vec3& viewPosition) const;
+
+    private:
+        struct Batch
+        {
+            Myst::Mesh* Mesh;
+            const Myst::Material* Material;
+
+            // Variants with and without `INSTANCED`, built on first use.
+            GLShaderProgram* Program;
+            GLShaderProgram* SingleProgram;
+
+            // Sort IDs, once prepared.
+            std::uint32_t ProgramID;
+            std::uint32_t SingleProgramID;
+            std::uint32_t MaterialID;
+
+            // Instances submitted this frame, and where their data goes.
+            std::size_t Count;
+            GLRingBuffer::Range Instances;
+            InstanceData* Cursor;
+            float Depth;
+        };
+
+        struct Submission
+        {
+            std::uint32_t Batch;
+            glm::mat4 Transform;
+        };
+
+        struct BatchKeyHash
+        {
+            std::size_t operator()(const std::pair<const Mesh*, const Material*>& key) const
+            {
+                return std::hash<const void*>()(key.first) * 31 ^
+                       std::hash<const void*>()(key.second);
+            }
+        };
+
+        std::uint32_t GetBatch(Mesh& mesh, const Material& material);
+        GLShaderProgram* GetProgram(const Batch& batch, bool instanced);
+
+        void FlushInstanced(RenderQueue& queue, const glm::vec3& viewPosition);
+        void FlushSingle(RenderQueue& queue, const glm::vec3& viewPosition);
+
+    private:
+        GLShaderLibrary& mShaderLibrary;
+        GLRingBuffer& mRing;
+        std::string mVertexShaderFilepath;
+        std::string mFragmentShaderFilepath;
+
+        std::vector<Batch> mBatches;
+        std::unordered_map<
+            std::pair<const Mesh*, const Material*>, std::uint32_t, BatchKeyHash>
+            mBatchLookup;
+
+        std::vector<Submission> mSubmissions;
+
+        bool mInstancing;
+        Stats mStats;
+    };
+}
@@ -0,0 +1,294 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Renderer/LightGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define MYST_LIGHT_X86 1
+#include <immintrin.h>
+#endif
+
+namespace Myst
+{
+    namespace
+    {
+        // Tile overlaps are tracked as one bit per tile boundary.
+        constexpr std::uint32_t kMaxTiles{63};
+
+        int FindFirstBit(std::uint64_t bits)
+        {
+#if defined(__GNUC__)
+            return __builtin_ctzll(bits);
+#else
+            int index{0};
+
+            while ((bits & 1) == 0) {
+                bits >>= 1;
+                ++index;
+            }
+
+            return index;
+#endif
+        }
+
+        int FindLastBit(std::uint64_t bits)
+        {
+#if defined(__GNUC__)
+            return 63 - __builtin_clzll(bits);
+#else
+            int index{-1};
+
+            while (bits != 0) {
+                bits >>= 1;
+                ++index;
+            }
+
+            return index;
+#endif
+        }
+    }
+
+    LightGrid::LightGrid(std::uint32_t tilesX, std::uint32_t tilesY, std::uint32_t slices)
+        : mTilesX(std::clamp<std::uint32_t>(tilesX, 1, kMaxTiles))
+        , mTilesY(std::clamp<std::uint32_t>(tilesY, 1, kMaxTiles))
+        , mSlices(std::clamp<std::uint32_t>(slices, 1, 0xffff))
+        , mSliceScale(0.0f)
+        , mSliceBias(0.0f)
+        , mStats{}
+    {
+        // Nothing to do.
+    }
+
+    void LightGrid::ComputePlanes(
+        const glm::mat4& projection, int row, std::uint32_t tiles, Planes& planes)
+    {
+        const std::size_t count = tiles + 1;
+        const std::size_t padded = (count + 3) & ~std::size_t{3};
+
+        planes.X.assign(padded, 0.0f);
+        planes.Y.assign(padded, 0.0f);
+        planes.Z.assign(padded, 0.0f);
+        planes.W.assign(padded, 0.0f);
+
+        // The boundary at NDC coordinate a is where clip[row] = a * clip.w, so
+        // its plane is the projection's row minus a times the w row. It's
+        // positive on the side of larger coordinates.
+        const glm::vec4 axis(
+            projection[0][row], projection[1][row], projection[2][row], projection[3][row]);
+        const glm::vec4 w(
+            projection[0][3], projection[1][3], projection[2][3], projection[3][3]);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            const float a = -1.0f + 2.0f * static_cast<float>(i) / static_cast<float>(tiles);
+            glm::vec4 plane = axis - a * w;
+            plane /= glm::length(glm::vec3(plane));
+
+            planes.X[i] = plane.x;
+            planes.Y[i] = plane.y;
+            planes.Z[i] = plane.z;
+            planes.W[i] = plane.w;
+        }
+    }
+
+    bool LightGrid::FindTiles(
+        const Planes& planes, std::uint32_t tiles, const glm::vec3& center, float radius,
+        std::uint16_t& first, std::uint16_t& last)
+    {
+        // Bit i of `inside` is set if the sphere reaches the positive side of
+        // boundary i, and of `outside` if it reaches its negative side. Tile i
+        // lies between boundaries i and i + 1.
+        std::uint64_t inside{0};
+        std::uint64_t outside{0};
+
+#if defined(MYST_LIGHT_X86)
+        const __m128 cx = _mm_set1_ps(center.x);
+        const __m128 cy = _mm_set1_ps(center.y);
+        const __m128 cz = _mm_set1_ps(center.z);
+        const __m128 r = _mm_set1_ps(radius);
+        const __m128 negativeR = _mm_set1_ps(-radius);
+
+        for (std::size_t i = 0; i < planes.X.size(); i += 4) {
+            __m128 distance = _mm_add_ps(
+                _mm_add_ps(
+                    _mm_mul_ps(_mm_loadu_ps(&planes.X[i]), cx),
+                    _mm_mul_ps(_mm_loadu_ps(&planes.Y[i]), cy)),
+                _mm_add_ps(
+                    _mm_mul_ps(_mm_loadu_ps(&planes.Z[i]), cz),
+                    _mm_loadu_ps(&planes.W[i])));
+
+            inside |= static_cast<std::uint64_t>(
+                          _mm_movemask_ps(_mm_cmpge_ps(distance, negativeR)))
+                      << i;
+            outside |= static_cast<std::uint64_t>(
+                           _mm_movemask_ps(_mm_cmple_ps(distance, r)))
+                       << i;
+        }
+#else
+        for (std::size_t i = 0; i <= tiles; ++i) {
+            const float distance = planes.X[i] * center.x + planes.Y[i] * center.y +
+                                   planes.Z[i] * center.z + planes.W[i];
+
+            inside |= static_cast<std::uint64_t>(distance >= -radius) << i;
+            outside |= static_cast<std::uint64_t>(distance <= radius) << i;
+        }
+#endif
+
+        const std::uint64_t overlap =
+            inside & (outside >> 1) & ((std::uint64_t{1} << tiles) - 1);
+
+        if (overlap == 0) {
+            return false;
+        }
+
+        first = static_cast<std::uint16_t>(FindFirstBit(overlap));
+        last = static_cast<std::uint16_t>(FindLastBit(overlap));
+
+        return true;
+    }
+
+    void LightGrid::TransformLights(const LightSet& lights, const glm::mat4& view)
+    {
+        const std::size_t count = lights.GetSize();
+        const float* px = lights.GetPositionX();
+        const float* py = lights.GetPositionY();
+        const float* pz = lights.GetPositionZ();
+
+        mViewX.resize(count);
+        mViewY.resize(count);
+        mViewZ.resize(count);
+
+        std::size_t i{0};
+
+#if defined(MYST_LIGHT_X86)
+        // Four lights at a time, one output row per register.
+        for (; i + 4 <= count; i += 4) {
+            const __m128 x = _mm_loadu_ps(px + i);
+            const __m128 y = _mm_loadu_ps(py + i);
+            const __m128 z = _mm_loadu_ps(pz + i);
+
+            float* outputs[3]{mViewX.data(), mViewY.data(), mViewZ.data()};
+
+            for (int row = 0; row < 3; ++row) {
+                __m128 result = _mm_add_ps(
+                    _mm_add_ps(
+                        _mm_mul_ps(_mm_set1_ps(view[0][row]), x),
+                        _mm_mul_ps(_mm_set1_ps(view[1][row]), y)),
+                    _mm_add_ps(
+                        _mm_mul_ps(_mm_set1_ps(view[2][row]), z),
+                        _mm_set1_ps(view[3][row])));
+
+                _mm_storeu_ps(outputs[row] + i, result);
+            }
+        }
+#endif
+
+        for (; i < count; ++i) {
+            glm::vec4 position = view * glm::vec4(px[i], py[i], pz[i], 1.0f);
+
+            mViewX[i] = position.x;
+            mViewY[i] = position.y;
+            mViewZ[i] = position.z;
+        }
+    }
+
+    void LightGrid::Build(
+        const LightSet& lights, const glm::mat4& view, const glm::mat4& projection,
+        float near, float far)
+    {
+        mStats = {};
+        mRanges.clear();
+        mIndices.clear();
+        mClusters.assign(GetClusterCount(), glm::uvec2(0));
+
+        const float depthRange = std::log(far / near);
+        mSliceScale = static_cast<float>(mSlices) / depthRange;
+        mSliceBias = -static_cast<float>(mSlices) * std::log(near) / depthRange;
+
+        ComputePlanes(projection, 0, mTilesX, mColumns);
+        ComputePlanes(projection, 1, mTilesY, mRows);
+        TransformLights(lights, view);
+
+        const float* radii = lights.GetRadius();
+        const int lastSlice = static_cast<int>(mSlices) - 1;
+
+        auto getSlice = [&](float depth) {
+            int slice = static_cast<int>(std::floor(std::log(depth) * mSliceScale + mSliceBias));
+            return static_cast<std::uint16_t>(std::clamp(slice, 0, lastSlice));
+        };
+
+        for (std::size_t i = 0; i < lights.GetSize(); ++i) {
+            const float radius = radii[i];
+            const glm::vec3 center(mViewX[i], mViewY[i], mViewZ[i]);
+            const float depth = -center.z;
+
+            if (radius <= 0.0f || depth + radius < near || depth - radius > far) {
+                continue;
+            }
+
+            Range range;
+            range.Light = static_cast<std::uint32_t>(i);
+            range.Z0 = getSlice(std::max(depth - radius, near));
+            range.Z1 = getSlice(std::min(depth + radius, far));
+
+            // Spheres around the eye can touch every tile, and the side
+            // planes don't bound anything behind it.
+            if (depth <= radius) {
+                range.X0 = range.Y0 = 0;
+                range.X1 = static_cast<std::uint16_t>(mTilesX - 1);
+                range.Y1 = static_cast<std::uint16_t>(mTilesY - 1);
+            } else if (
+                !FindTiles(mColumns, mTilesX, center, radius, range.X0, range.X1) ||
+                !FindTiles(mRows, mTilesY, center, radius, range.Y0, range.Y1)) {
+                continue;
+            }
+
+            mRanges.push_back(range);
+
+            for (std::uint32_t z = range.Z0; z <= range.Z1; ++z) {
+                for (std::uint32_t y = range.Y0; y <= range.Y1; ++y) {
+                    glm::uvec2* row = &mClusters[(z * mTilesY + y) * mTilesX];
+
+                    for (std::uint32_t x = range.X0; x <= range.X1; ++x) {
+                        ++row[x].y;
+                    }
+                }
+            }
+        }
+
+        // Turn the counts into offsets, then fill every cluster's run in light
+        // order, recounting as it goes.
+        std::uint32_t offset{0};
+
+        for (glm::uvec2& cluster : mClusters) {
+            mStats.MaxPerCluster = std::max(mStats.MaxPerCluster, cluster.y);
+
+            cluster.x = offset;
+            offset += cluster.y;
+            cluster.y = 0;
+        }
+
+        mIndices.resize(offset);
+
+        for (const Range& range : mRanges) {
+            for (std::uint32_t z = range.Z0; z <= range.Z1; ++z) {
+                for (std::uint32_t y = range.Y0; y <= range.Y1; ++y) {
+                    glm::uvec2* row = &mClusters[(z * mTilesY + y) * mTilesX];
+
+                    for (std::uint32_t x = range.X0; x <= range.X1; ++x) {
+                        mIndices[row[x].x + row[x].y++] = range.Light;
+                    }
+                }
+            }
+        }
+
+        mStats.Lights = mRanges.size();
+        mStats.References = mIndices.size();
+    }
+}
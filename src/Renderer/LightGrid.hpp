@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Scene/Light.hpp"
+
+namespace Myst
+{
+    // Bins point lights into a grid of froxels: screen tiles split into depth
+    // slices that grow exponentially with distance, so that near and far
+    // slices cover about the same amount of detail. Each cluster ends up with
+    // a contiguous run in a shared list of light indices, which is what the
+    // fragment shader walks for the cluster it falls into.
+    //
+    // Binning is conservative: a light is added to every cluster its bounding
+    // sphere may touch, tested against the tiles' side planes and the slices'
+    // depth bounds separately.
+    class LightGrid
+    {
+    public:
+        struct Stats
+        {
+            // Lights that overlap the grid at all.
+            std::size_t Lights;
+            std::size_t References;
+            std::uint32_t MaxPerCluster;
+        };
+
+        LightGrid(
+            std::uint32_t tilesX = 16, std::uint32_t tilesY = 9, std::uint32_t slices = 24);
+
+        std::uint32_t GetTilesX() const
+        {
+            return mTilesX;
+        }
+
+        std::uint32_t GetTilesY() const
+        {
+            return mTilesY;
+        }
+
+        std::uint32_t GetSlices() const
+        {
+            return mSlices;
+        }
+
+        std::size_t GetClusterCount() const
+        {
+            return static_cast<std::size_t>(mTilesX) * mTilesY * mSlices;
+        }
+
+        // The slice of view depth z is floor(log(z) * scale + bias).
+        float GetSliceScale() const
+        {
+            return mSliceScale;
+        }
+
+        float GetSliceBias() const
+        {
+            return mSliceBias;
+        }
+
+        // Offset into GetIndices() and light count, per cluster. Clusters are
+        // ordered by tile column, then row from the bottom, then slice.
+        const std::vector<glm::uvec2>& GetClusters() const
+        {
+            return mClusters;
+        }
+
+        const std::vector<std::uint32_t>& GetIndices() const
+        {
+            return mIndices;
+        }
+
+        const Stats& GetStats() const
+        {
+            return mStats;
+        }
+
+        // `projection` must be a perspective projection whose depth range is
+        // [near, far].
+        void Build(
+            const LightSet& lights, const glm::mat4& view, const glm::mat4& projection,
+            float near, float far);
+
+    private:
+        // A light's cluster bounds, inclusive.
+        struct Range
+        {
+            std::uint32_t Light;
+            std::uint16_t X0, X1;
+            std::uint16_t Y0, Y1;
+            std::uint16_t Z0, Z1;
+        };
+
+        // The tile boundaries along one axis as planes through the eye, in
+        // structure-of-arrays form and padded to a multiple of four.
+        struct Planes
+        {
+            std::vector<float> X;
+            std::vector<float> Y;
+            std::vector<float> Z;
+            std::vector<float> W;
+        };
+
+        static void ComputePlanes(
+            const glm::mat4& projection, int row, std::uint32_t tiles, Planes& planes);
+
+        // Finds the tiles a view space sphere overlaps along one axis;
+        // returns false if it's outside.
+        static bool FindTiles(
+            const Planes& planes, std::uint32_t tiles, const glm::vec3& center,
+            float radius, std::uint16_t& first, std::uint16_t& last);
+
+        void TransformLights(const LightSet& lights, const glm::mat4& view);
+
+    private:
+        std::uint32_t mTilesX;
+        std::uint32_t mTilesY;
+        std::uint32_t mSlices;
+
+        float mSliceScale;
+        float mSliceBias;
+
+        Planes mColumns;
+        Planes mRows;
+
+        // View space light positions, rebuilt every frame.
+        std::vector<float> mViewX;
+        std::vector<float> mViewY;
+        std::vector<float> mViewZ;
+
+        std::vector<Range> mRanges;
+        std::vector<glm::uvec2> mClusters;
+        std::vector<std::uint32_t> mIndices;
+
+        Stats mStats;
+    };
+}
@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Renderer/Material.hpp"
+
+namespace Myst
+{
+    GLShaderPreprocessor::Defines Material::GetShaderDefines() const
+    {
+        GLShaderPreprocessor::Defines defines = Defines;
+
+        if (UsesTextureArrays()) {
+            defines.emplace("MATERIAL_TEXTURE_ARRAY", "");
+        }
+
+        if (HasSpecularMap()) {
+            defines.emplace("MATERIAL_SPECULAR_MAP", "");
+        }
+
+        if (Attenuation) {
+            defines.emplace("LIGHT_ATTENUATION", "");
+        }
+
+        return defines;
+    }
+
+    MaterialBlock Material::GetBlock() const
+    {
+        MaterialBlock block{};
+        block.Shininess = Shininess;
+        block.DiffuseLayer = DiffuseLayer.Layer;
+        block.SpecularLayer = SpecularLayer.Layer;
+
+        return block;
+    }
+
+    void Material::Bind() const
+    {
+        if (UsesTextureArrays()) {
+            DiffuseLayer.Array->Bind(0);
+
+            if (SpecularLayer.IsValid()) {
+                SpecularLayer.Array->Bind(1);
+            }
+
+            return;
+        }
+
+        if (Diffuse != nullptr) {
+            Diffuse->Bind(0);
+        }
+
+        if (Specular != nullptr) {
+            Specular->Bind(1);
+        }
+    }
+
+    void Material::Bind(GLStateCache& state) const
+    {
+        if (UsesTextureArrays()) {
+            state.BindTexture(0, DiffuseLayer.Array->GetID());
+
+            if (SpecularLayer.IsValid()) {
+                state.BindTexture(1, SpecularLayer.Array->GetID());
+            }
+
+            return;
+        }
+
+        if (Diffuse != nullptr) {
+            state.BindTexture(0, Diffuse->GetID());
+        }
+
+        if (Specular != nullptr) {
+            state.BindTexture(1, Specular->GetID());
+        }
+    }
+}
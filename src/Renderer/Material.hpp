@@ -0,0 +1,59 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include "OpenGL/GLShaderPreprocessor.hpp"
+#include "OpenGL/GLStateCache.hpp"
+#include "OpenGL/GLTexture.hpp"
+#include "OpenGL/GLTextureArray.hpp"
+#include "Renderer/UniformBlocks.hpp"
+
+namespace Myst
+{
+    struct Material
+    {
+        // A material samples either standalone textures or layers of texture
+        // arrays; the latter lets many materials share the same bindings.
+        GLTexture* Diffuse{nullptr};
+        GLTexture* Specular{nullptr};
+
+        GLTextureArrayPool::Slot DiffuseLayer;
+        GLTextureArrayPool::Slot SpecularLayer;
+
+        float Shininess{32.0f};
+
+        // Whether lights fade out over distance. Disabling it is cheaper for
+        // materials that are only ever lit from up close.
+        bool Attenuation{true};
+
+        // Added to the defines of the material's shaders. Materials that
+        // differ in them get programs of their own.
+        GLShaderPreprocessor::Defines Defines;
+
+        bool UsesTextureArrays() const
+        {
+            return DiffuseLayer.IsValid();
+        }
+
+        bool HasSpecularMap() const
+        {
+            return UsesTextureArrays() ? SpecularLayer.IsValid()
+                                       : Specular != nullptr;
+        }
+
+        // Returns the defines selecting the smallest shader variant that can
+        // render this material, so unused features cost nothing at runtime.
+        GLShaderPreprocessor::Defines GetShaderDefines() const;
+
+        MaterialBlock GetBlock() const;
+
+        // Binds the material's textures to the units the shaders expect.
+        void Bind() const;
+        void Bind(GLStateCache& state) const;
+    };
+}
@@ -0,0 +1,157 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Renderer/Mesh.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Myst
+{
+    namespace
+    {
+        struct FormatInfo
+        {
+            GLint Components;
+            GLenum Type;
+            GLboolean Normalized;
+        };
+
+        FormatInfo GetFormatInfo(VertexFormat format)
+        {
+            switch (format) {
+                case VertexFormat::Float2: return {2, GL_FLOAT, GL_FALSE};
+                case VertexFormat::Float3: return {3, GL_FLOAT, GL_FALSE};
+                case VertexFormat::Half2: return {2, GL_HALF_FLOAT, GL_FALSE};
+                case VertexFormat::Half4: return {4, GL_HALF_FLOAT, GL_FALSE};
+                case VertexFormat::Snorm16x4: return {4, GL_SHORT, GL_TRUE};
+                case VertexFormat::Unorm16x2: return {2, GL_UNSIGNED_SHORT, GL_TRUE};
+                case VertexFormat::Oct16: return {2, GL_SHORT, GL_TRUE};
+                case VertexFormat::Snorm10x3: return {4, GL_INT_2_10_10_10_REV, GL_TRUE};
+            }
+
+            return {0, GL_NONE, GL_FALSE};
+        }
+    }
+
+    Mesh::Mesh(const MeshData& data)
+        : mLayout(data.Layout)
+        , mDequantization(data.Dequantization)
+        , mVertexArray(0)
+        , mVertexCount(static_cast<GLsizei>(data.GetVertexCount()))
+        , mIndexCount(static_cast<GLsizei>(data.Indices.size()))
+        , mIndexType(GL_UNSIGNED_INT)
+    {
+        mVertices = std::make_unique<GLBuffer>(
+            static_cast<GLsizeiptr>(data.Vertices.size()), 0,
+            data.Vertices.data());
+
+        if (data.GetVertexCount() <= std::numeric_limits<std::uint16_t>::max() + 1u) {
+            std::vector<std::uint16_t> indices(data.Indices.begin(), data.Indices.end());
+
+            mIndices = std::make_unique<GLBuffer>(
+                static_cast<GLsizeiptr>(indices.size() * sizeof(std::uint16_t)),
+                0, indices.data());
+            mIndexType = GL_UNSIGNED_SHORT;
+        } else {
+            mIndices = std::make_unique<GLBuffer>(
+                static_cast<GLsizeiptr>(data.Indices.size() * sizeof(std::uint32_t)),
+                0, data.Indices.data());
+        }
+
+        glCreateVertexArrays(1, &mVertexArray);
+        glVertexArrayVertexBuffer(
+            mVertexArray, 0, mVertices->GetID(), 0,
+            static_cast<GLsizei>(mLayout.GetStride()));
+        glVertexArrayElementBuffer(mVertexArray, mIndices->GetID());
+
+        ApplyLayout(mVertexArray, mLayout, 0);
+    }
+
+    Mesh::~Mesh()
+    {
+        glDeleteVertexArrays(1, &mVertexArray);
+    }
+
+    GLShaderPreprocessor::Defines Mesh::GetShaderDefines(const VertexLayout& layout)
+    {
+        GLShaderPreprocessor::Defines defines;
+
+        const VertexElement* position = layout.Find(VertexAttribute::Position);
+        const VertexElement* normal = layout.Find(VertexAttribute::Normal);
+        const VertexElement* texCoord = layout.Find(VertexAttribute::TexCoord);
+
+        if (position != nullptr && position->Format == VertexFormat::Snorm16x4) {
+            defines.emplace("VERTEX_QUANTIZED_POSITION", "");
+        }
+
+        if (normal != nullptr && normal->Format == VertexFormat::Oct16) {
+            defines.emplace("VERTEX_OCTAHEDRAL_NORMAL", "");
+        }
+
+        if (texCoord != nullptr && texCoord->Format == VertexFormat::Unorm16x2) {
+            defines.emplace("VERTEX_QUANTIZED_TEXCOORD", "");
+        }
+
+        return defines;
+    }
+
+    void Mesh::SetObjectBlock(ObjectBlock& block) const
+    {
+        block.PositionOffset = glm::vec4(mDequantization.PositionOffset, 0.0f);
+        block.PositionScale = glm::vec4(mDequantization.PositionScale, 0.0f);
+        block.TexCoordTransform = glm::vec4(
+            mDequantization.TexCoordOffset, mDequantization.TexCoordScale);
+    }
+
+    void Mesh::Bind()
+    {
+        glBindVertexArray(mVertexArray);
+    }
+
+    void Mesh::Draw()
+    {
+        glBindVertexArray(mVertexArray);
+        glDrawElements(GL_TRIANGLES, mIndexCount, mIndexType, nullptr);
+    }
+
+    void Mesh::DrawInstanced(GLsizei instances)
+    {
+        glBindVertexArray(mVertexArray);
+        glDrawElementsInstanced(
+            GL_TRIANGLES, mIndexCount, mIndexType, nullptr, instances);
+    }
+
+    void Mesh::Draw(GLStateCache& state)
+    {
+        state.BindVertexArray(mVertexArray);
+        glDrawElements(GL_TRIANGLES, mIndexCount, mIndexType, nullptr);
+    }
+
+    void Mesh::DrawInstanced(GLStateCache& state, GLsizei instances)
+    {
+        state.BindVertexArray(mVertexArray);
+        glDrawElementsInstanced(
+            GL_TRIANGLES, mIndexCount, mIndexType, nullptr, instances);
+    }
+
+    void Mesh::ApplyLayout(
+        GLuint vertexArray, const VertexLayout& layout, GLuint binding)
+    {
+        for (const VertexElement& element : layout.GetElements()) {
+            FormatInfo info = GetFormatInfo(element.Format);
+            GLuint location = static_cast<GLuint>(element.Attribute);
+
+            glEnableVertexArrayAttrib(vertexArray, location);
+            glVertexArrayAttribFormat(
+                vertexArray, location, info.Components, info.Type,
+                info.Normalized, element.Offset);
+            glVertexArrayAttribBinding(vertexArray, location, binding);
+        }
+    }
+}
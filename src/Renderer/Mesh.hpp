@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <glad/glad.h>
+
+#include "Geometry/VertexLayout.hpp"
+#include "OpenGL/GLBuffer.hpp"
+#include "OpenGL/GLShaderPreprocessor.hpp"
+#include "OpenGL/GLStateCache.hpp"
+#include "Renderer/UniformBlocks.hpp"
+
+namespace Myst
+{
+    // Indexed triangles in GPU buffers, with a vertex array object set up from
+    // the mesh's layout. Indices are stored as 16 bits whenever they fit.
+    class Mesh
+    {
+    public:
+        explicit Mesh(const MeshData& data);
+        ~Mesh();
+
+        Mesh(const Mesh&) = delete;
+        Mesh& operator=(const Mesh&) = delete;
+
+        GLuint GetVertexArray() const
+        {
+            return mVertexArray;
+        }
+
+        const VertexLayout& GetLayout() const
+        {
+            return mLayout;
+        }
+
+        GLsizei GetVertexCount() const
+        {
+            return mVertexCount;
+        }
+
+        GLsizei GetIndexCount() const
+        {
+            return mIndexCount;
+        }
+
+        GLenum GetIndexType() const
+        {
+            return mIndexType;
+        }
+
+        const VertexDequantization& GetDequantization() const
+        {
+            return mDequantization;
+        }
+
+        // Selects the attribute decoding in `include/vertex.glsl`.
+        GLShaderPreprocessor::Defines GetShaderDefines() const
+        {
+            return GetShaderDefines(mLayout);
+        }
+
+        static GLShaderPreprocessor::Defines GetShaderDefines(const VertexLayout& layout);
+
+        // Writes the dequantization bounds the vertex shader needs.
+        void SetObjectBlock(ObjectBlock& block) const;
+
+        void Bind();
+        void Draw();
+        void DrawInstanced(GLsizei instances);
+
+        // As above, binding the vertex array only if it isn't already.
+        void Draw(GLStateCache& state);
+        void DrawInstanced(GLStateCache& state, GLsizei instances);
+
+        // Describes the layout's attributes on `vertexArray`, sourcing them
+        // from vertex buffer binding `binding`.
+        static void ApplyLayout(
+            GLuint vertexArray, const VertexLayout& layout, GLuint binding);
+
+    private:
+        VertexLayout mLayout;
+        VertexDequantization mDequantization;
+
+        std::unique_ptr<GLBuffer> mVertices;
+        std::unique_ptr<GLBuffer> mIndices;
+        GLuint mVertexArray;
+
+        GLsizei mVertexCount;
+        GLsizei mIndexCount;
+        GLenum mIndexType;
+    };
+}
@@ -0,0 +1,450 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Renderer/OcclusionBuffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "Core/Profiler.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define MYST_OCCLUSION_X86 1
+#include <immintrin.h>
+#endif
+
+namespace Myst
+{
+    namespace
+    {
+        std::uint32_t RoundUp(std::uint32_t value, std::uint32_t multiple)
+        {
+            return (std::max(value, 1u) + multiple - 1) / multiple * multiple;
+        }
+
+        // Keeps far off screen vertices within what a pixel index can hold.
+        std::int32_t ToPixel(float coordinate)
+        {
+            return static_cast<std::int32_t>(std::floor(std::clamp(coordinate, -1e7f, 1e7f)));
+        }
+    }
+
+    OccluderMesh OccluderMesh::FromMeshData(const MeshData& mesh)
+    {
+        OccluderMesh occluder;
+        occluder.Positions = ReadPositions(mesh);
+        occluder.Indices = mesh.Indices;
+
+        if (occluder.Indices.empty()) {
+            occluder.Indices.resize(occluder.Positions.size() / 3 * 3);
+
+            for (std::size_t i = 0; i < occluder.Indices.size(); ++i) {
+                occluder.Indices[i] = static_cast<std::uint32_t>(i);
+            }
+        }
+
+        return occluder;
+    }
+
+    OcclusionBuffer::OcclusionBuffer(std::uint32_t width, std::uint32_t height)
+        : mWidth(RoundUp(width, kTileSize))
+        , mHeight(RoundUp(height, kTileSize))
+        , mTilesX(mWidth / kTileSize)
+        , mTilesY(mHeight / kTileSize)
+        , mViewProjection(1.0f)
+        , mDepth(static_cast<std::size_t>(mWidth) * mHeight, 0.0f)
+        , mTileDepth(static_cast<std::size_t>(mTilesX) * mTilesY, 0.0f)
+        , mStats{}
+    {
+        // Nothing to do.
+    }
+
+    void OcclusionBuffer::Begin(const glm::mat4& viewProjection)
+    {
+        mViewProjection = viewProjection;
+        mOccluders.clear();
+        mStats = {};
+
+        std::fill(mDepth.begin(), mDepth.end(), 0.0f);
+        std::fill(mTileDepth.begin(), mTileDepth.end(), 0.0f);
+    }
+
+    void OcclusionBuffer::AddOccluder(const OccluderMesh& mesh, const glm::mat4& transform)
+    {
+        mOccluders.push_back({&mesh, transform});
+    }
+
+    void OcclusionBuffer::Rasterize(JobSystem* jobs)
+    {
+        MYST_PROFILE_SCOPE("OcclusionBuffer::Rasterize");
+
+        const std::size_t threads = jobs != nullptr ? jobs->GetThreadCount() : 1;
+
+        auto parallelFor = [jobs](
+                               std::size_t count,
+                               const std::function<void(std::size_t, std::size_t)>& function) {
+            if (jobs != nullptr) {
+                jobs->ParallelFor(count, 1, function);
+            } else {
+                function(0, count);
+            }
+        };
+
+        // Triangle setup, a few occluders per job.
+        const std::size_t groups = std::min(mOccluders.size(), threads * 2);
+        mTriangles.resize(groups);
+
+        parallelFor(groups, [this, groups](std::size_t first, std::size_t last) {
+            for (std::size_t group = first; group < last; ++group) {
+                std::vector<Triangle>& triangles = mTriangles[group];
+                triangles.clear();
+
+                for (std::size_t i = group; i < mOccluders.size(); i += groups) {
+                    SetupOccluder(mOccluders[i], triangles);
+                }
+            }
+        });
+
+        mStats.Occluders = mOccluders.size();
+
+        for (const Occluder& occluder : mOccluders) {
+            mStats.Triangles += occluder.Mesh->GetTriangleCount();
+        }
+
+        for (std::size_t group = 0; group < groups; ++group) {
+            mStats.Rasterized += mTriangles[group].size();
+        }
+
+        if (mStats.Rasterized == 0) {
+            return;
+        }
+
+        // Bands of whole tile rows, so each job owns its pixels and tiles.
+        const std::uint32_t bands = static_cast<std::uint32_t>(
+            std::min<std::size_t>(mTilesY, threads * 2));
+        const std::uint32_t rowsPerBand = (mTilesY + bands - 1) / bands;
+
+        parallelFor(bands, [this, rowsPerBand](std::size_t first, std::size_t last) {
+            for (std::size_t band = first; band < last; ++band) {
+                const std::uint32_t row = static_cast<std::uint32_t>(band) * rowsPerBand;
+
+                if (row < mTilesY) {
+                    RasterizeBand(row, std::min(rowsPerBand, mTilesY - row));
+                }
+            }
+        });
+    }
+
+    void OcclusionBuffer::SetupOccluder(
+        const Occluder& occluder, std::vector<Triangle>& triangles) const
+    {
+        const OccluderMesh& mesh = *occluder.Mesh;
+        const glm::mat4 transform = mViewProjection * occluder.Transform;
+
+        std::vector<glm::vec4> clip(mesh.Positions.size());
+
+        for (std::size_t i = 0; i < clip.size(); ++i) {
+            clip[i] = transform * glm::vec4(mesh.Positions[i], 1.0f);
+        }
+
+        for (std::size_t i = 0; i + 2 < mesh.Indices.size(); i += 3) {
+            const glm::vec4 v[3]{
+                clip[mesh.Indices[i]], clip[mesh.Indices[i + 1]], clip[mesh.Indices[i + 2]]};
+
+            // Entirely outside one of the side or far planes.
+            if ((v[0].x < -v[0].w && v[1].x < -v[1].w && v[2].x < -v[2].w) ||
+                (v[0].x > v[0].w && v[1].x > v[1].w && v[2].x > v[2].w) ||
+                (v[0].y < -v[0].w && v[1].y < -v[1].w && v[2].y < -v[2].w) ||
+                (v[0].y > v[0].w && v[1].y > v[1].w && v[2].y > v[2].w) ||
+                (v[0].z > v[0].w && v[1].z > v[1].w && v[2].z > v[2].w)) {
+                continue;
+            }
+
+            // Clipped against the near plane, z >= -w, which leaves a convex
+            // polygon of up to four vertices with w > 0.
+            glm::vec4 polygon[4];
+            int count{0};
+
+            for (int j = 0; j < 3; ++j) {
+                const glm::vec4& current = v[j];
+                const glm::vec4& next = v[(j + 1) % 3];
+                const float currentDistance = current.z + current.w;
+                const float nextDistance = next.z + next.w;
+
+                if (currentDistance >= 0.0f) {
+                    polygon[count++] = current;
+                }
+
+                if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f)) {
+                    const float t = currentDistance / (currentDistance - nextDistance);
+                    polygon[count++] = current + (next - current) * t;
+                }
+            }
+
+            for (int j = 2; j < count; ++j) {
+                SetupTriangle(polygon[0], polygon[j - 1], polygon[j], triangles);
+            }
+        }
+    }
+
+    void OcclusionBuffer::SetupTriangle(
+        const glm::vec4& a, const glm::vec4& b, const glm::vec4& c,
+        std::vector<Triangle>& triangles) const
+    {
+        const float halfWidth = 0.5f * static_cast<float>(mWidth);
+        const float halfHeight = 0.5f * static_cast<float>(mHeight);
+
+        // Pixel coordinates with y up, and 1/w as depth.
+        glm::vec3 p[3];
+        const glm::vec4* v[3]{&a, &b, &c};
+
+        for (int i = 0; i < 3; ++i) {
+            const float inverseW = 1.0f / v[i]->w;
+            p[i] = glm::vec3(
+                (v[i]->x * inverseW + 1.0f) * halfWidth,
+                (v[i]->y * inverseW + 1.0f) * halfHeight, inverseW);
+        }
+
+        float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) -
+                     (p[2].x - p[0].x) * (p[1].y - p[0].y);
+
+        // Occluders are rasterized from both sides, since not every mesh
+        // winds its triangles consistently.
+        if (area < 0.0f) {
+            std::swap(p[1], p[2]);
+            area = -area;
+        }
+
+        if (area < 1e-6f) {
+            return;
+        }
+
+        Triangle triangle;
+        triangle.MinX = std::max(0, ToPixel(std::min({p[0].x, p[1].x, p[2].x})));
+        triangle.MaxX = std::min(
+            static_cast<std::int32_t>(mWidth) - 1, ToPixel(std::max({p[0].x, p[1].x, p[2].x})));
+        triangle.MinY = std::max(0, ToPixel(std::min({p[0].y, p[1].y, p[2].y})));
+        triangle.MaxY = std::min(
+            static_cast<std::int32_t>(mHeight) - 1, ToPixel(std::max({p[0].y, p[1].y, p[2].y})));
+
+        if (triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY) {
+            return;
+        }
+
+        // Edge i runs from p[i] to p[i + 1]; inside is where all three are
+        // non-negative.
+        for (int i = 0; i < 3; ++i) {
+            const glm::vec3& from = p[i];
+            const glm::vec3& to = p[(i + 1) % 3];
+
+            triangle.EdgeA[i] = from.y - to.y;
+            triangle.EdgeB[i] = to.x - from.x;
+            triangle.EdgeC[i] = from.x * to.y - from.y * to.x;
+        }
+
+        const glm::vec3 d1 = p[1] - p[0];
+        const glm::vec3 d2 = p[2] - p[0];
+
+        triangle.DepthA = (d1.z * d2.y - d2.z * d1.y) / area;
+        triangle.DepthB = (d1.x * d2.z - d2.x * d1.z) / area;
+
+        // Evaluated at pixel centers but lowered to the farthest depth within
+        // the pixel, so an occluder never claims to be nearer than it is.
+        triangle.DepthC = p[0].z - triangle.DepthA * p[0].x - triangle.DepthB * p[0].y -
+                          0.5f * (std::abs(triangle.DepthA) + std::abs(triangle.DepthB));
+
+        triangles.push_back(triangle);
+    }
+
+    void OcclusionBuffer::RasterizeBand(std::uint32_t firstTileRow, std::uint32_t tileRows)
+    {
+        MYST_PROFILE_SCOPE("OcclusionBuffer::RasterizeBand");
+
+        const std::int32_t bandMinY = static_cast<std::int32_t>(firstTileRow * kTileSize);
+        const std::int32_t bandMaxY =
+            static_cast<std::int32_t>((firstTileRow + tileRows) * kTileSize) - 1;
+
+        for (const std::vector<Triangle>& triangles : mTriangles) {
+            for (const Triangle& triangle : triangles) {
+                const std::int32_t minY = std::max(triangle.MinY, bandMinY);
+                const std::int32_t maxY = std::min(triangle.MaxY, bandMaxY);
+
+                for (std::int32_t y = minY; y <= maxY; ++y) {
+                    const float py = static_cast<float>(y) + 0.5f;
+                    float* row = mDepth.data() + static_cast<std::size_t>(y) * mWidth;
+
+                    float rowEdge[3];
+
+                    for (int i = 0; i < 3; ++i) {
+                        rowEdge[i] = triangle.EdgeB[i] * py + triangle.EdgeC[i];
+                    }
+
+                    const float rowDepth = triangle.DepthB * py + triangle.DepthC;
+
+                    // Rows are a multiple of four wide, so aligning the start
+                    // keeps every group of four on the row.
+                    std::int32_t x = triangle.MinX & ~3;
+
+#if defined(MYST_OCCLUSION_X86)
+                    const __m128 edgeA0 = _mm_set1_ps(triangle.EdgeA[0]);
+                    const __m128 edgeA1 = _mm_set1_ps(triangle.EdgeA[1]);
+                    const __m128 edgeA2 = _mm_set1_ps(triangle.EdgeA[2]);
+                    const __m128 edge0 = _mm_set1_ps(rowEdge[0]);
+                    const __m128 edge1 = _mm_set1_ps(rowEdge[1]);
+                    const __m128 edge2 = _mm_set1_ps(rowEdge[2]);
+                    const __m128 depthA = _mm_set1_ps(triangle.DepthA);
+                    const __m128 depth = _mm_set1_ps(rowDepth);
+                    const __m128 zero = _mm_setzero_ps();
+
+                    __m128 px = _mm_add_ps(
+                        _mm_set1_ps(static_cast<float>(x)), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+                    const __m128 four = _mm_set1_ps(4.0f);
+
+                    for (; x <= triangle.MaxX; x += 4) {
+                        __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA0, px), edge0), zero);
+                        inside = _mm_and_ps(
+                            inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA1, px), edge1), zero));
+                        inside = _mm_and_ps(
+                            inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA2, px), edge2), zero));
+
+                        if (_mm_movemask_ps(inside) != 0) {
+                            const __m128 z = _mm_add_ps(_mm_mul_ps(depthA, px), depth);
+                            const __m128 previous = _mm_loadu_ps(row + x);
+                            const __m128 nearest = _mm_max_ps(previous, z);
+
+                            _mm_storeu_ps(
+                                row + x,
+                                _mm_or_ps(
+                                    _mm_and_ps(inside, nearest),
+                                    _mm_andnot_ps(inside, previous)));
+                        }
+
+                        px = _mm_add_ps(px, four);
+                    }
+#else
+                    for (; x <= triangle.MaxX; ++x) {
+                        const float px = static_cast<float>(x) + 0.5f;
+
+                        if (triangle.EdgeA[0] * px + rowEdge[0] >= 0.0f &&
+                            triangle.EdgeA[1] * px + rowEdge[1] >= 0.0f &&
+                            triangle.EdgeA[2] * px + rowEdge[2] >= 0.0f) {
+                            row[x] = std::max(row[x], triangle.DepthA * px + rowDepth);
+                        }
+                    }
+#endif
+                }
+            }
+        }
+
+        for (std::uint32_t ty = firstTileRow; ty < firstTileRow + tileRows; ++ty) {
+            for (std::uint32_t tx = 0; tx < mTilesX; ++tx) {
+                float farthest = 1e30f;
+
+                for (std::uint32_t y = ty * kTileSize; y < (ty + 1) * kTileSize; ++y) {
+                    const float* row = mDepth.data() + static_cast<std::size_t>(y) * mWidth;
+
+                    for (std::uint32_t x = tx * kTileSize; x < (tx + 1) * kTileSize; ++x) {
+                        farthest = std::min(farthest, row[x]);
+                    }
+                }
+
+                mTileDepth[static_cast<std::size_t>(ty) * mTilesX + tx] = farthest;
+            }
+        }
+    }
+
+    bool OcclusionBuffer::IsVisible(const BoundingBox& box)
+    {
+        ++mStats.Tested;
+
+        float minX{1e30f}, minY{1e30f};
+        float maxX{-1e30f}, maxY{-1e30f};
+        float nearest{0.0f};
+
+        for (int i = 0; i < 8; ++i) {
+            const glm::vec3 corner(
+                (i & 1) ? box.Max.x : box.Min.x, (i & 2) ? box.Max.y : box.Min.y,
+                (i & 4) ? box.Max.z : box.Min.z);
+            const glm::vec4 clip = mViewProjection * glm::vec4(corner, 1.0f);
+
+            // Reaching past the near plane: too close to bother.
+            if (clip.z < -clip.w || clip.w <= 0.0f) {
+                return true;
+            }
+
+            const float inverseW = 1.0f / clip.w;
+            const float x = (clip.x * inverseW + 1.0f) * 0.5f * static_cast<float>(mWidth);
+            const float y = (clip.y * inverseW + 1.0f) * 0.5f * static_cast<float>(mHeight);
+
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+            nearest = std::max(nearest, inverseW);
+        }
+
+        const std::int32_t x0 = std::max(0, ToPixel(minX));
+        const std::int32_t x1 = std::min(static_cast<std::int32_t>(mWidth) - 1, ToPixel(maxX));
+        const std::int32_t y0 = std::max(0, ToPixel(minY));
+        const std::int32_t y1 = std::min(static_cast<std::int32_t>(mHeight) - 1, ToPixel(maxY));
+
+        if (x0 > x1 || y0 > y1) {
+            ++mStats.Rejected;
+            return false;
+        }
+
+        const std::int32_t tileSize = static_cast<std::int32_t>(kTileSize);
+
+        for (std::int32_t ty = y0 / tileSize; ty <= y1 / tileSize; ++ty) {
+            for (std::int32_t tx = x0 / tileSize; tx <= x1 / tileSize; ++tx) {
+                // The whole tile is nearer than the box.
+                if (mTileDepth[static_cast<std::size_t>(ty) * mTilesX + tx] > nearest) {
+                    continue;
+                }
+
+                const std::int32_t tileX1 = std::min(x1, (tx + 1) * tileSize - 1);
+                const std::int32_t tileY1 = std::min(y1, (ty + 1) * tileSize - 1);
+
+                for (std::int32_t y = std::max(y0, ty * tileSize); y <= tileY1; ++y) {
+                    const float* row = mDepth.data() + static_cast<std::size_t>(y) * mWidth;
+
+                    for (std::int32_t x = std::max(x0, tx * tileSize); x <= tileX1; ++x) {
+                        if (row[x] <= nearest) {
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+
+        ++mStats.Rejected;
+        return false;
+    }
+
+    void OcclusionBuffer::GetDebugImage(
+        float near, float far, std::vector<std::uint8_t>& pixels) const
+    {
+        pixels.resize(mDepth.size() * 4);
+
+        const float range = std::log(far / near);
+
+        for (std::size_t i = 0; i < mDepth.size(); ++i) {
+            std::uint8_t value{0};
+
+            if (mDepth[i] > 0.0f) {
+                float t = 1.0f - std::log(1.0f / (mDepth[i] * near)) / range;
+                value = static_cast<std::uint8_t>(40.0f + 215.0f * std::clamp(t, 0.0f, 1.0f));
+            }
+
+            pixels[i * 4 + 0] = value;
+            pixels[i * 4 + 1] = value;
+            pixels[i * 4 + 2] = value;
+            pixels[i * 4 + 3] = 255;
+        }
+    }
+}
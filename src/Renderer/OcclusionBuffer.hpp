@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Core/JobSystem.hpp"
+#include "Geometry/Bounds.hpp"
+#include "Geometry/VertexLayout.hpp"
+
+namespace Myst
+{
+    // The triangles an occluder is rasterized from: plain positions, so
+    // quantized meshes are only decoded once.
+    struct OccluderMesh
+    {
+        std::vector<glm::vec3> Positions;
+        std::vector<std::uint32_t> Indices;
+
+        static OccluderMesh FromMeshData(const MeshData& mesh);
+
+        std::size_t GetTriangleCount() const
+        {
+            return Indices.size() / 3;
+        }
+    };
+
+    // A small software depth buffer for occlusion culling. Designated
+    // occluders are rasterized into it on the CPU, then the bounding boxes of
+    // other objects are tested against it before they are submitted, so that
+    // nothing hidden behind a wall reaches the GPU.
+    //
+    // Depth is stored as 1/w, which is linear in screen space, with zero for
+    // nothing. Each 8x8 tile also keeps its farthest depth, which settles
+    // most tests without looking at single pixels. Rasterization runs in
+    // horizontal bands as jobs, four pixels at a time.
+    //
+    // Occluders are sampled at pixel centers and so may cover a little more
+    // than they do at full resolution; occludees are tested with their
+    // nearest depth over every pixel they touch.
+    class OcclusionBuffer
+    {
+    public:
+        struct Stats
+        {
+            std::size_t Occluders;
+            std::size_t Triangles;
+            // Triangles left after clipping and culling, as rasterized.
+            std::size_t Rasterized;
+            std::size_t Tested;
+            std::size_t Rejected;
+        };
+
+        static constexpr std::uint32_t kTileSize{8};
+
+        // Rounded up to whole tiles.
+        OcclusionBuffer(std::uint32_t width = 256, std::uint32_t height = 144);
+
+        std::uint32_t GetWidth() const
+        {
+            return mWidth;
+        }
+
+        std::uint32_t GetHeight() const
+        {
+            return mHeight;
+        }
+
+        // Rows from the bottom, as 1/w.
+        const std::vector<float>& GetDepth() const
+        {
+            return mDepth;
+        }
+
+        const Stats& GetStats() const
+        {
+            return mStats;
+        }
+
+        // Starts a frame seen through `viewProjection`, dropping the previous
+        // occluders and statistics.
+        void Begin(const glm::mat4& viewProjection);
+
+        // `mesh` must stay alive until Rasterize() returns.
+        void AddOccluder(const OccluderMesh& mesh, const glm::mat4& transform);
+
+        // Fills the buffer with the occluders added since Begin(). Without a
+        // job system, everything runs on the calling thread.
+        void Rasterize(JobSystem* jobs = nullptr);
+
+        // False if the box is entirely hidden behind rasterized occluders,
+        // or off screen.
+        bool IsVisible(const BoundingBox& box);
+
+        // The buffer as RGBA8, brighter when nearer, on a logarithmic scale
+        // between the planes.
+        void GetDebugImage(float near, float far, std::vector<std::uint8_t>& pixels) const;
+
+    private:
+        struct Occluder
+        {
+            const OccluderMesh* Mesh;
+            glm::mat4 Transform;
+        };
+
+        // A screen space triangle ready for the band loops: three edge
+        // functions, the depth plane and the pixel bounds.
+        struct Triangle
+        {
+            float EdgeA[3];
+            float EdgeB[3];
+            float EdgeC[3];
+            float DepthA;
+            float DepthB;
+            float DepthC;
+            std::int32_t MinX, MaxX;
+            std::int32_t MinY, MaxY;
+        };
+
+        void SetupOccluder(const Occluder& occluder, std::vector<Triangle>& triangles) const;
+        void SetupTriangle(
+            const glm::vec4& a, const glm::vec4& b, const glm::vec4& c,
+            std::vector<Triangle>& triangles) const;
+
+        void RasterizeBand(std::uint32_t firstTileRow, std::uint32_t tileRows);
+
+    private:
+        std::uint32_t mWidth;
+        std::uint32_t mHeight;
+        std::uint32_t mTilesX;
+        std::uint32_t mTilesY;
+
+        glm::mat4 mViewProjection;
+
+        std::vector<float> mDepth;
+        // The farthest depth of each tile.
+        std::vector<float> mTileDepth;
+
+        std::vector<Occluder> mOccluders;
+        // Triangles per setup job, so that jobs don't share a vector.
+        std::vector<std::vector<Triangle>> mTriangles;
+
+        Stats mStats;
+    };
+}
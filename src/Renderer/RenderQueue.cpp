@@ -0,0 +1,257 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Renderer/RenderQueue.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Core/Profiler.hpp"
+
+namespace Myst
+{
+    namespace
+    {
+        constexpr unsigned int kPassShift{60};
+        constexpr unsigned int kTranslucentShift{59};
+
+        constexpr unsigned int kStateBits{12};
+        constexpr std::uint64_t kStateMask{(1u << kStateBits) - 1};
+
+        constexpr unsigned int kDepthBits{24};
+        constexpr std::uint64_t kDepthMask{(1u << kDepthBits) - 1};
+
+        // Non-negative floats order like their bit patterns, so the top bits
+        // below the sign keep the order: 8 bits of exponent and 16 of mantissa.
+        std::uint64_t QuantizeDepth(float depth)
+        {
+            std::uint32_t bits;
+            depth = std::max(depth, 0.0f);
+            std::memcpy(&bits, &depth, sizeof(bits));
+
+            return (bits >> (31 - kDepthBits)) & kDepthMask;
+        }
+    }
+
+    RenderQueue::RenderQueue(GLRingBuffer& ring)
+        : mRing(ring)
+        , mSorted(true)
+        , mStats{}
+    {
+        // Nothing to do.
+    }
+
+    std::uint64_t RenderQueue::MakeKey(
+        RenderPass pass, bool translucent, std::uint32_t program,
+        std::uint32_t material, float depth)
+    {
+        // IDs past the field's range wrap, which only costs sorting quality.
+        const std::uint64_t state =
+            (program & kStateMask) << kStateBits | (material & kStateMask);
+        const std::uint64_t quantized = QuantizeDepth(depth);
+
+        std::uint64_t key = static_cast<std::uint64_t>(pass) << kPassShift |
+                            static_cast<std::uint64_t>(translucent) << kTranslucentShift;
+
+        if (translucent) {
+            key |= (kDepthMask - quantized) << (2 * kStateBits + 11) | state << 11;
+        } else {
+            key |= state << (kDepthBits + 11) | quantized << 11;
+        }
+
+        return key;
+    }
+
+    std::uint32_t RenderQueue::GetID(
+        std::unordered_map<const void*, std::uint32_t>& ids, const void* object)
+    {
+        auto it = ids.find(object);
+
+        if (it != ids.end()) {
+            return it->second;
+        }
+
+        std::uint32_t id = static_cast<std::uint32_t>(ids.size());
+        ids.emplace(object, id);
+
+        return id;
+    }
+
+    void RenderQueue::Submit(
+        RenderPass pass, const RenderItem& item, float depth, bool translucent)
+    {
+        const std::uint32_t program = GetID(mProgramIDs, item.Program);
+        const std::uint32_t material = GetID(mMaterialIDs, item.Material);
+
+        mEntries.push_back(
+            {MakeKey(pass, translucent, program, material, depth),
+             static_cast<std::uint32_t>(mItems.size())});
+        mItems.push_back(item);
+        mSorted = false;
+    }
+
+    void RenderQueue::Submit(const CommandBuffer& commands)
+    {
+        MYST_PROFILE_SCOPE("RenderQueue::Submit");
+
+        if (commands.GetSize() == 0) {
+            return;
+        }
+
+        // One range for the whole payload keeps its offsets, and with them
+        // the alignment of every block in it.
+        GLRingBuffer::Range payload;
+
+        if (commands.GetPayloadSize() > 0) {
+            payload = mRing.Allocate(static_cast<GLsizeiptr>(commands.GetPayloadSize()));
+
+            if (!payload.IsValid()) {
+                return;
+            }
+
+            std::memcpy(payload.Data, commands.GetPayload(), commands.GetPayloadSize());
+        }
+
+        auto slice = [&payload](std::uint32_t offset, std::uint32_t size) {
+            GLRingBuffer::Range range;
+
+            if (size > 0) {
+                range.Buffer = payload.Buffer;
+                range.Offset = payload.Offset + offset;
+                range.Size = size;
+                range.Data = static_cast<unsigned char*>(payload.Data) + offset;
+            }
+
+            return range;
+        };
+
+        mItems.reserve(mItems.size() + commands.GetSize());
+        mEntries.reserve(mEntries.size() + commands.GetSize());
+
+        for (const DrawCommand& command : commands.GetCommands()) {
+            RenderItem item;
+            item.Program = command.Program;
+            item.Material = command.Material;
+            item.Mesh = command.Mesh;
+            item.Object = slice(command.ObjectOffset, command.ObjectSize);
+            item.Instances = slice(command.InstancesOffset, command.InstancesSize);
+            item.InstanceCount = static_cast<GLsizei>(command.InstanceCount);
+
+            mEntries.push_back({command.Key, static_cast<std::uint32_t>(mItems.size())});
+            mItems.push_back(item);
+        }
+
+        mSorted = false;
+    }
+
+    void RenderQueue::Sort()
+    {
+        if (mSorted) {
+            return;
+        }
+
+        // LSD radix sort over the key's bytes. All eight histograms are built
+        // in one pass, and bytes that are the same in every key, such as the
+        // unused pass bits or the low bits, are skipped. Being stable, draws
+        // with equal keys keep their submission order.
+        std::uint32_t histograms[8][256]{};
+
+        for (const Entry& entry : mEntries) {
+            for (unsigned int byte = 0; byte < 8; ++byte) {
+                ++histograms[byte][(entry.Key >> (byte * 8)) & 0xff];
+            }
+        }
+
+        mScratch.resize(mEntries.size());
+
+        for (unsigned int byte = 0; byte < 8; ++byte) {
+            std::uint32_t* histogram = histograms[byte];
+            const std::uint32_t first = (mEntries[0].Key >> (byte * 8)) & 0xff;
+
+            if (histogram[first] == mEntries.size()) {
+                continue;
+            }
+
+            std::uint32_t offset{0};
+
+            for (unsigned int digit = 0; digit < 256; ++digit) {
+                std::uint32_t count = histogram[digit];
+                histogram[digit] = offset;
+                offset += count;
+            }
+
+            for (const Entry& entry : mEntries) {
+                mScratch[histogram[(entry.Key >> (byte * 8)) & 0xff]++] = entry;
+            }
+
+            mEntries.swap(mScratch);
+        }
+
+        mSorted = true;
+    }
+
+    void RenderQueue::Execute(GLStateCache& state)
+    {
+        MYST_PROFILE_SCOPE("RenderQueue::Execute");
+
+        mStats = {};
+        mStats.Items = mItems.size();
+
+        if (mItems.empty()) {
+            return;
+        }
+
+        Sort();
+
+        mMaterialBlocks.assign(mMaterialIDs.size(), GLRingBuffer::Range{});
+
+        const GLShaderProgram* program{nullptr};
+        const Material* material{nullptr};
+
+        for (const Entry& entry : mEntries) {
+            const RenderItem& item = mItems[entry.Item];
+
+            if (item.Program == nullptr || item.Mesh == nullptr) {
+                continue;
+            }
+
+            if (item.Program != program) {
+                state.UseProgram(item.Program->GetID());
+                program = item.Program;
+                ++mStats.Programs;
+            }
+
+            if (item.Material != nullptr && item.Material != material) {
+                GLRingBuffer::Range& block = mMaterialBlocks[mMaterialIDs[item.Material]];
+
+                if (!block.IsValid()) {
+                    block = mRing.Push(item.Material->GetBlock());
+                }
+
+                item.Material->Bind(state);
+                block.Bind(state, GL_UNIFORM_BUFFER, kMaterialBlockBinding);
+                material = item.Material;
+                ++mStats.Materials;
+            }
+
+            if (item.Object.IsValid()) {
+                item.Object.Bind(state, GL_UNIFORM_BUFFER, kObjectBlockBinding);
+            }
+
+            if (item.Instances.IsValid()) {
+                item.Instances.Bind(state, GL_SHADER_STORAGE_BUFFER, kInstanceBufferBinding);
+                item.Mesh->DrawInstanced(state, item.InstanceCount);
+            } else {
+                item.Mesh->Draw(state);
+            }
+        }
+
+        mItems.clear();
+        mEntries.clear();
+        mSorted = true;
+    }
+}
@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "OpenGL/GLRingBuffer.hpp"
+#include "OpenGL/GLShader.hpp"
+#include "OpenGL/GLStateCache.hpp"
+#include "Renderer/CommandBuffer.hpp"
+#include "Renderer/Material.hpp"
+#include "Renderer/Mesh.hpp"
+
+namespace Myst
+{
+    // Passes are drawn in order; there can be up to 16.
+    enum class RenderPass : std::uint8_t
+    {
+        Main,
+        Overlay,
+    };
+
+    // Everything a draw needs. The ranges are already written into the ring;
+    // only the material block is pushed at execution, once per material.
+    struct RenderItem
+    {
+        GLShaderProgram* Program{nullptr};
+
+        // May be null for programs that don't sample a material.
+        const Myst::Material* Material{nullptr};
+        Myst::Mesh* Mesh{nullptr};
+
+        // Bound to the object block, if valid.
+        GLRingBuffer::Range Object;
+
+        // Bound to the instance buffer, if valid, and drawn `InstanceCount`
+        // times.
+        GLRingBuffer::Range Instances;
+        GLsizei InstanceCount{1};
+    };
+
+    // Records a frame's draws as 64-bit sort keys with the items on the side,
+    // and executes them sorted so that consecutive draws share as much state
+    // as possible. From the most significant bit down, a key is:
+    //
+    //   pass (4) | translucent (1) | program (12) | material (12) | depth (24)
+    //
+    // with the low 11 bits unused.
+    //
+    // Translucent draws swap in the inverted depth ahead of the state, so they
+    // go back to front; opaque draws of the same state go front to back.
+    class RenderQueue
+    {
+    public:
+        struct Stats
+        {
+            std::size_t Items;
+            std::size_t Programs;
+            std::size_t Materials;
+        };
+
+        explicit RenderQueue(GLRingBuffer& ring);
+
+        RenderQueue(const RenderQueue&) = delete;
+        RenderQueue& operator=(const RenderQueue&) = delete;
+
+        // Statistics of the last Execute().
+        const Stats& GetStats() const
+        {
+            return mStats;
+        }
+
+        std::size_t GetSize() const
+        {
+            return mItems.size();
+        }
+
+        // `depth` is the view distance. The program and material must outlive
+        // the queue, as their sort IDs are kept across frames.
+        void Submit(
+            RenderPass pass, const RenderItem& item, float depth, bool translucent = false);
+
+        // Merges commands recorded elsewhere, copying their payload into the
+        // ring. The buffer can be reset right after.
+        void Submit(const CommandBuffer& commands);
+
+        // The sort IDs that go into keys, for recording them ahead of time.
+        // Like Submit(), these may only be called by the queue's thread.
+        std::uint32_t GetProgramID(const GLShaderProgram* program)
+        {
+            return GetID(mProgramIDs, program);
+        }
+
+        std::uint32_t GetMaterialID(const Myst::Material* material)
+        {
+            return GetID(mMaterialIDs, material);
+        }
+
+        // Sorts, draws and clears the recorded items. Expects the frame and
+        // view blocks to be bound.
+        void Execute(GLStateCache& state);
+
+        // Sorts the recorded items without drawing them; Execute() does this
+        // itself.
+        void Sort();
+
+        static std::uint64_t MakeKey(
+            RenderPass pass, bool translucent, std::uint32_t program,
+            std::uint32_t material, float depth);
+
+    private:
+        struct Entry
+        {
+            std::uint64_t Key;
+            std::uint32_t Item;
+        };
+
+        std::uint32_t GetID(
+            std::unordered_map<const void*, std::uint32_t>& ids, const void* object);
+
+    private:
+        GLRingBuffer& mRing;
+
+        std::vector<RenderItem> mItems;
+        std::vector<Entry> mEntries;
+        std::vector<Entry> mScratch;
+        bool mSorted;
+
+        // Dense IDs, so that they fit the key.
+        std::unordered_map<const void*, std::uint32_t> mProgramIDs;
+        std::unordered_map<const void*, std::uint32_t> mMaterialIDs;
+
+        // Material blocks pushed by the current Execute(), by material ID.
+        std::vector<GLRingBuffer::Range> mMaterialBlocks;
+
+        Stats mStats;
+    };
+}
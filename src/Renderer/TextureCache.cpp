@@ -0,0 +1,178 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Renderer/TextureCache.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+#include "Core/Hash.hpp"
+#include "Core/Profiler.hpp"
+
+namespace Myst
+{
+    TextureCache::TextureCache(GLTextureLoader& loader, std::size_t budget)
+        : mLoader(loader)
+        , mBudget(budget)
+        , mFrame(0)
+        , mHits(0)
+        , mMisses(0)
+        , mEvictions(0)
+        , mOverBudget(false)
+    {
+        // Nothing to do.
+    }
+
+    TextureCache::Handle TextureCache::Acquire(
+        const std::string& filepath, GLTexture::Parameters params)
+    {
+        std::uint64_t key = ComputeKey(filepath, params);
+        auto it = mEntries.find(key);
+
+        if (it != mEntries.end()) {
+            ++mHits;
+            it->second->LastUsed = mFrame;
+            return Handle(it->second);
+        }
+
+        ++mMisses;
+
+        auto entry = std::make_shared<Entry>();
+        entry->Key = key;
+        entry->Filepath = filepath;
+        entry->Texture = mLoader.Load(filepath, params);
+        entry->LastUsed = mFrame;
+
+        mEntries.emplace(key, entry);
+
+        return Handle(entry);
+    }
+
+    void TextureCache::Update()
+    {
+        MYST_PROFILE_SCOPE("TextureCache::Update");
+
+        ++mFrame;
+
+        for (auto& [key, entry] : mEntries) {
+            // Whatever is still referenced counts as used, so that a texture
+            // released a while ago goes before one released just now.
+            if (IsReferenced(entry)) {
+                entry->LastUsed = mFrame;
+            }
+        }
+
+        Evict();
+    }
+
+    TextureCache::Residency TextureCache::GetResidency() const
+    {
+        Residency residency{};
+        residency.Textures = mEntries.size();
+        residency.Budget = mBudget;
+        residency.Hits = mHits;
+        residency.Misses = mMisses;
+        residency.Evictions = mEvictions;
+
+        for (const auto& [key, entry] : mEntries) {
+            residency.Bytes += GetBytes(*entry);
+
+            if (IsReferenced(entry)) {
+                ++residency.Referenced;
+            }
+        }
+
+        return residency;
+    }
+
+    void TextureCache::PrintResidency(std::ostream& out) const
+    {
+        Residency residency = GetResidency();
+
+        out << "myst: texture cache " << residency.Bytes / 1024 << " / "
+            << residency.Budget / 1024 << " KiB, " << residency.Textures
+            << " textures (" << residency.Referenced << " referenced), "
+            << residency.Hits << " hits, " << residency.Misses << " misses, "
+            << residency.Evictions << " evictions" << std::endl;
+
+        std::vector<const Entry*> entries;
+
+        for (const auto& [key, entry] : mEntries) {
+            entries.push_back(entry.get());
+        }
+
+        std::sort(
+            entries.begin(), entries.end(), [](const Entry* a, const Entry* b) {
+                return GetBytes(*a) > GetBytes(*b);
+            });
+
+        for (const Entry* entry : entries) {
+            out << "  " << std::setw(8) << GetBytes(*entry) / 1024 << " KiB  "
+                << entry->Filepath << std::endl;
+        }
+    }
+
+    std::uint64_t TextureCache::ComputeKey(
+        const std::string& filepath, const GLTexture::Parameters& params)
+    {
+        // Hashed field by field, so that padding never ends up in the key.
+        const GLenum fields[]{
+            params.DataFormat, params.StorageFormat, params.FilterMin,
+            params.FilterMax,  params.WrapS,         params.WrapT,
+            params.WrapR,
+            static_cast<GLenum>(params.MipmapFilter),
+            static_cast<GLenum>(params.NormalMap),
+        };
+
+        return Hash(fields, sizeof(fields), Hash(filepath));
+    }
+
+    void TextureCache::Evict()
+    {
+        std::size_t bytes{0};
+        std::vector<std::shared_ptr<Entry>> candidates;
+
+        for (const auto& [key, entry] : mEntries) {
+            bytes += GetBytes(*entry);
+
+            if (!IsReferenced(entry)) {
+                candidates.push_back(entry);
+            }
+        }
+
+        if (bytes <= mBudget) {
+            mOverBudget = false;
+            return;
+        }
+
+        std::sort(
+            candidates.begin(), candidates.end(),
+            [](const auto& a, const auto& b) {
+                return a->LastUsed < b->LastUsed;
+            });
+
+        for (const auto& entry : candidates) {
+            if (bytes <= mBudget) {
+                break;
+            }
+
+            // Dropping the last loader handle deletes the GL texture.
+            bytes -= GetBytes(*entry);
+            mEntries.erase(entry->Key);
+            ++mEvictions;
+        }
+
+        if (bytes > mBudget && !mOverBudget) {
+            std::cerr << "myst: referenced textures exceed the budget ("
+                      << bytes / 1024 << " / " << mBudget / 1024 << " KiB)"
+                      << std::endl;
+        }
+
+        mOverBudget = bytes > mBudget;
+    }
+}
@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "OpenGL/GLTexture.hpp"
+#include "OpenGL/GLTextureLoader.hpp"
+
+namespace Myst
+{
+    // Interns textures by file and parameters, so every material asking for
+    // the same image shares a single GL texture.
+    //
+    // Textures stay cached after their last handle is dropped, which makes
+    // reacquiring them free. Once the estimated video memory exceeds the
+    // budget, unreferenced textures are evicted, least recently used first.
+    // Textures that are still referenced are never evicted.
+    class TextureCache
+    {
+        struct Entry
+        {
+            std::uint64_t Key;
+            std::string Filepath;
+            GLTextureLoader::Handle Texture;
+            std::uint64_t LastUsed{0};
+        };
+
+    public:
+        struct Residency
+        {
+            std::size_t Textures;
+            std::size_t Referenced;
+            std::size_t Bytes;
+            std::size_t Budget;
+            std::size_t Hits;
+            std::size_t Misses;
+            std::size_t Evictions;
+        };
+
+        class Handle
+        {
+        public:
+            Handle() = default;
+
+            bool IsValid() const
+            {
+                return mEntry != nullptr;
+            }
+
+            bool IsReady() const
+            {
+                return IsValid() && mEntry->Texture.IsReady();
+            }
+
+            bool HasFailed() const
+            {
+                return IsValid() && mEntry->Texture.HasFailed();
+            }
+
+            // Always usable; shows a placeholder until IsReady().
+            GLTexture* GetTexture() const
+            {
+                return mEntry->Texture.GetTexture();
+            }
+
+        private:
+            friend class TextureCache;
+
+            explicit Handle(std::shared_ptr<Entry> entry)
+                : mEntry(std::move(entry))
+            {
+                // Nothing to do.
+            }
+
+        private:
+            std::shared_ptr<Entry> mEntry;
+        };
+
+        TextureCache(GLTextureLoader& loader, std::size_t budget = 256 << 20);
+
+        std::size_t GetBudget() const
+        {
+            return mBudget;
+        }
+
+        void SetBudget(std::size_t budget)
+        {
+            mBudget = budget;
+        }
+
+        Handle Acquire(
+            const std::string& filepath,
+            GLTexture::Parameters params = GLTexture::Parameters{});
+
+        // Advances the frame and evicts textures while over budget. Must be
+        // called once per frame on the thread that owns the GL context.
+        void Update();
+
+        Residency GetResidency() const;
+        void PrintResidency(std::ostream& out = std::cout) const;
+
+        static std::uint64_t ComputeKey(
+            const std::string& filepath, const GLTexture::Parameters& params);
+
+    private:
+        static bool IsReferenced(const std::shared_ptr<Entry>& entry)
+        {
+            // The cache holds one reference itself.
+            return entry.use_count() > 1;
+        }
+
+        static std::size_t GetBytes(const Entry& entry)
+        {
+            return entry.Texture.GetTexture()->GetMemoryUsage();
+        }
+
+        void Evict();
+
+    private:
+        GLTextureLoader& mLoader;
+        std::unordered_map<std::uint64_t, std::shared_ptr<Entry>> mEntries;
+
+        std::size_t mBudget;
+        std::uint64_t mFrame;
+
+        std::size_t mHits;
+        std::size_t mMisses;
+        std::size_t mEvictions;
+        bool mOverBudget;
+    };
+}
@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+namespace Myst
+{
+    // These structs mirror the std140 blocks in `assets/shaders/include/
+    // blocks.glsl`, so they can be copied into a uniform buffer as they are.
+    // Keep both sides in sync: the assertions below only catch size drift.
+
+    enum UniformBlockBinding : GLuint
+    {
+        kFrameBlockBinding = 0,
+        kViewBlockBinding = 1,
+        kMaterialBlockBinding = 2,
+        kObjectBlockBinding = 3,
+        kCullBlockBinding = 4,
+        kLightGridBlockBinding = 5,
+    };
+
+    enum StorageBufferBinding : GLuint
+    {
+        kInstanceBufferBinding = 0,
+
+        // The GPU-driven path, see `include/scene.glsl` and
+        // `cull_compute.glsl`.
+        kObjectBufferBinding = 1,
+        kMeshBufferBinding = 2,
+        kCommandBufferBinding = 3,
+        kVisibleBufferBinding = 4,
+        kDrawCountBufferBinding = 5,
+        kCompactedCommandBufferBinding = 6,
+
+        // Clustered lighting, see `include/clusters.glsl`.
+        kLightPositionBufferBinding = 7,
+        kLightColorBufferBinding = 8,
+        kLightAttenuationBufferBinding = 9,
+        kLightClusterBufferBinding = 10,
+        kLightIndexBufferBinding = 11,
+    };
+
+    struct LightBlock
+    {
+        glm::vec3 Position;
+        float Padding0;
+        glm::vec3 Ambient;
+        float Padding1;
+        glm::vec3 Diffuse;
+        float Padding2;
+        glm::vec3 Specular;
+
+        // std140 packs a scalar into the last component of a preceding vec3.
+        float Constant;
+        float Linear;
+        float Quadratic;
+        float Padding3[2];
+    };
+
+    struct FrameBlock
+    {
+        float Time;
+        float DeltaTime;
+        float Padding[2];
+
+        LightBlock Light;
+    };
+
+    struct ViewBlock
+    {
+        glm::mat4 Projection;
+        glm::mat4 View;
+        glm::mat4 ViewProjection;
+        glm::vec3 Position;
+        float Padding;
+    };
+
+    struct MaterialBlock
+    {
+        float Shininess;
+
+        // Layers to sample when the material lives in texture arrays.
+        int DiffuseLayer;
+        int SpecularLayer;
+        float Padding;
+    };
+
+    struct ObjectBlock
+    {
+        glm::mat4 Model;
+
+        // A std140 mat3 is stored as three vec4 columns.
+        glm::mat3x4 Normal;
+
+        // Dequantization of the mesh's vertices; identity for float meshes.
+        glm::vec4 PositionOffset{0.0f};
+        glm::vec4 PositionScale{1.0f};
+        glm::vec4 TexCoordTransform{0.0f, 0.0f, 1.0f, 1.0f};
+    };
+
+    // An element of the std430 instance buffer in `include/vertex.glsl`.
+    struct InstanceData
+    {
+        glm::mat4 Model;
+        glm::mat3x4 Normal;
+    };
+
+    struct CullBlock
+    {
+        glm::vec4 Planes[6];
+        std::uint32_t ObjectCount;
+        std::uint32_t CommandCount;
+        std::uint32_t Padding[2];
+    };
+
+    // Elements of the std430 buffers in `include/scene.glsl`.
+    struct ObjectData
+    {
+        glm::mat4 Model;
+        glm::mat3x4 Normal;
+        std::uint32_t Mesh;
+        std::uint32_t Padding[3];
+    };
+
+    struct MeshInfo
+    {
+        glm::vec4 Sphere;
+        glm::vec4 PositionOffset;
+        glm::vec4 PositionScale;
+        glm::vec4 TexCoordTransform;
+    };
+
+    struct LightGridBlock
+    {
+        // Tiles across, tiles up, slices and the number of lights.
+        glm::uvec4 Size;
+
+        // Tiles per pixel along x and y, and the slice scale and bias.
+        glm::vec4 Scale;
+    };
+
+    // The layout glMultiDrawElementsIndirect() reads.
+    struct DrawElementsIndirectCommand
+    {
+        GLuint Count;
+        GLuint InstanceCount;
+        GLuint FirstIndex;
+        GLint BaseVertex;
+        GLuint BaseInstance;
+    };
+
+    static_assert(offsetof(LightBlock, Constant) == 60, "std140 mismatch");
+    static_assert(sizeof(LightBlock) == 80, "std140 mismatch");
+    static_assert(offsetof(FrameBlock, Light) == 16, "std140 mismatch");
+    static_assert(sizeof(ViewBlock) == 208, "std140 mismatch");
+    static_assert(sizeof(MaterialBlock) == 16, "std140 mismatch");
+    static_assert(offsetof(ObjectBlock, PositionOffset) == 112, "std140 mismatch");
+    static_assert(sizeof(ObjectBlock) == 160, "std140 mismatch");
+    static_assert(sizeof(InstanceData) == 112, "std430 mismatch");
+    static_assert(sizeof(CullBlock) == 112, "std140 mismatch");
+    static_assert(sizeof(LightGridBlock) == 32, "std140 mismatch");
+    static_assert(sizeof(ObjectData) == 128, "std430 mismatch");
+    static_assert(sizeof(MeshInfo) == 64, "std430 mismatch");
+    static_assert(sizeof(DrawElementsIndirectCommand) == 20, "std430 mismatch");
+}
@@ -34,6 +34,16 @@ namespace Myst
         return mZoom;
     }
 
+    float Camera::GetYaw() const
+    {
+        return mYaw;
+    }
+
+    float Camera::GetPitch() const
+    {
+        return mPitch;
+    }
+
     glm::vec3 Camera::GetPosition() const
     {
         return mPosition;
@@ -44,6 +54,26 @@ namespace Myst
         return glm::lookAt(mPosition, mPosition + mFront, mUp);
     }
 
+    glm::mat4 Camera::GetProjectionMatrix(float aspect, float near, float far) const
+    {
+        return glm::perspective(glm::radians(mZoom), aspect, near, far);
+    }
+
+    Frustum Camera::GetFrustum(float aspect, float near, float far) const
+    {
+        return Frustum::FromMatrix(GetProjectionMatrix(aspect, near, far) * GetViewMatrix());
+    }
+
+    void Camera::SetPose(const glm::vec3& position, float yaw, float pitch, float zoom)
+    {
+        mPosition = position;
+        mYaw = yaw;
+        mPitch = pitch;
+        mZoom = zoom;
+
+        Update();
+    }
+
     void Camera::OnKeyPress(int key, float deltaTime)
     {
         float velocity = 2.5f * deltaTime;
@@ -11,6 +11,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "Geometry/Frustum.hpp"
+
 namespace Myst
 {
     class Camera
@@ -20,8 +22,17 @@ namespace Myst
         ~Camera();
 
         float GetZoom() const;
+        float GetYaw() const;
+        float GetPitch() const;
         glm::vec3 GetPosition() const;
         glm::mat4 GetViewMatrix() const;
+        glm::mat4 GetProjectionMatrix(float aspect, float near, float far) const;
+
+        // The planes bounding what the camera sees, for culling.
+        Frustum GetFrustum(float aspect, float near, float far) const;
+
+        // Places the camera outright, as when replaying a recorded path.
+        void SetPose(const glm::vec3& position, float yaw, float pitch, float zoom);
 
         void OnKeyPress(int key, float deltaTime);
         void OnMouseMove(float xDelta, float yDelta, bool clamp = true);
@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Scene/CameraPath.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "Core/Json.hpp"
+#include "Core/MappedFile.hpp"
+
+namespace Myst
+{
+    void CameraPath::Add(float time, const Pose& pose)
+    {
+        mKeys.push_back({time, pose});
+    }
+
+    CameraPath::Pose CameraPath::Sample(float time) const
+    {
+        if (mKeys.empty()) {
+            return Pose{};
+        }
+
+        auto next = std::upper_bound(
+            mKeys.begin(), mKeys.end(), time,
+            [](float time, const Key& key) { return time < key.Time; });
+
+        if (next == mKeys.begin()) {
+            return mKeys.front().Value;
+        }
+
+        if (next == mKeys.end()) {
+            return mKeys.back().Value;
+        }
+
+        const Key& a = *(next - 1);
+        const Key& b = *next;
+        const float t = (time - a.Time) / std::max(b.Time - a.Time, 1e-6f);
+
+        Pose pose;
+        pose.Position = glm::mix(a.Value.Position, b.Value.Position, t);
+        pose.Yaw = glm::mix(a.Value.Yaw, b.Value.Yaw, t);
+        pose.Pitch = glm::mix(a.Value.Pitch, b.Value.Pitch, t);
+        pose.Zoom = glm::mix(a.Value.Zoom, b.Value.Zoom, t);
+
+        return pose;
+    }
+
+    bool CameraPath::Load(const std::string& filepath)
+    {
+        MappedFile file;
+
+        if (!file.Open(filepath)) {
+            std::cerr << "myst: could not read camera path \"" << filepath << "\"" << std::endl;
+            return false;
+        }
+
+        JsonValue document;
+
+        if (!JsonValue::Parse(
+                reinterpret_cast<const char*>(file.GetData()), file.GetSize(), document)) {
+            return false;
+        }
+
+        const JsonValue& keys = document["keys"];
+        mKeys.clear();
+
+        for (std::size_t i = 0; i < keys.GetSize(); ++i) {
+            const JsonValue& key = keys[i];
+            const JsonValue& position = key["position"];
+
+            Pose pose;
+            pose.Position = glm::vec3(
+                position[0].AsNumber(), position[1].AsNumber(), position[2].AsNumber());
+            pose.Yaw = static_cast<float>(key["yaw"].AsNumber(pose.Yaw));
+            pose.Pitch = static_cast<float>(key["pitch"].AsNumber(pose.Pitch));
+            pose.Zoom = static_cast<float>(key["zoom"].AsNumber(pose.Zoom));
+
+            const float time = static_cast<float>(key["time"].AsNumber());
+
+            if (!mKeys.empty() && time < mKeys.back().Time) {
+                std::cerr << "myst: camera path \"" << filepath << "\" goes back in time at key "
+                          << i << std::endl;
+                return false;
+            }
+
+            mKeys.push_back({time, pose});
+        }
+
+        return true;
+    }
+
+    bool CameraPath::Save(const std::string& filepath) const
+    {
+        JsonWriter writer;
+        writer.BeginObject();
+        writer.Key("keys");
+        writer.BeginArray();
+
+        for (const Key& key : mKeys) {
+            writer.BeginObject();
+            writer.Member("time", static_cast<double>(key.Time));
+            writer.Key("position");
+            writer.BeginArray();
+            writer.Value(static_cast<double>(key.Value.Position.x));
+            writer.Value(static_cast<double>(key.Value.Position.y));
+            writer.Value(static_cast<double>(key.Value.Position.z));
+            writer.EndArray();
+            writer.Member("yaw", static_cast<double>(key.Value.Yaw));
+            writer.Member("pitch", static_cast<double>(key.Value.Pitch));
+            writer.Member("zoom", static_cast<double>(key.Value.Zoom));
+            writer.EndObject();
+        }
+
+        writer.EndArray();
+        writer.EndObject();
+
+        return writer.Save(filepath);
+    }
+}
@@ -0,0 +1,66 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace Myst
+{
+    // Camera poses over time, recorded from an interactive session and
+    // replayed to get the same frames on every run. Between keys, poses are
+    // interpolated linearly; before the first and after the last, they hold.
+    //
+    // Stored as JSON: {"keys": [{"time", "position", "yaw", "pitch",
+    // "zoom"}, ...]}, with times in seconds and angles in degrees.
+    class CameraPath
+    {
+    public:
+        struct Pose
+        {
+            glm::vec3 Position{0.0f};
+            float Yaw{-90.0f};
+            float Pitch{0.0f};
+            float Zoom{45.0f};
+        };
+
+        struct Key
+        {
+            float Time;
+            Pose Value;
+        };
+
+        bool IsEmpty() const
+        {
+            return mKeys.empty();
+        }
+
+        const std::vector<Key>& GetKeys() const
+        {
+            return mKeys;
+        }
+
+        float GetDuration() const
+        {
+            return mKeys.empty() ? 0.0f : mKeys.back().Time;
+        }
+
+        // Keys must come in order of time.
+        void Add(float time, const Pose& pose);
+
+        Pose Sample(float time) const;
+
+        bool Load(const std::string& filepath);
+        bool Save(const std::string& filepath) const;
+
+    private:
+        std::vector<Key> mKeys;
+    };
+}
@@ -0,0 +1,57 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Scene/CameraReplay.hpp"
+
+#include <iostream>
+
+namespace Myst
+{
+    bool CameraReplay::Load(const std::string& filepath)
+    {
+        mReplaying = mReplay.Load(filepath);
+
+        return mReplaying;
+    }
+
+    void CameraReplay::StartRecording(const std::string& filepath)
+    {
+        mRecordPath = filepath;
+    }
+
+    void CameraReplay::Apply(float time, Camera& camera) const
+    {
+        if (!mReplaying) {
+            return;
+        }
+
+        const CameraPath::Pose pose = mReplay.Sample(time);
+        camera.SetPose(pose.Position, pose.Yaw, pose.Pitch, pose.Zoom);
+    }
+
+    void CameraReplay::Capture(float time, const Camera& camera)
+    {
+        if (!IsRecording()) {
+            return;
+        }
+
+        mRecording.Add(
+            time, {camera.GetPosition(), camera.GetYaw(), camera.GetPitch(), camera.GetZoom()});
+    }
+
+    bool CameraReplay::SaveRecording() const
+    {
+        if (!IsRecording() || !mRecording.Save(mRecordPath)) {
+            return false;
+        }
+
+        std::cout << "myst: recorded " << mRecording.GetKeys().size() << " camera keys to \""
+                  << mRecordPath << "\"" << std::endl;
+
+        return true;
+    }
+}
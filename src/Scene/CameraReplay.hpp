@@ -0,0 +1,58 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "Scene/Camera.hpp"
+#include "Scene/CameraPath.hpp"
+
+namespace Myst
+{
+    // Drives the camera along a recorded path, records the path it takes,
+    // or both. A replayed path places the camera outright every frame, so
+    // that frames don't depend on input or on how long they took.
+    class CameraReplay
+    {
+    public:
+        bool IsReplaying() const
+        {
+            return mReplaying;
+        }
+
+        bool IsRecording() const
+        {
+            return !mRecordPath.empty();
+        }
+
+        // How long the replayed path runs, in seconds.
+        float GetDuration() const
+        {
+            return mReplay.GetDuration();
+        }
+
+        bool Load(const std::string& filepath);
+
+        // Records to `filepath` from now on, saved by SaveRecording().
+        void StartRecording(const std::string& filepath);
+
+        // Places the camera as of `time`, when replaying.
+        void Apply(float time, Camera& camera) const;
+
+        // Adds the pose the frame at `time` is seen from, when recording.
+        void Capture(float time, const Camera& camera);
+
+        bool SaveRecording() const;
+
+    private:
+        CameraPath mReplay;
+        CameraPath mRecording;
+        std::string mRecordPath;
+        bool mReplaying{false};
+    };
+}
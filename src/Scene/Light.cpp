@@ -7,7 +7,79 @@
 
 #include "Scene/Light.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 namespace Myst
 {
+    namespace
+    {
+        // Lights that never fade still need a bound to be clustered.
+        constexpr float kMaxLightRadius{1000.0f};
+    }
+
+    float Light::GetRadius(float threshold) const
+    {
+        // Solve intensity / (c + l * d + q * d^2) = threshold for d.
+        const float peak = Intensity * std::max(Color.r, std::max(Color.g, Color.b));
+        const float c = Constant - peak / threshold;
+
+        if (c >= 0.0f) {
+            return 0.0f;
+        }
+
+        float radius{kMaxLightRadius};
+
+        if (Quadratic > 0.0f) {
+            radius = (-Linear + std::sqrt(Linear * Linear - 4.0f * Quadratic * c)) /
+                     (2.0f * Quadratic);
+        } else if (Linear > 0.0f) {
+            radius = -c / Linear;
+        }
+
+        return std::min(radius, kMaxLightRadius);
+    }
+
+    std::uint32_t LightSet::Add(const Light& light)
+    {
+        mPositionX.push_back(0.0f);
+        mPositionY.push_back(0.0f);
+        mPositionZ.push_back(0.0f);
+        mRadius.push_back(0.0f);
+        mColors.emplace_back(0.0f);
+        mAttenuations.emplace_back(0.0f);
+
+        std::uint32_t index = static_cast<std::uint32_t>(mPositionX.size() - 1);
+        Set(index, light);
+
+        return index;
+    }
+
+    void LightSet::Set(std::uint32_t index, const Light& light)
+    {
+        mPositionX[index] = light.Position.x;
+        mPositionY[index] = light.Position.y;
+        mPositionZ[index] = light.Position.z;
+        mRadius[index] = light.GetRadius();
+        mColors[index] = glm::vec4(light.Color * light.Intensity, 0.0f);
+        mAttenuations[index] =
+            glm::vec4(light.Constant, light.Linear, light.Quadratic, 0.0f);
+    }
+
+    void LightSet::SetPosition(std::uint32_t index, const glm::vec3& position)
+    {
+        mPositionX[index] = position.x;
+        mPositionY[index] = position.y;
+        mPositionZ[index] = position.z;
+    }
 
+    void LightSet::Clear()
+    {
+        mPositionX.clear();
+        mPositionY.clear();
+        mPositionZ.clear();
+        mRadius.clear();
+        mColors.clear();
+        mAttenuations.clear();
+    }
 }
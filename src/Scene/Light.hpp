@@ -7,14 +7,94 @@
 
 #pragma once
 
-#include <GLFW/glfw3.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 #include <glm/glm.hpp>
 
 namespace Myst
 {
-    class Light
+    // Below this intensity a light is considered to no longer contribute. It
+    // decides how far each light reaches, and so how many clusters it lands in.
+    constexpr float kLightThreshold{1.0f / 256.0f};
+
+    struct Light
+    {
+        glm::vec3 Position{0.0f};
+        glm::vec3 Color{1.0f};
+        float Intensity{1.0f};
+
+        float Constant{1.0f};
+        float Linear{0.09f};
+        float Quadratic{0.032f};
+
+        // The distance at which the attenuated intensity falls to `threshold`.
+        float GetRadius(float threshold = kLightThreshold) const;
+    };
+
+    // Point lights stored structure-of-arrays, the way the clustering reads
+    // them and the shaders fetch them: a light's position and radius, its
+    // color and its attenuation each live in their own tightly packed array.
+    class LightSet
     {
     public:
-        Light();
-    }
+        std::size_t GetSize() const
+        {
+            return mPositionX.size();
+        }
+
+        bool IsEmpty() const
+        {
+            return mPositionX.empty();
+        }
+
+        std::uint32_t Add(const Light& light);
+        void Set(std::uint32_t index, const Light& light);
+
+        // Moving a light keeps its radius.
+        void SetPosition(std::uint32_t index, const glm::vec3& position);
+
+        void Clear();
+
+        const float* GetPositionX() const
+        {
+            return mPositionX.data();
+        }
+
+        const float* GetPositionY() const
+        {
+            return mPositionY.data();
+        }
+
+        const float* GetPositionZ() const
+        {
+            return mPositionZ.data();
+        }
+
+        const float* GetRadius() const
+        {
+            return mRadius.data();
+        }
+
+        // Premultiplied by the intensity.
+        const std::vector<glm::vec4>& GetColors() const
+        {
+            return mColors;
+        }
+
+        // Constant, linear and quadratic terms.
+        const std::vector<glm::vec4>& GetAttenuations() const
+        {
+            return mAttenuations;
+        }
+
+    private:
+        std::vector<float> mPositionX;
+        std::vector<float> mPositionY;
+        std::vector<float> mPositionZ;
+        std::vector<float> mRadius;
+        std::vector<glm::vec4> mColors;
+        std::vector<glm::vec4> mAttenuations;
+    };
 }
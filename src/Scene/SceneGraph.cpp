@@ -0,0 +1,235 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include "Scene/SceneGraph.hpp"
+
+#include <algorithm>
+
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include "Core/Profiler.hpp"
+
+namespace Myst
+{
+    namespace
+    {
+        // Nodes per job within a level; smaller levels stay on the calling
+        // thread.
+        constexpr std::size_t kChunkSize{512};
+
+        template<typename T>
+        void Permute(std::vector<T>& values, const std::vector<std::uint32_t>& order)
+        {
+            std::vector<T> permuted(values.size());
+
+            for (std::size_t i = 0; i < order.size(); ++i) {
+                permuted[i] = std::move(values[order[i]]);
+            }
+
+            values = std::move(permuted);
+        }
+    }
+
+    SceneGraph::Node SceneGraph::Create(
+        Node parent, const glm::mat4& local, const BoundingBox& bounds)
+    {
+        const Node handle = static_cast<Node>(mSlots.size());
+        const std::uint32_t slot = static_cast<std::uint32_t>(mHandles.size());
+        const std::uint32_t parentSlot = parent == kNone ? kNone : mSlots[parent];
+
+        mSlots.push_back(slot);
+        mHandles.push_back(handle);
+        mParents.push_back(parentSlot);
+        mLevels.push_back(parent == kNone ? 0 : mLevels[parentSlot] + 1);
+        mFirstChild.push_back(0);
+        mChildCount.push_back(0);
+        mLocal.push_back(local);
+        mWorld.push_back(glm::mat4(1.0f));
+        mNormals.push_back(glm::mat3x4(1.0f));
+        mLocalBounds.push_back(bounds);
+        mWorldBounds.push_back(bounds);
+        mDirty.push_back(0);
+
+        MarkDirty(slot);
+        mSorted = false;
+
+        return handle;
+    }
+
+    void SceneGraph::SetLocalTransform(Node node, const glm::mat4& local)
+    {
+        const std::uint32_t slot = mSlots[node];
+
+        mLocal[slot] = local;
+        MarkDirty(slot);
+    }
+
+    void SceneGraph::SetLocalBounds(Node node, const BoundingBox& bounds)
+    {
+        const std::uint32_t slot = mSlots[node];
+
+        mLocalBounds[slot] = bounds;
+        MarkDirty(slot);
+    }
+
+    void SceneGraph::MarkDirty(std::uint32_t slot)
+    {
+        if (mDirty[slot] == 0) {
+            mDirty[slot] = 1;
+            mPending.push_back(mHandles[slot]);
+        }
+    }
+
+    void SceneGraph::Sort()
+    {
+        const std::size_t count = mHandles.size();
+
+        // Children per node, in creation order.
+        std::vector<std::uint32_t> childStart(count + 1, 0);
+
+        for (std::uint32_t parent : mParents) {
+            if (parent != kNone) {
+                ++childStart[parent + 1];
+            }
+        }
+
+        for (std::size_t i = 0; i < count; ++i) {
+            childStart[i + 1] += childStart[i];
+        }
+
+        std::vector<std::uint32_t> children(childStart[count]);
+        std::vector<std::uint32_t> cursor(childStart.begin(), childStart.end() - 1);
+        std::vector<std::uint32_t> order;
+        order.reserve(count);
+
+        for (std::uint32_t slot = 0; slot < count; ++slot) {
+            if (mParents[slot] == kNone) {
+                order.push_back(slot);
+            } else {
+                children[cursor[mParents[slot]]++] = slot;
+            }
+        }
+
+        // Breadth first from the roots, which both sorts by level and keeps
+        // siblings together.
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            const std::uint32_t slot = order[i];
+
+            mFirstChild[slot] = static_cast<std::uint32_t>(order.size());
+            mChildCount[slot] = childStart[slot + 1] - childStart[slot];
+
+            order.insert(
+                order.end(), children.begin() + childStart[slot],
+                children.begin() + childStart[slot + 1]);
+        }
+
+        std::vector<std::uint32_t> newSlots(count);
+
+        for (std::uint32_t i = 0; i < count; ++i) {
+            newSlots[order[i]] = i;
+        }
+
+        for (std::uint32_t& parent : mParents) {
+            if (parent != kNone) {
+                parent = newSlots[parent];
+            }
+        }
+
+        for (std::uint32_t& slot : mSlots) {
+            slot = newSlots[slot];
+        }
+
+        Permute(mHandles, order);
+        Permute(mParents, order);
+        Permute(mLevels, order);
+        Permute(mFirstChild, order);
+        Permute(mChildCount, order);
+        Permute(mLocal, order);
+        Permute(mWorld, order);
+        Permute(mNormals, order);
+        Permute(mLocalBounds, order);
+        Permute(mWorldBounds, order);
+        Permute(mDirty, order);
+
+        mStats.Levels = count == 0 ? 0 : mLevels.back() + 1;
+        mSorted = true;
+    }
+
+    void SceneGraph::UpdateNode(std::uint32_t slot)
+    {
+        const std::uint32_t parent = mParents[slot];
+        const glm::mat4 world = parent == kNone ? mLocal[slot] : mWorld[parent] * mLocal[slot];
+
+        mWorld[slot] = world;
+        mNormals[slot] = glm::mat3x4(glm::inverseTranspose(glm::mat3(world)));
+        mWorldBounds[slot] = TransformBounds(mLocalBounds[slot], world);
+    }
+
+    void SceneGraph::Update(JobSystem* jobs)
+    {
+        MYST_PROFILE_SCOPE("SceneGraph::Update");
+
+        mChanged.clear();
+
+        if (!mSorted) {
+            Sort();
+        }
+
+        mStats.Nodes = mHandles.size();
+        mStats.Updated = 0;
+
+        if (mPending.empty()) {
+            return;
+        }
+
+        mDirtyLevels.resize(mStats.Levels);
+
+        for (std::vector<std::uint32_t>& level : mDirtyLevels) {
+            level.clear();
+        }
+
+        for (Node node : mPending) {
+            const std::uint32_t slot = mSlots[node];
+            mDirtyLevels[mLevels[slot]].push_back(slot);
+        }
+
+        mPending.clear();
+
+        for (std::size_t level = 0; level < mDirtyLevels.size(); ++level) {
+            const std::vector<std::uint32_t>& dirty = mDirtyLevels[level];
+
+            auto update = [this, &dirty](std::size_t first, std::size_t last) {
+                for (std::size_t i = first; i < last; ++i) {
+                    UpdateNode(dirty[i]);
+                }
+            };
+
+            if (jobs != nullptr && dirty.size() > kChunkSize) {
+                jobs->ParallelFor(dirty.size(), kChunkSize, update);
+            } else {
+                update(0, dirty.size());
+            }
+
+            // Everything below a recomputed node follows it, once.
+            for (std::uint32_t slot : dirty) {
+                const std::uint32_t first = mFirstChild[slot];
+
+                for (std::uint32_t child = first; child < first + mChildCount[slot]; ++child) {
+                    if (mDirty[child] == 0) {
+                        mDirty[child] = 1;
+                        mDirtyLevels[level + 1].push_back(child);
+                    }
+                }
+
+                mDirty[slot] = 0;
+                mChanged.push_back(mHandles[slot]);
+            }
+        }
+
+        mStats.Updated = mChanged.size();
+    }
+}
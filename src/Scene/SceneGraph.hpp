@@ -0,0 +1,137 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Core/JobSystem.hpp"
+#include "Geometry/Bounds.hpp"
+
+namespace Myst
+{
+    // A transform hierarchy stored as parallel arrays, ordered level by
+    // level from the roots, with each node's children next to each other on
+    // the level below. Setting a local transform queues the node; Update()
+    // then walks the levels top down, recomputing only the queued nodes and
+    // everything below them, each level in parallel chunks. A frame where
+    // nothing moved costs nothing.
+    //
+    // For every node it writes the world transform, the normal matrix as the
+    // shaders expect it, and the world bounds of its local bounds. Nodes are
+    // referred to by handles that stay valid as the arrays are reordered.
+    class SceneGraph
+    {
+    public:
+        using Node = std::uint32_t;
+
+        static constexpr Node kNone{UINT32_MAX};
+
+        struct Stats
+        {
+            std::size_t Nodes;
+            std::size_t Levels;
+            // Nodes recomputed by the last Update().
+            std::size_t Updated;
+        };
+
+        std::size_t GetNodeCount() const
+        {
+            return mSlots.size();
+        }
+
+        const Stats& GetStats() const
+        {
+            return mStats;
+        }
+
+        // The node is placed below `parent`, or at the root. Its world
+        // values are valid after the next Update().
+        Node Create(
+            Node parent = kNone, const glm::mat4& local = glm::mat4(1.0f),
+            const BoundingBox& bounds = {});
+
+        Node GetParent(Node node) const
+        {
+            const std::uint32_t parent = mParents[mSlots[node]];
+            return parent == kNone ? kNone : mHandles[parent];
+        }
+
+        const glm::mat4& GetLocalTransform(Node node) const
+        {
+            return mLocal[mSlots[node]];
+        }
+
+        const glm::mat4& GetWorldTransform(Node node) const
+        {
+            return mWorld[mSlots[node]];
+        }
+
+        // The inverse transpose of the world transform's upper 3x3, padded
+        // to std140 columns.
+        const glm::mat3x4& GetNormalMatrix(Node node) const
+        {
+            return mNormals[mSlots[node]];
+        }
+
+        const BoundingBox& GetWorldBounds(Node node) const
+        {
+            return mWorldBounds[mSlots[node]];
+        }
+
+        void SetLocalTransform(Node node, const glm::mat4& local);
+        void SetLocalBounds(Node node, const BoundingBox& bounds);
+
+        // Recomputes the queued nodes and their descendants.
+        void Update(JobSystem* jobs = nullptr);
+
+        // The nodes recomputed by the last Update(), parents first.
+        const std::vector<Node>& GetChanged() const
+        {
+            return mChanged;
+        }
+
+    private:
+        void MarkDirty(std::uint32_t slot);
+
+        // Restores the level order after nodes were created.
+        void Sort();
+
+        void UpdateNode(std::uint32_t slot);
+
+    private:
+        // Indexed by handle.
+        std::vector<std::uint32_t> mSlots;
+
+        // Indexed by slot.
+        std::vector<Node> mHandles;
+        std::vector<std::uint32_t> mParents;
+        std::vector<std::uint32_t> mLevels;
+        std::vector<std::uint32_t> mFirstChild;
+        std::vector<std::uint32_t> mChildCount;
+        std::vector<glm::mat4> mLocal;
+        std::vector<glm::mat4> mWorld;
+        std::vector<glm::mat3x4> mNormals;
+        std::vector<BoundingBox> mLocalBounds;
+        std::vector<BoundingBox> mWorldBounds;
+        std::vector<std::uint8_t> mDirty;
+
+        // Nodes set since the last Update(), as handles since slots change
+        // when sorting.
+        std::vector<Node> mPending;
+        std::vector<std::vector<std::uint32_t>> mDirtyLevels;
+        std::vector<Node> mChanged;
+
+        bool mSorted{true};
+
+        Stats mStats{};
+    };
+}
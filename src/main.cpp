@@ -5,39 +5,202 @@
  * that was distributed with this source code.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
 
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 #include <glad/glad.h>
 
 #include <glm/glm.hpp>
-#include <glm/gtc/matrix_inverse.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "Core/FixedTimestep.hpp"
+#include "Core/FramePacer.hpp"
+#include "Core/FrameReport.hpp"
+#include "Core/Hash.hpp"
+#include "Core/JobSystem.hpp"
+#include "Core/Profiler.hpp"
+#include "Geometry/Bounds.hpp"
+#include "Geometry/Bvh.hpp"
+#include "Geometry/Frustum.hpp"
+#include "Geometry/MeshOptimizer.hpp"
+#include "Geometry/Model.hpp"
+#include "Geometry/VertexQuantization.hpp"
+#include "Image/Image.hpp"
+#include "OpenGL/GLGpuProfiler.hpp"
+#include "OpenGL/GLHeadlessContext.hpp"
+#include "OpenGL/GLProgramCache.hpp"
+#include "OpenGL/GLRingBuffer.hpp"
 #include "OpenGL/GLShader.hpp"
+#include "OpenGL/GLShaderLibrary.hpp"
+#include "OpenGL/GLStateCache.hpp"
 #include "OpenGL/GLTexture.hpp"
+#include "OpenGL/GLTextureArray.hpp"
+#include "OpenGL/GLTextureLoader.hpp"
+#include "Renderer/ClusteredLighting.hpp"
+#include "Renderer/CommandBuffer.hpp"
+#include "Renderer/GeometryBuffer.hpp"
+#include "Renderer/IndirectRenderer.hpp"
+#include "Renderer/InstancedRenderer.hpp"
+#include "Renderer/Material.hpp"
+#include "Renderer/Mesh.hpp"
+#include "Renderer/OcclusionBuffer.hpp"
+#include "Renderer/RenderQueue.hpp"
+#include "Renderer/TextureCache.hpp"
+#include "Renderer/UniformBlocks.hpp"
 #include "Scene/Camera.hpp"
+#include "Scene/CameraReplay.hpp"
+#include "Scene/Light.hpp"
+#include "Scene/SceneGraph.hpp"
 
 #define WIDTH (640)
 #define HEIGHT (480)
+#define NEAR (0.1f)
+#define FAR (100.0f)
 
 static GLFWwindow* window = nullptr;
-static GLuint lightVAO, cubeVAO, VBO;
+static std::unique_ptr<Myst::Mesh> cubeMesh;
+static std::vector<std::unique_ptr<Myst::Mesh>> modelMeshes;
+static std::vector<Myst::ModelInstance> modelInstances;
+static Myst::BoundingBox cubeBounds;
+static std::vector<Myst::BoundingBox> modelBounds;
+
+// Meshes this small are designated occluders; anything larger costs more to
+// rasterize than it saves.
+static constexpr std::size_t kMaxOccluderTriangles{2048};
+static constexpr std::size_t kMaxOccluders{128};
+// Occluders must cover about this many radians of the view.
+static constexpr float kMinOccluderSize{0.1f};
+
+static Myst::OccluderMesh cubeOccluder;
+static std::vector<Myst::OccluderMesh> modelOccluders;
+
+// Every transform lives in the scene graph: the crates under one node, the
+// model's instances under another, and the light cube on its own.
+static Myst::SceneGraph sceneGraph;
+static Myst::SceneGraph::Node lightNode;
+
+// Everything lit, with a hierarchy over their world bounds so that only what
+// the camera sees is submitted.
+struct SceneObject
+{
+    Myst::Mesh* Mesh;
+    const Myst::Material* Material;
+    const Myst::OccluderMesh* Occluder;
+    Myst::SceneGraph::Node Node;
+    // The renderer's batch, when recording in parallel.
+    std::uint32_t Batch;
+};
+
+static std::vector<SceneObject> sceneObjects;
+// The object of each scene graph node, if any.
+static std::vector<std::uint32_t> nodeObjects;
+static Myst::Bvh sceneBvh;
+static std::vector<std::uint32_t> visibleObjects;
+
+// With --materials or --shader-variants, the stress scene's crates cycle
+// through materials of their own, with textures or programs of their own.
+static std::vector<Myst::Material> stressMaterials;
+static std::vector<std::unique_ptr<Myst::GLTexture>> stressTextures;
+
+// With --parallel-recording, the draws of the objects in view are recorded
+// by jobs, a chunk of objects each into its own command buffer, while the GL
+// thread replays what was recorded the frame before. What's on screen trails
+// the simulation by a frame.
+static constexpr std::size_t kRecordChunkSize{1024};
+
+struct RecordedFrame
+{
+    Myst::FrameBlock Frame;
+    Myst::ViewBlock View;
+    Myst::ObjectBlock Light;
+    std::vector<glm::vec3> LightPositions;
+
+    std::vector<std::uint32_t> Objects;
+    std::size_t Chunks;
+    std::vector<Myst::CommandBuffer> Commands;
+    std::vector<std::vector<Myst::InstancedRenderer::Instance>> Instances;
+};
+
+static RecordedFrame recordedFrames[2];
+static Myst::JobSystem::Counter recording;
+
+// With --occlusion, frustum culled objects are also tested against the
+// biggest occluders in view, rasterized on the CPU. --occlusion-debug shows
+// the buffer in the corner of the window.
+static std::unique_ptr<Myst::OcclusionBuffer> occlusionBuffer;
+static std::vector<std::uint32_t> occluders;
+static GLuint occlusionDebugTexture{0};
+static GLuint occlusionDebugFramebuffer{0};
+// With --gpu-driven, the cube and model meshes are also packed here; a model
+// mesh whose layout differs from the cube's maps to -1 and isn't drawn.
+static std::unique_ptr<Myst::GeometryBuffer> sceneGeometry;
+static std::vector<int> modelGeometry;
 
 static std::unique_ptr<Myst::Camera> camera;
-static std::unique_ptr<Myst::GLTexture> diffuse;
-static std::unique_ptr<Myst::GLTexture> specular;
+static std::unique_ptr<Myst::GLProgramCache> programCache;
+static std::unique_ptr<Myst::GLShaderLibrary> shaderLibrary;
+static std::unique_ptr<Myst::GLRingBuffer> uniformRing;
+static std::unique_ptr<Myst::GLStateCache> stateCache;
+static std::unique_ptr<Myst::RenderQueue> renderQueue;
+static std::unique_ptr<Myst::ClusteredLighting> clusteredLighting;
+static Myst::LightSet pointLights;
+static std::vector<glm::vec3> pointLightOrigins;
+static std::unique_ptr<Myst::InstancedRenderer> renderer;
+static std::unique_ptr<Myst::IndirectRenderer> indirectRenderer;
+static std::unique_ptr<Myst::JobSystem> jobSystem;
+static std::unique_ptr<Myst::GLTextureLoader> textureLoader;
+static std::unique_ptr<Myst::TextureCache> textureCache;
+static Myst::TextureCache::Handle diffuse;
+static Myst::TextureCache::Handle specular;
+static std::unique_ptr<Myst::GLTextureArrayPool> texturePool;
+
+// With --profile or --profile-stats, scopes are timed on every thread, and
+// on the GPU through this.
+static std::unique_ptr<Myst::GLGpuProfiler> gpuProfiler;
+
+// With --headless there is no window to draw into: frames go to this
+// framebuffer instead, on an EGL context when built with EGL, or else on a
+// hidden window's.
+#if defined(MYST_HAS_EGL)
+static std::unique_ptr<Myst::GLHeadlessContext> headlessContext;
+#endif
+static GLuint outputFramebuffer{0};
+static GLuint outputRenderbuffers[2]{};
+// Time each frame on the GPU, when headless. Timestamps, like
+// GLGpuProfiler's, since elapsed time queries can't nest.
+static GLuint frameTimeQueries[2]{};
+
+// The simulation ticks at a fixed rate, and frames are drawn in between its
+// last two ticks: the camera moves and the lights bob per tick, and what's
+// drawn is interpolated from where they were at either.
+struct SimulationState
+{
+    glm::vec3 CameraPosition;
+    std::vector<glm::vec3> LightPositions;
+};
+
+static SimulationState simulated[2];
 
 static bool firstMouseMovement{true};
 static float mouseLastX{0};
 static float mouseLastY{0};
 
-static float deltaTime{0};
-static float lastTime{0};
-
 static void glfwErrorCallback(int error, const char* description)
 {
     std::cerr << "glfw: " << description << std::endl;
@@ -79,21 +242,32 @@ static void GLAPIENTRY glMessageCallback(
               << ", message=" << message << std::endl;
 }
 
-static bool initGLFW()
+static bool initGLFW(bool visible = true)
 {
     if (!glfwInit()) {
         std::cerr << "glfw: initialization failed" << std::endl;
         return false;
     }
 
-    glfwSetErrorCallback(glfwErrorCallback);
-
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
+
+    // Drivers such as llvmpipe stop at 4.5, which is all the renderer needs.
+    // Only the last attempt's errors are reported.
+    for (int minor : {6, 5}) {
+        glfwSetErrorCallback(minor == 5 ? glfwErrorCallback : nullptr);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor);
 
-    window = glfwCreateWindow(WIDTH, HEIGHT, "Myst", nullptr, nullptr);
+        window = glfwCreateWindow(WIDTH, HEIGHT, "Myst", nullptr, nullptr);
+
+        if (window != nullptr) {
+            break;
+        }
+    }
+
+    glfwSetErrorCallback(glfwErrorCallback);
 
     if (window == nullptr) {
         std::cerr << "glfw: window creation failed" << std::endl;
@@ -109,9 +283,9 @@ static bool initGLFW()
     return true;
 }
 
-static bool initGLAD()
+static bool initGLAD(GLADloadproc loader)
 {
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    if (!gladLoadGLLoader(loader)) {
         std::cerr << "glad: initialization failed" << std::endl;
         return false;
     }
@@ -119,42 +293,50 @@ static bool initGLAD()
     return true;
 }
 
-static Myst::GLShaderProgram* createShaderProgram(
-    const std::string& vertexShaderFilepath,
-    const std::string& fragmentShaderFilepath)
+static bool initHeadless()
 {
-    auto vShader = std::make_unique<Myst::GLShader>(
-        vertexShaderFilepath, GL_VERTEX_SHADER);
-    auto fShader = std::make_unique<Myst::GLShader>(
-        fragmentShaderFilepath, GL_FRAGMENT_SHADER);
+#if defined(MYST_HAS_EGL)
+    headlessContext = std::make_unique<Myst::GLHeadlessContext>();
 
-    if (!vShader->Compile()) {
-        std::cerr << "gl: failed to compile vShader" << std::endl;
-        return nullptr;
+    if (headlessContext->Create()) {
+        return initGLAD(&Myst::GLHeadlessContext::GetProcAddress);
     }
 
-    if (!fShader->Compile()) {
-        std::cerr << "gl: failed to compile fShader" << std::endl;
-        return nullptr;
-    }
+    headlessContext.reset();
+    std::cerr << "myst: falling back to a hidden window" << std::endl;
+#endif
 
-    Myst::GLShaderProgram* program = new Myst::GLShaderProgram();
+    return initGLFW(false) && initGLAD((GLADloadproc)glfwGetProcAddress);
+}
 
-    program->AttachShader(*vShader);
-    program->AttachShader(*fShader);
+static void initOutputFramebuffer()
+{
+    glCreateRenderbuffers(2, outputRenderbuffers);
+    glNamedRenderbufferStorage(outputRenderbuffers[0], GL_RGBA8, WIDTH, HEIGHT);
+    glNamedRenderbufferStorage(outputRenderbuffers[1], GL_DEPTH24_STENCIL8, WIDTH, HEIGHT);
+
+    glCreateFramebuffers(1, &outputFramebuffer);
+    glNamedFramebufferRenderbuffer(
+        outputFramebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, outputRenderbuffers[0]);
+    glNamedFramebufferRenderbuffer(
+        outputFramebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER,
+        outputRenderbuffers[1]);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+    glViewport(0, 0, WIDTH, HEIGHT);
+}
 
-    if (!program->Link()) {
-        std::cerr << "gl: failed to link program" << std::endl;
-        delete program;
-        return nullptr;
+static void getFramebufferSize(int& width, int& height)
+{
+    if (outputFramebuffer != 0) {
+        width = WIDTH;
+        height = HEIGHT;
+    } else {
+        glfwGetFramebufferSize(window, &width, &height);
     }
-
-    program->Bind();
-
-    return program;
 }
 
-static void initBuffers()
+static void initBuffers(bool quantizeVertices, bool gpuDriven)
 {
     // clang-format off
     float vertices[] = {
@@ -202,180 +384,1337 @@ static void initBuffers()
         -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
     };
 
-    // Create the cube's vertex array object and the vertex buffer object.
-    glGenVertexArrays(1, &cubeVAO);
-    glGenBuffers(1, &VBO);
+    Myst::MeshData data;
+    data.Layout.Add(Myst::VertexAttribute::Position, Myst::VertexFormat::Float3)
+        .Add(Myst::VertexAttribute::Normal, Myst::VertexFormat::Float3)
+        .Add(Myst::VertexAttribute::TexCoord, Myst::VertexFormat::Float2);
+    data.Vertices.assign(
+        reinterpret_cast<const unsigned char*>(vertices),
+        reinterpret_cast<const unsigned char*>(vertices) + sizeof(vertices));
+
+    // Shared corners are welded, so each is only transformed once.
+    Myst::OptimizeMesh(data).Print("cube");
+
+    if (quantizeVertices) {
+        data = Myst::QuantizeMesh(data);
+        std::cout << "myst: cube: quantized to " << data.Layout.GetStride()
+                  << " bytes per vertex" << std::endl;
+    }
 
-    // Bind the vertex buffer object and move the vertex data into it.
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    // The light is drawn with the same mesh; its shader only reads positions.
+    cubeMesh = std::make_unique<Myst::Mesh>(data);
+    cubeBounds = Myst::ComputeBoundingBox(data);
+    cubeOccluder = Myst::OccluderMesh::FromMeshData(data);
 
-    // Bind the cube's vertex array object to it becomes active.
-    glBindVertexArray(cubeVAO);
+    if (gpuDriven) {
+        sceneGeometry = std::make_unique<Myst::GeometryBuffer>(data.Layout);
+        sceneGeometry->Add(data);
+    }
+}
 
-    // Setup `position` attribute.
-    glVertexAttribPointer(
-        0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+static bool initModel(const char* filepath, bool quantizeVertices)
+{
+    Myst::Model model;
 
-    // Setup `normal` attribute.
-    glVertexAttribPointer(
-        1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    auto start = std::chrono::steady_clock::now();
 
-    // Setup `texture` attribute.
-    glVertexAttribPointer(
-        2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    if (!Myst::LoadModel(filepath, *jobSystem, model)) {
+        return false;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout << "myst: " << filepath << ": " << model.Meshes.size()
+              << " meshes, " << model.GetTriangleCount() << " triangles, "
+              << model.Instances.size() << " instances in "
+              << std::chrono::duration<double, std::milli>(end - start).count()
+              << " ms" << std::endl;
+
+    for (Myst::ModelMesh& mesh : model.Meshes) {
+        if (quantizeVertices) {
+            mesh.Data = Myst::QuantizeMesh(mesh.Data);
+        }
+
+        modelMeshes.push_back(std::make_unique<Myst::Mesh>(mesh.Data));
+        modelBounds.push_back(Myst::ComputeBoundingBox(mesh.Data));
+        modelOccluders.push_back(
+            mesh.Data.Indices.size() / 3 <= kMaxOccluderTriangles
+                ? Myst::OccluderMesh::FromMeshData(mesh.Data)
+                : Myst::OccluderMesh{});
+
+        if (sceneGeometry) {
+            modelGeometry.push_back(sceneGeometry->Add(mesh.Data));
+        }
+    }
 
-    // Create the light's vertex array object.
-    glGenVertexArrays(1, &lightVAO);
+    modelInstances = std::move(model.Instances);
 
-    // Bind the lights's vertex array object to it becomes active.
-    glBindVertexArray(lightVAO);
+    return true;
+}
+
+// A square grid of `count` crates around the origin.
+static std::vector<glm::mat4> createStressScene(std::size_t count)
+{
+    std::vector<glm::mat4> transforms;
+    transforms.reserve(count);
 
-    // Bind the vertex buffer object. (No need to fill it because it's already
-    // filled.)
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
 
-    // Setup `position` attribute.
-    glVertexAttribPointer(
-        0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    for (std::size_t i = 0; i < count; ++i) {
+        float x = (static_cast<int>(i % side) - side / 2) * 1.5f;
+        float z = (static_cast<int>(i / side) - side / 2) * 1.5f;
+        float angle = static_cast<float>(i % 360);
+
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(x, -2.0f, -z));
+        transforms.push_back(
+            glm::rotate(transform, glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f)));
+    }
+
+    return transforms;
 }
 
-static bool initTextures()
+// Copies of `crate`: the first `textures` with a checkered diffuse map of
+// their own, as a layer of the texture arrays when there are any, and each
+// of them with one of `variants` shader variants, if any. The variants only
+// differ in a define the shaders ignore, so they cost a program switch and
+// nothing else.
+static void createMaterials(const Myst::Material& crate, std::size_t textures, std::size_t variants)
 {
-    diffuse = std::make_unique<Myst::GLTexture>("assets/textures/crate_diffuse.png", GL_TEXTURE_2D);
-    if (!diffuse->Generate()) {
-        std::cerr << "gl: failed to load diffuse map" << std::endl;
-        return false;
+    constexpr int kSize{64};
+
+    Myst::GLTexture::Parameters params;
+    params.DataFormat = GL_RGBA;
+    params.StorageFormat = GL_RGBA;
+    params.FilterMin = GL_LINEAR;
+
+    Myst::Image image(kSize, kSize, 4);
+
+    stressMaterials.assign(std::max(textures, variants), crate);
+
+    for (std::size_t i = 0; i < stressMaterials.size(); ++i) {
+        Myst::Material& material = stressMaterials[i];
+
+        if (i < textures) {
+            const int color[3]{
+                64 + static_cast<int>(i * 97 % 192), 64 + static_cast<int>(i * 57 % 192),
+                64 + static_cast<int>(i * 31 % 192)};
+
+            for (int y = 0; y < kSize; ++y) {
+                for (int x = 0; x < kSize; ++x) {
+                    unsigned char* pixel = &image.Pixels[(y * kSize + x) * 4];
+                    const int shade = (x / 8 + y / 8) % 2 + 1;
+
+                    for (int c = 0; c < 3; ++c) {
+                        pixel[c] = static_cast<unsigned char>(color[c] / shade);
+                    }
+
+                    pixel[3] = 255;
+                }
+            }
+
+            if (texturePool) {
+                material.DiffuseLayer = texturePool->Add(image, params);
+            } else {
+                stressTextures.push_back(std::make_unique<Myst::GLTexture>(GL_TEXTURE_2D, params));
+                stressTextures.back()->Allocate(kSize, kSize, 1);
+                stressTextures.back()->SetImage(
+                    0, 0, kSize, kSize, GL_RGBA, image.Pixels.data());
+
+                material.Diffuse = stressTextures.back().get();
+            }
+        }
+
+        if (variants > 0) {
+            material.Defines["MATERIAL_VARIANT"] = std::to_string(i % variants);
+        }
     }
+}
 
-    specular = std::make_unique<Myst::GLTexture>("assets/textures/crate_specular.png", GL_TEXTURE_2D);
-    if (!specular->Generate()) {
-        std::cerr << "gl: failed to load specular map" << std::endl;
-        return false;
+// Small colored lights on a spiral over the scene, bobbing up and down.
+static void createLights(std::size_t count)
+{
+    const float spread = std::max(4.0f, std::sqrt(static_cast<float>(count)));
+
+    for (std::size_t i = 0; i < count; ++i) {
+        float t = (static_cast<float>(i) + 0.5f) / static_cast<float>(count);
+        float angle = static_cast<float>(i) * 2.39996f;
+
+        Myst::Light light;
+        light.Position = glm::vec3(
+            spread * std::sqrt(t) * std::cos(angle), -1.2f,
+            spread * std::sqrt(t) * std::sin(angle));
+        light.Color = glm::vec3(
+            0.5f + 0.5f * std::sin(angle), 0.5f + 0.5f * std::sin(angle + 2.1f),
+            0.5f + 0.5f * std::sin(angle + 4.2f));
+        light.Linear = 1.0f;
+        light.Quadratic = 60.0f;
+
+        pointLights.Add(light);
+        pointLightOrigins.push_back(light.Position);
     }
+}
 
-    diffuse->Bind(0);
-    specular->Bind(1);
+static void simulateLights(float time, std::vector<glm::vec3>& positions)
+{
+    positions.resize(pointLightOrigins.size());
 
-    return true;
+    for (std::size_t i = 0; i < pointLightOrigins.size(); ++i) {
+        positions[i] = pointLightOrigins[i];
+        positions[i].y += 0.5f * std::sin(time * 1.3f + static_cast<float>(i));
+    }
 }
 
-static void processInput(GLFWwindow* window)
+static void interpolateLights(float alpha, std::vector<glm::vec3>& positions)
 {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-        glfwSetWindowShouldClose(window, true);
+    positions.resize(pointLightOrigins.size());
+
+    for (std::size_t i = 0; i < pointLightOrigins.size(); ++i) {
+        positions[i] =
+            glm::mix(simulated[0].LightPositions[i], simulated[1].LightPositions[i], alpha);
+    }
+}
+
+static void placeLights(const std::vector<glm::vec3>& positions)
+{
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        pointLights.SetPosition(static_cast<std::uint32_t>(i), positions[i]);
+    }
+}
+
+static void initScene(const std::vector<glm::mat4>& stressScene, const Myst::Material& crate)
+{
+    auto add = [](Myst::SceneGraph::Node parent, Myst::Mesh* mesh,
+                  const Myst::Material& material, const Myst::OccluderMesh& occluder,
+                  const Myst::BoundingBox& local, const glm::mat4& transform) {
+        Myst::SceneGraph::Node node = sceneGraph.Create(parent, transform, local);
+
+        nodeObjects.resize(sceneGraph.GetNodeCount(), UINT32_MAX);
+        nodeObjects[node] = static_cast<std::uint32_t>(sceneObjects.size());
+
+        sceneObjects.push_back(
+            {mesh, &material, occluder.GetTriangleCount() > 0 ? &occluder : nullptr, node, 0});
+    };
+
+    add(Myst::SceneGraph::kNone, cubeMesh.get(), crate, cubeOccluder, cubeBounds,
+        glm::mat4(1.0f));
+
+    Myst::SceneGraph::Node crates = sceneGraph.Create();
+
+    for (std::size_t i = 0; i < stressScene.size(); ++i) {
+        const Myst::Material& material =
+            stressMaterials.empty() ? crate : stressMaterials[i % stressMaterials.size()];
+
+        add(crates, cubeMesh.get(), material, cubeOccluder, cubeBounds, stressScene[i]);
+    }
+
+    Myst::SceneGraph::Node model = sceneGraph.Create();
+
+    for (const Myst::ModelInstance& instance : modelInstances) {
+        add(model, modelMeshes[instance.Mesh].get(), crate, modelOccluders[instance.Mesh],
+            modelBounds[instance.Mesh], instance.Transform);
+    }
+
+    sceneGraph.Update(jobSystem.get());
+
+    std::vector<Myst::BoundingBox> bounds;
+    bounds.reserve(sceneObjects.size());
+
+    for (const SceneObject& object : sceneObjects) {
+        bounds.push_back(sceneGraph.GetWorldBounds(object.Node));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    sceneBvh.Build(bounds);
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout << "myst: built a BVH of " << sceneBvh.GetNodeCount() << " nodes over "
+              << sceneBvh.GetObjectCount() << " objects in "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms"
+              << std::endl;
+}
+
+// Queues the jobs recording the draws of `recorded.Objects`. They read the
+// scene graph, which must not change until they are done.
+static void recordDraws(RecordedFrame& recorded, const glm::vec3& viewPosition)
+{
+    const std::size_t count = recorded.Objects.size();
+    recorded.Chunks = (count + kRecordChunkSize - 1) / kRecordChunkSize;
+
+    while (recorded.Commands.size() < recorded.Chunks) {
+        recorded.Commands.emplace_back(static_cast<std::size_t>(uniformRing->GetAlignment()));
+        recorded.Instances.emplace_back();
+    }
+
+    for (std::size_t chunk = 0; chunk < recorded.Chunks; ++chunk) {
+        jobSystem->Run(
+            [&recorded, chunk, count, viewPosition]() {
+                MYST_PROFILE_SCOPE("Record draws");
+
+                const std::size_t first = chunk * kRecordChunkSize;
+                const std::size_t last = std::min(first + kRecordChunkSize, count);
+
+                Myst::CommandBuffer& commands = recorded.Commands[chunk];
+                std::vector<Myst::InstancedRenderer::Instance>& instances =
+                    recorded.Instances[chunk];
+
+                commands.Reset();
+                instances.clear();
+
+                for (std::size_t i = first; i < last; ++i) {
+                    const SceneObject& object = sceneObjects[recorded.Objects[i]];
+
+                    instances.push_back(
+                        {object.Batch, &sceneGraph.GetWorldTransform(object.Node),
+                         &sceneGraph.GetNormalMatrix(object.Node)});
+                }
+
+                renderer->Record(commands, instances.data(), instances.size(), viewPosition);
+            },
+            &recording);
+    }
+}
+
+static void initOcclusionDebug()
+{
+    glCreateTextures(GL_TEXTURE_2D, 1, &occlusionDebugTexture);
+    glTextureStorage2D(
+        occlusionDebugTexture, 1, GL_RGBA8, occlusionBuffer->GetWidth(),
+        occlusionBuffer->GetHeight());
+
+    glCreateFramebuffers(1, &occlusionDebugFramebuffer);
+    glNamedFramebufferTexture(
+        occlusionDebugFramebuffer, GL_COLOR_ATTACHMENT0, occlusionDebugTexture, 0);
+}
+
+// Brings the world transforms up to date, and the BVH with them.
+static void updateScene()
+{
+    MYST_PROFILE_SCOPE("Update scene");
+
+    sceneGraph.Update(jobSystem.get());
+
+    bool moved{false};
+
+    for (Myst::SceneGraph::Node node : sceneGraph.GetChanged()) {
+        if (node < nodeObjects.size() && nodeObjects[node] != UINT32_MAX) {
+            sceneBvh.Update(nodeObjects[node], sceneGraph.GetWorldBounds(node));
+            moved = true;
+        }
+    }
+
+    if (moved) {
+        sceneBvh.Refit();
+    }
+}
+
+// Drops the visible objects hidden behind the largest visible occluders,
+// which are always kept themselves.
+static void cullOccluded(const glm::mat4& viewProjection, const glm::vec3& viewPosition)
+{
+    MYST_PROFILE_SCOPE("Cull occluded");
+
+    occluders.clear();
+
+    for (std::uint32_t object : visibleObjects) {
+        if (sceneObjects[object].Occluder != nullptr) {
+            occluders.push_back(object);
+        }
+    }
+
+    auto size = [&](std::uint32_t object) {
+        const Myst::BoundingBox& bounds = sceneBvh.GetBounds(object);
+        float distance = std::max(glm::distance(bounds.GetCenter(), viewPosition), NEAR);
+
+        return glm::length(bounds.GetExtents()) / distance;
+    };
+
+    occluders.erase(
+        std::remove_if(
+            occluders.begin(), occluders.end(),
+            [&](std::uint32_t object) { return size(object) < kMinOccluderSize; }),
+        occluders.end());
+
+    if (occluders.size() > kMaxOccluders) {
+        std::nth_element(
+            occluders.begin(), occluders.begin() + kMaxOccluders, occluders.end(),
+            [&](std::uint32_t a, std::uint32_t b) { return size(a) > size(b); });
+        occluders.resize(kMaxOccluders);
+    }
+
+    occlusionBuffer->Begin(viewProjection);
+
+    for (std::uint32_t object : occluders) {
+        occlusionBuffer->AddOccluder(
+            *sceneObjects[object].Occluder,
+            sceneGraph.GetWorldTransform(sceneObjects[object].Node));
     }
 
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
-        camera->OnKeyPress(GLFW_KEY_W, deltaTime);
+    occlusionBuffer->Rasterize(jobSystem.get());
+
+    std::sort(occluders.begin(), occluders.end());
+
+    visibleObjects.erase(
+        std::remove_if(
+            visibleObjects.begin(), visibleObjects.end(),
+            [&](std::uint32_t object) {
+                return !std::binary_search(occluders.begin(), occluders.end(), object) &&
+                       !occlusionBuffer->IsVisible(sceneBvh.GetBounds(object));
+            }),
+        visibleObjects.end());
+}
+
+// Blits the occlusion buffer, at twice its size, over the bottom left corner.
+static void drawOcclusionDebug()
+{
+    MYST_GPU_SCOPE(gpuProfiler.get(), "Occlusion debug");
+
+    static std::vector<std::uint8_t> pixels;
+
+    const GLsizei width = static_cast<GLsizei>(occlusionBuffer->GetWidth());
+    const GLsizei height = static_cast<GLsizei>(occlusionBuffer->GetHeight());
+
+    occlusionBuffer->GetDebugImage(NEAR, FAR, pixels);
+    glTextureSubImage2D(
+        occlusionDebugTexture, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+        pixels.data());
+
+    glBlitNamedFramebuffer(
+        occlusionDebugFramebuffer, outputFramebuffer, 0, 0, width, height, 0, 0, width * 2,
+        height * 2,
+        GL_COLOR_BUFFER_BIT, GL_NEAREST);
+}
+
+// The output as RGBA rows from the bottom, once the frame is complete.
+static void readFrame(std::vector<std::uint8_t>& pixels)
+{
+    MYST_PROFILE_SCOPE("Read frame");
+
+    pixels.resize(WIDTH * HEIGHT * 4);
+    glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+}
+
+static bool writeFrame(
+    const std::string& directory, std::size_t frame, const std::vector<std::uint8_t>& pixels)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%05zu.ppm", frame);
+
+    const std::string filepath = directory + "/" + name;
+    std::ofstream ofs(filepath, std::ios::binary | std::ios::trunc);
+    ofs << "P6\n" << WIDTH << " " << HEIGHT << "\n255\n";
+
+    for (int y = HEIGHT - 1; y >= 0; --y) {
+        for (int x = 0; x < WIDTH; ++x) {
+            ofs.write(reinterpret_cast<const char*>(&pixels[(y * WIDTH + x) * 4]), 3);
+        }
     }
 
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
-        camera->OnKeyPress(GLFW_KEY_A, deltaTime);
+    if (!ofs) {
+        std::cerr << "myst: could not write \"" << filepath << "\"" << std::endl;
+        return false;
     }
 
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-        camera->OnKeyPress(GLFW_KEY_S, deltaTime);
+    return true;
+}
+
+// The rolling statistics of every scope, longest first.
+static void printProfile()
+{
+    const Myst::Profiler& profiler = Myst::Profiler::Get();
+
+    std::cout << "myst: profile of the last "
+              << std::min(profiler.GetFrameCount(), Myst::Profiler::kWindow)
+              << " frames, in ms per frame:" << std::endl;
+
+    for (const Myst::Profiler::ScopeStats& scope : profiler.GetStats()) {
+        char line[128];
+        std::snprintf(
+            line, sizeof(line), "%-4s %-36s %8.3f mean %8.3f max %7.1f calls",
+            scope.Group.c_str(), scope.Name.c_str(), scope.Mean, scope.Max, scope.Calls);
+
+        std::cout << "myst:   " << line << std::endl;
     }
 
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
-        camera->OnKeyPress(GLFW_KEY_D, deltaTime);
+    if (gpuProfiler && gpuProfiler->GetDropped() > 0) {
+        std::cout << "myst: " << gpuProfiler->GetDropped()
+                  << " frames of GPU timings dropped, not ready in time" << std::endl;
     }
 }
 
+static bool initTextures()
+{
+    diffuse = textureCache->Acquire("assets/textures/crate_diffuse.png");
+    specular = textureCache->Acquire("assets/textures/crate_specular.png");
+
+    return diffuse.IsValid() && specular.IsValid();
+}
+
+static void processInput(GLFWwindow* window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+        glfwSetWindowShouldClose(window, true);
+    }
+}
+
+// Moves the simulation on by a tick of `step` seconds, to `time`. The mouse
+// turns the camera as soon as it moves, but keys move it per tick.
+static void simulate(float time, float step)
+{
+    std::swap(simulated[0], simulated[1]);
+
+    if (window != nullptr) {
+        for (int key : {GLFW_KEY_W, GLFW_KEY_A, GLFW_KEY_S, GLFW_KEY_D}) {
+            if (glfwGetKey(window, key) == GLFW_PRESS) {
+                camera->OnKeyPress(key, step);
+            }
+        }
+    }
+
+    simulated[1].CameraPosition = camera->GetPosition();
+    simulateLights(time, simulated[1].LightPositions);
+}
+
 int main(int argc, char* argv[])
 {
-    if (!initGLFW()) {
-        return EXIT_FAILURE;
+    // The program binary cache is opt-in, either through the command line or
+    // through the environment.
+    const char* shaderCacheDirectory = std::getenv("MYST_SHADER_CACHE");
+    bool useTextureArrays{false};
+    std::size_t textureBudget{256};
+    bool quantizeVertices{false};
+    const char* modelPath{nullptr};
+    std::size_t stressCount{0};
+    bool useInstancing{true};
+    bool useCulling{true};
+    bool useOcclusion{false};
+    bool showOcclusion{false};
+    bool gpuDriven{false};
+    bool parallelRecording{false};
+    std::size_t lightCount{0};
+    bool headless{false};
+    std::size_t frameCount{0};
+    float timestep{1.0f / 60.0f};
+    float tickRate{0.0f};
+    double frameLimit{0.0};
+    bool lowLatency{false};
+    const char* replayPath{nullptr};
+    const char* recordPath{nullptr};
+    const char* dumpDirectory{nullptr};
+    bool useChecksums{false};
+    const char* reportPath{nullptr};
+    const char* profilePath{nullptr};
+    bool profileStats{false};
+    std::size_t materialCount{0};
+    std::size_t shaderVariants{0};
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--shader-cache") == 0 && i + 1 < argc) {
+            shaderCacheDirectory = argv[++i];
+        } else if (std::strcmp(argv[i], "--texture-arrays") == 0) {
+            useTextureArrays = true;
+        } else if (std::strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc) {
+            textureBudget = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--quantize-vertices") == 0) {
+            quantizeVertices = true;
+        } else if (std::strcmp(argv[i], "--model") == 0 && i + 1 < argc) {
+            modelPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--stress") == 0 && i + 1 < argc) {
+            stressCount = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--no-instancing") == 0) {
+            useInstancing = false;
+        } else if (std::strcmp(argv[i], "--no-culling") == 0) {
+            useCulling = false;
+        } else if (std::strcmp(argv[i], "--occlusion") == 0) {
+            useOcclusion = true;
+        } else if (std::strcmp(argv[i], "--occlusion-debug") == 0) {
+            useOcclusion = true;
+            showOcclusion = true;
+        } else if (std::strcmp(argv[i], "--gpu-driven") == 0) {
+            gpuDriven = true;
+        } else if (std::strcmp(argv[i], "--parallel-recording") == 0) {
+            parallelRecording = true;
+        } else if (std::strcmp(argv[i], "--lights") == 0 && i + 1 < argc) {
+            lightCount = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frameCount = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--timestep") == 0 && i + 1 < argc) {
+            timestep = std::max(1e-4f, std::strtof(argv[++i], nullptr));
+        } else if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            tickRate = std::max(0.0f, std::strtof(argv[++i], nullptr));
+        } else if (std::strcmp(argv[i], "--frame-limit") == 0 && i + 1 < argc) {
+            frameLimit = std::max(0.0, std::strtod(argv[++i], nullptr));
+        } else if (std::strcmp(argv[i], "--low-latency") == 0) {
+            lowLatency = true;
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--dump-frames") == 0 && i + 1 < argc) {
+            dumpDirectory = argv[++i];
+        } else if (std::strcmp(argv[i], "--checksums") == 0) {
+            useChecksums = true;
+        } else if (std::strcmp(argv[i], "--report") == 0 && i + 1 < argc) {
+            reportPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profilePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--profile-stats") == 0) {
+            profileStats = true;
+        } else if (std::strcmp(argv[i], "--materials") == 0 && i + 1 < argc) {
+            materialCount = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--shader-variants") == 0 && i + 1 < argc) {
+            shaderVariants = std::strtoul(argv[++i], nullptr, 10);
+        }
     }
 
-    if (!initGLAD()) {
+    // A replay advances by the same step every frame, so that it shows the
+    // same frames however long they take.
+    Myst::CameraReplay cameraReplay;
+    const bool fixedTimestep = headless || replayPath != nullptr;
+
+    // The simulation ticks by the timestep unless told otherwise, so that
+    // replays take a tick per frame.
+    auto toNanoseconds = [](double seconds) {
+        return static_cast<std::uint64_t>(std::llround(seconds * 1e9));
+    };
+
+    const float tickStep = tickRate > 0.0f ? 1.0f / tickRate : timestep;
+    Myst::FixedTimestep simulation(toNanoseconds(tickStep));
+
+    if (replayPath != nullptr && !cameraReplay.Load(replayPath)) {
         return EXIT_FAILURE;
     }
 
+    if (recordPath != nullptr) {
+        cameraReplay.StartRecording(recordPath);
+    }
+
+    if (headless) {
+        if (frameCount == 0) {
+            frameCount = cameraReplay.IsReplaying()
+                             ? static_cast<std::size_t>(cameraReplay.GetDuration() / timestep) + 1
+                             : 600;
+        }
+
+        if (reportPath == nullptr) {
+            reportPath = "myst-report.json";
+        }
+
+        if (dumpDirectory != nullptr) {
+            std::error_code error;
+            std::filesystem::create_directories(dumpDirectory, error);
+        }
+
+        if (!initHeadless()) {
+            return EXIT_FAILURE;
+        }
+
+        initOutputFramebuffer();
+        glGenQueries(2, frameTimeQueries);
+
+        std::cout << "myst: rendering " << frameCount << " frames headless on "
+                  << glGetString(GL_RENDERER) << std::endl;
+    } else {
+        if (!initGLFW()) {
+            return EXIT_FAILURE;
+        }
+
+        if (!initGLAD((GLADloadproc)glfwGetProcAddress)) {
+            return EXIT_FAILURE;
+        }
+    }
+
     glEnable(GL_DEBUG_OUTPUT);
     glEnable(GL_DEPTH_TEST);
     glDebugMessageCallback(glMessageCallback, 0);
 
-    initBuffers();
+    // Without a limit, low latency mode paces to the display, to start each
+    // frame as late as it can and still make the next refresh.
+    Myst::FramePacer pacer;
+
+    if (lowLatency && frameLimit == 0.0 && window != nullptr) {
+        if (const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor())) {
+            frameLimit = mode->refreshRate;
+        }
+    }
+
+    pacer.SetTargetRate(frameLimit);
+    pacer.SetMode(lowLatency ? Myst::FramePacer::Mode::LowLatency : Myst::FramePacer::Mode::Limit);
+
+    if (lowLatency && !pacer.IsEnabled()) {
+        std::cerr << "myst: low latency mode needs a --frame-limit to pace to" << std::endl;
+    }
+
+    // Started before anything loads, so that the first frame shows what the
+    // start up cost.
+#if defined(MYST_PROFILING)
+    const bool profiling = profilePath != nullptr || profileStats;
+
+    if (profiling) {
+        Myst::Profiler::Get().SetThreadName("Main");
+        Myst::Profiler::Get().SetCapturing(profilePath != nullptr);
+        Myst::Profiler::Get().SetEnabled(true);
+        gpuProfiler = std::make_unique<Myst::GLGpuProfiler>();
+    }
+#else
+    const bool profiling = false;
+
+    if (profilePath != nullptr || profileStats) {
+        std::cerr << "myst: built without the profiler, see the profiling option" << std::endl;
+    }
+#endif
+
+    if (shaderCacheDirectory != nullptr) {
+        programCache =
+            std::make_unique<Myst::GLProgramCache>(shaderCacheDirectory);
+    }
+
+    initBuffers(quantizeVertices, gpuDriven);
+
+    jobSystem = std::make_unique<Myst::JobSystem>();
+    textureLoader = std::make_unique<Myst::GLTextureLoader>(*jobSystem);
+    textureCache = std::make_unique<Myst::TextureCache>(
+        *textureLoader, textureBudget << 20);
 
     if (!initTextures()) {
         return EXIT_FAILURE;
     }
 
-    std::unique_ptr<Myst::GLShaderProgram> lightProgram(
-            createShaderProgram(
-                "assets/shaders/light_vertex.glsl",
-                "assets/shaders/light_fragment.glsl"));
+    if (modelPath != nullptr && !initModel(modelPath, quantizeVertices)) {
+        return EXIT_FAILURE;
+    }
+
+    shaderLibrary = std::make_unique<Myst::GLShaderLibrary>(programCache.get());
+    shaderLibrary->AddIncludeDirectory("assets/shaders");
+
+    // Point lights are shaded per froxel cluster, on top of the main light.
+    if (lightCount > 0) {
+        shaderLibrary->SetGlobalDefine("CLUSTERED_LIGHTING");
+        clusteredLighting = std::make_unique<Myst::ClusteredLighting>();
+        createLights(lightCount);
+    }
+
+    Myst::Material crate;
+    crate.Shininess = 32.0f;
+
+    if (useTextureArrays) {
+        texturePool = std::make_unique<Myst::GLTextureArrayPool>();
+        crate.DiffuseLayer = texturePool->Add("assets/textures/crate_diffuse.png");
+        crate.SpecularLayer = texturePool->Add("assets/textures/crate_specular.png");
+    } else {
+        crate.Diffuse = diffuse.GetTexture();
+        crate.Specular = specular.GetTexture();
+    }
+
+    // The mesh picks how its vertices are decoded. Lit meshes get their
+    // programs from the renderer, per mesh and material.
+    Myst::GLShaderProgram* lightProgram = shaderLibrary->Get(
+        "assets/shaders/light_vertex.glsl",
+        "assets/shaders/light_fragment.glsl",
+        cubeMesh->GetShaderDefines());
+
+    if (lightProgram == nullptr) {
+        return EXIT_FAILURE;
+    }
 
-    std::unique_ptr<Myst::GLShaderProgram> cubeProgram(
-            createShaderProgram(
-                "assets/shaders/cube_vertex.glsl",
-                "assets/shaders/cube_fragment.glsl"));
+    if (programCache) {
+        programCache->PrintStats();
+    }
 
     camera = std::make_unique<Myst::Camera>(glm::vec3(0.0f, 0.0f, 3.0f));
 
+    // Every block of a frame is written into this ring and only bound by
+    // range, so there's no glUniform* traffic left in the render loop. Each
+    // object needs at most an aligned block on top, when drawn on its own.
+    std::vector<glm::mat4> stressScene = createStressScene(stressCount);
+    std::size_t objectCount = 1 + modelInstances.size() + stressScene.size();
+
+    if (!sceneGeometry) {
+        if (stressCount > 0) {
+            createMaterials(crate, materialCount, shaderVariants);
+        }
+
+        initScene(stressScene, crate);
+
+        if (useCulling && useOcclusion) {
+            occlusionBuffer = std::make_unique<Myst::OcclusionBuffer>();
+
+            if (showOcclusion) {
+                initOcclusionDebug();
+            }
+        }
+    }
+
+    uniformRing = std::make_unique<Myst::GLRingBuffer>(
+        64 * 1024 + static_cast<GLsizeiptr>(objectCount) * 256);
+
+    // Draws are recorded into the queue, sorted by state, and issued through
+    // the state cache, which drops the binds that wouldn't change anything.
+    stateCache = std::make_unique<Myst::GLStateCache>();
+    renderQueue = std::make_unique<Myst::RenderQueue>(*uniformRing);
+
+    renderer = std::make_unique<Myst::InstancedRenderer>(
+        *shaderLibrary, *uniformRing, "assets/shaders/cube_vertex.glsl",
+        "assets/shaders/cube_fragment.glsl");
+    renderer->SetInstancing(useInstancing);
+
+    // Recording jobs only look batches up, so they are all made here.
+    if (parallelRecording && !sceneGeometry) {
+        for (SceneObject& object : sceneObjects) {
+            object.Batch = renderer->Prepare(*object.Mesh, *object.Material, *renderQueue);
+        }
+
+        if (!useCulling) {
+            for (RecordedFrame& recorded : recordedFrames) {
+                recorded.Objects.resize(sceneObjects.size());
+                std::iota(recorded.Objects.begin(), recorded.Objects.end(), 0);
+            }
+        }
+    } else {
+        parallelRecording = false;
+    }
+
+    // The GPU-driven path keeps every lit object resident and leaves culling
+    // and draw generation to a compute pass.
+    if (sceneGeometry) {
+        sceneGeometry->Upload();
+
+        indirectRenderer = std::make_unique<Myst::IndirectRenderer>(
+            *shaderLibrary, *uniformRing, *sceneGeometry,
+            "assets/shaders/cube_vertex.glsl", "assets/shaders/cube_fragment.glsl",
+            "assets/shaders/cull_compute.glsl");
+
+        if (!indirectRenderer->IsValid()) {
+            return EXIT_FAILURE;
+        }
+
+        indirectRenderer->Add(0, glm::mat4(1.0f));
+
+        for (const glm::mat4& transform : stressScene) {
+            indirectRenderer->Add(0, transform);
+        }
+
+        for (const Myst::ModelInstance& instance : modelInstances) {
+            if (modelGeometry[instance.Mesh] >= 0) {
+                indirectRenderer->Add(
+                    static_cast<std::uint32_t>(modelGeometry[instance.Mesh]),
+                    instance.Transform);
+            }
+        }
+    }
+
+    float lastReport{0};
+    float lastProfileReport{0};
+    float lastPacingReport{0};
+    std::size_t frameNumber{0};
+
     glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
 
-    while (!glfwWindowShouldClose(window)) {
-        float currentTime = glfwGetTime();
-        deltaTime = currentTime - lastTime;
-        lastTime = currentTime;
+    lightNode = sceneGraph.Create(
+        Myst::SceneGraph::kNone,
+        glm::scale(glm::translate(glm::mat4(1.0f), lightPos), glm::vec3(0.2f)));
+
+    Myst::FrameReport frameReport;
+    std::vector<std::uint8_t> pixels;
 
-        processInput(window);
+    // Replays must not depend on how fast the textures stream in.
+    if (fixedTimestep) {
+        auto settled = [](const Myst::TextureCache::Handle& texture) {
+            return texture.IsReady() || texture.HasFailed();
+        };
+
+        while (!settled(diffuse) || !settled(specular)) {
+            jobSystem->ExecuteMainThreadJobs();
+            textureLoader->Update();
+            std::this_thread::yield();
+        }
+    }
+
+    simulated[1].CameraPosition = camera->GetPosition();
+    simulateLights(0.0f, simulated[1].LightPositions);
+    simulated[0] = simulated[1];
+
+    const std::uint64_t frameStep = toNanoseconds(timestep);
+    std::uint64_t clock{0};
+    auto lastFrameStart = std::chrono::steady_clock::now();
+
+    while ((window == nullptr || !glfwWindowShouldClose(window)) &&
+           (frameCount == 0 || frameNumber < frameCount)) {
+        // Low latency mode holds the frame back here, so that the input it
+        // reads is as fresh as it can be.
+        pacer.BeginFrame();
+
+        auto frameStart = std::chrono::steady_clock::now();
+        const std::uint64_t profileStart = Myst::Profiler::Now();
+
+        if (window != nullptr) {
+            glfwPollEvents();
+            processInput(window);
+        }
+
+        auto inputRead = std::chrono::steady_clock::now();
+
+        if (gpuProfiler) {
+            gpuProfiler->BeginFrame();
+        }
+
+        MYST_GPU_SCOPE(gpuProfiler.get(), "Frame");
+
+        if (headless) {
+            glQueryCounter(frameTimeQueries[0], GL_TIMESTAMP);
+        }
+
+        std::uint64_t elapsed{0};
+
+        if (frameNumber > 0 && fixedTimestep) {
+            elapsed = frameStep;
+        } else if (frameNumber > 0) {
+            elapsed = static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(frameStart - lastFrameStart)
+                    .count());
+        }
+
+        lastFrameStart = frameStart;
+        clock += elapsed;
+
+        const float currentTime = fixedTimestep ? static_cast<float>(frameNumber) * timestep
+                                                : static_cast<float>(clock) * 1e-9f;
+        const float deltaTime = fixedTimestep ? timestep : static_cast<float>(elapsed) * 1e-9f;
+
+        {
+            MYST_PROFILE_SCOPE("Simulate");
+
+            for (std::uint32_t ticks = simulation.Advance(elapsed); ticks > 0; --ticks) {
+                const std::uint64_t tick = simulation.GetTicks() - ticks + 1;
+                simulate(static_cast<float>(tick) * tickStep, tickStep);
+            }
+        }
+
+        const float alpha = simulation.GetAlpha();
+
+        // Replays place the camera as of the frame's time outright. The mouse
+        // turns it as of now, and only its position is interpolated.
+        cameraReplay.Apply(currentTime, *camera);
+
+        Myst::Camera viewCamera = *camera;
+
+        if (!cameraReplay.IsReplaying()) {
+            viewCamera.SetPose(
+                glm::mix(simulated[0].CameraPosition, simulated[1].CameraPosition, alpha),
+                camera->GetYaw(), camera->GetPitch(), camera->GetZoom());
+        }
+
+        cameraReplay.Capture(currentTime, viewCamera);
+
+        // GL work handed back by jobs since the last frame.
+        jobSystem->ExecuteMainThreadJobs();
+
+        {
+            MYST_GPU_SCOPE(gpuProfiler.get(), "Texture upload");
+            textureLoader->Update();
+        }
+
+        textureCache->Update();
+        uniformRing->BeginFrame();
+
+        // Texture uploads bind behind the cache's back.
+        stateCache->Invalidate();
+        stateCache->ResetStats();
 
         glClearColor(0.25f, 0.25f, 0.25f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glm::mat4 projection = glm::perspective(glm::radians(camera->GetZoom()), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera->GetViewMatrix();
-        glm::mat4 model(1.0f);
-
-        glm::mat3 modelView(view * model);
-        glm::mat3 normal = glm::inverseTranspose(modelView);
+        Myst::FrameBlock frame{};
+        frame.Time = currentTime;
+        frame.DeltaTime = deltaTime;
+        frame.Light.Position = lightPos;
+        frame.Light.Ambient = glm::vec3(0.2f);
+        frame.Light.Diffuse = glm::vec3(0.5f);
+        frame.Light.Specular = glm::vec3(1.0f);
+        frame.Light.Constant = 1.0f;
+        frame.Light.Linear = 0.09f;
+        frame.Light.Quadratic = 0.032f;
+
+        Myst::ViewBlock view{};
+        view.Projection =
+            viewCamera.GetProjectionMatrix((float)WIDTH / (float)HEIGHT, NEAR, FAR);
+        view.View = viewCamera.GetViewMatrix();
+        view.ViewProjection = view.Projection * view.View;
+        view.Position = viewCamera.GetPosition();
+
+        // The scene graph is read by last frame's recording until it is done.
+        if (parallelRecording) {
+            jobSystem->Wait(recording);
+        }
+
+        updateScene();
+
+        Myst::ObjectBlock light{};
+        light.Model = sceneGraph.GetWorldTransform(lightNode);
+        light.Normal = sceneGraph.GetNormalMatrix(lightNode);
+        cubeMesh->SetObjectBlock(light);
+
+        Myst::Frustum frustum = Myst::Frustum::FromMatrix(view.ViewProjection);
+
+        RecordedFrame& current = recordedFrames[frameNumber % 2];
+        RecordedFrame& replayed = recordedFrames[(frameNumber + 1) % 2];
+
+        if (clusteredLighting) {
+            interpolateLights(alpha, current.LightPositions);
+        }
+
+        // This frame is recorded in the background, and from here on
+        // everything is drawn as of the frame before, to match its draws.
+        if (parallelRecording) {
+            if (useCulling) {
+                visibleObjects.clear();
+                sceneBvh.Cull(frustum, visibleObjects);
+
+                if (occlusionBuffer) {
+                    cullOccluded(view.ViewProjection, view.Position);
+                }
+
+                current.Objects.swap(visibleObjects);
+            }
+
+            current.Frame = frame;
+            current.View = view;
+            current.Light = light;
+            recordDraws(current, view.Position);
+
+            if (frameNumber > 0) {
+                frame = replayed.Frame;
+                view = replayed.View;
+                light = replayed.Light;
+                frustum = Myst::Frustum::FromMatrix(view.ViewProjection);
+            }
+        }
+
+        auto frameRange = uniformRing->Push(frame);
+        auto viewRange = uniformRing->Push(view);
+        auto lightRange = uniformRing->Push(light);
+
+        frameRange.Bind(*stateCache, GL_UNIFORM_BUFFER, Myst::kFrameBlockBinding);
+        viewRange.Bind(*stateCache, GL_UNIFORM_BUFFER, Myst::kViewBlockBinding);
+
+        if (clusteredLighting) {
+            int width, height;
+            getFramebufferSize(width, height);
+
+            MYST_GPU_SCOPE(gpuProfiler.get(), "Light clustering");
+
+            placeLights(
+                parallelRecording && frameNumber > 0 ? replayed.LightPositions
+                                                     : current.LightPositions);
+            clusteredLighting->BeginFrame();
+            clusteredLighting->Update(
+                pointLights, view.View, view.Projection, NEAR, FAR,
+                glm::vec2(width, height), *stateCache);
+        }
+
+        if (indirectRenderer) {
+            MYST_GPU_SCOPE(gpuProfiler.get(), "Indirect draw");
+
+            indirectRenderer->Draw(frustum, crate, *stateCache);
+        } else if (parallelRecording) {
+            for (std::size_t chunk = 0; chunk < replayed.Chunks; ++chunk) {
+                renderQueue->Submit(replayed.Commands[chunk]);
+            }
+        } else if (useCulling) {
+            visibleObjects.clear();
+            sceneBvh.Cull(frustum, visibleObjects);
+
+            if (occlusionBuffer) {
+                cullOccluded(view.ViewProjection, view.Position);
+            }
+
+            for (std::uint32_t object : visibleObjects) {
+                const SceneObject& visible = sceneObjects[object];
+                renderer->Submit(
+                    *visible.Mesh, *visible.Material, sceneGraph.GetWorldTransform(visible.Node));
+            }
+
+            renderer->Flush(*renderQueue, view.Position);
+        } else {
+            for (const SceneObject& object : sceneObjects) {
+                renderer->Submit(
+                    *object.Mesh, *object.Material, sceneGraph.GetWorldTransform(object.Node));
+            }
+
+            renderer->Flush(*renderQueue, view.Position);
+        }
+
+        Myst::RenderItem lightItem;
+        lightItem.Program = lightProgram;
+        lightItem.Mesh = cubeMesh.get();
+        lightItem.Object = lightRange;
+        renderQueue->Submit(
+            Myst::RenderPass::Main, lightItem, glm::distance(view.Position, lightPos));
+
+        {
+            MYST_GPU_SCOPE(gpuProfiler.get(), "Render queue");
+            renderQueue->Execute(*stateCache);
+        }
+
+        if (occlusionDebugFramebuffer != 0) {
+            drawOcclusionDebug();
+        }
+
+        const Myst::RenderQueue::Stats& queued = renderQueue->GetStats();
+
+        frameReport.DrawCalls.push_back(
+            queued.Items + (indirectRenderer ? indirectRenderer->GetStats().Commands : 0));
+        frameReport.ProgramSwitches.push_back(queued.Programs);
+        frameReport.StateChanges.push_back(stateCache->GetStats().GetIssued());
+
+        if (clusteredLighting && currentTime - lastReport >= 1.0f) {
+            const Myst::LightGrid::Stats& stats = clusteredLighting->GetGrid().GetStats();
+
+            std::cout << "myst: " << stats.Lights << " of " << pointLights.GetSize()
+                      << " lights in view, " << stats.References
+                      << " cluster references, at most " << stats.MaxPerCluster
+                      << " per cluster" << std::endl;
+
+            if (stressCount == 0) {
+                lastReport = currentTime;
+            }
+        }
+
+        if (stressCount > 0 && currentTime - lastReport >= 1.0f) {
+            if (indirectRenderer) {
+                const Myst::IndirectRenderer::Stats& stats = indirectRenderer->GetStats();
+
+                std::cout << "myst: " << indirectRenderer->ReadVisibleCount() << " of "
+                          << stats.Objects << " objects visible, " << stats.Commands
+                          << (stats.IndirectCount ? " commands, GPU draw count"
+                                                  : " commands, CPU draw count")
+                          << std::endl;
+            } else {
+                const Myst::InstancedRenderer::Stats& stats = renderer->GetStats();
+
+                if (useCulling) {
+                    const Myst::Bvh::Stats& culling = sceneBvh.GetStats();
+
+                    std::cout << "myst: " << culling.Visible << " of " << sceneObjects.size()
+                              << " objects visible, " << culling.NodesVisited
+                              << " nodes visited, " << culling.NodesAccepted
+                              << " accepted whole" << std::endl;
+                }
+
+                if (occlusionBuffer) {
+                    const Myst::OcclusionBuffer::Stats& occlusion = occlusionBuffer->GetStats();
+
+                    std::cout << "myst: occlusion: " << occlusion.Occluders << " occluders, "
+                              << occlusion.Rasterized << " of " << occlusion.Triangles
+                              << " triangles rasterized, " << occlusion.Rejected << " of "
+                              << occlusion.Tested << " objects rejected" << std::endl;
+                }
+
+                if (parallelRecording) {
+                    std::size_t draws{0};
+                    std::size_t payload{0};
+
+                    for (std::size_t chunk = 0; chunk < replayed.Chunks; ++chunk) {
+                        draws += replayed.Commands[chunk].GetSize();
+                        payload += replayed.Commands[chunk].GetPayloadSize();
+                    }
+
+                    std::cout << "myst: " << replayed.Objects.size() << " of "
+                              << sceneObjects.size() << " objects recorded by "
+                              << replayed.Chunks << " jobs into " << draws << " draws, "
+                              << payload / 1024 << " KiB of blocks" << std::endl;
+                } else {
+                    std::cout << "myst: " << stats.Instances << " objects in "
+                              << stats.Batches << " batches, " << stats.DrawCalls
+                              << " draws per frame" << std::endl;
+                }
+            }
+
+            const Myst::SceneGraph::Stats& graph = sceneGraph.GetStats();
+
+            std::cout << "myst: scene graph: " << graph.Nodes << " nodes in " << graph.Levels
+                      << " levels, " << graph.Updated << " updated" << std::endl;
+
+            const Myst::GLStateCache::Stats& state = stateCache->GetStats();
+
+            std::cout << "myst: state changes: " << state.GetIssued() << " issued, "
+                      << state.GetElided() << " elided (programs "
+                      << state.Programs.Issued << "/" << state.Programs.Elided
+                      << ", textures " << state.Textures.Issued << "/"
+                      << state.Textures.Elided << ", vertex arrays "
+                      << state.VertexArrays.Issued << "/" << state.VertexArrays.Elided
+                      << ", buffers " << state.Buffers.Issued << "/"
+                      << state.Buffers.Elided << ")" << std::endl;
+            lastReport = currentTime;
+        }
+
+        {
+            // Fencing flushes the frame, which software drivers such as
+            // llvmpipe then render on the spot.
+            MYST_PROFILE_SCOPE("End frame");
+
+            uniformRing->EndFrame();
+
+            if (clusteredLighting) {
+                clusteredLighting->EndFrame();
+            }
+        }
+
+        if (headless) {
+            glQueryCounter(frameTimeQueries[1], GL_TIMESTAMP);
+        }
+
+        auto submitted = std::chrono::steady_clock::now();
+
+        {
+            MYST_PROFILE_SCOPE("Present");
+
+            if (headless) {
+                glFinish();
+            } else {
+                glfwSwapBuffers(window);
+            }
+        }
+
+        auto finished = std::chrono::steady_clock::now();
+
+        frameReport.CpuTimes.push_back(
+            std::chrono::duration<double, std::milli>(submitted - frameStart).count());
+        frameReport.FrameTimes.push_back(
+            std::chrono::duration<double, std::milli>(finished - frameStart).count());
+        frameReport.Latencies.push_back(
+            std::chrono::duration<double, std::milli>(finished - inputRead).count());
+
+        // The frame is finished, so its timestamps are already there.
+        if (headless) {
+            GLuint64 begin{0};
+            GLuint64 end{0};
+            glGetQueryObjectui64v(frameTimeQueries[0], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(frameTimeQueries[1], GL_QUERY_RESULT, &end);
+            frameReport.GpuTimes.push_back(static_cast<double>(end - begin) * 1e-6);
+        }
+
+        if (headless && (dumpDirectory != nullptr || useChecksums)) {
+            readFrame(pixels);
+
+            if (useChecksums) {
+                frameReport.Checksums.push_back(Myst::Hash(pixels.data(), pixels.size()));
+            }
+
+            if (dumpDirectory != nullptr && !writeFrame(dumpDirectory, frameNumber, pixels)) {
+                dumpDirectory = nullptr;
+            }
+        }
+
+        if (profiling) {
+            Myst::Profiler::Get().AddScope("Frame", profileStart, Myst::Profiler::Now());
+            Myst::Profiler::Get().EndFrame();
+
+            if (profileStats && currentTime - lastProfileReport >= 1.0f) {
+                printProfile();
+                lastProfileReport = currentTime;
+            }
+        }
+
+        if (pacer.IsEnabled() && currentTime - lastPacingReport >= 1.0f) {
+            const Myst::FramePacer::Stats& pacing = pacer.GetStats();
+
+            std::cout << "myst: paced to " << frameLimit << " Hz"
+                      << (lowLatency ? " for low latency, " : ", ") << "input to present in "
+                      << frameReport.Latencies.back() << " ms, waited "
+                      << static_cast<double>(pacing.Waited) * 1e-6 << " ms, "
+                      << pacing.Missed << " frames missed" << std::endl;
+            lastPacingReport = currentTime;
+        }
+
+        pacer.EndFrame();
+
+        ++frameNumber;
+    }
 
-        cubeProgram->Bind();
+    frameReport.Ticks = simulation.GetTicks();
+    frameReport.DroppedTicks = simulation.GetDropped();
+    frameReport.MissedFrames = pacer.GetStats().Missed;
 
-        cubeProgram->SetInt("material.diffuse", 0);
-        cubeProgram->SetInt("material.specular", 1);
-        cubeProgram->SetFloat("material.shininess", 32.0f);
+    jobSystem->Wait(recording);
 
-        cubeProgram->SetVec3("light.position", view * glm::vec4(lightPos, 1.0));
-        cubeProgram->SetVec3("light.ambient", glm::vec3(0.2f));
-        cubeProgram->SetVec3("light.diffuse", glm::vec3(0.5f));
-        cubeProgram->SetVec3("light.specular", glm::vec3(1.0f));
-        cubeProgram->SetFloat("light.constant", 1.0f);
-        cubeProgram->SetFloat("light.linear", 0.09f);
-        cubeProgram->SetFloat("light.quadratic", 0.032f);
+    cameraReplay.SaveRecording();
 
-        cubeProgram->SetMat4("projection", projection);
-        cubeProgram->SetMat4("view", view);
-        cubeProgram->SetMat4("model", model);
-        cubeProgram->SetMat3("normal", normal);
+    bool reported{true};
 
-        glBindVertexArray(cubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+    if (profiling) {
+        if (profileStats) {
+            printProfile();
+        }
 
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, lightPos);
-        model = glm::scale(model, glm::vec3(0.2f));
+        if (profilePath != nullptr) {
+            // The last frames' GPU timings are still in flight.
+            gpuProfiler->Finish();
+            Myst::Profiler::Get().Flush();
 
-        lightProgram->Bind();
-        lightProgram->SetMat4("projection", projection);
-        lightProgram->SetMat4("view", view);
-        lightProgram->SetMat4("model", model);
-        glBindVertexArray(lightVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+            if (Myst::Profiler::Get().SaveTrace(profilePath)) {
+                std::cout << "myst: wrote a trace of " << frameNumber << " frames to \""
+                          << profilePath << "\"" << std::endl;
+            } else {
+                reported = false;
+            }
+        }
+    }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    if (reportPath != nullptr) {
+        frameReport.Renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+        frameReport.Version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+        frameReport.Arguments.assign(argv + 1, argv + argc);
+        frameReport.Width = WIDTH;
+        frameReport.Height = HEIGHT;
+        frameReport.Timestep = timestep;
+        frameReport.TickStep = tickStep;
+        frameReport.TextureMemory = textureCache->GetResidency().Bytes;
+
+        for (const auto& texture : stressTextures) {
+            frameReport.TextureMemory += texture->GetMemoryUsage();
+        }
+
+        reported = frameReport.Save(reportPath) && reported;
     }
 
+    textureCache->PrintResidency();
+
+    // Release everything that owns GL objects while the context still exists.
+    glDeleteFramebuffers(1, &occlusionDebugFramebuffer);
+    glDeleteTextures(1, &occlusionDebugTexture);
+    glDeleteFramebuffers(1, &outputFramebuffer);
+    glDeleteRenderbuffers(2, outputRenderbuffers);
+    glDeleteQueries(2, frameTimeQueries);
+    gpuProfiler.reset();
+    indirectRenderer.reset();
+    sceneGeometry.reset();
+    renderer.reset();
+    renderQueue.reset();
+    stateCache.reset();
+    clusteredLighting.reset();
+    uniformRing.reset();
+    cubeMesh.reset();
+    stressMaterials.clear();
+    stressTextures.clear();
+    modelMeshes.clear();
+    shaderLibrary.reset();
+    programCache.reset();
+    diffuse = Myst::TextureCache::Handle{};
+    specular = Myst::TextureCache::Handle{};
+    // Decodes still running hand their textures back through main thread
+    // jobs, which go with the job system, so it goes before the loader.
+    jobSystem.reset();
+    textureCache.reset();
+    textureLoader.reset();
+    texturePool.reset();
+
+#if defined(MYST_HAS_EGL)
+    headlessContext.reset();
+#endif
+
     glfwTerminate();
 
-    return EXIT_SUCCESS;
+    return reported ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,287 @@
+/**
+ * Copyright (c) 2021-2021 Jacob van Eijk. All rights reserved.
+ *
+ * For the full copyright and license information, please view the LICENSE file
+ * that was distributed with this source code.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "Core/JobSystem.hpp"
+#include "Image/BlockCompression.hpp"
+#include "Image/CookedTexture.hpp"
+#include "Image/Image.hpp"
+#include "Image/MipChain.hpp"
+
+struct Options
+{
+    std::string Input;
+    std::string Output;
+    std::string Format{"auto"};
+    std::uint32_t Flags{0};
+    bool Flip{true};
+    bool Mipmaps{true};
+    Myst::MipFilter MipFilter{Myst::MipFilter::Kaiser};
+};
+
+static void printUsage()
+{
+    std::cerr
+        << "usage: myst-cook [options] <input> <output.mtex>\n"
+           "\n"
+           "options:\n"
+           "  --format <name>  bc1, bc3, bc5, bc7, r8, rg8, rgb8, rgba8 or auto\n"
+           "  --srgb           the texture holds sRGB colour data\n"
+           "  --normal-map     the texture holds a tangent-space normal map\n"
+           "  --no-mipmaps     only store the base level\n"
+           "  --mip-filter <f> box or kaiser (default)\n"
+           "  --no-flip        don't flip vertically (the engine expects flips)\n";
+}
+
+static bool parseArguments(int argc, char* argv[], Options& options)
+{
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            options.Format = argv[++i];
+        } else if (std::strcmp(argv[i], "--srgb") == 0) {
+            options.Flags |= Myst::kCookedSRGB;
+        } else if (std::strcmp(argv[i], "--normal-map") == 0) {
+            options.Flags |= Myst::kCookedNormalMap;
+        } else if (std::strcmp(argv[i], "--no-mipmaps") == 0) {
+            options.Mipmaps = false;
+        } else if (std::strcmp(argv[i], "--mip-filter") == 0 && i + 1 < argc) {
+            std::string filter = argv[++i];
+
+            if (filter == "box") {
+                options.MipFilter = Myst::MipFilter::Box;
+            } else if (filter == "kaiser") {
+                options.MipFilter = Myst::MipFilter::Kaiser;
+            } else {
+                std::cerr << "myst-cook: unknown mip filter \"" << filter << "\""
+                          << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(argv[i], "--no-flip") == 0) {
+            options.Flip = false;
+        } else if (argv[i][0] == '-') {
+            std::cerr << "myst-cook: unknown option \"" << argv[i] << "\"" << std::endl;
+            return false;
+        } else {
+            positional.push_back(argv[i]);
+        }
+    }
+
+    if (positional.size() != 2) {
+        return false;
+    }
+
+    options.Input = positional[0];
+    options.Output = positional[1];
+
+    return true;
+}
+
+static bool selectFormat(
+    const Options& options, const Myst::Image& image, Myst::CookedFormat& format)
+{
+    static const std::pair<const char*, Myst::CookedFormat> kFormats[]{
+        {"r8", Myst::CookedFormat::R8},   {"rg8", Myst::CookedFormat::RG8},
+        {"rgb8", Myst::CookedFormat::RGB8}, {"rgba8", Myst::CookedFormat::RGBA8},
+        {"bc1", Myst::CookedFormat::BC1}, {"bc3", Myst::CookedFormat::BC3},
+        {"bc5", Myst::CookedFormat::BC5}, {"bc7", Myst::CookedFormat::BC7},
+    };
+
+    for (const auto& entry : kFormats) {
+        if (options.Format == entry.first) {
+            format = entry.second;
+            return true;
+        }
+    }
+
+    if (options.Format != "auto") {
+        std::cerr << "myst-cook: unknown format \"" << options.Format << "\""
+                  << std::endl;
+        return false;
+    }
+
+    if ((options.Flags & Myst::kCookedNormalMap) != 0 || image.Channels == 2) {
+        format = Myst::CookedFormat::BC5;
+        return true;
+    }
+
+    bool opaque{true};
+
+    if (image.Channels == 4) {
+        for (std::size_t i = 3; i < image.Pixels.size(); i += 4) {
+            opaque = opaque && image.Pixels[i] == 255;
+        }
+    }
+
+    format = opaque ? Myst::CookedFormat::BC1 : Myst::CookedFormat::BC7;
+
+    return true;
+}
+
+static bool isBlockFormat(Myst::CookedFormat format, Myst::BlockFormat& block)
+{
+    switch (format) {
+        case Myst::CookedFormat::BC1: block = Myst::BlockFormat::BC1; return true;
+        case Myst::CookedFormat::BC3: block = Myst::BlockFormat::BC3; return true;
+        case Myst::CookedFormat::BC5: block = Myst::BlockFormat::BC5; return true;
+        case Myst::CookedFormat::BC7: block = Myst::BlockFormat::BC7; return true;
+        default: break;
+    }
+
+    return false;
+}
+
+static int getChannels(Myst::CookedFormat format)
+{
+    switch (format) {
+        case Myst::CookedFormat::R8: return 1;
+        case Myst::CookedFormat::RG8: return 2;
+        case Myst::CookedFormat::RGB8: return 3;
+        default: break;
+    }
+
+    return 4;
+}
+
+// Converts to the channel count of an uncompressed target format, dropping or
+// filling channels as needed.
+static Myst::Image convertChannels(const Myst::Image& image, int channels)
+{
+    if (image.Channels == channels) {
+        return image;
+    }
+
+    Myst::Image result(image.Width, image.Height, channels);
+    std::size_t pixels = static_cast<std::size_t>(image.Width) * image.Height;
+
+    for (std::size_t i = 0; i < pixels; ++i) {
+        for (int c = 0; c < channels; ++c) {
+            unsigned char value = c == 3 ? 255 : 0;
+
+            if (c < image.Channels) {
+                value = image.Pixels[i * image.Channels + c];
+            } else if (image.Channels == 1 && c < 3) {
+                value = image.Pixels[i];
+            }
+
+            result.Pixels[i * channels + c] = value;
+        }
+    }
+
+    return result;
+}
+
+static std::vector<unsigned char> encodeLevel(
+    Myst::JobSystem& jobs, const Myst::Image& image, Myst::CookedFormat format)
+{
+    Myst::BlockFormat block;
+
+    if (!isBlockFormat(format, block)) {
+        return convertChannels(image, getChannels(format)).Pixels;
+    }
+
+    std::vector<unsigned char> output(
+        Myst::GetCompressedSize(block, image.Width, image.Height));
+
+    // Split the level into bands of block rows; every band writes a disjoint
+    // part of the output.
+    int rows = (image.Height + 3) / 4;
+    int bands = static_cast<int>(jobs.GetThreadCount()) * 4;
+    int step = std::max(1, (rows + bands - 1) / bands);
+
+    Myst::JobSystem::Counter counter;
+
+    for (int first = 0; first < rows; first += step) {
+        int last = std::min(rows, first + step);
+
+        jobs.Run(
+            [&image, &output, block, first, last]() {
+                Myst::CompressBlockRows(image, block, first, last, output.data());
+            },
+            &counter);
+    }
+
+    jobs.Wait(counter);
+
+    return output;
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+
+    if (!parseArguments(argc, argv, options)) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    stbi_set_flip_vertically_on_load(options.Flip);
+
+    int width, height, channels{0};
+    unsigned char* data{
+        stbi_load(options.Input.c_str(), &width, &height, &channels, 0)};
+
+    if (data == nullptr) {
+        std::cerr << "stb: failed to load (" << options.Input << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Myst::Image image(width, height, channels);
+    std::copy(data, data + image.Pixels.size(), image.Pixels.begin());
+    stbi_image_free(data);
+
+    Myst::CookedFormat format;
+
+    if (!selectFormat(options, image, format)) {
+        return EXIT_FAILURE;
+    }
+
+    Myst::MipOptions mipOptions;
+    mipOptions.Filter = options.MipFilter;
+    mipOptions.SRGB = (options.Flags & Myst::kCookedSRGB) != 0;
+    mipOptions.NormalMap = (options.Flags & Myst::kCookedNormalMap) != 0;
+
+    Myst::JobSystem jobs;
+
+    std::vector<Myst::Image> chain = options.Mipmaps
+        ? Myst::GenerateMipChain(image, mipOptions, jobs)
+        : std::vector<Myst::Image>{image};
+
+    std::vector<std::vector<unsigned char>> levels;
+    std::vector<std::pair<int, int>> sizes;
+    std::size_t cookedSize{0};
+
+    for (const Myst::Image& level : chain) {
+        levels.push_back(encodeLevel(jobs, level, format));
+        sizes.emplace_back(level.Width, level.Height);
+        cookedSize += levels.back().size();
+    }
+
+    if (!Myst::WriteCookedTexture(
+            options.Output, format, options.Flags, levels, sizes)) {
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "myst-cook: " << options.Input << " -> " << options.Output
+              << " (" << width << "x" << height << ", "
+              << Myst::GetCookedFormatName(format) << ", " << levels.size()
+              << " levels, " << cookedSize << " bytes)" << std::endl;
+
+    return EXIT_SUCCESS;
+}